@@ -0,0 +1,97 @@
+'use strict';
+
+// Measures the rate of QUIC handshakes completed one after the other over
+// loopback, optionally resuming a session (making 0-RTT keys available) and
+// optionally requiring the server to validate the client address with a
+// Retry packet first.
+
+const common = require('../common.js');
+const bench = common.createBenchmark(main, {
+  n: [200],
+  earlyData: ['false', 'true'],
+  retry: ['false', 'true'],
+  packetSize: [1200, 1252],
+  loss: [0, 0.01],
+}, {
+  flags: ['--no-warnings'],
+  test: { packetSize: 1200 }
+});
+
+const fixtures = require('../../test/common/fixtures');
+
+function main({ n, earlyData, retry, packetSize, loss }) {
+  const { createQuicSocket } = require('net');
+
+  const options = {
+    key: fixtures.readKey('agent1-key.pem', 'binary'),
+    cert: fixtures.readKey('agent1-cert.pem', 'binary'),
+    ca: fixtures.readKey('ca1-cert.pem', 'binary'),
+    alpn: 'bench',
+    maxPacketSize: packetSize,
+  };
+
+  // Closed sessions may linger while draining, so the limits
+  // must allow for all of the sessions at once.
+  const server = createQuicSocket({
+    validateAddress: retry === 'true',
+    maxConnections: n,
+    maxConnectionsPerHost: n,
+    server: options
+  });
+  const client = createQuicSocket({ client: options });
+  server.setDiagnosticPacketLoss({ rx: loss, tx: loss });
+
+  server.on('session', (session) => {
+    session.on('stream', (stream) => stream.resume().end());
+  });
+
+  let sessionTicket;
+  let remoteTransportParams;
+  let completed = 0;
+
+  server.listen();
+  server.on('ready', () => {
+    if (earlyData !== 'true') {
+      bench.start();
+      connect();
+      return;
+    }
+
+    // The first session only collects a ticket to resume with.
+    const req = client.connect({
+      address: 'localhost',
+      port: server.endpoints[0].address.port,
+    });
+    req.on('sessionTicket', (ticket, params) => {
+      if (sessionTicket !== undefined)
+        return;
+      sessionTicket = ticket;
+      remoteTransportParams = params;
+      req.close(() => {
+        bench.start();
+        connect();
+      });
+    });
+  });
+
+  function connect() {
+    const req = client.connect({
+      address: 'localhost',
+      port: server.endpoints[0].address.port,
+      sessionTicket,
+      remoteTransportParams,
+    });
+    // Sent as early data when the session is resumed.
+    const stream = req.openStream();
+    stream.resume();
+    stream.end('ping');
+    req.on('secure', () => req.close());
+    req.on('close', () => {
+      if (++completed < n)
+        return connect();
+      bench.end(n);
+      client.close();
+      server.close();
+    });
+  }
+}
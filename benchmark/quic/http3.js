@@ -0,0 +1,89 @@
+'use strict';
+
+// Measures the rate of HTTP/3 requests, with a fixed number of
+// requests in flight on a single QUIC session.
+
+const common = require('../common.js');
+const bench = common.createBenchmark(main, {
+  n: [2000],
+  streams: [1, 10, 100],
+  size: [16, 16 * 1024],
+  packetSize: [1200, 1252],
+  loss: [0, 0.01],
+}, {
+  flags: ['--no-warnings'],
+  test: { packetSize: 1200 }
+});
+
+const fixtures = require('../../test/common/fixtures');
+
+function main({ n, streams, size, packetSize, loss }) {
+  const { createQuicSocket } = require('net');
+
+  const options = {
+    key: fixtures.readKey('agent1-key.pem', 'binary'),
+    cert: fixtures.readKey('agent1-cert.pem', 'binary'),
+    ca: fixtures.readKey('ca1-cert.pem', 'binary'),
+    alpn: 'h3-27',
+    maxPacketSize: packetSize,
+    maxStreamsBidi: n,
+    maxStreamsUni: 10,
+  };
+
+  const body = Buffer.alloc(size, 'b');
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+  server.setDiagnosticPacketLoss({ rx: loss, tx: loss });
+
+  server.on('session', (session) => {
+    session.on('stream', (stream) => {
+      stream.resume();
+      stream.on('initialHeaders', () => {
+        stream.submitInitialHeaders({
+          ':status': '200',
+          'content-length': `${size}`
+        });
+        stream.end(body);
+      });
+    });
+  });
+
+  server.listen();
+  server.on('ready', () => {
+    const req = client.connect({
+      address: 'localhost',
+      port: server.endpoints[0].address.port,
+    });
+
+    let started = 0;
+    let completed = 0;
+
+    function request() {
+      started++;
+      const stream = req.openStream();
+      stream.submitInitialHeaders({
+        ':method': 'GET',
+        ':scheme': 'https',
+        ':authority': 'localhost',
+        ':path': '/',
+      });
+      stream.end();
+      stream.resume();
+      stream.on('close', () => {
+        if (++completed === n) {
+          bench.end(n);
+          client.close();
+          server.close();
+        } else if (started < n) {
+          request();
+        }
+      });
+    }
+
+    req.on('secure', () => {
+      bench.start();
+      for (let i = 0; i < Math.min(streams, n); i++)
+        request();
+    });
+  });
+}
@@ -0,0 +1,74 @@
+'use strict';
+
+// Measures the memory held per established QUIC session. The client and
+// server share the process, so each session is counted with both of its
+// ends. The reported value is the growth of the resident set size, in
+// bytes, divided by the number of sessions; lower is better.
+
+const common = require('../common.js');
+const bench = common.createBenchmark(main, {
+  sessions: [100, 1000],
+  streams: [0, 1],
+  packetSize: [1200, 1252],
+  loss: [0, 0.01],
+}, {
+  flags: ['--no-warnings', '--expose-gc'],
+  test: { packetSize: 1200 }
+});
+
+const fixtures = require('../../test/common/fixtures');
+
+function main({ sessions, streams, packetSize, loss }) {
+  const { createQuicSocket } = require('net');
+
+  const options = {
+    key: fixtures.readKey('agent1-key.pem', 'binary'),
+    cert: fixtures.readKey('agent1-cert.pem', 'binary'),
+    ca: fixtures.readKey('ca1-cert.pem', 'binary'),
+    alpn: 'bench',
+    maxPacketSize: packetSize,
+  };
+
+  const server = createQuicSocket({
+    maxConnections: sessions,
+    maxConnectionsPerHost: sessions,
+    server: options
+  });
+  const client = createQuicSocket({ client: options });
+  server.setDiagnosticPacketLoss({ rx: loss, tx: loss });
+
+  server.on('session', (session) => {
+    session.on('stream', (stream) => stream.resume());
+  });
+
+  server.listen();
+  server.on('ready', () => {
+    global.gc();
+    const { rss } = process.memoryUsage();
+    const start = process.hrtime();
+    const reqs = [];
+    let established = 0;
+
+    for (let i = 0; i < sessions; i++) {
+      const req = client.connect({
+        address: 'localhost',
+        port: server.endpoints[0].address.port,
+      });
+      req.on('secure', () => {
+        for (let j = 0; j < streams; j++)
+          req.openStream({ halfOpen: true }).write('ping');
+        if (++established === sessions)
+          setImmediate(done);
+      });
+      reqs.push(req);
+    }
+
+    function done() {
+      global.gc();
+      const bytes = process.memoryUsage().rss - rss;
+      bench.report(Math.max(bytes, 0) / sessions, process.hrtime(start));
+      client.close();
+      server.close();
+    }
+  });
+}
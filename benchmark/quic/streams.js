@@ -0,0 +1,77 @@
+'use strict';
+
+// Measures the rate of small request/response exchanges, each on its own
+// bidirectional QUIC stream, with a fixed number of streams in flight.
+
+const common = require('../common.js');
+const bench = common.createBenchmark(main, {
+  n: [2000],
+  streams: [1, 10, 100],
+  size: [16, 1024],
+  packetSize: [1200, 1252],
+  loss: [0, 0.01],
+}, {
+  flags: ['--no-warnings'],
+  test: { packetSize: 1200 }
+});
+
+const fixtures = require('../../test/common/fixtures');
+
+function main({ n, streams, size, packetSize, loss }) {
+  const { createQuicSocket } = require('net');
+
+  const options = {
+    key: fixtures.readKey('agent1-key.pem', 'binary'),
+    cert: fixtures.readKey('agent1-cert.pem', 'binary'),
+    ca: fixtures.readKey('ca1-cert.pem', 'binary'),
+    alpn: 'bench',
+    maxPacketSize: packetSize,
+    maxStreamsBidi: n,
+  };
+
+  const payload = Buffer.alloc(size, 'b');
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+  server.setDiagnosticPacketLoss({ rx: loss, tx: loss });
+
+  // Each request is answered with a response of the same size.
+  server.on('session', (session) => {
+    session.on('stream', (stream) => {
+      stream.resume();
+      stream.on('end', () => stream.end(payload));
+    });
+  });
+
+  server.listen();
+  server.on('ready', () => {
+    const req = client.connect({
+      address: 'localhost',
+      port: server.endpoints[0].address.port,
+    });
+
+    let started = 0;
+    let completed = 0;
+
+    function request() {
+      started++;
+      const stream = req.openStream();
+      stream.resume();
+      stream.end(payload);
+      stream.on('close', () => {
+        if (++completed === n) {
+          bench.end(n);
+          client.close();
+          server.close();
+        } else if (started < n) {
+          request();
+        }
+      });
+    }
+
+    req.on('secure', () => {
+      bench.start();
+      for (let i = 0; i < Math.min(streams, n); i++)
+        request();
+    });
+  });
+}
@@ -0,0 +1,73 @@
+'use strict';
+
+// Measures the throughput, in megabits per second, of a single
+// bidirectional QUIC stream sending data over loopback.
+
+const common = require('../common.js');
+const bench = common.createBenchmark(main, {
+  dur: [5],
+  size: [1024, 16 * 1024, 64 * 1024],
+  packetSize: [1200, 1252],
+  loss: [0, 0.001],
+}, {
+  flags: ['--no-warnings'],
+  test: { packetSize: 1200 }
+});
+
+const fixtures = require('../../test/common/fixtures');
+
+const kWindow = 16 * 1024 * 1024;
+
+function main({ dur, size, packetSize, loss }) {
+  const { createQuicSocket } = require('net');
+
+  const options = {
+    key: fixtures.readKey('agent1-key.pem', 'binary'),
+    cert: fixtures.readKey('agent1-cert.pem', 'binary'),
+    ca: fixtures.readKey('ca1-cert.pem', 'binary'),
+    alpn: 'bench',
+    maxPacketSize: packetSize,
+    maxData: kWindow,
+    maxStreamDataBidiRemote: kWindow,
+  };
+
+  const chunk = Buffer.alloc(size, 'b');
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+  server.setDiagnosticPacketLoss({ rx: loss, tx: loss });
+
+  let received = 0;
+  server.on('session', (session) => {
+    session.on('stream', (stream) => {
+      stream.on('data', (data) => received += data.length);
+    });
+  });
+
+  server.listen();
+  server.on('ready', () => {
+    const req = client.connect({
+      address: 'localhost',
+      port: server.endpoints[0].address.port,
+    });
+
+    req.on('secure', () => {
+      const stream = req.openStream({ halfOpen: true });
+      stream.on('drain', write);
+      stream.on('error', () => {});
+
+      setTimeout(() => {
+        const mbits = (received * 8) / (1024 * 1024);
+        bench.end(mbits);
+        stream.destroy();
+        client.close();
+        server.close();
+      }, dur * 1000);
+      bench.start();
+      write();
+
+      function write() {
+        while (stream.write(chunk));
+      }
+    });
+  });
+}
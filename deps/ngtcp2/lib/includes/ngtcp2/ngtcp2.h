@@ -556,9 +556,12 @@ typedef struct ngtcp2_settings {
      NULL means no logging output. */
   ngtcp2_printf log_printf;
   /* token is a token received in Client Initial packet and
-     successfully validated.  Only server application may specify this
-     field.  Server then verifies that all Client Initial packets have
-     this token.  `ngtcp2_conn_server_new` makes a copy of token. */
+     successfully validated.  Server then verifies that all Client
+     Initial packets have this token.  `ngtcp2_conn_server_new` makes
+     a copy of token.  Client application may specify a token
+     received in a NEW_TOKEN frame in a previous connection, and the
+     client then sends it in its Initial packets.
+     `ngtcp2_conn_client_new` makes a copy of token. */
   ngtcp2_vec token;
 } ngtcp2_settings;
 
@@ -1018,6 +1021,50 @@ typedef int (*ngtcp2_handshake_completed)(ngtcp2_conn *conn, void *user_data);
  */
 typedef int (*ngtcp2_handshake_confirmed)(ngtcp2_conn *conn, void *user_data);
 
+/**
+ * @functypedef
+ *
+ * :type:`ngtcp2_recv_new_token` is invoked when client receives
+ * NEW_TOKEN frame.  |token| is the received token.  Client
+ * application may present the token in a future connection to the
+ * same server by specifying it in :member:`ngtcp2_settings.token`.
+ *
+ * The callback function must return 0 if it succeeds.  Returning
+ * :enum:`NGTCP2_ERR_CALLBACK_FAILURE` makes the library call return
+ * immediately.
+ */
+typedef int (*ngtcp2_recv_new_token)(ngtcp2_conn *conn,
+                                     const ngtcp2_vec *token,
+                                     void *user_data);
+
+/**
+ * @functypedef
+ *
+ * :type:`ngtcp2_acked_pmtud_probe` is invoked when a packet written
+ * by `ngtcp2_conn_write_pmtud_probe` is acknowledged.  |probelen| is
+ * the length of the acknowledged packet.
+ *
+ * The callback function must return 0 if it succeeds.  Returning
+ * :enum:`NGTCP2_ERR_CALLBACK_FAILURE` makes the library call return
+ * immediately.
+ */
+typedef int (*ngtcp2_acked_pmtud_probe)(ngtcp2_conn *conn, size_t probelen,
+                                        void *user_data);
+
+/**
+ * @functypedef
+ *
+ * :type:`ngtcp2_acked_pkt` is invoked when a packet that counts
+ * towards the bytes in flight is acknowledged.  |pktlen| is the
+ * length of the packet and |ts_sent| the time it was sent.
+ *
+ * The callback function must return 0 if it succeeds.  Returning
+ * :enum:`NGTCP2_ERR_CALLBACK_FAILURE` makes the library call return
+ * immediately.
+ */
+typedef int (*ngtcp2_acked_pkt)(ngtcp2_conn *conn, size_t pktlen,
+                                ngtcp2_tstamp ts_sent, void *user_data);
+
 /**
  * @functypedef
  *
@@ -1617,6 +1664,24 @@ typedef struct ngtcp2_conn_callbacks {
    * handshake confirmation for server.
    */
   ngtcp2_handshake_confirmed handshake_confirmed;
+  /**
+   * recv_new_token is a callback function which is invoked when
+   * client receives NEW_TOKEN frame.  This callback function is
+   * optional.
+   */
+  ngtcp2_recv_new_token recv_new_token;
+  /**
+   * acked_pmtud_probe is a callback function which is invoked when a
+   * packet written by `ngtcp2_conn_write_pmtud_probe` is
+   * acknowledged.  This callback function is optional.
+   */
+  ngtcp2_acked_pmtud_probe acked_pmtud_probe;
+  /**
+   * acked_pkt is a callback function which is invoked when a packet
+   * that counts towards the bytes in flight is acknowledged.  This
+   * callback function is optional.
+   */
+  ngtcp2_acked_pkt acked_pkt;
 } ngtcp2_conn_callbacks;
 
 /**
@@ -1783,6 +1848,38 @@ NGTCP2_EXTERN ngtcp2_ssize ngtcp2_conn_write_pkt(ngtcp2_conn *conn,
                                                  uint8_t *dest, size_t destlen,
                                                  ngtcp2_tstamp ts);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_write_pmtud_probe` writes a Short packet of exactly
+ * |probelen| bytes, which contains a PING frame and PADDING, to the
+ * buffer pointed by |dest| in order to discover whether the current
+ * path carries packets of that size.  The packet is ack-eliciting,
+ * and :type:`ngtcp2_acked_pmtud_probe` is invoked when it is
+ * acknowledged.  A lost probe is not retransmitted, and its loss is
+ * not taken as a congestion signal.
+ *
+ * If |path| is not ``NULL``, this function stores the network path
+ * with which the packet should be sent.
+ *
+ * This function returns 0 if a probe cannot be written at this time,
+ * because the handshake has not been confirmed, a path is being
+ * validated, a packet is being written, or the congestion window
+ * does not allow another |probelen| bytes in flight.  Otherwise, it
+ * returns the number of bytes written, or one of the following
+ * negative error codes:
+ *
+ * :enum:`NGTCP2_ERR_NOMEM`
+ *     Out of memory
+ * :enum:`NGTCP2_ERR_PKT_NUM_EXHAUSTED`
+ *     The packet number has reached at the maximum value.
+ */
+NGTCP2_EXTERN ngtcp2_ssize ngtcp2_conn_write_pmtud_probe(ngtcp2_conn *conn,
+                                                        ngtcp2_path *path,
+                                                        uint8_t *dest,
+                                                        size_t probelen,
+                                                        ngtcp2_tstamp ts);
+
 /**
  * @function
  *
@@ -2568,6 +2665,17 @@ ngtcp2_conn_get_rcvry_stat(ngtcp2_conn *conn);
  */
 NGTCP2_EXTERN const ngtcp2_cc_stat *ngtcp2_conn_get_cc_stat(ngtcp2_conn *conn);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_set_cc_window` replaces the congestion window and the
+ * slow start threshold computed by the built-in congestion
+ * controller.  It allows an application to run its own congestion
+ * controller on the congestion signals reported by ngtcp2.
+ */
+NGTCP2_EXTERN void ngtcp2_conn_set_cc_window(ngtcp2_conn *conn, uint64_t cwnd,
+                                             uint64_t ssthresh);
+
 /**
  * @function
  *
@@ -2607,6 +2715,24 @@ ngtcp2_conn_submit_crypto_data(ngtcp2_conn *conn,
                                ngtcp2_crypto_level crypto_level,
                                const uint8_t *data, const size_t datalen);
 
+/**
+ * @function
+ *
+ * `ngtcp2_conn_submit_new_token` submits address validation token
+ * |token| of length |tokenlen| to be sent to client in a NEW_TOKEN
+ * frame.  This function makes a copy of |token|.  Only server may
+ * call this function, and |tokenlen| must not be 0.
+ *
+ * This function returns 0 if it succeeds, or one of the following
+ * negative error codes:
+ *
+ * :enum:`NGTCP2_ERR_NOMEM`
+ *     Out of memory
+ */
+NGTCP2_EXTERN int ngtcp2_conn_submit_new_token(ngtcp2_conn *conn,
+                                               const uint8_t *token,
+                                               size_t tokenlen);
+
 /**
  * @function
  *
@@ -759,6 +759,18 @@ int ngtcp2_conn_client_new(ngtcp2_conn **pconn, const ngtcp2_cid *dcid,
   }
   (*pconn)->rcid = *dcid;
   (*pconn)->state = NGTCP2_CS_CLIENT_INITIAL;
+
+  if (settings->token.len) {
+    uint8_t *p = ngtcp2_mem_malloc(mem, settings->token.len);
+    if (p == NULL) {
+      ngtcp2_conn_del(*pconn);
+      return NGTCP2_ERR_NOMEM;
+    }
+    ngtcp2_buf_init(&(*pconn)->token, p, settings->token.len);
+    (*pconn)->token.last =
+        ngtcp2_cpymem(p, settings->token.base, settings->token.len);
+  }
+
   (*pconn)->local.bidi.next_stream_id = 0;
   (*pconn)->local.uni.next_stream_id = 2;
 
@@ -3702,7 +3714,9 @@ static int conn_on_retry(ngtcp2_conn *conn, const ngtcp2_pkt_hd *hd,
     return rv;
   }
 
-  assert(conn->token.begin == NULL);
+  /* Retry token replaces the token from NEW_TOKEN frame, if any. */
+  ngtcp2_mem_free(conn->mem, conn->token.begin);
+  conn->token.begin = NULL;
 
   p = ngtcp2_mem_malloc(conn->mem, retry.tokenlen);
   if (p == NULL) {
@@ -5993,14 +6007,30 @@ static int conn_recv_retire_connection_id(ngtcp2_conn *conn,
  *
  * NGTCP2_ERR_FRAME_ENCODING:
  *     Token is empty
+ * NGTCP2_ERR_PROTO:
+ *     Server received NEW_TOKEN.
+ * NGTCP2_ERR_CALLBACK_FAILURE:
+ *     User callback failed.
  */
 static int conn_recv_new_token(ngtcp2_conn *conn, const ngtcp2_new_token *fr) {
-  (void)conn;
+  ngtcp2_vec token;
+
+  if (conn->server) {
+    return NGTCP2_ERR_PROTO;
+  }
 
   if (fr->tokenlen == 0) {
     return NGTCP2_ERR_FRAME_ENCODING;
   }
-  /* TODO Not implemented yet*/
+
+  if (conn->callbacks.recv_new_token) {
+    token.base = (uint8_t *)fr->token;
+    token.len = fr->tokenlen;
+    if (conn->callbacks.recv_new_token(conn, &token, conn->user_data) != 0) {
+      return NGTCP2_ERR_CALLBACK_FAILURE;
+    }
+  }
+
   return 0;
 }
 
@@ -8445,6 +8475,119 @@ fin:
   return nwrite;
 }
 
+ngtcp2_ssize ngtcp2_conn_write_pmtud_probe(ngtcp2_conn *conn,
+                                           ngtcp2_path *path, uint8_t *dest,
+                                           size_t probelen, ngtcp2_tstamp ts) {
+  ngtcp2_ppe ppe;
+  ngtcp2_pkt_hd hd;
+  ngtcp2_pktns *pktns = &conn->pktns;
+  ngtcp2_crypto_cc cc;
+  ngtcp2_rtb_entry *ent;
+  ngtcp2_frame lfr;
+  int rv;
+  ngtcp2_ssize nwrite;
+
+  conn->log.last_ts = ts;
+  conn->qlog.last_ts = ts;
+
+  if (conn->state != NGTCP2_CS_POST_HANDSHAKE ||
+      !(conn->flags & NGTCP2_CONN_FLAG_HANDSHAKE_CONFIRMED) ||
+      (conn->flags & NGTCP2_CONN_FLAG_PPE_PENDING) || conn->pv ||
+      conn_cwnd_left(conn) < probelen) {
+    return 0;
+  }
+
+  assert(pktns->crypto.tx.ckm);
+
+  if (conn_check_pkt_num_exhausted(conn)) {
+    return NGTCP2_ERR_PKT_NUM_EXHAUSTED;
+  }
+
+  if (path) {
+    ngtcp2_path_copy(path, &conn->dcid.current.ps.path);
+  }
+
+  cc.aead_overhead = conn->crypto.aead_overhead;
+  cc.encrypt = conn->callbacks.encrypt;
+  cc.hp_mask = conn->callbacks.hp_mask;
+  cc.aead = pktns->crypto.ctx.aead;
+  cc.hp = pktns->crypto.ctx.hp;
+  cc.ckm = pktns->crypto.tx.ckm;
+  cc.hp_key = pktns->crypto.tx.hp_key;
+
+  ngtcp2_pkt_hd_init(
+      &hd,
+      (pktns->crypto.tx.ckm->flags & NGTCP2_CRYPTO_KM_FLAG_KEY_PHASE_ONE)
+          ? NGTCP2_PKT_FLAG_KEY_PHASE
+          : NGTCP2_PKT_FLAG_NONE,
+      NGTCP2_PKT_SHORT, &conn->dcid.current.cid, NULL,
+      pktns->tx.last_pkt_num + 1, pktns_select_pkt_numlen(pktns), conn->version,
+      0);
+
+  ngtcp2_ppe_init(&ppe, dest, probelen, &cc);
+
+  rv = ngtcp2_ppe_encode_hd(&ppe, &hd);
+  if (rv != 0) {
+    assert(NGTCP2_ERR_NOBUF == rv);
+    return 0;
+  }
+
+  if (!ngtcp2_ppe_ensure_hp_sample(&ppe)) {
+    return 0;
+  }
+
+  ngtcp2_log_tx_pkt_hd(&conn->log, &hd);
+  ngtcp2_qlog_pkt_sent_start(&conn->qlog, &hd);
+
+  lfr.type = NGTCP2_FRAME_PING;
+
+  rv = conn_ppe_write_frame(conn, &ppe, &hd, &lfr);
+  if (rv != 0) {
+    assert(NGTCP2_ERR_NOBUF == rv);
+    return 0;
+  }
+
+  /* The probe is padded to fill the whole buffer. */
+  lfr.type = NGTCP2_FRAME_PADDING;
+  lfr.padding.len = ngtcp2_ppe_padding(&ppe);
+  if (lfr.padding.len) {
+    ngtcp2_log_tx_fr(&conn->log, &hd, &lfr);
+    ngtcp2_qlog_write_frame(&conn->qlog, &lfr);
+  }
+
+  nwrite = ngtcp2_ppe_final(&ppe, NULL);
+  if (nwrite < 0) {
+    return nwrite;
+  }
+
+  ngtcp2_qlog_pkt_sent_end(&conn->qlog, &hd, (size_t)nwrite);
+
+  /* The probe has no frame chain so that nothing is retransmitted if
+     it is lost. */
+  rv = ngtcp2_rtb_entry_new(
+      &ent, &hd, NULL, ts, (size_t)nwrite,
+      NGTCP2_RTB_FLAG_ACK_ELICITING | NGTCP2_RTB_FLAG_PMTUD_PROBE, conn->mem);
+  if (rv != 0) {
+    return rv;
+  }
+
+  rv = conn_on_pkt_sent(conn, &pktns->rtb, ent);
+  if (rv != 0) {
+    ngtcp2_rtb_entry_del(ent, conn->mem);
+    return rv;
+  }
+
+  if (conn->flags & NGTCP2_CONN_FLAG_RESTART_IDLE_TIMER_ON_WRITE) {
+    conn_restart_timer_on_write(conn, ts);
+  }
+
+  ngtcp2_qlog_metrics_updated(&conn->qlog, &conn->rcs, &conn->ccs);
+
+  ++pktns->tx.last_pkt_num;
+
+  return nwrite;
+}
+
 ngtcp2_ssize ngtcp2_conn_write_connection_close(ngtcp2_conn *conn,
                                                 ngtcp2_path *path,
                                                 uint8_t *dest, size_t destlen,
@@ -8889,6 +9032,12 @@ const ngtcp2_cc_stat *ngtcp2_conn_get_cc_stat(ngtcp2_conn *conn) {
   return &conn->ccs;
 }
 
+void ngtcp2_conn_set_cc_window(ngtcp2_conn *conn, uint64_t cwnd,
+                               uint64_t ssthresh) {
+  conn->ccs.cwnd = cwnd;
+  conn->ccs.ssthresh = ssthresh;
+}
+
 static ngtcp2_pktns *conn_get_earliest_loss_time_pktns(ngtcp2_conn *conn) {
   ngtcp2_pktns *in_pktns = conn->in_pktns;
   ngtcp2_pktns *hs_pktns = conn->hs_pktns;
@@ -9118,6 +9267,33 @@ int ngtcp2_conn_on_loss_detection_timer(ngtcp2_conn *conn, ngtcp2_tstamp ts) {
   return 0;
 }
 
+int ngtcp2_conn_submit_new_token(ngtcp2_conn *conn, const uint8_t *token,
+                                 size_t tokenlen) {
+  ngtcp2_pktns *pktns = &conn->pktns;
+  ngtcp2_frame_chain *nfrc;
+  uint8_t *p;
+  int rv;
+
+  assert(conn->server);
+  assert(tokenlen);
+
+  rv = ngtcp2_frame_chain_extralen_new(&nfrc, tokenlen, conn->mem);
+  if (rv != 0) {
+    return rv;
+  }
+
+  p = (uint8_t *)nfrc + sizeof(*nfrc);
+  memcpy(p, token, tokenlen);
+
+  nfrc->fr.type = NGTCP2_FRAME_NEW_TOKEN;
+  nfrc->fr.new_token.token = p;
+  nfrc->fr.new_token.tokenlen = tokenlen;
+  nfrc->next = pktns->tx.frq;
+  pktns->tx.frq = nfrc;
+
+  return 0;
+}
+
 int ngtcp2_conn_submit_crypto_data(ngtcp2_conn *conn,
                                    ngtcp2_crypto_level crypto_level,
                                    const uint8_t *data, const size_t datalen) {
@@ -273,6 +273,22 @@ static int rtb_call_acked_stream_offset(ngtcp2_rtb *rtb, ngtcp2_rtb_entry *ent,
   size_t datalen;
   ngtcp2_strm *crypto = rtb->crypto;
 
+  if ((ent->flags & NGTCP2_RTB_FLAG_PMTUD_PROBE) &&
+      conn->callbacks.acked_pmtud_probe) {
+    rv = conn->callbacks.acked_pmtud_probe(conn, ent->pktlen, conn->user_data);
+    if (rv != 0) {
+      return NGTCP2_ERR_CALLBACK_FAILURE;
+    }
+  }
+
+  if (rtb->cc_pkt_num <= ent->hd.pkt_num && conn->callbacks.acked_pkt) {
+    rv = conn->callbacks.acked_pkt(conn, ent->pktlen, ent->ts,
+                                   conn->user_data);
+    if (rv != 0) {
+      return NGTCP2_ERR_CALLBACK_FAILURE;
+    }
+  }
+
   for (frc = ent->frc; frc; frc = frc->next) {
     switch (frc->fr.type) {
     case NGTCP2_FRAME_STREAM:
@@ -506,6 +522,7 @@ void ngtcp2_rtb_detect_lost_pkt(ngtcp2_rtb *rtb, ngtcp2_frame_chain **pfrc,
   ngtcp2_tstamp latest_ts, oldest_ts;
   int64_t last_lost_pkt_num;
   ngtcp2_ksl_key key;
+  int congested = 0;
 
   rtb->loss_time = UINT64_MAX;
   loss_delay = compute_pkt_loss_delay(rcs);
@@ -533,10 +550,19 @@ void ngtcp2_rtb_detect_lost_pkt(ngtcp2_rtb *rtb, ngtcp2_frame_chain **pfrc,
         }
 
         oldest_ts = ent->ts;
+        /* Path MTU discovery probes are likely to be lost because of
+           their size rather than because of congestion. */
+        if (!(ent->flags & NGTCP2_RTB_FLAG_PMTUD_PROBE)) {
+          congested = 1;
+        }
         rtb_on_remove(rtb, ent);
         rtb_on_pkt_lost(rtb, pfrc, ent);
       }
 
+      if (!congested) {
+        return;
+      }
+
       ngtcp2_default_cc_congestion_event(rtb->cc, latest_ts, ts);
 
       if (last_lost_pkt_num != -1) {
@@ -146,6 +146,9 @@ typedef enum {
   /* NGTCP2_RTB_FLAG_CRYPTO_TIMEOUT_RETRANSMITTED indicates that the
      CRYPTO frames have been retransmitted. */
   NGTCP2_RTB_FLAG_CRYPTO_TIMEOUT_RETRANSMITTED = 0x08,
+  /* NGTCP2_RTB_FLAG_PMTUD_PROBE indicates that the entry is a Path
+     MTU discovery probe packet. */
+  NGTCP2_RTB_FLAG_PMTUD_PROBE = 0x10,
 } ngtcp2_rtb_flag;
 
 struct ngtcp2_rtb_entry;
@@ -30,6 +30,7 @@ const {
 
 const errors = require('internal/errors');
 const {
+  kRecvMMsgSymbol,
   kStateSymbol,
   _createSocketHandle,
   newHandle,
@@ -91,6 +92,7 @@ function Socket(type, listener) {
   let lookup;
   let recvBufferSize;
   let sendBufferSize;
+  let recvmmsg = false;
 
   let options;
   if (type !== null && typeof type === 'object') {
@@ -99,9 +101,10 @@ function Socket(type, listener) {
     lookup = options.lookup;
     recvBufferSize = options.recvBufferSize;
     sendBufferSize = options.sendBufferSize;
+    recvmmsg = options[kRecvMMsgSymbol] === true;
   }
 
-  const handle = newHandle(type, lookup);
+  const handle = newHandle(type, lookup, recvmmsg);
   handle[owner_symbol] = this;
 
   this[async_id_symbol] = handle.getAsyncId();
@@ -5,12 +5,17 @@ const {
 } = primordials;
 
 const { codes } = require('internal/errors');
-const { UDP } = internalBinding('udp_wrap');
+const {
+  constants: { UV_UDP_RECVMMSG },
+  UDP,
+} = internalBinding('udp_wrap');
 const { guessHandleType } = internalBinding('util');
 const { isInt32 } = require('internal/validators');
 const { UV_EINVAL } = internalBinding('uv');
 const { ERR_INVALID_ARG_TYPE, ERR_SOCKET_BAD_TYPE } = codes;
 const kStateSymbol = Symbol('state symbol');
+// Internal-only option used by QUIC to read multiple datagrams per wakeup.
+const kRecvMMsgSymbol = Symbol('recvmmsg symbol');
 let dns;  // Lazy load for startup performance.
 
 
@@ -23,7 +28,7 @@ function lookup6(lookup, address, callback) {
   return lookup(address || '::1', 6, callback);
 }
 
-function newHandle(type, lookup) {
+function newHandle(type, lookup, recvmmsg = false) {
   if (lookup === undefined) {
     if (dns === undefined) {
       dns = require('dns');
@@ -34,15 +39,17 @@ function newHandle(type, lookup) {
     throw new ERR_INVALID_ARG_TYPE('lookup', 'Function', lookup);
   }
 
+  const flags = recvmmsg ? UV_UDP_RECVMMSG : 0;
+
   if (type === 'udp4') {
-    const handle = new UDP();
+    const handle = new UDP(flags);
 
     handle.lookup = lookup4.bind(handle, lookup);
     return handle;
   }
 
   if (type === 'udp6') {
-    const handle = new UDP();
+    const handle = new UDP(flags);
 
     handle.lookup = lookup6.bind(handle, lookup);
     handle.bind = handle.bind6;
@@ -80,6 +87,7 @@ function _createSocketHandle(address, port, addressType, fd, flags) {
 
 
 module.exports = {
+  kRecvMMsgSymbol,
   kStateSymbol,
   _createSocketHandle,
   newHandle
@@ -15,6 +15,7 @@ const {
   Boolean,
   Error,
   Map,
+  Number,
   RegExp,
   Set,
   Symbol,
@@ -34,6 +35,7 @@ const {
   validateQuicClientSessionOptions,
   validateQuicSocketOptions,
   validateQuicStreamOptions,
+  validateTicketKeys,
   validateQuicSocketListenOptions,
   validateQuicEndpointOptions,
   validateCreateSecureContextOptions,
@@ -43,6 +45,7 @@ const util = require('util');
 const assert = require('internal/assert');
 const EventEmitter = require('events');
 const fs = require('fs');
+const path = require('path');
 const fsPromisesInternal = require('internal/fs/promises');
 const { Duplex } = require('stream');
 const {
@@ -52,7 +55,6 @@ const {
   translatePeerCertificate
 } = require('_tls_common');
 const {
-  defaultTriggerAsyncIdScope,
   symbols: {
     async_id_symbol,
     owner_symbol,
@@ -69,6 +71,7 @@ const {
 
 const {
   constants: {
+    UDP_REUSEPORT,
     UV_UDP_IPV6ONLY,
     UV_UDP_REUSEADDR,
   }
@@ -86,9 +89,7 @@ const {
 } = require('internal/stream_base_commons');
 
 const {
-  ShutdownWrap,
-  kReadBytesOrError,
-  streamBaseState
+  ShutdownWrap
 } = internalBinding('stream_wrap');
 
 const {
@@ -113,9 +114,7 @@ const {
   exceptionWithHostPort
 } = require('internal/errors');
 
-const { FileHandle } = internalBinding('fs');
-const { StreamPipe } = internalBinding('stream_pipe');
-const { UV_EOF } = internalBinding('uv');
+const { isIP } = require('internal/net');
 
 const {
   QuicSocket: QuicSocketHandle,
@@ -129,6 +128,7 @@ const {
   constants: {
     AF_INET,
     AF_INET6,
+    DEFAULT_STREAM_URGENCY,
     IDX_QUIC_SESSION_MAX_PACKET_SIZE_DEFAULT,
     IDX_QUIC_SESSION_STATE_MAX_STREAMS_BIDI,
     IDX_QUIC_SESSION_STATE_MAX_STREAMS_UNI,
@@ -152,6 +152,15 @@ const {
     IDX_QUIC_SESSION_STATS_MIN_RTT,
     IDX_QUIC_SESSION_STATS_SMOOTHED_RTT,
     IDX_QUIC_SESSION_STATS_LATEST_RTT,
+    IDX_QUIC_SESSION_STATS_PACING_DELAY_COUNT,
+    IDX_QUIC_SESSION_STATS_PACING_DELAY_TIME,
+    IDX_QUIC_SESSION_STATS_CONGESTION_WINDOW,
+    IDX_QUIC_SESSION_STATS_SLOW_START_THRESHOLD,
+    IDX_QUIC_SESSION_STATS_PACING_RATE,
+    IDX_QUIC_SESSION_STATS_PATH_MTU,
+    IDX_QUIC_SESSION_STATS_PATH_MTU_PROBE_COUNT,
+    IDX_QUIC_SESSION_STATS_CONGESTION_CONTROL,
+    IDX_QUIC_SESSION_STATS_HANDSHAKE_OFFLOAD_COUNT,
     IDX_QUIC_STREAM_STATS_CREATED_AT,
     IDX_QUIC_STREAM_STATS_BYTES_RECEIVED,
     IDX_QUIC_STREAM_STATS_BYTES_SENT,
@@ -171,16 +180,34 @@ const {
     IDX_QUIC_SOCKET_STATS_CLIENT_SESSIONS,
     IDX_QUIC_SOCKET_STATS_STATELESS_RESET_COUNT,
     IDX_QUIC_SOCKET_STATS_SERVER_BUSY_COUNT,
+    IDX_QUIC_SOCKET_STATS_SEND_BATCH_COUNT,
+    IDX_QUIC_SOCKET_STATS_PACKET_POOL_HITS,
+    IDX_QUIC_SOCKET_STATS_PACKET_POOL_MISSES,
+    IDX_QUIC_SOCKET_STATS_QLOG_BYTES_DROPPED,
+    IDX_QUIC_SOCKET_STATS_RETRY_COUNT,
+    IDX_QUIC_SOCKET_STATS_NEW_TOKEN_COUNT,
+    IDX_QUIC_SOCKET_STATS_PACKETS_FORWARDED,
+    IDX_QUIC_SOCKET_STATS_EVENT_BATCH_COUNT,
+    IDX_QUIC_SOCKET_STATS_BATCHED_EVENT_COUNT,
     ERR_FAILED_TO_CREATE_SESSION,
     ERR_INVALID_REMOTE_TRANSPORT_PARAMS,
     ERR_INVALID_TLS_SESSION_TICKET,
     NGTCP2_PATH_VALIDATION_RESULT_FAILURE,
     NGTCP2_NO_ERROR,
     QUIC_ERROR_APPLICATION,
+    QUIC_CC_ALGORITHM_BBR,
+    QUIC_CC_ALGORITHM_CUBIC,
     QUICSERVERSESSION_OPTION_REJECT_UNAUTHORIZED,
     QUICSERVERSESSION_OPTION_REQUEST_CERT,
     QUICCLIENTSESSION_OPTION_REQUEST_OCSP,
     QUICCLIENTSESSION_OPTION_VERIFY_HOSTNAME_IDENTITY,
+    QUICSOCKET_EVENT_STREAM_READY,
+    QUICSOCKET_EVENT_STREAM_HEADERS,
+    QUICSOCKET_EVENT_STREAM_CLOSE,
+    QUICSOCKET_EVENT_STREAM_RESET,
+    QUICSOCKET_EVENT_STREAM_BLOCKED,
+    QUICSOCKET_OPTIONS_BATCH_EVENTS,
+    QUICSOCKET_OPTIONS_BATCH_SEND,
     QUICSOCKET_OPTIONS_VALIDATE_ADDRESS,
     QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU,
     QUICSTREAM_HEADERS_KIND_NONE,
@@ -190,6 +217,7 @@ const {
     QUICSTREAM_HEADERS_KIND_PUSH,
     QUICSTREAM_HEADER_FLAGS_NONE,
     QUICSTREAM_HEADER_FLAGS_TERMINAL,
+    kQuicSocketEventFields,
   }
 } = internalBinding('quic');
 
@@ -200,6 +228,7 @@ const {
 
 const {
   validateBoolean,
+  validateInt32,
   validateInteger,
   validateNumber,
   validateObject,
@@ -218,6 +247,7 @@ const kContinueConnect = Symbol('kContinueConnect');
 const kDestroy = Symbol('kDestroy');
 const kEndpointBound = Symbol('kEndpointBound');
 const kEndpointClose = Symbol('kEndpointClose');
+const kForwardingEndpoint = Symbol('kForwardingEndpoint');
 const kGetStreamOptions = Symbol('kGetStreamOptions');
 const kHandshake = Symbol('kHandshake');
 const kHandshakePost = Symbol('kHandshakePost');
@@ -524,11 +554,13 @@ function onStreamReady(streamHandle, id, push_id) {
   const uni = id & 0b10;
   const {
     highWaterMark,
+    writeHighWaterMark,
     defaultEncoding,
   } = session[kGetStreamOptions]();
   const stream = new QuicStream({
     writable: !uni,
     highWaterMark,
+    writeHighWaterMark,
     defaultEncoding,
   }, session, push_id);
   stream[kSetHandle](streamHandle);
@@ -576,10 +608,54 @@ function onStreamBlocked() {
   process.nextTick(emit.bind(this[owner_symbol], 'blocked'));
 }
 
+// Called by the C++ internals, when the QuicSocket is batching events,
+// with the stream events queued while receiving a batch of packets.
+// objects holds the handle each event is for followed by the event's
+// value, and records holds kQuicSocketEventFields numbers per event,
+// the first of which is the event type.
+function onSocketEvents(objects, records) {
+  for (let i = 0, n = 0; i < records.length;
+    i += kQuicSocketEventFields, n += 2) {
+    const handle = objects[n];
+    const value = objects[n + 1];
+    if (handle[owner_symbol] === undefined) {
+      // The session was destroyed after the event was queued.
+      if (records[i] === QUICSOCKET_EVENT_STREAM_READY)
+        value.destroy();
+      continue;
+    }
+    switch (records[i]) {
+      case QUICSOCKET_EVENT_STREAM_READY:
+        onStreamReady.call(handle, value, records[i + 1], records[i + 2]);
+        break;
+      case QUICSOCKET_EVENT_STREAM_HEADERS: {
+        const kind = records[i + 2];
+        onStreamHeaders.call(
+          handle,
+          records[i + 1],
+          value,
+          kind,
+          kind === QUICSTREAM_HEADERS_KIND_PUSH ? records[i + 3] : undefined);
+        break;
+      }
+      case QUICSOCKET_EVENT_STREAM_CLOSE:
+        onStreamClose.call(handle, records[i + 1], records[i + 2]);
+        break;
+      case QUICSOCKET_EVENT_STREAM_RESET:
+        onStreamReset.call(handle, records[i + 1], records[i + 2]);
+        break;
+      case QUICSOCKET_EVENT_STREAM_BLOCKED:
+        onStreamBlocked.call(handle);
+        break;
+    }
+  }
+}
+
 // Register the callbacks with the QUIC internal binding.
 setCallbacks({
   onSocketClose,
   onSocketError,
+  onSocketEvents,
   onSocketServerBusy,
   onSessionReady,
   onSessionCert,
@@ -621,10 +697,10 @@ function connectAfterLookup(type, err, ip) {
 // for new connections.
 function createSecureContext(options, init_cb) {
   const sc_options = validateCreateSecureContextOptions(options);
-  const { groups, earlyData } = sc_options;
+  const { groups, earlyData, offloadHandshake } = sc_options;
   const sc = _createSecureContext(sc_options);
   // TODO(@jasnell): Determine if it's really necessary to pass in groups here.
-  init_cb(sc.context, groups, earlyData);
+  init_cb(sc.context, groups, earlyData, offloadHandshake);
   return sc;
 }
 
@@ -648,6 +724,7 @@ class QuicEndpoint {
   #lookup = undefined;
   #port = undefined;
   #reuseAddr = undefined;
+  #reusePort = undefined;
   #type = undefined;
   #fd = undefined;
 
@@ -658,6 +735,7 @@ class QuicEndpoint {
       lookup,
       port = 0,
       reuseAddr,
+      reusePort,
       type,
       preferred,
     } = validateQuicEndpointOptions(options);
@@ -667,7 +745,12 @@ class QuicEndpoint {
     this.#lookup = lookup || (type === AF_INET6 ? lookup6 : lookup4);
     this.#port = port;
     this.#reuseAddr = !!reuseAddr;
-    this.#udpSocket = dgram.createSocket(type === AF_INET6 ? 'udp6' : 'udp4');
+    this.#reusePort = !!reusePort;
+    this.#udpSocket = dgram.createSocket({
+      type: type === AF_INET6 ? 'udp6' : 'udp4',
+      // Drain multiple datagrams per wakeup where the platform supports it.
+      [internalDgram.kRecvMMsgSymbol]: true,
+    });
 
     // kUDPHandleForTesting is only used in the Node.js test suite to
     // artificially test the endpoint. This code path should never be
@@ -681,7 +764,10 @@ class QuicEndpoint {
     const handle = new QuicEndpointHandle(socket[kHandle], udpHandle);
     handle[owner_symbol] = this;
     this[kHandle] = handle;
-    socket[kHandle].addEndpoint(handle, !!preferred);
+    socket[kHandle].addEndpoint(
+      handle,
+      !!preferred,
+      !!options[kForwardingEndpoint]);
   }
 
   [kInspect]() {
@@ -728,6 +814,7 @@ class QuicEndpoint {
     }
     const flags =
       (this.#reuseAddr ? UV_UDP_REUSEADDR : 0) |
+      (this.#reusePort ? UDP_REUSEPORT : 0) |
       (this.#ipv6Only ? UV_UDP_IPV6ONLY : 0);
 
     const ret = udpHandle.bind(ip, this.#port, flags);
@@ -886,6 +973,7 @@ class QuicSocket extends EventEmitter {
   #defaultEncoding = undefined;
   #endpoints = new Set();
   #highWaterMark = undefined;
+  #writeHighWaterMark = undefined;
   #lookup = undefined;
   #server = undefined;
   #serverBusy = false;
@@ -904,6 +992,14 @@ class QuicSocket extends EventEmitter {
       // closes
       autoClose,
 
+      // True if stream events for the packets received together should
+      // be passed from the C++ internals in a single callback
+      batchEvents,
+
+      // True if packets serialized during a single send pass should
+      // be flushed to the network together
+      batchSend,
+
       // Default configuration for QuicClientSessions
       client,
 
@@ -919,6 +1015,9 @@ class QuicSocket extends EventEmitter {
       // The maximum number of seconds for retry token
       retryTokenTimeout,
 
+      // How QuicSession and QuicStream histograms are allocated
+      histograms,
+
       // The DNS lookup function
       lookup,
 
@@ -934,14 +1033,43 @@ class QuicSocket extends EventEmitter {
       // True if an LRU should be used for add validation
       validateAddressLRU,
 
+      // The number of validated addresses remembered by the LRU
+      validateAddressLRUSize,
+
+      // The width of the sketches used for per-host accounting
+      addressSketchSize,
+
       // Whether qlog should be enabled for sessions
       qlog,
 
+      // The directory qlog files are written to. When not set,
+      // qlog output is emitted as 'qlog' events.
+      qlogDir,
+
+      // The fraction of sessions qlog is enabled for regardless
+      // of the qlog option
+      qlogSampleRate,
+
       // Stateless reset token secret (16 byte buffer)
       statelessResetSecret,
 
       // When true, stateless resets will not be sent (default false)
       disableStatelessReset,
+
+      // Session ticket key rotation interval in seconds
+      ticketKeyRotation,
+
+      // Session ticket key secret (32 byte buffer)
+      ticketKeySecret,
+
+      // Address validation token secret (16 byte buffer)
+      tokenSecret,
+
+      // The forwarding endpoints of a group of workers sharing a port
+      workerForwarding,
+
+      // The identifier of this QuicSocket within a group of workers
+      workerId,
     } = validateQuicSocketOptions(options);
     super({ captureRejections: true });
 
@@ -952,7 +1080,9 @@ class QuicSocket extends EventEmitter {
 
     const socketOptions =
       (validateAddress ? QUICSOCKET_OPTIONS_VALIDATE_ADDRESS : 0) |
-      (validateAddressLRU ? QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU : 0);
+      (validateAddressLRU ? QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU : 0) |
+      (batchSend ? QUICSOCKET_OPTIONS_BATCH_SEND : 0) |
+      (batchEvents ? QUICSOCKET_OPTIONS_BATCH_EVENTS : 0);
 
     this[kSetHandle](
       new QuicSocketHandle(
@@ -963,7 +1093,16 @@ class QuicSocket extends EventEmitter {
         maxStatelessResetsPerHost,
         qlog,
         statelessResetSecret,
-        disableStatelessReset));
+        disableStatelessReset,
+        qlogDir !== undefined ? path.resolve(qlogDir) : undefined,
+        qlogSampleRate,
+        histograms,
+        validateAddressLRUSize,
+        addressSketchSize,
+        tokenSecret,
+        workerId,
+        ticketKeySecret,
+        ticketKeyRotation));
 
     this.addEndpoint({
       lookup: this.#lookup,
@@ -973,6 +1112,26 @@ class QuicSocket extends EventEmitter {
       ...endpoint,
       preferred: true
     });
+
+    // Packets for connections owned by other workers of the group are
+    // forwarded to them, and packets forwarded by them are received,
+    // through a separate endpoint bound to this worker's entry.
+    if (workerForwarding !== undefined) {
+      workerForwarding.forEach(({ address, port }, id) => {
+        if (id === workerId)
+          return;
+        const ret = this[kHandle].addForwardingPeer(id, address, port);
+        if (ret !== 0)
+          throw exceptionWithHostPort(ret, 'addForwardingPeer', address, port);
+      });
+      const { address, port } = workerForwarding[workerId];
+      this.addEndpoint({
+        address,
+        port,
+        type: isIP(address) === 6 ? 'udp6' : 'udp4',
+        [kForwardingEndpoint]: true,
+      });
+    }
   }
 
   // Returns the default QuicStream options for peer-initiated
@@ -981,6 +1140,7 @@ class QuicSocket extends EventEmitter {
   [kGetStreamOptions]() {
     return {
       highWaterMark: this.#highWaterMark,
+      writeHighWaterMark: this.#writeHighWaterMark,
       defaultEncoding: this.#defaultEncoding,
     };
   }
@@ -1238,6 +1398,7 @@ class QuicSocket extends EventEmitter {
       alpn,
       defaultEncoding,
       highWaterMark,
+      writeHighWaterMark,
       transportParams,
     } = validateQuicSocketListenOptions(options);
 
@@ -1249,6 +1410,7 @@ class QuicSocket extends EventEmitter {
         initSecureContext);
 
     this.#highWaterMark = highWaterMark;
+    this.#writeHighWaterMark = writeHighWaterMark;
     this.#defaultEncoding = defaultEncoding;
     this.#serverListening = true;
     this.#alpn = alpn;
@@ -1552,6 +1714,21 @@ class QuicSocket extends EventEmitter {
     return stats[IDX_QUIC_SOCKET_STATS_PACKETS_IGNORED];
   }
 
+  get packetPoolHits() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_PACKET_POOL_HITS];
+  }
+
+  get packetPoolMisses() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_PACKET_POOL_MISSES];
+  }
+
+  get qlogBytesDropped() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_QLOG_BYTES_DROPPED];
+  }
+
   get serverBusy() {
     return this.#serverBusy;
   }
@@ -1576,6 +1753,36 @@ class QuicSocket extends EventEmitter {
     return stats[IDX_QUIC_SOCKET_STATS_SERVER_BUSY_COUNT];
   }
 
+  get sendBatchCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_SEND_BATCH_COUNT];
+  }
+
+  get retryCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_RETRY_COUNT];
+  }
+
+  get newTokenCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_NEW_TOKEN_COUNT];
+  }
+
+  get packetsForwarded() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_PACKETS_FORWARDED];
+  }
+
+  get eventBatchCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_EVENT_BATCH_COUNT];
+  }
+
+  get batchedEventCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SOCKET_STATS_BATCHED_EVENT_COUNT];
+  }
+
   // Diagnostic packet loss is a testing mechanism that allows simulating
   // pseudo-random packet loss for rx or tx. The value specified for each
   // option is a number between 0 and 1 that identifies the possibility of
@@ -1607,6 +1814,18 @@ class QuicSocket extends EventEmitter {
     this[kHandle].setDiagnosticPacketLoss(rx, tx);
   }
 
+  // Replaces the keys used to encrypt and decrypt TLS session tickets
+  // with the given ones. The first key encrypts new tickets. Explicit
+  // keys are not rotated automatically; rotating them is up to the
+  // caller, typically by calling setTicketKeys() again with a new key
+  // first, followed by the previous ones.
+  setTicketKeys(keys) {
+    if (this.#state === kSocketDestroyed)
+      throw new ERR_QUICSOCKET_DESTROYED('setTicketKeys');
+    validateTicketKeys(keys);
+    this[kHandle].setTicketKeys(keys);
+  }
+
   // Toggles stateless reset on/off. By default, stateless reset tokens
   // are generated when necessary. The disableStatelessReset option may
   // be used when the QuicSocket is created to disable generation of
@@ -1643,6 +1862,7 @@ class QuicSession extends EventEmitter {
   #handshakeAckHistogram = undefined;
   #handshakeContinuationHistogram = undefined;
   #highWaterMark = undefined;
+  #writeHighWaterMark = undefined;
   #defaultEncoding = undefined;
 
   constructor(socket, options) {
@@ -1650,6 +1870,7 @@ class QuicSession extends EventEmitter {
       alpn,
       servername,
       highWaterMark,
+      writeHighWaterMark,
       defaultEncoding,
     } = options;
     super({ captureRejections: true });
@@ -1659,6 +1880,7 @@ class QuicSession extends EventEmitter {
     this.#servername = servername;
     this.#alpn = alpn;
     this.#highWaterMark = highWaterMark;
+    this.#writeHighWaterMark = writeHighWaterMark;
     this.#defaultEncoding = defaultEncoding;
     socket[kAddSession](this);
   }
@@ -1668,6 +1890,7 @@ class QuicSession extends EventEmitter {
   [kGetStreamOptions]() {
     return {
       highWaterMark: this.#highWaterMark,
+      writeHighWaterMark: this.#writeHighWaterMark,
       defaultEncoding: this.#defaultEncoding,
     };
   }
@@ -1682,8 +1905,6 @@ class QuicSession extends EventEmitter {
     this[kHandle] = handle;
     if (handle !== undefined) {
       handle[owner_symbol] = this;
-      this.#handshakeAckHistogram = new Histogram(handle.ack);
-      this.#handshakeContinuationHistogram = new Histogram(handle.rate);
     } else {
       if (this.#handshakeAckHistogram)
         this.#handshakeAckHistogram[kDestroyHistogram]();
@@ -2091,11 +2312,13 @@ class QuicSession extends EventEmitter {
     const {
       halfOpen,  // Unidirectional or Bidirectional
       highWaterMark,
+      writeHighWaterMark,
       defaultEncoding,
     } = validateQuicStreamOptions(options);
 
     const stream = new QuicStream({
       highWaterMark,
+      writeHighWaterMark,
       defaultEncoding,
       readable: !halfOpen
     }, this);
@@ -2223,6 +2446,55 @@ class QuicSession extends EventEmitter {
     return stats[IDX_QUIC_SESSION_STATS_SMOOTHED_RTT];
   }
 
+  get pacingDelayCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_PACING_DELAY_COUNT];
+  }
+
+  get pacingDelayTime() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_PACING_DELAY_TIME];
+  }
+
+  get congestionControl() {
+    const stats = this.#stats || this[kHandle].stats;
+    switch (Number(stats[IDX_QUIC_SESSION_STATS_CONGESTION_CONTROL])) {
+      case QUIC_CC_ALGORITHM_CUBIC: return 'cubic';
+      case QUIC_CC_ALGORITHM_BBR: return 'bbr';
+      default: return 'newreno';
+    }
+  }
+
+  get congestionWindow() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_CONGESTION_WINDOW];
+  }
+
+  get slowStartThreshold() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_SLOW_START_THRESHOLD];
+  }
+
+  get pacingRate() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_PACING_RATE];
+  }
+
+  get pathMtu() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_PATH_MTU];
+  }
+
+  get pathMtuProbeCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_PATH_MTU_PROBE_COUNT];
+  }
+
+  get handshakeOffloadCount() {
+    const stats = this.#stats || this[kHandle].stats;
+    return stats[IDX_QUIC_SESSION_STATS_HANDSHAKE_OFFLOAD_COUNT];
+  }
+
   updateKey() {
     // Initiates a key update for the connection.
     if (this.#destroyed || this.#closing)
@@ -2232,11 +2504,22 @@ class QuicSession extends EventEmitter {
     return this[kHandle].updateKey();
   }
 
+  // Unless the QuicSocket was created with a different histograms
+  // option, the internal handle only allocates a histogram when
+  // it is first accessed.
   get handshakeAckHistogram() {
+    const handle = this[kHandle];
+    if (this.#handshakeAckHistogram === undefined && handle !== undefined)
+      this.#handshakeAckHistogram = new Histogram(handle.ack);
     return this.#handshakeAckHistogram;
   }
 
   get handshakeContinuationHistogram() {
+    const handle = this[kHandle];
+    if (this.#handshakeContinuationHistogram === undefined &&
+        handle !== undefined) {
+      this.#handshakeContinuationHistogram = new Histogram(handle.rate);
+    }
     return this.#handshakeContinuationHistogram;
   }
 
@@ -2253,9 +2536,10 @@ class QuicServerSession extends QuicSession {
   constructor(socket, handle, options) {
     const {
       highWaterMark,
+      writeHighWaterMark,
       defaultEncoding,
     } = options;
-    super(socket, { highWaterMark, defaultEncoding });
+    super(socket, { highWaterMark, writeHighWaterMark, defaultEncoding });
     this[kSetHandle](handle);
 
     // Both the handle and socket are immediately usable
@@ -2356,6 +2640,7 @@ class QuicClientSession extends QuicSession {
       verifyHostnameIdentity,
       qlog,
       highWaterMark,
+      writeHighWaterMark,
       defaultEncoding,
     } = validateQuicClientSessionOptions(options);
 
@@ -2368,7 +2653,13 @@ class QuicClientSession extends QuicSession {
       );
     }
 
-    super(socket, { servername, alpn, highWaterMark, defaultEncoding });
+    super(socket, {
+      servername,
+      alpn,
+      highWaterMark,
+      writeHighWaterMark,
+      defaultEncoding
+    });
     this.#autoStart = autoStart;
     this.#handshakeStarted = autoStart;
     this.#dcid = dcid;
@@ -2572,17 +2863,20 @@ class QuicStream extends Duplex {
   #didRead = false;
   #id = undefined;
   #highWaterMark = undefined;
+  #writeHighWaterMark = undefined;
   #push_id = undefined;
   #resetCode = undefined;
   #session = undefined;
   #dataRateHistogram = undefined;
   #dataSizeHistogram = undefined;
   #dataAckHistogram = undefined;
+  #priority = undefined;
   #stats = undefined;
 
   constructor(options, session, push_id) {
     const {
       highWaterMark,
+      writeHighWaterMark,
       defaultEncoding,
     } = options;
     super({
@@ -2595,6 +2889,7 @@ class QuicStream extends Duplex {
       captureRejections: true,
     });
     this.#highWaterMark = highWaterMark;
+    this.#writeHighWaterMark = writeHighWaterMark;
     this.#defaultEncoding = defaultEncoding;
     this.#session = session;
     this.#push_id = push_id;
@@ -2641,9 +2936,12 @@ class QuicStream extends Duplex {
       handle[owner_symbol] = this;
       this[async_id_symbol] = handle.getAsyncId();
       this.#id = handle.id();
-      this.#dataRateHistogram = new Histogram(handle.rate);
-      this.#dataSizeHistogram = new Histogram(handle.size);
-      this.#dataAckHistogram = new Histogram(handle.ack);
+      if (this.#priority !== undefined) {
+        const { urgency, incremental } = this.#priority;
+        handle.setPriority(urgency, incremental);
+      }
+      if (this.#writeHighWaterMark !== undefined)
+        handle.setWriteHighWaterMark(this.#writeHighWaterMark);
       this.uncork();
       this.emit('ready');
     } else {
@@ -2893,6 +3191,7 @@ class QuicStream extends Duplex {
       fd = fd.fd;
     else if (typeof fd !== 'number')
       throw new ERR_INVALID_ARG_TYPE('fd', ['number', 'FileHandle'], fd);
+    validateInt32(fd, 'fd', 0);
 
     if (this.pending) {
       return this.once('ready', () => {
@@ -2901,48 +3200,27 @@ class QuicStream extends Duplex {
     }
 
     this[kUpdateTimer]();
-    this.ownsFd = ownsFd;
 
     // Close the writable side of the stream, but only as far as the writable
-    // stream implementation is concerned.
+    // stream implementation is concerned. The file is read and sent by the
+    // internal handle, which closes the writable side once it is done.
     this._final = null;
     this.end();
 
-    defaultTriggerAsyncIdScope(this[async_id_symbol],
-                               QuicStream.#startFilePipe,
-                               this, fd, offset, length);
-  }
-
-  static #startFilePipe = (stream, fd, offset, length) => {
-    const handle = new FileHandle(fd, offset, length);
-    handle.onread = QuicStream.#onPipedFileHandleRead;
-    handle.stream = stream;
-
-    const pipe = new StreamPipe(handle, stream[kHandle]);
-    pipe.onunpipe = QuicStream.#onFileUnpipe;
-    pipe.start();
+    const err = this[kHandle].sendFD(fd, offset, length, ownsFd);
+    if (err < 0) {
+      if (ownsFd)
+        fs.close(fd, () => {});
+      this.destroy(errnoException(err, 'sendFD'));
+      return;
+    }
 
     // Exact length of the file doesn't matter here, since the
     // stream is closing anyway - just use 1 to signify that
     // a write does exist
-    stream[kTrackWriteState](stream, 1);
+    this[kTrackWriteState](this, 1);
   }
 
-  static #onFileUnpipe = function() {  // Called on the StreamPipe instance.
-    const stream = this.sink[owner_symbol];
-    if (stream.ownsFd)
-      this.source.close().catch(stream.destroy.bind(stream));
-    else
-      this.source.releaseFD();
-  };
-
-  static #onPipedFileHandleRead = function() {
-    const err = streamBaseState[kReadBytesOrError];
-    if (err < 0 && err !== UV_EOF) {
-      this.stream.destroy(errnoException(err, 'sendFD'));
-    }
-  };
-
   get resetReceived() {
     return (this.#resetCode !== undefined) ?
       { code: this.#resetCode | 0 } :
@@ -2950,8 +3228,11 @@ class QuicStream extends Duplex {
   }
 
   get bufferSize() {
-    // TODO(@jasnell): Implement this
-    return undefined;
+    // Data not yet passed on to the internal handle, plus data whose
+    // writes have completed but that the peer has not acknowledged.
+    if (this.destroyed || this[kHandle] === undefined)
+      return this.writableLength;
+    return this.writableLength + this[kHandle].getBufferSize();
   }
 
   get id() {
@@ -2962,6 +3243,37 @@ class QuicStream extends Duplex {
     return this.#push_id;
   }
 
+  get priority() {
+    const handle = this[kHandle];
+    if (handle === undefined || this.destroyed) {
+      return {
+        urgency: DEFAULT_STREAM_URGENCY,
+        incremental: false,
+        ...this.#priority
+      };
+    }
+    const [urgency, incremental] = handle.getPriority();
+    return { urgency, incremental };
+  }
+
+  setPriority(options = {}) {
+    if (this.destroyed)
+      throw new ERR_QUICSTREAM_DESTROYED('setPriority');
+    validateObject(options, 'options');
+    const {
+      urgency = DEFAULT_STREAM_URGENCY,
+      incremental = false,
+    } = options;
+    // Urgency levels follow those of HTTP extensible priorities.
+    validateInteger(urgency, 'options.urgency', /* min */ 0, /* max */ 7);
+    validateBoolean(incremental, 'options.incremental');
+
+    // The priority is applied once the handle has been created.
+    this.#priority = { urgency, incremental };
+    if (this[kHandle] !== undefined)
+      this[kHandle].setPriority(urgency, incremental);
+  }
+
   close(code) {
     this[kClose](QUIC_ERROR_APPLICATION, code);
   }
@@ -2978,6 +3290,8 @@ class QuicStream extends Duplex {
     // will segfault and crash the process.
     if (handle !== undefined) {
       this.#stats = new BigInt64Array(handle.stats);
+      const [urgency, incremental] = handle.getPriority();
+      this.#priority = { urgency, incremental };
       handle.destroy();
     }
     // The destroy callback must be invoked in a nextTick
@@ -2988,15 +3302,27 @@ class QuicStream extends Duplex {
     // TODO(@jasnell): Implement this
   }
 
+  // Unless the QuicSocket was created with a different histograms
+  // option, the internal handle only allocates a histogram when
+  // it is first accessed.
   get dataRateHistogram() {
+    const handle = this[kHandle];
+    if (this.#dataRateHistogram === undefined && handle !== undefined)
+      this.#dataRateHistogram = new Histogram(handle.rate);
     return this.#dataRateHistogram;
   }
 
   get dataSizeHistogram() {
+    const handle = this[kHandle];
+    if (this.#dataSizeHistogram === undefined && handle !== undefined)
+      this.#dataSizeHistogram = new Histogram(handle.size);
     return this.#dataSizeHistogram;
   }
 
   get dataAckHistogram() {
+    const handle = this[kHandle];
+    if (this.#dataAckHistogram === undefined && handle !== undefined)
+      this.#dataAckHistogram = new Histogram(handle.ack);
     return this.#dataAckHistogram;
   }
 
@@ -3006,6 +3332,7 @@ class QuicStream extends Duplex {
 
     const {
       highWaterMark = this.#highWaterMark,
+      writeHighWaterMark = this.#writeHighWaterMark,
       defaultEncoding = this.#defaultEncoding,
     } = validateQuicStreamOptions(options);
 
@@ -3040,6 +3367,7 @@ class QuicStream extends Duplex {
     const stream = new QuicStream({
       readable: false,
       highWaterMark,
+      writeHighWaterMark,
       defaultEncoding,
     }, this.session);
 
@@ -1,9 +1,14 @@
 'use strict';
 
+const {
+  ArrayIsArray,
+} = primordials;
+
 const {
   codes: {
     ERR_INVALID_ARG_TYPE,
     ERR_INVALID_ARG_VALUE,
+    ERR_OUT_OF_RANGE,
     ERR_QUICSESSION_INVALID_DCID,
     ERR_QUICSOCKET_INVALID_STATELESS_RESET_SECRET_LENGTH,
   },
@@ -30,11 +35,15 @@ const {
     AF_INET,
     AF_INET6,
     NGTCP2_ALPN_H3,
+    DEFAULT_ADDRESS_SKETCH_SIZE,
     DEFAULT_RETRYTOKEN_EXPIRATION,
     DEFAULT_MAX_CONNECTIONS,
     DEFAULT_MAX_CONNECTIONS_PER_HOST,
     DEFAULT_MAX_STATELESS_RESETS_PER_HOST,
+    DEFAULT_TICKET_KEY_ROTATION,
+    DEFAULT_VALIDATE_ADDRESS_LRU_SIZE,
     IDX_QUIC_SESSION_ACTIVE_CONNECTION_ID_LIMIT,
+    IDX_QUIC_SESSION_CC_ALGORITHM,
     IDX_QUIC_SESSION_MAX_STREAM_DATA_BIDI_LOCAL,
     IDX_QUIC_SESSION_MAX_STREAM_DATA_BIDI_REMOTE,
     IDX_QUIC_SESSION_MAX_STREAM_DATA_UNI,
@@ -43,6 +52,7 @@ const {
     IDX_QUIC_SESSION_MAX_STREAMS_UNI,
     IDX_QUIC_SESSION_MAX_IDLE_TIMEOUT,
     IDX_QUIC_SESSION_MAX_ACK_DELAY,
+    IDX_QUIC_SESSION_MAX_PACING_BURST,
     IDX_QUIC_SESSION_MAX_PACKET_SIZE,
     IDX_QUIC_SESSION_CONFIG_COUNT,
     IDX_QUIC_SESSION_STATE_CERT_ENABLED,
@@ -57,11 +67,24 @@ const {
     IDX_HTTP3_MAX_HEADER_PAIRS,
     IDX_HTTP3_MAX_HEADER_LENGTH,
     IDX_HTTP3_CONFIG_COUNT,
+    MAX_ADDRESS_SKETCH_SIZE,
     MAX_RETRYTOKEN_EXPIRATION,
+    MAX_TICKET_KEY_ROTATION,
+    MAX_TICKET_KEYS,
+    MAX_VALIDATE_ADDRESS_LRU_SIZE,
+    MAX_WORKER_ID,
+    MIN_ADDRESS_SKETCH_SIZE,
     MIN_RETRYTOKEN_EXPIRATION,
+    MIN_TICKET_KEY_ROTATION,
     NGTCP2_NO_ERROR,
     NGTCP2_MAX_CIDLEN,
     NGTCP2_MIN_CIDLEN,
+    QUIC_CC_ALGORITHM_BBR,
+    QUIC_CC_ALGORITHM_CUBIC,
+    QUIC_CC_ALGORITHM_NEWRENO,
+    QUIC_HISTOGRAM_MODE_EAGER,
+    QUIC_HISTOGRAM_MODE_LAZY,
+    QUIC_HISTOGRAM_MODE_SHARED,
     QUIC_PREFERRED_ADDRESS_IGNORE,
     QUIC_PREFERRED_ADDRESS_USE,
     QUIC_ERROR_APPLICATION,
@@ -98,6 +121,26 @@ function getSocketType(type = 'udp4') {
   throw new ERR_INVALID_ARG_VALUE('options.type', type);
 }
 
+function getCongestionControl(algorithm) {
+  validateString(algorithm, 'options.congestionControl');
+  switch (algorithm) {
+    case 'newreno': return QUIC_CC_ALGORITHM_NEWRENO;
+    case 'cubic': return QUIC_CC_ALGORITHM_CUBIC;
+    case 'bbr': return QUIC_CC_ALGORITHM_BBR;
+  }
+  throw new ERR_INVALID_ARG_VALUE('options.congestionControl', algorithm);
+}
+
+function getHistogramMode(mode) {
+  validateString(mode, 'options.histograms');
+  switch (mode) {
+    case 'lazy': return QUIC_HISTOGRAM_MODE_LAZY;
+    case 'eager': return QUIC_HISTOGRAM_MODE_EAGER;
+    case 'shared': return QUIC_HISTOGRAM_MODE_SHARED;
+  }
+  throw new ERR_INVALID_ARG_VALUE('options.histograms', mode);
+}
+
 function lookup4(address, callback) {
   const { lookup } = lazyDNS();
   lookup(address || '127.0.0.1', 4, callback);
@@ -153,6 +196,8 @@ function validateTransportParams(params) {
     idleTimeout,
     maxPacketSize,
     maxAckDelay,
+    maxPacingBurst,
+    congestionControl,
     preferredAddress,
     rejectUnauthorized,
     requestCert,
@@ -227,6 +272,14 @@ function validateTransportParams(params) {
       'options.maxAckDelay',
       /* min */ 0);
   }
+  if (maxPacingBurst !== undefined) {
+    validateInteger(
+      maxPacingBurst,
+      'options.maxPacingBurst',
+      /* min */ 1);
+  }
+  const ccAlgorithm = congestionControl !== undefined ?
+    getCongestionControl(congestionControl) : undefined;
   if (qpackMaxTableCapacity !== undefined) {
     validateInteger(
       qpackMaxTableCapacity,
@@ -277,6 +330,8 @@ function validateTransportParams(params) {
     idleTimeout,
     maxPacketSize,
     maxAckDelay,
+    maxPacingBurst,
+    ccAlgorithm,
     preferredAddress,
     rejectUnauthorized,
     requestCert,
@@ -310,6 +365,7 @@ function validateQuicClientSessionOptions(options = {}) {
     verifyHostnameIdentity = true,
     qlog = false,
     highWaterMark,
+    writeHighWaterMark,
     defaultEncoding,
   } = options;
 
@@ -383,7 +439,11 @@ function validateQuicClientSessionOptions(options = {}) {
     sessionTicket,
     verifyHostnameIdentity,
     qlog,
-    ...validateQuicStreamOptions({ highWaterMark, defaultEncoding })
+    ...validateQuicStreamOptions({
+      highWaterMark,
+      writeHighWaterMark,
+      defaultEncoding
+    })
   };
 }
 
@@ -393,6 +453,7 @@ function validateQuicStreamOptions(options = {}) {
     defaultEncoding = 'utf8',
     halfOpen,
     highWaterMark,
+    writeHighWaterMark,
   } = options;
   if (!Buffer.isEncoding(defaultEncoding)) {
     throw new ERR_INVALID_ARG_VALUE(
@@ -408,10 +469,17 @@ function validateQuicStreamOptions(options = {}) {
       'options.highWaterMark',
       /* min */ 0);
   }
+  if (writeHighWaterMark !== undefined) {
+    validateInteger(
+      writeHighWaterMark,
+      'options.writeHighWaterMark',
+      /* min */ 1);
+  }
   return {
     defaultEncoding,
     halfOpen,
     highWaterMark,
+    writeHighWaterMark,
   };
 }
 
@@ -425,6 +493,7 @@ function validateQuicEndpointOptions(options = {}, name = 'options') {
     lookup,
     port = 0,
     reuseAddr = false,
+    reusePort = false,
     type = 'udp4',
     preferred = false,
   } = options;
@@ -435,6 +504,7 @@ function validateQuicEndpointOptions(options = {}, name = 'options') {
   validateLookup(lookup);
   validateBoolean(ipv6Only, 'options.ipv6Only');
   validateBoolean(reuseAddr, 'options.reuseAddr');
+  validateBoolean(reusePort, 'options.reusePort');
   validateBoolean(preferred, 'options.preferred');
   return {
     address,
@@ -443,29 +513,90 @@ function validateQuicEndpointOptions(options = {}, name = 'options') {
     port,
     preferred,
     reuseAddr,
+    reusePort,
     type: getSocketType(type),
   };
 }
 
+// Returns the forwarding endpoints of a group of workers, indexed by
+// worker id. Each is identified by an IP address rather than a host
+// name because the address that forwarded packets are received from
+// must match it exactly.
+// Session ticket keys are given as a single buffer of one or more
+// 48 byte keys, in the same format as tls ticketKeys.
+function validateTicketKeys(keys) {
+  validateBuffer(keys, 'keys');
+  if (keys.length === 0 ||
+      keys.length % 48 !== 0 ||
+      keys.length / 48 > MAX_TICKET_KEYS) {
+    throw new ERR_INVALID_ARG_VALUE(
+      'keys',
+      keys,
+      `must be between 1 and ${MAX_TICKET_KEYS} keys of 48 bytes each`);
+  }
+}
+
+function validateWorkerForwarding(workerForwarding, workerId) {
+  const name = 'options.workerForwarding';
+  if (!ArrayIsArray(workerForwarding))
+    throw new ERR_INVALID_ARG_TYPE(name, 'Array', workerForwarding);
+  if (workerId === undefined ||
+      workerForwarding.length <= workerId ||
+      workerForwarding.length > MAX_WORKER_ID + 1) {
+    throw new ERR_INVALID_ARG_VALUE(
+      name,
+      workerForwarding,
+      'must have one entry for each worker, including options.workerId');
+  }
+  const peers = [];
+  for (let n = 0; n < workerForwarding.length; n++) {
+    const peer = workerForwarding[n];
+    validateObject(peer, `${name}[${n}]`);
+    const { address, port } = peer;
+    validateString(address, `${name}[${n}].address`);
+    if (!isIP(address)) {
+      throw new ERR_INVALID_ARG_VALUE(
+        `${name}[${n}].address`,
+        address,
+        'must be an IP address');
+    }
+    validatePort(port, `${name}[${n}].port`, { allowZero: false });
+    peers.push({ address, port: +port });
+  }
+  return peers;
+}
+
 function validateQuicSocketOptions(options = {}) {
   validateObject(options, 'options');
 
   const {
+    addressSketchSize = DEFAULT_ADDRESS_SKETCH_SIZE,
     autoClose = false,
+    batchEvents = false,
+    batchSend = false,
     client = {},
     disableStatelessReset = false,
     endpoint = { port: 0, type: 'udp4' },
+    histograms = 'lazy',
     lookup,
     maxConnections = DEFAULT_MAX_CONNECTIONS,
     maxConnectionsPerHost = DEFAULT_MAX_CONNECTIONS_PER_HOST,
     maxStatelessResetsPerHost = DEFAULT_MAX_STATELESS_RESETS_PER_HOST,
     qlog = false,
+    qlogDir,
+    qlogSampleRate = 0,
     retryTokenTimeout = DEFAULT_RETRYTOKEN_EXPIRATION,
     server = {},
     statelessResetSecret,
+    ticketKeyRotation = DEFAULT_TICKET_KEY_ROTATION,
+    ticketKeySecret,
+    tokenSecret,
     type = endpoint.type || 'udp4',
     validateAddressLRU = false,
+    validateAddressLRUSize = DEFAULT_VALIDATE_ADDRESS_LRU_SIZE,
     validateAddress = false,
+    workerForwarding,
+    workerId,
   } = options;
 
   validateQuicEndpointOptions(endpoint, 'options.endpoint');
@@ -476,8 +607,19 @@ function validateQuicSocketOptions(options = {}) {
   validateBoolean(validateAddress, 'options.validateAddress');
   validateBoolean(validateAddressLRU, 'options.validateAddressLRU');
   validateBoolean(autoClose, 'options.autoClose');
+  validateBoolean(batchEvents, 'options.batchEvents');
+  validateBoolean(batchSend, 'options.batchSend');
   validateBoolean(qlog, 'options.qlog');
   validateBoolean(disableStatelessReset, 'options.disableStatelessReset');
+  if (qlogDir !== undefined)
+    validateString(qlogDir, 'options.qlogDir');
+  validateNumber(qlogSampleRate, 'options.qlogSampleRate');
+  if (!(qlogSampleRate >= 0 && qlogSampleRate <= 1)) {
+    throw new ERR_OUT_OF_RANGE(
+      'options.qlogSampleRate',
+      '>= 0 and <= 1',
+      qlogSampleRate);
+  }
 
   if (retryTokenTimeout !== undefined) {
     validateInteger(
@@ -504,6 +646,16 @@ function validateQuicSocketOptions(options = {}) {
       'options.maxStatelessResetsPerHost',
       /* min */ 1);
   }
+  validateInteger(
+    validateAddressLRUSize,
+    'options.validateAddressLRUSize',
+    /* min */ 1,
+    /* max */ MAX_VALIDATE_ADDRESS_LRU_SIZE);
+  validateInteger(
+    addressSketchSize,
+    'options.addressSketchSize',
+    /* min */ MIN_ADDRESS_SKETCH_SIZE,
+    /* max */ MAX_ADDRESS_SKETCH_SIZE);
 
   if (statelessResetSecret !== undefined) {
     validateBuffer(statelessResetSecret, 'options.statelessResetSecret');
@@ -511,10 +663,45 @@ function validateQuicSocketOptions(options = {}) {
       throw new ERR_QUICSOCKET_INVALID_STATELESS_RESET_SECRET_LENGTH();
   }
 
+  if (tokenSecret !== undefined) {
+    validateBuffer(tokenSecret, 'options.tokenSecret');
+    if (tokenSecret.length !== 16) {
+      throw new ERR_INVALID_ARG_VALUE(
+        'options.tokenSecret',
+        tokenSecret,
+        'must be 16 bytes long');
+    }
+  }
+
+  if (ticketKeySecret !== undefined) {
+    validateBuffer(ticketKeySecret, 'options.ticketKeySecret');
+    if (ticketKeySecret.length !== 32) {
+      throw new ERR_INVALID_ARG_VALUE(
+        'options.ticketKeySecret',
+        ticketKeySecret,
+        'must be 32 bytes long');
+    }
+  }
+  validateInteger(
+    ticketKeyRotation,
+    'options.ticketKeyRotation',
+    /* min */ MIN_TICKET_KEY_ROTATION,
+    /* max */ MAX_TICKET_KEY_ROTATION);
+
+  if (workerId !== undefined)
+    validateInteger(workerId, 'options.workerId', 0, MAX_WORKER_ID);
+  let forwarding;
+  if (workerForwarding !== undefined)
+    forwarding = validateWorkerForwarding(workerForwarding, workerId);
+
   return {
     endpoint,
+    addressSketchSize,
     autoClose,
+    batchEvents,
+    batchSend,
     client,
+    histograms: getHistogramMode(histograms),
     lookup,
     maxConnections,
     maxConnectionsPerHost,
@@ -524,9 +711,17 @@ function validateQuicSocketOptions(options = {}) {
     type: getSocketType(type),
     validateAddress: validateAddress || validateAddressLRU,
     validateAddressLRU,
+    validateAddressLRUSize,
     qlog,
+    qlogDir,
+    qlogSampleRate,
     statelessResetSecret,
     disableStatelessReset,
+    ticketKeyRotation,
+    ticketKeySecret,
+    tokenSecret,
+    workerForwarding: forwarding,
+    workerId,
   };
 }
 
@@ -536,6 +731,7 @@ function validateQuicSocketListenOptions(options = {}) {
     alpn = NGTCP2_ALPN_H3,
     defaultEncoding,
     highWaterMark,
+    writeHighWaterMark,
     requestCert,
     rejectUnauthorized,
   } = options;
@@ -556,7 +752,11 @@ function validateQuicSocketListenOptions(options = {}) {
     rejectUnauthorized,
     requestCert,
     transportParams,
-    ...validateQuicStreamOptions({ highWaterMark, defaultEncoding })
+    ...validateQuicStreamOptions({
+      highWaterMark,
+      writeHighWaterMark,
+      defaultEncoding
+    })
   };
 }
 
@@ -588,6 +788,7 @@ function validateCreateSecureContextOptions(options = {}) {
     honorCipherOrder,
     key,
     earlyData = true,  // Early data is enabled by default
+    offloadHandshake = false,
     passphrase,
     pfx,
     sessionIdContext,
@@ -597,6 +798,7 @@ function validateCreateSecureContextOptions(options = {}) {
   validateString(groups, 'option.groups');
   if (earlyData !== undefined)
     validateBoolean(earlyData, 'option.earlyData');
+  validateBoolean(offloadHandshake, 'option.offloadHandshake');
 
   // Additional validation occurs within the tls
   // createSecureContext function.
@@ -612,6 +814,7 @@ function validateCreateSecureContextOptions(options = {}) {
     honorCipherOrder,
     key,
     earlyData,
+    offloadHandshake,
     passphrase,
     pfx,
     sessionIdContext,
@@ -642,6 +845,8 @@ function setTransportParams(config) {
     idleTimeout,
     maxPacketSize,
     maxAckDelay,
+    maxPacingBurst,
+    ccAlgorithm,
     h3: {
       qpackMaxTableCapacity,
       qpackBlockedStreams,
@@ -683,7 +888,13 @@ function setTransportParams(config) {
                                IDX_QUIC_SESSION_MAX_ACK_DELAY) |
                 setConfigField(sessionConfig,
                                maxPacketSize,
-                               IDX_QUIC_SESSION_MAX_PACKET_SIZE);
+                               IDX_QUIC_SESSION_MAX_PACKET_SIZE) |
+                setConfigField(sessionConfig,
+                               maxPacingBurst,
+                               IDX_QUIC_SESSION_MAX_PACING_BURST) |
+                setConfigField(sessionConfig,
+                               ccAlgorithm,
+                               IDX_QUIC_SESSION_CC_ALGORITHM);
 
   sessionConfig[IDX_QUIC_SESSION_CONFIG_COUNT] = flags;
 
@@ -748,6 +959,7 @@ module.exports = {
   validateTransportParams,
   validateQuicClientSessionOptions,
   validateQuicSocketOptions,
+  validateTicketKeys,
   validateQuicStreamOptions,
   validateQuicSocketListenOptions,
   validateQuicEndpointOptions,
@@ -897,7 +897,9 @@
             'src/node_bob-inl.h',
             'src/quic/node_quic_buffer.h',
             'src/quic/node_quic_buffer-inl.h',
+            'src/quic/node_quic_congestion.h',
             'src/quic/node_quic_crypto.h',
+            'src/quic/node_quic_qlog.h',
             'src/quic/node_quic_session.h',
             'src/quic/node_quic_session-inl.h',
             'src/quic/node_quic_socket.h',
@@ -910,10 +912,13 @@
             'src/quic/node_quic_default_application.h',
             'src/quic/node_quic_http3_application.h',
             'src/quic/node_quic_buffer.cc',
+            'src/quic/node_quic_congestion.cc',
             'src/quic/node_quic_crypto.cc',
+            'src/quic/node_quic_qlog.cc',
             'src/quic/node_quic_session.cc',
             'src/quic/node_quic_socket.cc',
             'src/quic/node_quic_stream.cc',
+            'src/quic/node_quic_util.cc',
             'src/quic/node_quic.cc',
             'src/quic/node_quic_default_application.cc',
             'src/quic/node_quic_http3_application.cc'
@@ -1209,8 +1214,16 @@
             'NODE_EXPERIMENTAL_QUIC=1',
           ],
           'sources': [
+            'test/cctest/test_quic_address.cc',
             'test/cctest/test_quic_buffer.cc',
             'test/cctest/test_quic_cid.cc',
+            'test/cctest/test_quic_congestion.cc',
+            'test/cctest/test_quic_pacer.cc',
+            'test/cctest/test_quic_packet_cipher.cc',
+            'test/cctest/test_quic_path_mtu.cc',
+            'test/cctest/test_quic_qlog.cc',
+            'test/cctest/test_quic_ticket_keys.cc',
+            'test/cctest/test_quic_timer_wheel.cc',
             'test/cctest/test_quic_verifyhostnameidentity.cc'
           ]
         }],
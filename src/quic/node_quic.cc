@@ -55,6 +55,7 @@ void QuicSetCallbacks(const FunctionCallbackInfo<Value>& args) {
 
   SETFUNCTION("onSocketClose", socket_close);
   SETFUNCTION("onSocketError", socket_error);
+  SETFUNCTION("onSocketEvents", socket_events);
   SETFUNCTION("onSessionReady", session_ready);
   SETFUNCTION("onSessionCert", session_cert);
   SETFUNCTION("onSessionClientHello", session_client_hello);
@@ -90,6 +91,7 @@ void QuicInitSecureContext(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsObject());  // Secure Context
   CHECK(args[1]->IsString());  // groups
   CHECK(args[2]->IsBoolean());  // early data
+  CHECK(args[3]->IsBoolean());  // offload handshake
 
   SecureContext* sc;
   ASSIGN_OR_RETURN_UNWRAP(&sc, args[0].As<Object>(),
@@ -97,11 +99,13 @@ void QuicInitSecureContext(const FunctionCallbackInfo<Value>& args) {
   const node::Utf8Value groups(env->isolate(), args[1]);
 
   bool early_data = args[2]->BooleanValue(env->isolate());
+  bool offload_handshake = args[3]->BooleanValue(env->isolate());
 
   InitializeSecureContext(
       BaseObjectPtr<SecureContext>(sc),
       early_data,
-      side);
+      side,
+      offload_handshake);
 
   if (!crypto::SetGroups(sc, *groups))
     THROW_ERR_QUIC_CANNOT_SET_GROUPS(env);
@@ -149,11 +153,15 @@ void Initialize(Local<Object> target,
 
 // TODO(@jasnell): Audit which constants are actually being used in JS
 #define QUIC_CONSTANTS(V)                                                      \
+  V(DEFAULT_ADDRESS_SKETCH_SIZE)                                               \
   V(DEFAULT_MAX_STREAM_DATA_BIDI_LOCAL)                                        \
   V(DEFAULT_RETRYTOKEN_EXPIRATION)                                             \
   V(DEFAULT_MAX_CONNECTIONS)                                                   \
   V(DEFAULT_MAX_CONNECTIONS_PER_HOST)                                          \
   V(DEFAULT_MAX_STATELESS_RESETS_PER_HOST)                                     \
+  V(DEFAULT_STREAM_URGENCY)                                                    \
+  V(DEFAULT_TICKET_KEY_ROTATION)                                               \
+  V(DEFAULT_VALIDATE_ADDRESS_LRU_SIZE)                                         \
   V(IDX_HTTP3_QPACK_MAX_TABLE_CAPACITY)                                        \
   V(IDX_HTTP3_QPACK_BLOCKED_STREAMS)                                           \
   V(IDX_HTTP3_MAX_HEADER_LIST_SIZE)                                            \
@@ -173,6 +181,8 @@ void Initialize(Local<Object> target,
   V(IDX_QUIC_SESSION_ACK_DELAY_EXPONENT)                                       \
   V(IDX_QUIC_SESSION_DISABLE_MIGRATION)                                        \
   V(IDX_QUIC_SESSION_MAX_ACK_DELAY)                                            \
+  V(IDX_QUIC_SESSION_MAX_PACING_BURST)                                         \
+  V(IDX_QUIC_SESSION_CC_ALGORITHM)                                             \
   V(IDX_QUIC_SESSION_CONFIG_COUNT)                                             \
   V(IDX_QUIC_SESSION_STATE_CERT_ENABLED)                                       \
   V(IDX_QUIC_SESSION_STATE_CLIENT_HELLO_ENABLED)                               \
@@ -185,20 +195,40 @@ void Initialize(Local<Object> target,
   V(IDX_QUIC_SESSION_STATE_BYTES_IN_FLIGHT)                                    \
   V(IDX_QUIC_SESSION_STATE_HANDSHAKE_CONFIRMED)                                \
   V(IDX_QUIC_SESSION_STATE_IDLE_TIMEOUT)                                       \
+  V(MAX_ADDRESS_SKETCH_SIZE)                                                   \
   V(MAX_RETRYTOKEN_EXPIRATION)                                                 \
+  V(MAX_TICKET_KEY_ROTATION)                                                   \
+  V(MAX_TICKET_KEYS)                                                           \
+  V(MAX_VALIDATE_ADDRESS_LRU_SIZE)                                             \
+  V(MAX_WORKER_ID)                                                             \
+  V(MIN_ADDRESS_SKETCH_SIZE)                                                   \
   V(MIN_RETRYTOKEN_EXPIRATION)                                                 \
+  V(MIN_TICKET_KEY_ROTATION)                                                   \
   V(NGTCP2_APP_NOERROR)                                                        \
   V(NGTCP2_PATH_VALIDATION_RESULT_FAILURE)                                     \
   V(NGTCP2_PATH_VALIDATION_RESULT_SUCCESS)                                     \
+  V(QUIC_CC_ALGORITHM_BBR)                                                     \
+  V(QUIC_CC_ALGORITHM_CUBIC)                                                   \
+  V(QUIC_CC_ALGORITHM_NEWRENO)                                                 \
   V(QUIC_ERROR_APPLICATION)                                                    \
   V(QUIC_ERROR_CRYPTO)                                                         \
   V(QUIC_ERROR_SESSION)                                                        \
+  V(QUIC_HISTOGRAM_MODE_EAGER)                                                 \
+  V(QUIC_HISTOGRAM_MODE_LAZY)                                                  \
+  V(QUIC_HISTOGRAM_MODE_SHARED)                                                \
   V(QUIC_PREFERRED_ADDRESS_USE)                                                \
   V(QUIC_PREFERRED_ADDRESS_IGNORE)                                             \
   V(QUICCLIENTSESSION_OPTION_REQUEST_OCSP)                                     \
   V(QUICCLIENTSESSION_OPTION_VERIFY_HOSTNAME_IDENTITY)                         \
   V(QUICSERVERSESSION_OPTION_REJECT_UNAUTHORIZED)                              \
   V(QUICSERVERSESSION_OPTION_REQUEST_CERT)                                     \
+  V(QUICSOCKET_EVENT_STREAM_BLOCKED)                                           \
+  V(QUICSOCKET_EVENT_STREAM_CLOSE)                                             \
+  V(QUICSOCKET_EVENT_STREAM_HEADERS)                                           \
+  V(QUICSOCKET_EVENT_STREAM_READY)                                             \
+  V(QUICSOCKET_EVENT_STREAM_RESET)                                             \
+  V(QUICSOCKET_OPTIONS_BATCH_EVENTS)                                           \
+  V(QUICSOCKET_OPTIONS_BATCH_SEND)                                             \
   V(QUICSOCKET_OPTIONS_VALIDATE_ADDRESS)                                       \
   V(QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU)                                   \
   V(QUICSTREAM_HEADER_FLAGS_NONE)                                              \
@@ -231,6 +261,7 @@ void Initialize(Local<Object> target,
 #undef V
 
   NODE_DEFINE_CONSTANT(constants, NGTCP2_PROTO_VER);
+  NODE_DEFINE_CONSTANT(constants, kQuicSocketEventFields);
   NODE_DEFINE_CONSTANT(constants, NGTCP2_DEFAULT_MAX_ACK_DELAY);
   NODE_DEFINE_CONSTANT(constants, NGTCP2_MAX_CIDLEN);
   NODE_DEFINE_CONSTANT(constants, NGTCP2_MIN_CIDLEN);
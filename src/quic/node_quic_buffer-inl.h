@@ -29,6 +29,37 @@ QuicBufferChunk::QuicBufferChunk(uv_buf_t buf, DoneCB done)
 
 QuicBufferChunk::~QuicBufferChunk() {
   CHECK(done_called_);
+  CHECK(block_done_.empty());
+}
+
+std::unique_ptr<QuicBufferChunk> QuicBufferChunk::CreateBlock(size_t size) {
+  std::unique_ptr<QuicBufferChunk> block =
+      std::make_unique<QuicBufferChunk>(size);
+  block->buf_.len = 0;
+  block->length_ = 0;
+  block->is_block_ = true;
+  return block;
+}
+
+size_t QuicBufferChunk::available() const {
+  return is_block_ ? data_buf_.size() - used_ : 0;
+}
+
+size_t QuicBufferChunk::Append(const uint8_t* data, size_t len) {
+  len = std::min(len, available());
+  // The unread data always extends to the end of the used
+  // part of the block, so appending simply extends it.
+  memcpy(data_buf_.data() + used_, data, len);
+  used_ += len;
+  buf_.len += len;
+  length_ += len;
+  return len;
+}
+
+void QuicBufferChunk::AddDone(DoneCB done) {
+  CHECK(is_block_);
+  if (done != nullptr)
+    block_done_.emplace_back(used_, std::move(done));
 }
 
 size_t QuicBufferChunk::Seek(size_t amount) {
@@ -38,13 +69,27 @@ size_t QuicBufferChunk::Seek(size_t amount) {
   return amount;
 }
 
-size_t QuicBufferChunk::Consume(size_t amount) {
+size_t QuicBufferChunk::Consume(size_t amount, int status) {
   amount = std::min(amount, length_);
   length_ -= amount;
+  // A callback may lead to more data being appended to the
+  // block, so each is removed before it is invoked.
+  size_t acknowledged = used_ - length_;
+  while (!block_done_.empty() &&
+         block_done_.front().first <= acknowledged) {
+    DoneCB done = std::move(block_done_.front().second);
+    block_done_.pop_front();
+    done(status);
+  }
   return amount;
 }
 
 void QuicBufferChunk::Done(int status) {
+  while (!block_done_.empty()) {
+    DoneCB done = std::move(block_done_.front().second);
+    block_done_.pop_front();
+    done(status);
+  }
   if (done_called_) return;
   done_called_ = true;
   if (done_ != nullptr)
@@ -4,10 +4,16 @@
 #include "uv.h"
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <utility>
 
 namespace node {
+
+using v8::ArrayBuffer;
+using v8::BackingStore;
+using v8::Local;
+
 namespace quic {
 
 void QuicBufferChunk::MemoryInfo(MemoryTracker* tracker) const {
@@ -21,6 +27,11 @@ size_t QuicBuffer::Push(uv_buf_t* bufs, size_t nbufs, DoneCB done) {
     done(0);
     return 0;
   }
+  size_t total = 0;
+  for (size_t n = 0; n < nbufs; n++)
+    total += bufs[n].len;
+  if (total <= kMaxCopyLength)
+    return Copy(bufs, nbufs, std::move(done));
   size_t n = 0;
   while (nbufs > 1) {
     if (!is_empty(bufs[n])) {
@@ -35,6 +46,37 @@ size_t QuicBuffer::Push(uv_buf_t* bufs, size_t nbufs, DoneCB done) {
   return len;
 }
 
+size_t QuicBuffer::Copy(const uv_buf_t* bufs, size_t nbufs, DoneCB done) {
+  CHECK(!ended_);
+  size_t len = 0;
+  for (size_t n = 0; n < nbufs; n++) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(bufs[n].base);
+    size_t remaining = bufs[n].len;
+    while (remaining > 0) {
+      if (tail_ == nullptr || tail_->available() == 0) {
+        std::unique_ptr<QuicBufferChunk> block = std::move(spare_block_);
+        if (!block)
+          block = QuicBufferChunk::CreateBlock(kBlockSize);
+        Push(std::move(block));
+      }
+      size_t amount = tail_->Append(data, remaining);
+      data += amount;
+      remaining -= amount;
+      len += amount;
+      length_ += amount;
+      remaining_ += amount;
+      if (!head_)
+        head_ = tail_;
+    }
+  }
+
+  if (len == 0)
+    done(0);
+  else
+    tail_->AddDone(std::move(done));
+  return len;
+}
+
 void QuicBuffer::Push(std::unique_ptr<QuicBufferChunk> chunk) {
   CHECK(!ended_);
   length_ += chunk->remaining();
@@ -76,6 +118,15 @@ bool QuicBuffer::Pop(int status) {
     tail_ = root_.get();
 
   root->Done(status);
+
+  // Released blocks are reset and kept for reuse.
+  if (root->is_block_ && !spare_block_) {
+    root->used_ = 0;
+    root->buf_ = uv_buf_init(
+        reinterpret_cast<char*>(root->data_buf_.data()), 0);
+    root->length_ = 0;
+    spare_block_ = std::move(root);
+  }
   return true;
 }
 
@@ -84,7 +135,7 @@ size_t QuicBuffer::Consume(int status, size_t amount) {
   size_t len = 0;
   while (root_ && amt > 0) {
     auto root = root_.get();
-    size_t consumed = root->Consume(amt);
+    size_t consumed = root->Consume(amt, status);
     len += consumed;
     length_ -= consumed;
     amt -= consumed;
@@ -97,6 +148,7 @@ size_t QuicBuffer::Consume(int status, size_t amount) {
 
 void QuicBuffer::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("root", root_);
+  tracker->TrackField("spare_block", spare_block_);
 }
 
 int QuicBuffer::DoPull(
@@ -155,5 +207,60 @@ int QuicBuffer::DoPull(
   return status;
 }
 
+Local<ArrayBuffer> QuicReceiveSlab::Copy(
+    const uint8_t* data,
+    size_t len,
+    size_t* offset) {
+  Local<ArrayBuffer> buffer;
+  // The slab is replaced once it is full, or if JavaScript has
+  // detached the ArrayBuffer it is exposed through.
+  if (len <= kMaxSlabChunk && len <= remaining()) {
+    buffer = buffer_.Get(isolate_);
+    if (buffer->ByteLength() == 0)
+      buffer = Local<ArrayBuffer>();
+  }
+
+  if (buffer.IsEmpty() &&
+      (len > kMaxSlabChunk ||
+       (store_ && retired_count() >= kMaxRetiredSlabs))) {
+    std::shared_ptr<BackingStore> store =
+        ArrayBuffer::NewBackingStore(isolate_, len);
+    memcpy(store->Data(), data, len);
+    *offset = 0;
+    return ArrayBuffer::New(isolate_, std::move(store));
+  }
+
+  if (buffer.IsEmpty()) {
+    if (store_)
+      retired_.emplace_back(store_);
+    store_ = ArrayBuffer::NewBackingStore(isolate_, kSlabSize);
+    buffer = ArrayBuffer::New(isolate_, store_);
+    buffer_.Reset(isolate_, buffer);
+    offset_ = 0;
+  }
+
+  *offset = offset_;
+  memcpy(static_cast<uint8_t*>(store_->Data()) + offset_, data, len);
+  offset_ += len;
+  return buffer;
+}
+
+size_t QuicReceiveSlab::retired_count() {
+  retired_.erase(
+      std::remove_if(
+          retired_.begin(),
+          retired_.end(),
+          [](const std::weak_ptr<BackingStore>& store) {
+            return store.expired();
+          }),
+      retired_.end());
+  return retired_.size();
+}
+
+void QuicReceiveSlab::MemoryInfo(MemoryTracker* tracker) const {
+  if (store_)
+    tracker->TrackFieldWithSize("slab", kSlabSize);
+}
+
 }  // namespace quic
 }  // namespace node
@@ -10,7 +10,11 @@
 #include "node_internals.h"
 #include "util.h"
 #include "uv.h"
+#include "v8.h"
 
+#include <deque>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace node {
@@ -73,6 +77,16 @@ using DoneCB = std::function<void(int)>;
 // with a single write callback. For each uv_buf_t DoWrite gets, a
 // corresponding QuicBufferChunk is added to the QuicBuffer, with the
 // callback associated with the final chunk added to the list.
+//
+// Small writes are not worth a QuicBufferChunk of their own: each would
+// take one of the kMaxVectorCount vectors passed to ngtcp2 per packet,
+// leading to tiny stream frames. Writes of up to kMaxCopyLength bytes
+// are instead copied into blocks of kBlockSize bytes shared by many
+// writes. A block keeps the done callback of each write together with
+// the offset within the block at which the write ends, and invokes it
+// once the data up to that offset has been acknowledged. The block is
+// released as a whole once all of its data has been acknowledged, and
+// the most recently released block is kept for reuse.
 
 
 // A QuicBufferChunk contains the actual buffered data
@@ -107,7 +121,12 @@ class QuicBufferChunk : public MemoryRetainer {
 
   inline ~QuicBufferChunk() override;
 
-  // Invokes the done callback associated with the QuicBufferChunk.
+  // Creates an empty block that the data of multiple writes
+  // may be copied into.
+  static inline std::unique_ptr<QuicBufferChunk> CreateBlock(size_t size);
+
+  // Invokes the done callback associated with the QuicBufferChunk,
+  // and, for a block, those of the writes not yet acknowledged.
   inline void Done(int status);
 
   // length() provides the remaining-to-be-acknowledged length.
@@ -122,14 +141,27 @@ class QuicBufferChunk : public MemoryRetainer {
 
   // Consumes (acknowledges) the given number of bytes. If amount
   // is greater than length(), only length() bytes are consumed.
-  // Returns the actual number of bytes consumed.
-  inline size_t Consume(size_t amount);
+  // For a block, the done callbacks of the writes that have been
+  // acknowledged in full are invoked with status. Returns the
+  // actual number of bytes consumed.
+  inline size_t Consume(size_t amount, int status = 0);
 
   // Seeks (reads) the given number of bytes. If amount is greater
   // than remaining(), only remaining() bytes are read. Returns
   // the actual number of bytes read.
   inline size_t Seek(size_t amount);
 
+  // The number of bytes that may still be copied into a block.
+  // Always 0 for chunks that are not blocks.
+  inline size_t available() const;
+
+  // Copies up to available() bytes to the end of the block. Returns
+  // the number of bytes copied.
+  inline size_t Append(const uint8_t* data, size_t len);
+
+  // Associates done with the data appended to the block so far.
+  inline void AddDone(DoneCB done);
+
   uint8_t* out() { return reinterpret_cast<uint8_t*>(buf_.base); }
   uv_buf_t buf() { return buf_; }
   const uv_buf_t buf() const { return buf_; }
@@ -146,12 +178,22 @@ class QuicBufferChunk : public MemoryRetainer {
   bool done_called_ = false;
   std::unique_ptr<QuicBufferChunk> next_;
 
+  // Only used by blocks. The number of bytes copied into the block,
+  // and the done callbacks of the writes copied into it along with
+  // the offset at which each write ends.
+  bool is_block_ = false;
+  size_t used_ = 0;
+  std::deque<std::pair<size_t, DoneCB>> block_done_;
+
   friend class QuicBuffer;
 };
 
 class QuicBuffer : public bob::SourceImpl<ngtcp2_vec>,
                    public MemoryRetainer {
  public:
+  static constexpr size_t kBlockSize = 16 * 1024;
+  static constexpr size_t kMaxCopyLength = 1024;
+
   QuicBuffer() = default;
 
   inline QuicBuffer(QuicBuffer&& src) noexcept;
@@ -173,12 +215,21 @@ class QuicBuffer : public bob::SourceImpl<ngtcp2_vec>,
   // the DoneCB callback will be invoked when the last
   // uv_buf_t in the bufs array is consumed and popped out
   // of the internal linked list. Ownership of the uv_buf_t
-  // remains with the caller.
+  // remains with the caller. Writes of up to kMaxCopyLength
+  // bytes are copied into blocks instead.
   size_t Push(
       uv_buf_t* bufs,
       size_t nbufs,
       DoneCB done = QuicBufferChunk::default_done);
 
+  // Copies the data into blocks, filling the last block before
+  // adding new ones. The DoneCB callback will be invoked once
+  // all of the data has been consumed.
+  size_t Copy(
+      const uv_buf_t* bufs,
+      size_t nbufs,
+      DoneCB done = QuicBufferChunk::default_done);
+
   // Pushes a single QuicBufferChunk into the linked list
   void Push(std::unique_ptr<QuicBufferChunk> chunk);
 
@@ -222,6 +273,7 @@ class QuicBuffer : public bob::SourceImpl<ngtcp2_vec>,
   std::unique_ptr<QuicBufferChunk> root_;
   QuicBufferChunk* head_ = nullptr;  // Current Read Position
   QuicBufferChunk* tail_ = nullptr;  // Current Write Position
+  std::unique_ptr<QuicBufferChunk> spare_block_;
 
   bool canceled_ = false;
   bool ended_ = false;
@@ -231,6 +283,60 @@ class QuicBuffer : public bob::SourceImpl<ngtcp2_vec>,
   friend class QuicBufferChunk;
 };
 
+// A QuicReceiveSlab holds stream data received by a QuicSession.
+// ngtcp2 reuses the buffers it hands received stream data out in, so
+// the data has to be copied out before the callback returns. Rather
+// than allocating a separate buffer for every chunk, the chunks are
+// packed into a shared slab and passed to JavaScript as views over a
+// single ArrayBuffer. The slab's backing store is reference counted,
+// so a slab that has been replaced is freed once JavaScript no longer
+// holds any view over it.
+//
+// Because even a small retained view keeps its whole slab alive, the
+// number of replaced slabs that may still be pinned by JavaScript is
+// limited to kMaxRetiredSlabs. Once that many are alive, chunks are
+// copied into backing stores of their own until some of them have
+// been garbage collected. A QuicSession therefore pins at most
+// (kMaxRetiredSlabs + 1) * kSlabSize bytes of slab memory, no matter
+// how many of its streams hold on to received data.
+class QuicReceiveSlab final : public MemoryRetainer {
+ public:
+  static constexpr size_t kSlabSize = 64 * 1024;
+
+  // Chunks larger than this are given a backing store of their own
+  // rather than forcing the current slab to be replaced early.
+  static constexpr size_t kMaxSlabChunk = kSlabSize / 4;
+
+  static constexpr size_t kMaxRetiredSlabs = 16;
+
+  explicit QuicReceiveSlab(v8::Isolate* isolate) : isolate_(isolate) {}
+
+  // Copies len bytes into the slab. Returns the ArrayBuffer holding
+  // the copy and sets *offset to the position of the copy within it.
+  // The caller must have a HandleScope.
+  v8::Local<v8::ArrayBuffer> Copy(
+      const uint8_t* data,
+      size_t len,
+      size_t* offset);
+
+  // The number of bytes of the current slab that are unused.
+  size_t remaining() const { return store_ ? kSlabSize - offset_ : 0; }
+
+  // The number of replaced slabs that have not been freed yet.
+  size_t retired_count();
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(QuicReceiveSlab)
+  SET_SELF_SIZE(QuicReceiveSlab)
+
+ private:
+  v8::Isolate* isolate_;
+  std::shared_ptr<v8::BackingStore> store_;
+  v8::Global<v8::ArrayBuffer> buffer_;
+  size_t offset_ = 0;
+  std::vector<std::weak_ptr<v8::BackingStore>> retired_;
+};
+
 }  // namespace quic
 }  // namespace node
 
@@ -0,0 +1,229 @@
+#include "node_quic_congestion.h"  // NOLINT(build/include)
+#include "util-inl.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace node {
+namespace quic {
+
+namespace {
+constexpr double kNanosecondsPerSecond = 1e9;
+
+// RFC 8312 constants. kCubicC is in segments per second cubed.
+constexpr double kCubicBeta = 0.7;
+constexpr double kCubicC = 0.4;
+
+constexpr double kBbrCwndGain = 2;
+constexpr double kBbrProbeBwGains[] = { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+constexpr uint64_t kBbrMinPipeWindow =
+    4 * QuicCongestionController::kMaxDatagramSize;
+}  // namespace
+
+std::unique_ptr<QuicCongestionController> QuicCongestionController::Create(
+    QuicCongestionControlAlgorithm algorithm,
+    uint64_t initial_window) {
+  switch (algorithm) {
+    case QUIC_CC_ALGORITHM_NEWRENO:
+      return {};
+    case QUIC_CC_ALGORITHM_CUBIC:
+      return std::make_unique<CubicCongestionController>(initial_window);
+    case QUIC_CC_ALGORITHM_BBR:
+      return std::make_unique<BbrCongestionController>(initial_window);
+  }
+  UNREACHABLE();
+}
+
+void CubicCongestionController::OnAck(const QuicCongestionSample& sample) {
+  if (cwnd_ < ssthresh_) {
+    cwnd_ += sample.bytes_acked;
+    return;
+  }
+
+  double cwnd = static_cast<double>(cwnd_);
+  if (epoch_start_ == 0) {
+    epoch_start_ = sample.now;
+    if (cwnd < w_max_) {
+      k_ = std::cbrt((w_max_ - cwnd) / kMaxDatagramSize / kCubicC);
+      origin_ = w_max_;
+    } else {
+      k_ = 0;
+      origin_ = cwnd;
+    }
+    w_est_ = cwnd;
+  }
+
+  // The window the cubic function expects one round trip from now,
+  // limited so that the window grows by at most half per round trip.
+  double t =
+      static_cast<double>(sample.now - epoch_start_ + sample.min_rtt) /
+      kNanosecondsPerSecond;
+  double target = std::min(
+      origin_ + kCubicC * std::pow(t - k_, 3) * kMaxDatagramSize,
+      1.5 * cwnd);
+
+  double acked = static_cast<double>(sample.bytes_acked);
+  w_est_ += 3 * (1 - kCubicBeta) / (1 + kCubicBeta) *
+            kMaxDatagramSize * acked / cwnd;
+
+  if (target > cwnd)
+    cwnd += (target - cwnd) * acked / cwnd;
+
+  cwnd_ = static_cast<uint64_t>(std::max(cwnd, w_est_));
+}
+
+void CubicCongestionController::OnCongestionEvent(
+    const QuicCongestionSample& sample) {
+  epoch_start_ = 0;
+  double cwnd = static_cast<double>(cwnd_);
+  // Fast convergence: release bandwidth when the window
+  // stopped short of the previous maximum.
+  w_max_ = cwnd < w_max_ ? cwnd * (1 + kCubicBeta) / 2 : cwnd;
+  cwnd_ = std::max(static_cast<uint64_t>(cwnd * kCubicBeta),
+                   uint64_t{kMinWindow});
+  ssthresh_ = cwnd_;
+}
+
+void CubicCongestionController::OnPersistentCongestion(
+    const QuicCongestionSample& sample) {
+  epoch_start_ = 0;
+  w_max_ = static_cast<double>(cwnd_);
+  ssthresh_ = std::max(
+      static_cast<uint64_t>(cwnd_ * kCubicBeta),
+      uint64_t{kMinWindow});
+  cwnd_ = kMinWindow;
+}
+
+double BbrCongestionController::bandwidth() const {
+  return *std::max_element(
+      bandwidth_samples_,
+      bandwidth_samples_ + kBandwidthWindow);
+}
+
+uint64_t BbrCongestionController::bdp() const {
+  return static_cast<uint64_t>(bandwidth() * min_rtt_);
+}
+
+double BbrCongestionController::pacing_rate() const {
+  return pacing_gain_ * bandwidth();
+}
+
+void BbrCongestionController::OnAck(const QuicCongestionSample& sample) {
+  delivered_ += sample.bytes_acked;
+  UpdateMinRtt(sample);
+
+  if (round_start_ == 0) {
+    round_start_ = sample.now;
+    round_delivered_ = delivered_;
+  }
+
+  uint64_t rtt = sample.latest_rtt > 0 ? sample.latest_rtt : sample.min_rtt;
+  if (sample.now - round_start_ >= std::max(rtt, uint64_t{1}))
+    OnRoundEnd(sample);
+
+  if (mode_ == Mode::kDrain && sample.bytes_in_flight <= bdp())
+    EnterProbeBandwidth(sample.now);
+
+  UpdateWindow(sample);
+}
+
+void BbrCongestionController::OnCongestionEvent(
+    const QuicCongestionSample& sample) {
+  // The model, not loss, determines the window.
+}
+
+void BbrCongestionController::EnterProbeBandwidth(uint64_t now) {
+  mode_ = Mode::kProbeBandwidth;
+  cwnd_gain_ = kBbrCwndGain;
+  // Start the cycle past the draining phase.
+  cycle_index_ = 2;
+  cycle_start_ = now;
+  pacing_gain_ = kBbrProbeBwGains[cycle_index_];
+}
+
+void BbrCongestionController::OnRoundEnd(const QuicCongestionSample& sample) {
+  double rate =
+      static_cast<double>(delivered_ - round_delivered_) /
+      static_cast<double>(sample.now - round_start_);
+  bandwidth_samples_[round_count_++ % kBandwidthWindow] = rate;
+  round_start_ = sample.now;
+  round_delivered_ = delivered_;
+
+  switch (mode_) {
+    case Mode::kStartup:
+      if (bandwidth() >= full_bandwidth_ * 1.25) {
+        full_bandwidth_ = bandwidth();
+        full_bandwidth_count_ = 0;
+      } else if (++full_bandwidth_count_ >= 3) {
+        mode_ = Mode::kDrain;
+        pacing_gain_ = 1 / kHighGain;
+      }
+      break;
+    case Mode::kProbeBandwidth:
+      if (sample.now - cycle_start_ > min_rtt_) {
+        cycle_index_ = (cycle_index_ + 1) % kProbeBwGains;
+        cycle_start_ = sample.now;
+        pacing_gain_ = kBbrProbeBwGains[cycle_index_];
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void BbrCongestionController::UpdateMinRtt(
+    const QuicCongestionSample& sample) {
+  if (sample.latest_rtt > 0 &&
+      (min_rtt_ == 0 || sample.latest_rtt <= min_rtt_)) {
+    min_rtt_ = sample.latest_rtt;
+    min_rtt_at_ = sample.now;
+  } else if (mode_ != Mode::kProbeRtt &&
+             min_rtt_ > 0 &&
+             sample.now - min_rtt_at_ > kMinRttExpiry) {
+    // The estimate has expired. Drain the queue for a
+    // while so that a fresh one can be measured.
+    mode_ = Mode::kProbeRtt;
+    pacing_gain_ = 1;
+    probe_rtt_done_at_ = sample.now + kProbeRttDuration;
+    min_rtt_ = sample.latest_rtt;
+    min_rtt_at_ = sample.now;
+  }
+
+  if (mode_ == Mode::kProbeRtt && sample.now >= probe_rtt_done_at_) {
+    if (full_bandwidth_count_ >= 3) {
+      EnterProbeBandwidth(sample.now);
+    } else {
+      mode_ = Mode::kStartup;
+      pacing_gain_ = kHighGain;
+      cwnd_gain_ = kHighGain;
+    }
+  }
+}
+
+void BbrCongestionController::UpdateWindow(
+    const QuicCongestionSample& sample) {
+  if (mode_ == Mode::kProbeRtt) {
+    cwnd_ = kBbrMinPipeWindow;
+    return;
+  }
+
+  // Until there is a model, grow as in slow start.
+  if (bandwidth() == 0 || min_rtt_ == 0) {
+    cwnd_ += sample.bytes_acked;
+    return;
+  }
+
+  uint64_t target = std::max(
+      static_cast<uint64_t>(cwnd_gain_ * bdp()),
+      kBbrMinPipeWindow);
+  if (mode_ == Mode::kStartup) {
+    if (cwnd_ < target)
+      cwnd_ += sample.bytes_acked;
+  } else {
+    cwnd_ = std::min(cwnd_ + sample.bytes_acked, target);
+  }
+  cwnd_ = std::max(cwnd_, kBbrMinPipeWindow);
+}
+
+}  // namespace quic
+}  // namespace node
@@ -0,0 +1,195 @@
+#ifndef SRC_QUIC_NODE_QUIC_CONGESTION_H_
+#define SRC_QUIC_NODE_QUIC_CONGESTION_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "memory_tracker.h"
+
+#include <limits>
+#include <memory>
+
+namespace node {
+
+namespace quic {
+
+// The congestion control algorithms that may be selected for a
+// QuicSession. NewReno is the controller built into ngtcp2 and is
+// the default.
+enum QuicCongestionControlAlgorithm : uint32_t {
+  QUIC_CC_ALGORITHM_NEWRENO,
+  QUIC_CC_ALGORITHM_CUBIC,
+  QUIC_CC_ALGORITHM_BBR
+};
+
+// The congestion signals observed for a QuicSession since the
+// previous sample. All times are in nanoseconds.
+struct QuicCongestionSample {
+  uint64_t now;
+  uint64_t bytes_acked;
+  uint64_t bytes_in_flight;
+  uint64_t latest_rtt;
+  uint64_t min_rtt;
+  uint64_t smoothed_rtt;
+};
+
+// A QuicCongestionController replaces the window computed by the
+// NewReno controller built into ngtcp2. The version of ngtcp2 in use
+// does not allow the controller to be replaced, so the QuicSession
+// samples ngtcp2's congestion state after every received packet and
+// loss detection timeout, feeds the changes to the controller, and
+// writes the resulting congestion window back.
+class QuicCongestionController : public MemoryRetainer {
+ public:
+  // Matches the datagram size ngtcp2 assumes for congestion control.
+  static constexpr uint64_t kMaxDatagramSize = 1200;
+  static constexpr uint64_t kMinWindow = 2 * kMaxDatagramSize;
+
+  // Returns nullptr for QUIC_CC_ALGORITHM_NEWRENO, which is
+  // implemented by ngtcp2 itself.
+  static std::unique_ptr<QuicCongestionController> Create(
+      QuicCongestionControlAlgorithm algorithm,
+      uint64_t initial_window);
+
+  explicit QuicCongestionController(uint64_t initial_window)
+      : cwnd_(initial_window) {}
+  virtual ~QuicCongestionController() = default;
+
+  virtual QuicCongestionControlAlgorithm algorithm() const = 0;
+
+  // Called when previously sent bytes have been acknowledged.
+  virtual void OnAck(const QuicCongestionSample& sample) = 0;
+
+  // Called when ngtcp2 enters a new congestion recovery period
+  // because of packet loss.
+  virtual void OnCongestionEvent(const QuicCongestionSample& sample) = 0;
+
+  // Called when ngtcp2 has detected persistent congestion.
+  virtual void OnPersistentCongestion(const QuicCongestionSample& sample) {
+    cwnd_ = kMinWindow;
+  }
+
+  // The rate, in bytes per nanosecond, at which packets should be
+  // paced, or 0 if it is to be derived from the congestion window.
+  virtual double pacing_rate() const { return 0; }
+
+  uint64_t cwnd() const { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+
+ protected:
+  uint64_t cwnd_;
+  uint64_t ssthresh_ = std::numeric_limits<uint64_t>::max();
+};
+
+// CUBIC, as specified by RFC 8312, including fast convergence
+// and the TCP-friendly region.
+class CubicCongestionController final : public QuicCongestionController {
+ public:
+  explicit CubicCongestionController(uint64_t initial_window)
+      : QuicCongestionController(initial_window) {}
+
+  QuicCongestionControlAlgorithm algorithm() const override {
+    return QUIC_CC_ALGORITHM_CUBIC;
+  }
+
+  void OnAck(const QuicCongestionSample& sample) override;
+  void OnCongestionEvent(const QuicCongestionSample& sample) override;
+  void OnPersistentCongestion(const QuicCongestionSample& sample) override;
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(CubicCongestionController)
+  SET_SELF_SIZE(CubicCongestionController)
+
+ private:
+  // The time the current congestion avoidance epoch started,
+  // or 0 if a new epoch is to be started on the next ack.
+  uint64_t epoch_start_ = 0;
+  // The window, in bytes, before the last reduction.
+  double w_max_ = 0;
+  // The time, in seconds, the cubic function takes to reach w_max_.
+  double k_ = 0;
+  // The window, in bytes, the cubic function is centered on.
+  double origin_ = 0;
+  // The estimated window of a Reno controller, in bytes.
+  double w_est_ = 0;
+};
+
+// A model based controller after BBR. The bottleneck bandwidth is
+// the maximum delivery rate sampled once per round trip over the
+// last kBandwidthWindow rounds, and the window is a multiple of the
+// estimated bandwidth-delay product. Packets are paced at a gain of
+// the estimated bandwidth that cycles to probe for more bandwidth.
+// Loss is not treated as a congestion signal except when it is
+// persistent.
+class BbrCongestionController final : public QuicCongestionController {
+ public:
+  static constexpr size_t kBandwidthWindow = 10;
+  static constexpr size_t kProbeBwGains = 8;
+  static constexpr uint64_t kMinRttExpiry = 10000000000;  // 10 seconds
+  static constexpr uint64_t kProbeRttDuration = 200000000;  // 200 ms
+
+  explicit BbrCongestionController(uint64_t initial_window)
+      : QuicCongestionController(initial_window) {}
+
+  QuicCongestionControlAlgorithm algorithm() const override {
+    return QUIC_CC_ALGORITHM_BBR;
+  }
+
+  void OnAck(const QuicCongestionSample& sample) override;
+  void OnCongestionEvent(const QuicCongestionSample& sample) override;
+
+  double pacing_rate() const override;
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(BbrCongestionController)
+  SET_SELF_SIZE(BbrCongestionController)
+
+ private:
+  enum class Mode {
+    kStartup,
+    kDrain,
+    kProbeBandwidth,
+    kProbeRtt
+  };
+
+  void EnterProbeBandwidth(uint64_t now);
+  void OnRoundEnd(const QuicCongestionSample& sample);
+  void UpdateMinRtt(const QuicCongestionSample& sample);
+  void UpdateWindow(const QuicCongestionSample& sample);
+
+  double bandwidth() const;  // Bytes per nanosecond
+  uint64_t bdp() const;
+
+  // 2 / ln(2), the smallest gain that doubles the
+  // delivery rate each round during startup.
+  static constexpr double kHighGain = 2.885;
+
+  Mode mode_ = Mode::kStartup;
+  double pacing_gain_ = kHighGain;
+  double cwnd_gain_ = kHighGain;
+
+  // Per round delivery rate samples, in bytes per nanosecond.
+  double bandwidth_samples_[kBandwidthWindow] = {};
+  uint64_t round_count_ = 0;
+  uint64_t round_start_ = 0;
+  uint64_t round_delivered_ = 0;
+  uint64_t delivered_ = 0;
+
+  // Startup ends once the bandwidth has not grown by 25% in
+  // three consecutive rounds.
+  double full_bandwidth_ = 0;
+  size_t full_bandwidth_count_ = 0;
+
+  uint64_t min_rtt_ = 0;
+  uint64_t min_rtt_at_ = 0;
+  uint64_t probe_rtt_done_at_ = 0;
+
+  size_t cycle_index_ = 0;
+  uint64_t cycle_start_ = 0;
+};
+
+}  // namespace quic
+
+}  // namespace node
+
+#endif  // NODE_WANT_INTERNALS
+#endif  // SRC_QUIC_NODE_QUIC_CONGESTION_H_
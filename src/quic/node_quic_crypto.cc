@@ -8,19 +8,28 @@
 #include "node_sockaddr-inl.h"
 #include "node_url.h"
 #include "string_bytes.h"
+#include "threadpoolwork-inl.h"
 #include "v8.h"
 #include "util-inl.h"
 
 #include <ngtcp2/ngtcp2.h>
 #include <ngtcp2/ngtcp2_crypto.h>
+#include <openssl/async.h>
 #include <openssl/bio.h>
+#include <openssl/ec.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/kdf.h>
+#include <openssl/rand.h>
+#include <openssl/rsa.h>
 #include <openssl/ssl.h>
 #include <openssl/x509v3.h>
 
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <memory>
 #include <numeric>
 #include <unordered_map>
 #include <string>
@@ -87,6 +96,126 @@ bool DeriveTokenKey(
           kCryptoTokenSecretlen));
 }
 
+// Encrypts plaintext into a token laid out as:
+//
+//   magic (1 byte) | ciphertext | random data (kTokenRandLen bytes)
+//
+// The encryption key is derived from the token secret and the random
+// data. The magic byte identifies the kind of token and is
+// authenticated together with the given additional data, so a token
+// issued for one purpose cannot be passed off as the other.
+bool EncryptToken(
+    uint8_t magic,
+    uint8_t* token,
+    size_t* tokenlen,
+    const uint8_t* plaintext,
+    size_t plaintextlen,
+    const uint8_t* ad,
+    size_t adlen,
+    const uint8_t* token_secret) {
+  uint8_t rand_data[kTokenRandLen];
+  uint8_t token_key[kCryptoTokenKeylen];
+  uint8_t token_iv[kCryptoTokenIvlen];
+
+  ngtcp2_crypto_ctx ctx;
+  ngtcp2_crypto_ctx_initial(&ctx);
+  size_t ivlen = ngtcp2_crypto_packet_protection_ivlen(&ctx.aead);
+
+  EntropySource(rand_data, kTokenRandLen);
+
+  if (!DeriveTokenKey(
+          token_key,
+          token_iv,
+          rand_data,
+          kTokenRandLen,
+          ctx,
+          token_secret)) {
+    return false;
+  }
+
+  std::vector<uint8_t> aad(adlen + 1);
+  aad[0] = magic;
+  std::copy_n(ad, adlen, aad.begin() + 1);
+
+  token[0] = magic;
+  if (NGTCP2_ERR(ngtcp2_crypto_encrypt(
+          token + 1,
+          &ctx.aead,
+          plaintext,
+          plaintextlen,
+          token_key,
+          token_iv,
+          ivlen,
+          aad.data(),
+          aad.size()))) {
+    return false;
+  }
+
+  *tokenlen = 1 + plaintextlen + ngtcp2_crypto_aead_taglen(&ctx.aead);
+  memcpy(token + (*tokenlen), rand_data, kTokenRandLen);
+  *tokenlen += kTokenRandLen;
+  return true;
+}
+
+// Reverses EncryptToken. Returns false if the token is malformed, was
+// not generated with the given magic byte, additional data and token
+// secret, or has been tampered with. plaintext must be large enough to
+// hold tokenlen bytes.
+bool DecryptToken(
+    uint8_t magic,
+    const uint8_t* token,
+    size_t tokenlen,
+    uint8_t* plaintext,
+    size_t* plaintextlen,
+    const uint8_t* ad,
+    size_t adlen,
+    const uint8_t* token_secret) {
+  ngtcp2_crypto_ctx ctx;
+  ngtcp2_crypto_ctx_initial(&ctx);
+  size_t ivlen = ngtcp2_crypto_packet_protection_ivlen(&ctx.aead);
+  size_t taglen = ngtcp2_crypto_aead_taglen(&ctx.aead);
+
+  if (tokenlen < 1 + taglen + kTokenRandLen || token[0] != magic)
+    return false;
+
+  size_t ciphertextlen = tokenlen - 1 - kTokenRandLen;
+  const uint8_t* ciphertext = token + 1;
+  const uint8_t* rand_data = ciphertext + ciphertextlen;
+
+  uint8_t token_key[kCryptoTokenKeylen];
+  uint8_t token_iv[kCryptoTokenIvlen];
+
+  if (!DeriveTokenKey(
+          token_key,
+          token_iv,
+          rand_data,
+          kTokenRandLen,
+          ctx,
+          token_secret)) {
+    return false;
+  }
+
+  std::vector<uint8_t> aad(adlen + 1);
+  aad[0] = magic;
+  std::copy_n(ad, adlen, aad.begin() + 1);
+
+  if (NGTCP2_ERR(ngtcp2_crypto_decrypt(
+          plaintext,
+          &ctx.aead,
+          ciphertext,
+          ciphertextlen,
+          token_key,
+          token_iv,
+          ivlen,
+          aad.data(),
+          aad.size()))) {
+    return false;
+  }
+
+  *plaintextlen = ciphertextlen - taglen;
+  return true;
+}
+
 // Retry tokens are generated only by QUIC servers. They
 // are opaque to QUIC clients and must not be guessable by
 // on- or off-path attackers. A QUIC server sends a RETRY
@@ -112,7 +241,8 @@ bool DeriveTokenKey(
 //    the token secret to cryptographically derive an encryption key.
 // 3. Encrypting the byte array from step 1 using the encryption key
 //    from step 2.
-// 4. Appending random data generated in step 2 to the token.
+// 4. Prepending kRetryTokenMagic and appending the random data
+//    generated in step 2 to the token.
 //
 // The token secret must be kept secret on the QUIC server that
 // generated the retry. When multiple QUIC servers are used in a
@@ -138,13 +268,6 @@ bool GenerateRetryToken(
     const QuicCID& ocid,
     const uint8_t* token_secret) {
   std::array<uint8_t, 4096> plaintext;
-  uint8_t rand_data[kTokenRandLen];
-  uint8_t token_key[kCryptoTokenKeylen];
-  uint8_t token_iv[kCryptoTokenIvlen];
-
-  ngtcp2_crypto_ctx ctx;
-  ngtcp2_crypto_ctx_initial(&ctx);
-  size_t ivlen = ngtcp2_crypto_packet_protection_ivlen(&ctx.aead);
   uint64_t now = uv_hrtime();
 
   auto p = std::begin(plaintext);
@@ -152,36 +275,15 @@ bool GenerateRetryToken(
   p = std::copy_n(reinterpret_cast<uint8_t*>(&now), sizeof(uint64_t), p);
   p = std::copy_n(ocid->data, ocid->datalen, p);
 
-  EntropySource(rand_data, kTokenRandLen);
-
-  if (!DeriveTokenKey(
-          token_key,
-          token_iv,
-          rand_data,
-          kTokenRandLen,
-          ctx,
-          token_secret)) {
-    return false;
-  }
-
-  size_t plaintextlen = std::distance(std::begin(plaintext), p);
-  if (NGTCP2_ERR(ngtcp2_crypto_encrypt(
-          token,
-          &ctx.aead,
-          plaintext.data(),
-          plaintextlen,
-          token_key,
-          token_iv,
-          ivlen,
-          addr.raw(),
-          addr.length()))) {
-    return false;
-  }
-
-  *tokenlen = plaintextlen + ngtcp2_crypto_aead_taglen(&ctx.aead);
-  memcpy(token + (*tokenlen), rand_data, kTokenRandLen);
-  *tokenlen += kTokenRandLen;
-  return true;
+  return EncryptToken(
+      kRetryTokenMagic,
+      token,
+      tokenlen,
+      plaintext.data(),
+      std::distance(std::begin(plaintext), p),
+      addr.raw(),
+      addr.length(),
+      token_secret);
 }
 }  // namespace
 
@@ -215,6 +317,7 @@ bool GenerateResetToken(
 
 // Generates a RETRY packet. See the notes for GenerateRetryToken for details.
 std::unique_ptr<QuicPacket> GenerateRetryPacket(
+    QuicSocket* socket,
     const uint8_t* token_secret,
     const QuicCID& dcid,
     const QuicCID& scid,
@@ -234,7 +337,7 @@ std::unique_ptr<QuicPacket> GenerateRetryPacket(
   size_t pktlen = tokenlen + (2 * NGTCP2_MAX_CIDLEN) + scid.length() + 8;
   CHECK_LE(pktlen, NGTCP2_MAX_PKT_SIZE);
 
-  auto packet = QuicPacket::Create("retry", pktlen);
+  auto packet = QuicPacket::Create(socket, "retry", pktlen);
   ssize_t nwrite =
       ngtcp2_crypto_write_retry(
           packet->data(),
@@ -264,48 +367,22 @@ bool InvalidRetryToken(
     QuicCID* ocid,
     const uint8_t* token_secret,
     uint64_t verification_expiration) {
-
-  if (hd.tokenlen < kTokenRandLen)
-    return true;
-
-  ngtcp2_crypto_ctx ctx;
-  ngtcp2_crypto_ctx_initial(&ctx);
-
-  size_t ivlen = ngtcp2_crypto_packet_protection_ivlen(&ctx.aead);
-
-  size_t ciphertextlen = hd.tokenlen - kTokenRandLen;
-  const uint8_t* ciphertext = hd.token;
-  const uint8_t* rand_data = hd.token + ciphertextlen;
-
-  uint8_t token_key[kCryptoTokenKeylen];
-  uint8_t token_iv[kCryptoTokenIvlen];
-
-  if (!DeriveTokenKey(
-          token_key,
-          token_iv,
-          rand_data,
-          kTokenRandLen,
-          ctx,
-          token_secret)) {
-    return true;
-  }
-
   uint8_t plaintext[4096];
+  size_t plaintextlen;
 
-  if (NGTCP2_ERR(ngtcp2_crypto_decrypt(
+  if (hd.tokenlen > sizeof(plaintext) ||
+      !DecryptToken(
+          kRetryTokenMagic,
+          hd.token,
+          hd.tokenlen,
           plaintext,
-          &ctx.aead,
-          ciphertext,
-          ciphertextlen,
-          token_key,
-          token_iv,
-          ivlen,
+          &plaintextlen,
           addr.raw(),
-          addr.length()))) {
+          addr.length(),
+          token_secret)) {
     return true;
   }
 
-  size_t plaintextlen = ciphertextlen - ngtcp2_crypto_aead_taglen(&ctx.aead);
   if (plaintextlen < addr.length() + sizeof(uint64_t))
     return true;
 
@@ -332,6 +409,67 @@ bool InvalidRetryToken(
   return false;
 }
 
+// Tokens sent in NEW_TOKEN frames let a client that has connected
+// before skip the RETRY round trip on its next connection. Unlike
+// a retry token, the client may present the token long after it was
+// issued and from a different port, so it is bound only to the IP
+// address of the client and carries the wall clock time at which it
+// was issued, which remains meaningful across restarts of a server
+// whose token secret is configured explicitly.
+bool GenerateNewToken(
+    uint8_t* token,
+    size_t* tokenlen,
+    const SocketAddress& addr,
+    const uint8_t* token_secret) {
+  uv_timeval64_t tv;
+  if (uv_gettimeofday(&tv) != 0)
+    return false;
+  uint64_t now = tv.tv_sec;
+  std::string address = addr.address();
+  return EncryptToken(
+      kNewTokenMagic,
+      token,
+      tokenlen,
+      reinterpret_cast<const uint8_t*>(&now),
+      sizeof(now),
+      reinterpret_cast<const uint8_t*>(address.data()),
+      address.length(),
+      token_secret);
+}
+
+bool InvalidNewToken(
+    const ngtcp2_pkt_hd& hd,
+    const SocketAddress& addr,
+    const uint8_t* token_secret,
+    uint64_t verification_expiration) {
+  uint8_t plaintext[kMaxNewTokenLen];
+  size_t plaintextlen;
+  std::string address = addr.address();
+
+  if (hd.tokenlen > sizeof(plaintext) ||
+      !DecryptToken(
+          kNewTokenMagic,
+          hd.token,
+          hd.tokenlen,
+          plaintext,
+          &plaintextlen,
+          reinterpret_cast<const uint8_t*>(address.data()),
+          address.length(),
+          token_secret) ||
+      plaintextlen != sizeof(uint64_t)) {
+    return true;
+  }
+
+  uint64_t t;
+  memcpy(&t, plaintext, sizeof(uint64_t));
+
+  uv_timeval64_t tv;
+  if (uv_gettimeofday(&tv) != 0)
+    return true;
+  uint64_t now = tv.tv_sec;
+  return t > now || now - t > verification_expiration;
+}
+
 namespace {
 
 bool SplitHostname(
@@ -802,10 +940,163 @@ void InitializeTLS(QuicSession* session, const crypto::SSLPointer& ssl) {
   SetTransportParams(session, ssl);
 }
 
+namespace {
+// The state shared by an offloaded private key operation and the
+// async job waiting for it.
+struct PrivateKeyOperationState {
+  bool done = false;
+  int result = -1;
+};
+
+class PrivateKeyOperation final : public ThreadPoolWork {
+ public:
+  PrivateKeyOperation(
+      QuicSession* session,
+      std::function<int()> fn,
+      std::shared_ptr<PrivateKeyOperationState> state)
+      : ThreadPoolWork(session->env()),
+        session_(session),
+        fn_(std::move(fn)),
+        state_(std::move(state)) {}
+
+  void DoThreadPoolWork() override {
+    result_ = fn_();
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<PrivateKeyOperation> self(this);
+    state_->done = true;
+    state_->result =
+        status == 0 && !session_->is_destroyed() ? result_ : -1;
+    if (status == 0)
+      session_->IncrementStat(&QuicSessionStats::handshake_offload_count);
+    session_->crypto_context()->OnPrivateKeyOperationDone();
+  }
+
+ private:
+  BaseObjectPtr<QuicSession> session_;
+  std::function<int()> fn_;
+  std::shared_ptr<PrivateKeyOperationState> state_;
+  int result_ = -1;
+};
+
+// Runs fn on the threadpool if called within the async job of an
+// offloaded handshake, pausing the job until it is done. The job may
+// be resumed by further calls to SSL_do_handshake before then, in
+// which case it is simply paused again.
+int RunPrivateKeyOperation(std::function<int()> fn) {
+  QuicCryptoContext* context = QuicCryptoContext::current_handshake();
+  if (context == nullptr || ASYNC_get_current_job() == nullptr)
+    return fn();
+
+  Debug(context->session(), "Offloading private key operation");
+  auto state = std::make_shared<PrivateKeyOperationState>();
+  (new PrivateKeyOperation(context->session(), std::move(fn), state))
+      ->ScheduleWork();
+  while (!state->done)
+    CHECK_EQ(ASYNC_pause_job(), 1);
+  return state->result;
+}
+
+int OffloadRSAPrivateEncrypt(
+    int flen,
+    const unsigned char* from,
+    unsigned char* to,
+    RSA* rsa,
+    int padding) {
+  return RunPrivateKeyOperation([=]() {
+    return RSA_meth_get_priv_enc(RSA_PKCS1_OpenSSL())(
+        flen, from, to, rsa, padding);
+  });
+}
+
+int OffloadECDSASign(
+    int type,
+    const unsigned char* dgst,
+    int dlen,
+    unsigned char* sig,
+    unsigned int* siglen,
+    const BIGNUM* kinv,
+    const BIGNUM* r,
+    EC_KEY* eckey) {
+  return RunPrivateKeyOperation([=]() {
+    int (*sign)(
+        int,
+        const unsigned char*,
+        int,
+        unsigned char*,
+        unsigned int*,
+        const BIGNUM*,
+        const BIGNUM*,
+        EC_KEY*);
+    EC_KEY_METHOD_get_sign(EC_KEY_OpenSSL(), &sign, nullptr, nullptr);
+    return sign(type, dgst, dlen, sig, siglen, kinv, r, eckey);
+  });
+}
+
+const RSA_METHOD* OffloadRSAMethod() {
+  static RSA_METHOD* method = []() {
+    RSA_METHOD* method = RSA_meth_dup(RSA_PKCS1_OpenSSL());
+    CHECK_NOT_NULL(method);
+    RSA_meth_set1_name(method, "node.js quic offload");
+    RSA_meth_set_priv_enc(method, OffloadRSAPrivateEncrypt);
+    return method;
+  }();
+  return method;
+}
+
+const EC_KEY_METHOD* OffloadECMethod() {
+  static EC_KEY_METHOD* method = []() {
+    EC_KEY_METHOD* method = EC_KEY_METHOD_new(EC_KEY_OpenSSL());
+    CHECK_NOT_NULL(method);
+    int (*sign_setup)(EC_KEY*, BN_CTX*, BIGNUM**, BIGNUM**);
+    ECDSA_SIG* (*sign_sig)(
+        const unsigned char*,
+        int,
+        const BIGNUM*,
+        const BIGNUM*,
+        EC_KEY*);
+    EC_KEY_METHOD_get_sign(EC_KEY_OpenSSL(), nullptr, &sign_setup, &sign_sig);
+    EC_KEY_METHOD_set_sign(method, OffloadECDSASign, sign_setup, sign_sig);
+    return method;
+  }();
+  return method;
+}
+}  // namespace
+
+void EnableHandshakeOffload(SSL_CTX* ctx) {
+  SSL_CTX_set_mode(ctx, SSL_MODE_ASYNC);
+
+  // A SecureContext may hold one key per certificate type.
+  int ret = SSL_CTX_set_current_cert(ctx, SSL_CERT_SET_FIRST);
+  while (ret == 1) {
+    EVP_PKEY* pkey = SSL_CTX_get0_privatekey(ctx);
+    if (pkey != nullptr) {
+      switch (EVP_PKEY_base_id(pkey)) {
+        case EVP_PKEY_RSA:
+        case EVP_PKEY_RSA_PSS: {
+          RSA* rsa = EVP_PKEY_get0_RSA(pkey);
+          if (RSA_get_method(rsa) == RSA_PKCS1_OpenSSL())
+            RSA_set_method(rsa, OffloadRSAMethod());
+          break;
+        }
+        case EVP_PKEY_EC: {
+          EC_KEY* ec = EVP_PKEY_get0_EC_KEY(pkey);
+          if (EC_KEY_get_method(ec) == EC_KEY_OpenSSL())
+            EC_KEY_set_method(ec, OffloadECMethod());
+          break;
+        }
+      }
+    }
+    ret = SSL_CTX_set_current_cert(ctx, SSL_CERT_SET_NEXT);
+  }
+}
+
 void InitializeSecureContext(
     BaseObjectPtr<crypto::SecureContext> sc,
     bool early_data,
-    ngtcp2_crypto_side side) {
+    ngtcp2_crypto_side side,
+    bool offload_handshake) {
   // TODO(@jasnell): Using a static value for this at the moment but
   // we need to determine if a non-static or per-session value is better.
   constexpr static unsigned char session_id_ctx[] = "node.js quic server";
@@ -829,6 +1120,13 @@ void InitializeSecureContext(
           DecryptSessionTicket,
           nullptr);
 
+      // Replaces the per-SecureContext ticket key so that tickets are
+      // protected by the QuicSocket's rotating, shareable key ring.
+      SSL_CTX_set_tlsext_ticket_key_cb(**sc, TicketKeyCallback);
+
+      if (offload_handshake)
+        EnableHandshakeOffload(**sc);
+
       if (early_data) {
         SSL_CTX_set_max_early_data(**sc, 0xffffffff);
         SSL_CTX_set_allow_early_data_cb(**sc, AllowEarlyDataCB, nullptr);
@@ -858,6 +1156,146 @@ void InitializeSecureContext(
   SSL_CTX_set_quic_method(**sc, &quic_method);
 }
 
+QuicTicketKeyRing::QuicTicketKeyRing(
+    const uint8_t* secret,
+    uint64_t rotation)
+    : rotation_(rotation) {
+  CHECK_GT(rotation, 0);
+  if (secret != nullptr)
+    memcpy(secret_, secret, kTicketKeySecretLen);
+  else
+    EntropySource(secret_, kTicketKeySecretLen);
+  uv_timeval64_t tv;
+  CHECK_EQ(uv_gettimeofday(&tv), 0);
+  Update(tv.tv_sec);
+}
+
+QuicTicketKeyRing::~QuicTicketKeyRing() {
+  ClearKeys();
+  OPENSSL_cleanse(secret_, kTicketKeySecretLen);
+}
+
+void QuicTicketKeyRing::ClearKeys() {
+  OPENSSL_cleanse(keys_.data(), keys_.size() * sizeof(Key));
+  keys_.clear();
+}
+
+// The secret is not used for explicit keys, so it is wiped as well.
+void QuicTicketKeyRing::SetKeys(const uint8_t* data, size_t count) {
+  static_assert(sizeof(Key) == kTicketKeyLen, "Unexpected ticket key size");
+  CHECK_GT(count, 0);
+  explicit_ = true;
+  OPENSSL_cleanse(secret_, kTicketKeySecretLen);
+  ClearKeys();
+  keys_.resize(count);
+  memcpy(keys_.data(), data, count * kTicketKeyLen);
+}
+
+// The key for an interval is expanded from the secret with an
+// info string that includes the big-endian interval number.
+bool QuicTicketKeyRing::DeriveKey(uint64_t interval, Key* key) const {
+  static constexpr char kInfoPrefix[] = "node.js quic ticket key";
+  uint8_t info[sizeof(kInfoPrefix) - 1 + sizeof(uint64_t)];
+  memcpy(info, kInfoPrefix, sizeof(kInfoPrefix) - 1);
+  for (size_t n = 0; n < sizeof(uint64_t); n++)
+    info[sizeof(info) - 1 - n] = static_cast<uint8_t>(interval >> (n * 8));
+
+  ngtcp2_crypto_ctx ctx;
+  ngtcp2_crypto_ctx_initial(&ctx);
+  return NGTCP2_OK(ngtcp2_crypto_hkdf_expand(
+      reinterpret_cast<uint8_t*>(key),
+      sizeof(*key),
+      &ctx.md,
+      secret_,
+      kTicketKeySecretLen,
+      info,
+      sizeof(info)));
+}
+
+void QuicTicketKeyRing::Update(uint64_t now) {
+  uint64_t interval = now / rotation_;
+  if (explicit_ || (!keys_.empty() && interval == interval_))
+    return;
+
+  // The key of the current interval comes first, followed by
+  // those of the previous and next intervals.
+  std::vector<Key> keys(3);
+  CHECK(DeriveKey(interval, &keys[0]));
+  CHECK(DeriveKey(interval - 1, &keys[1]));
+  CHECK(DeriveKey(interval + 1, &keys[2]));
+  ClearKeys();
+  keys_ = std::move(keys);
+  interval_ = interval;
+}
+
+int QuicTicketKeyRing::Find(const uint8_t* name) const {
+  for (size_t n = 0; n < keys_.size(); n++) {
+    if (memcmp(keys_[n].name, name, sizeof(keys_[n].name)) == 0)
+      return static_cast<int>(n);
+  }
+  return -1;
+}
+
+// Returns 1 when a ticket is encrypted or is decrypted with the current
+// key, 2 when it is decrypted with another key and should be renewed,
+// 0 when the key is unknown, and -1 on error.
+int QuicTicketKeyRing::Callback(
+    unsigned char* name,
+    unsigned char* iv,
+    EVP_CIPHER_CTX* ectx,
+    HMAC_CTX* hctx,
+    int enc) {
+  uv_timeval64_t tv;
+  if (uv_gettimeofday(&tv) == 0)
+    Update(tv.tv_sec);
+
+  if (enc) {
+    const Key& key = current();
+    memcpy(name, key.name, sizeof(key.name));
+    if (RAND_bytes(iv, 16) <= 0 ||
+        EVP_EncryptInit_ex(
+            ectx, EVP_aes_128_cbc(), nullptr, key.aes_secret, iv) <= 0 ||
+        HMAC_Init_ex(
+            hctx,
+            key.hmac_secret,
+            sizeof(key.hmac_secret),
+            EVP_sha256(),
+            nullptr) <= 0) {
+      return -1;
+    }
+    return 1;
+  }
+
+  int index = Find(name);
+  if (index < 0)
+    return 0;
+
+  const Key& key = keys_[index];
+  if (EVP_DecryptInit_ex(
+          ectx, EVP_aes_128_cbc(), nullptr, key.aes_secret, iv) <= 0 ||
+      HMAC_Init_ex(
+          hctx,
+          key.hmac_secret,
+          sizeof(key.hmac_secret),
+          EVP_sha256(),
+          nullptr) <= 0) {
+    return -1;
+  }
+  return index == 0 ? 1 : 2;
+}
+
+int TicketKeyCallback(
+    SSL* ssl,
+    unsigned char* name,
+    unsigned char* iv,
+    EVP_CIPHER_CTX* ectx,
+    HMAC_CTX* hctx,
+    int enc) {
+  QuicSession* session = static_cast<QuicSession*>(SSL_get_app_data(ssl));
+  return session->socket()->ticket_keys()->Callback(
+      name, iv, ectx, hctx, enc);
+}
+
 bool DeriveAndInstallInitialKey(
     const QuicSession& session,
     const QuicCID& dcid) {
@@ -870,19 +1308,353 @@ bool DeriveAndInstallInitialKey(
   uint8_t tx_hp[NGTCP2_CRYPTO_INITIAL_KEYLEN];
   uint8_t rx_iv[NGTCP2_CRYPTO_INITIAL_IVLEN];
   uint8_t tx_iv[NGTCP2_CRYPTO_INITIAL_IVLEN];
-  return NGTCP2_OK(ngtcp2_crypto_derive_and_install_initial_key(
-      session.connection(),
-      rx_secret,
-      tx_secret,
-      initial_secret,
-      rx_key,
-      rx_iv,
-      rx_hp,
-      tx_key,
-      tx_iv,
-      tx_hp,
-      dcid.cid(),
-      session.crypto_context()->side()));
+  if (NGTCP2_ERR(ngtcp2_crypto_derive_and_install_initial_key(
+          session.connection(),
+          rx_secret,
+          tx_secret,
+          initial_secret,
+          rx_key,
+          rx_iv,
+          rx_hp,
+          tx_key,
+          tx_iv,
+          tx_hp,
+          dcid.cid(),
+          session.crypto_context()->side()))) {
+    return false;
+  }
+
+  ngtcp2_crypto_ctx ctx;
+  ngtcp2_crypto_ctx_initial(&ctx);
+  session.crypto_context()->packet_protection(NGTCP2_CRYPTO_LEVEL_INITIAL)
+      ->Install(ctx, rx_key, rx_hp, tx_key, tx_hp);
+  return true;
+}
+
+namespace {
+// Packet and header protection keys are HKDF output, so their
+// leading bytes are uniformly distributed and serve as a hash.
+struct QuicPacketCipherIdHash {
+  size_t operator()(const QuicPacketCipher::Id& id) const {
+    size_t hash;
+    memcpy(&hash, id.key, sizeof(hash));
+    return hash ^ reinterpret_cast<uintptr_t>(id.cipher) ^ id.operation;
+  }
+};
+
+// The map's keys are copies of the packet protection keys, so its
+// memory is wiped before being released.
+template <typename T>
+struct CleansingAllocator : public std::allocator<T> {
+  template <typename U>
+  struct rebind { using other = CleansingAllocator<U>; };
+
+  CleansingAllocator() = default;
+  template <typename U>
+  CleansingAllocator(const CleansingAllocator<U>&) {}  // NOLINT
+
+  void deallocate(T* p, size_t n) {
+    OPENSSL_cleanse(p, n * sizeof(T));
+    std::allocator<T>::deallocate(p, n);
+  }
+};
+
+using QuicPacketCipherMap = std::unordered_map<
+    QuicPacketCipher::Id,
+    QuicPacketCipher*,
+    QuicPacketCipherIdHash,
+    std::equal_to<QuicPacketCipher::Id>,
+    CleansingAllocator<
+        std::pair<const QuicPacketCipher::Id, QuicPacketCipher*>>>;
+
+// ngtcp2's crypto callbacks receive only the key and no context,
+// so the ciphers are registered per thread under their key rather
+// than per QuicSession. A QuicPacketCipher is owned by the
+// QuicSession's QuicPacketProtection and is unregistered when the
+// keys are discarded or the QuicSession is destroyed.
+QuicPacketCipherMap& packet_ciphers() {
+  static thread_local QuicPacketCipherMap ciphers;
+  return ciphers;
+}
+
+bool GetPacketCipherId(
+    const EVP_CIPHER* cipher,
+    QuicPacketCipher::Operation operation,
+    const uint8_t* key,
+    QuicPacketCipher::Id* id) {
+  size_t keylen = EVP_CIPHER_key_length(cipher);
+  if (keylen > QuicPacketCipher::kMaxKeyLength)
+    return false;
+  id->cipher = cipher;
+  id->operation = operation;
+  memcpy(id->key, key, keylen);
+  memset(id->key + keylen, 0, QuicPacketCipher::kMaxKeyLength - keylen);
+  return true;
+}
+}  // namespace
+
+bool QuicPacketCipher::Id::operator==(const Id& other) const {
+  return cipher == other.cipher &&
+         operation == other.operation &&
+         memcmp(key, other.key, kMaxKeyLength) == 0;
+}
+
+std::unique_ptr<QuicPacketCipher> QuicPacketCipher::Create(
+    const EVP_CIPHER* cipher,
+    Operation operation,
+    const uint8_t* key) {
+  Id id;
+  auto cleanse = OnScopeLeave([&]() {
+    OPENSSL_cleanse(id.key, kMaxKeyLength);
+  });
+  // AES-CCM needs the message length before the additional data
+  // of every packet, so it is left to ngtcp2's implementation.
+  if (cipher == nullptr ||
+      cipher == EVP_aes_128_ccm() ||
+      !GetPacketCipherId(cipher, operation, key, &id)) {
+    return {};
+  }
+
+  CipherContextPointer ctx(EVP_CIPHER_CTX_new());
+  if (!ctx)
+    return {};
+
+  // The key is set once. Each packet only supplies the nonce,
+  // or the sample when masking the header.
+  switch (operation) {
+    case ENCRYPT:
+      if (!EVP_EncryptInit_ex(ctx.get(), cipher, nullptr, nullptr, nullptr) ||
+          !EVP_CIPHER_CTX_ctrl(
+              ctx.get(),
+              EVP_CTRL_AEAD_SET_IVLEN,
+              kNonceLength,
+              nullptr) ||
+          !EVP_EncryptInit_ex(ctx.get(), nullptr, nullptr, key, nullptr)) {
+        return {};
+      }
+      break;
+    case DECRYPT:
+      if (!EVP_DecryptInit_ex(ctx.get(), cipher, nullptr, nullptr, nullptr) ||
+          !EVP_CIPHER_CTX_ctrl(
+              ctx.get(),
+              EVP_CTRL_AEAD_SET_IVLEN,
+              kNonceLength,
+              nullptr) ||
+          !EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, key, nullptr)) {
+        return {};
+      }
+      break;
+    case HEADER_PROTECTION:
+      if (!EVP_EncryptInit_ex(ctx.get(), cipher, nullptr, key, nullptr))
+        return {};
+      break;
+  }
+
+  return std::unique_ptr<QuicPacketCipher>(
+      new QuicPacketCipher(id, std::move(ctx)));
+}
+
+QuicPacketCipher* QuicPacketCipher::Find(
+    const EVP_CIPHER* cipher,
+    Operation operation,
+    const uint8_t* key) {
+  Id id;
+  auto cleanse = OnScopeLeave([&]() {
+    OPENSSL_cleanse(id.key, kMaxKeyLength);
+  });
+  if (!GetPacketCipherId(cipher, operation, key, &id))
+    return nullptr;
+  QuicPacketCipherMap& ciphers = packet_ciphers();
+  auto it = ciphers.find(id);
+  return it != ciphers.end() ? it->second : nullptr;
+}
+
+// If another QuicPacketCipher is already registered for the same
+// key, it remains registered and serves both.
+QuicPacketCipher::QuicPacketCipher(const Id& id, CipherContextPointer ctx)
+    : id_(id),
+      ctx_(std::move(ctx)),
+      taglen_(id.operation == HEADER_PROTECTION ? 0 : EVP_GCM_TLS_TAG_LEN) {
+  static_assert(EVP_GCM_TLS_TAG_LEN == EVP_CHACHAPOLY_TLS_TAG_LEN,
+                "AEAD tag lengths must match");
+  packet_ciphers().emplace(id_, this);
+}
+
+QuicPacketCipher::~QuicPacketCipher() {
+  QuicPacketCipherMap& ciphers = packet_ciphers();
+  auto it = ciphers.find(id_);
+  if (it != ciphers.end() && it->second == this)
+    ciphers.erase(it);
+  OPENSSL_cleanse(id_.key, kMaxKeyLength);
+}
+
+bool QuicPacketCipher::Encrypt(
+    uint8_t* dest,
+    const uint8_t* plaintext,
+    size_t plaintextlen,
+    const uint8_t* nonce,
+    const uint8_t* ad,
+    size_t adlen) {
+  int len;
+  return EVP_EncryptInit_ex(ctx_.get(), nullptr, nullptr, nullptr, nonce) &&
+         EVP_EncryptUpdate(ctx_.get(), nullptr, &len, ad, adlen) &&
+         EVP_EncryptUpdate(ctx_.get(), dest, &len, plaintext, plaintextlen) &&
+         EVP_EncryptFinal_ex(ctx_.get(), dest + len, &len) &&
+         EVP_CIPHER_CTX_ctrl(
+             ctx_.get(),
+             EVP_CTRL_AEAD_GET_TAG,
+             taglen_,
+             dest + plaintextlen);
+}
+
+bool QuicPacketCipher::Decrypt(
+    uint8_t* dest,
+    const uint8_t* ciphertext,
+    size_t ciphertextlen,
+    const uint8_t* nonce,
+    const uint8_t* ad,
+    size_t adlen) {
+  if (ciphertextlen < static_cast<size_t>(taglen_))
+    return false;
+  ciphertextlen -= taglen_;
+  uint8_t* tag = const_cast<uint8_t*>(ciphertext + ciphertextlen);
+  int len;
+  return EVP_DecryptInit_ex(ctx_.get(), nullptr, nullptr, nullptr, nonce) &&
+         EVP_DecryptUpdate(ctx_.get(), nullptr, &len, ad, adlen) &&
+         EVP_DecryptUpdate(
+             ctx_.get(),
+             dest,
+             &len,
+             ciphertext,
+             ciphertextlen) &&
+         EVP_CIPHER_CTX_ctrl(ctx_.get(), EVP_CTRL_AEAD_SET_TAG, taglen_, tag) &&
+         EVP_DecryptFinal_ex(ctx_.get(), dest + ciphertextlen, &len);
+}
+
+bool QuicPacketCipher::Mask(uint8_t* dest, const uint8_t* sample) {
+  static constexpr uint8_t kPlaintext[5] = {};
+  int len;
+  return EVP_EncryptInit_ex(ctx_.get(), nullptr, nullptr, nullptr, sample) &&
+         EVP_EncryptUpdate(
+             ctx_.get(),
+             dest,
+             &len,
+             kPlaintext,
+             arraysize(kPlaintext)) &&
+         EVP_EncryptFinal_ex(ctx_.get(), dest + arraysize(kPlaintext), &len);
+}
+
+void QuicPacketProtection::Install(
+    const ngtcp2_crypto_ctx& ctx,
+    const uint8_t* rx_key,
+    const uint8_t* rx_hp,
+    const uint8_t* tx_key,
+    const uint8_t* tx_hp) {
+  const EVP_CIPHER* aead =
+      static_cast<const EVP_CIPHER*>(ctx.aead.native_handle);
+  const EVP_CIPHER* hp = static_cast<const EVP_CIPHER*>(ctx.hp.native_handle);
+  Discard();
+  if (rx_key != nullptr) {
+    rx_[0] = QuicPacketCipher::Create(aead, QuicPacketCipher::DECRYPT, rx_key);
+    rx_hp_ = QuicPacketCipher::Create(
+        hp,
+        QuicPacketCipher::HEADER_PROTECTION,
+        rx_hp);
+  }
+  if (tx_key != nullptr) {
+    tx_[0] = QuicPacketCipher::Create(aead, QuicPacketCipher::ENCRYPT, tx_key);
+    tx_hp_ = QuicPacketCipher::Create(
+        hp,
+        QuicPacketCipher::HEADER_PROTECTION,
+        tx_hp);
+  }
+}
+
+void QuicPacketProtection::Discard() {
+  for (size_t n = 0; n < kKeyPhases; n++) {
+    rx_[n].reset();
+    tx_[n].reset();
+  }
+  phase_ = 0;
+  rx_hp_.reset();
+  tx_hp_.reset();
+}
+
+void QuicPacketProtection::Update(
+    const ngtcp2_crypto_aead& aead,
+    const uint8_t* rx_key,
+    const uint8_t* tx_key) {
+  const EVP_CIPHER* cipher = static_cast<const EVP_CIPHER*>(aead.native_handle);
+  phase_ = (phase_ + 1) % kKeyPhases;
+  rx_[phase_] =
+      QuicPacketCipher::Create(cipher, QuicPacketCipher::DECRYPT, rx_key);
+  tx_[phase_] =
+      QuicPacketCipher::Create(cipher, QuicPacketCipher::ENCRYPT, tx_key);
+}
+
+int EncryptPacket(
+    uint8_t* dest,
+    const ngtcp2_crypto_aead* aead,
+    const uint8_t* plaintext,
+    size_t plaintextlen,
+    const uint8_t* key,
+    const uint8_t* nonce,
+    size_t noncelen,
+    const uint8_t* ad,
+    size_t adlen) {
+  QuicPacketCipher* cipher =
+      noncelen == QuicPacketCipher::kNonceLength ?
+          QuicPacketCipher::Find(
+              static_cast<const EVP_CIPHER*>(aead->native_handle),
+              QuicPacketCipher::ENCRYPT,
+              key) :
+          nullptr;
+  if (cipher == nullptr) {
+    return ngtcp2_crypto_encrypt_cb(
+        dest, aead, plaintext, plaintextlen, key, nonce, noncelen, ad, adlen);
+  }
+  return cipher->Encrypt(dest, plaintext, plaintextlen, nonce, ad, adlen) ?
+      0 : NGTCP2_ERR_CALLBACK_FAILURE;
+}
+
+int DecryptPacket(
+    uint8_t* dest,
+    const ngtcp2_crypto_aead* aead,
+    const uint8_t* ciphertext,
+    size_t ciphertextlen,
+    const uint8_t* key,
+    const uint8_t* nonce,
+    size_t noncelen,
+    const uint8_t* ad,
+    size_t adlen) {
+  QuicPacketCipher* cipher =
+      noncelen == QuicPacketCipher::kNonceLength ?
+          QuicPacketCipher::Find(
+              static_cast<const EVP_CIPHER*>(aead->native_handle),
+              QuicPacketCipher::DECRYPT,
+              key) :
+          nullptr;
+  if (cipher == nullptr) {
+    return ngtcp2_crypto_decrypt_cb(
+        dest, aead, ciphertext, ciphertextlen, key, nonce, noncelen, ad, adlen);
+  }
+  return cipher->Decrypt(dest, ciphertext, ciphertextlen, nonce, ad, adlen) ?
+      0 : NGTCP2_ERR_TLS_DECRYPT;
+}
+
+int GetHeaderProtectionMask(
+    uint8_t* dest,
+    const ngtcp2_crypto_cipher* hp,
+    const uint8_t* hp_key,
+    const uint8_t* sample) {
+  QuicPacketCipher* cipher =
+      QuicPacketCipher::Find(
+          static_cast<const EVP_CIPHER*>(hp->native_handle),
+          QuicPacketCipher::HEADER_PROTECTION,
+          hp_key);
+  if (cipher == nullptr)
+    return ngtcp2_crypto_hp_mask_cb(dest, hp, hp_key, sample);
+  return cipher->Mask(dest, sample) ? 0 : NGTCP2_ERR_CALLBACK_FAILURE;
 }
 
 ngtcp2_crypto_level from_ossl_level(OSSL_ENCRYPTION_LEVEL ossl_level) {
@@ -9,8 +9,13 @@
 
 #include <ngtcp2/ngtcp2.h>
 #include <ngtcp2/ngtcp2_crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/ssl.h>
 
+#include <memory>
+#include <vector>
+
 namespace node {
 
 namespace quic {
@@ -21,6 +26,7 @@ namespace quic {
 // Forward declaration
 class QuicSession;
 class QuicPacket;
+class QuicSocket;
 
 // many ngtcp2 functions return 0 to indicate success
 // and non-zero to indicate failure. Most of the time,
@@ -36,7 +42,18 @@ class QuicPacket;
 void InitializeSecureContext(
     BaseObjectPtr<crypto::SecureContext> sc,
     bool early_data,
-    ngtcp2_crypto_side side);
+    ngtcp2_crypto_side side,
+    bool offload_handshake = false);
+
+// The RSA or ECDSA signature in the CertificateVerify message is the
+// most expensive part of a full server handshake. Handshake offload
+// moves it off the event loop: the SSL_CTX runs handshakes as OpenSSL
+// async jobs, and its private keys use RSA and EC_KEY methods that,
+// within a job, sign on the libuv threadpool and pause the job until
+// the signature is ready. The QuicCryptoContext then resumes the
+// handshake. Keys of other types, or keys provided by an engine, are
+// still used synchronously.
+void EnableHandshakeOffload(SSL_CTX* ctx);
 
 // Called in the QuicSession::InitServer and
 // QuicSession::InitClient to configure the
@@ -77,6 +94,7 @@ bool GenerateResetToken(
 //   * be specific to the original cid
 //   * contain random data.
 std::unique_ptr<QuicPacket> GenerateRetryPacket(
+    QuicSocket* socket,
     const uint8_t* token_secret,
     const QuicCID& dcid,
     const QuicCID& scid,
@@ -107,6 +125,24 @@ bool InvalidRetryToken(
     const uint8_t* token_secret,
     uint64_t verification_expiration);
 
+// Generates a token for a NEW_TOKEN frame that the client at addr can
+// present in the Initial packet of a future connection in place of a
+// retry token. token must have room for kMaxNewTokenLen bytes.
+bool GenerateNewToken(
+    uint8_t* token,
+    size_t* tokenlen,
+    const SocketAddress& addr,
+    const uint8_t* token_secret);
+
+// Verifies the validity of a token generated by GenerateNewToken.
+// Returns true if the token is *not valid*, false otherwise. The
+// token is valid for verification_expiration seconds.
+bool InvalidNewToken(
+    const ngtcp2_pkt_hd& hd,
+    const SocketAddress& addr,
+    const uint8_t* token_secret,
+    uint64_t verification_expiration);
+
 int VerifyHostnameIdentity(const crypto::SSLPointer& ssl, const char* hostname);
 int VerifyHostnameIdentity(
     const char* hostname,
@@ -116,6 +152,142 @@ int VerifyHostnameIdentity(
 // Get the ALPN protocol identifier that was negotiated for the session
 v8::Local<v8::Value> GetALPNProtocol(const QuicSession& session);
 
+// ngtcp2 passes the raw key to the encrypt, decrypt and hp_mask callbacks
+// for every packet, and ngtcp2's own OpenSSL callbacks allocate and key a
+// new EVP_CIPHER_CTX on every call. A QuicPacketCipher is an EVP_CIPHER_CTX
+// that is keyed once for a single packet or header protection key. While
+// it exists it is registered, per thread, under its cipher, operation and
+// key. EncryptPacket, DecryptPacket and GetHeaderProtectionMask look it up
+// so that only the nonce or sample has to be set per packet. Keys without
+// a QuicPacketCipher are handled by ngtcp2's implementation.
+class QuicPacketCipher final {
+ public:
+  enum Operation : uint8_t {
+    ENCRYPT,
+    DECRYPT,
+    HEADER_PROTECTION
+  };
+
+  static constexpr size_t kMaxKeyLength = 32;
+  static constexpr size_t kNonceLength = 12;
+
+  struct Id {
+    const EVP_CIPHER* cipher;
+    Operation operation;
+    uint8_t key[kMaxKeyLength];
+
+    bool operator==(const Id& other) const;
+  };
+
+  // Returns an empty pointer if the cipher is not supported
+  // or the OpenSSL context could not be initialized.
+  static std::unique_ptr<QuicPacketCipher> Create(
+      const EVP_CIPHER* cipher,
+      Operation operation,
+      const uint8_t* key);
+
+  // Returns the QuicPacketCipher registered for the key, if any.
+  static QuicPacketCipher* Find(
+      const EVP_CIPHER* cipher,
+      Operation operation,
+      const uint8_t* key);
+
+  ~QuicPacketCipher();
+
+  bool Encrypt(
+      uint8_t* dest,
+      const uint8_t* plaintext,
+      size_t plaintextlen,
+      const uint8_t* nonce,
+      const uint8_t* ad,
+      size_t adlen);
+
+  bool Decrypt(
+      uint8_t* dest,
+      const uint8_t* ciphertext,
+      size_t ciphertextlen,
+      const uint8_t* nonce,
+      const uint8_t* ad,
+      size_t adlen);
+
+  bool Mask(uint8_t* dest, const uint8_t* sample);
+
+ private:
+  using CipherContextPointer =
+      DeleteFnPtr<EVP_CIPHER_CTX, EVP_CIPHER_CTX_free>;
+
+  QuicPacketCipher(const Id& id, CipherContextPointer ctx);
+
+  Id id_;
+  CipherContextPointer ctx_;
+  int taglen_;
+};
+
+// The QuicPacketCiphers for the keys of a single encryption level.
+// For the application level, the ciphers for the previous, current
+// and next key phase are kept, matching the keys held by ngtcp2.
+class QuicPacketProtection final {
+ public:
+  // Replaces the ciphers with ones for newly installed keys. The
+  // keys of a direction that is not used are passed as nullptr.
+  void Install(
+      const ngtcp2_crypto_ctx& ctx,
+      const uint8_t* rx_key,
+      const uint8_t* rx_hp,
+      const uint8_t* tx_key,
+      const uint8_t* tx_hp);
+
+  // Releases the ciphers once ngtcp2 has discarded the keys.
+  void Discard();
+
+  // Adds the ciphers for the packet protection keys of the next
+  // key phase, releasing those of the oldest key phase. Header
+  // protection keys do not change with the key phase.
+  void Update(
+      const ngtcp2_crypto_aead& aead,
+      const uint8_t* rx_key,
+      const uint8_t* tx_key);
+
+ private:
+  static constexpr size_t kKeyPhases = 3;
+
+  std::unique_ptr<QuicPacketCipher> rx_hp_;
+  std::unique_ptr<QuicPacketCipher> tx_hp_;
+  std::unique_ptr<QuicPacketCipher> rx_[kKeyPhases];
+  std::unique_ptr<QuicPacketCipher> tx_[kKeyPhases];
+  size_t phase_ = 0;
+};
+
+// ngtcp2 encrypt, decrypt and hp_mask callbacks that use the
+// registered QuicPacketCiphers.
+int EncryptPacket(
+    uint8_t* dest,
+    const ngtcp2_crypto_aead* aead,
+    const uint8_t* plaintext,
+    size_t plaintextlen,
+    const uint8_t* key,
+    const uint8_t* nonce,
+    size_t noncelen,
+    const uint8_t* ad,
+    size_t adlen);
+
+int DecryptPacket(
+    uint8_t* dest,
+    const ngtcp2_crypto_aead* aead,
+    const uint8_t* ciphertext,
+    size_t ciphertextlen,
+    const uint8_t* key,
+    const uint8_t* nonce,
+    size_t noncelen,
+    const uint8_t* ad,
+    size_t adlen);
+
+int GetHeaderProtectionMask(
+    uint8_t* dest,
+    const ngtcp2_crypto_cipher* hp,
+    const uint8_t* hp_key,
+    const uint8_t* sample);
+
 ngtcp2_crypto_level from_ossl_level(OSSL_ENCRYPTION_LEVEL ossl_level);
 const char* crypto_level_name(ngtcp2_crypto_level level);
 
@@ -150,6 +322,87 @@ class SessionTicketAppData {
   SSL_SESSION* session_;
 };
 
+// A QuicTicketKeyRing holds the keys a server QuicSocket uses to
+// encrypt and decrypt TLS session tickets. Each key is kTicketKeyLen
+// bytes, laid out as a 16 byte name, a 16 byte HMAC-SHA256 key and a
+// 16 byte AES-128-CBC key -- the same format as tls ticketKeys.
+//
+// By default the keys are derived from a secret using HKDF, one key
+// per rotation interval of wall clock time. The key of the current
+// interval encrypts new tickets, while those of the previous and next
+// intervals are still accepted, so that tickets survive a rotation and
+// modest clock skew between servers. Servers that share the secret
+// derive the same keys, so a ticket issued by any of them resumes a
+// session -- with 0RTT -- on any other. Alternatively, the keys can be
+// set explicitly, for instance by an external key distribution
+// service, in which case the first key is the current one.
+class QuicTicketKeyRing final : public MemoryRetainer {
+ public:
+  struct Key {
+    uint8_t name[16];
+    uint8_t hmac_secret[16];
+    uint8_t aes_secret[16];
+  };
+
+  // If secret is nullptr, a random secret is used, and the keys
+  // cannot be shared.
+  QuicTicketKeyRing(const uint8_t* secret, uint64_t rotation);
+  ~QuicTicketKeyRing() override;
+
+  QuicTicketKeyRing(const QuicTicketKeyRing&) = delete;
+  QuicTicketKeyRing& operator=(const QuicTicketKeyRing&) = delete;
+
+  // Replaces the ring with count explicit keys of kTicketKeyLen bytes
+  // each. Explicit keys are not rotated.
+  void SetKeys(const uint8_t* data, size_t count);
+
+  // Derives the keys for the rotation interval that includes now,
+  // in seconds since the epoch, if they are not derived yet.
+  void Update(uint64_t now);
+
+  // Returns the index of the key with the given name, or -1.
+  int Find(const uint8_t* name) const;
+
+  // Implements the semantics of the OpenSSL tlsext ticket key
+  // callback for the current wall clock time.
+  int Callback(
+      unsigned char* name,
+      unsigned char* iv,
+      EVP_CIPHER_CTX* ectx,
+      HMAC_CTX* hctx,
+      int enc);
+
+  const Key& current() const { return keys_[0]; }
+  size_t size() const { return keys_.size(); }
+  uint64_t rotation() const { return rotation_; }
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(QuicTicketKeyRing)
+  SET_SELF_SIZE(QuicTicketKeyRing)
+
+ private:
+  bool DeriveKey(uint64_t interval, Key* key) const;
+
+  // Wipes and removes the keys.
+  void ClearKeys();
+
+  uint8_t secret_[kTicketKeySecretLen];
+  uint64_t rotation_;
+  uint64_t interval_ = 0;
+  bool explicit_ = false;
+  std::vector<Key> keys_;
+};
+
+// The tlsext ticket key callback installed on server SecureContexts.
+// It uses the QuicTicketKeyRing of the session's QuicSocket.
+int TicketKeyCallback(
+    SSL* ssl,
+    unsigned char* name,
+    unsigned char* iv,
+    EVP_CIPHER_CTX* ectx,
+    HMAC_CTX* hctx,
+    int enc);
+
 }  // namespace quic
 }  // namespace node
 
@@ -54,7 +54,7 @@ void DefaultApplication::ScheduleStream(int64_t stream_id) {
   BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
   Debug(session(), "Scheduling stream %" PRIu64, stream_id);
   if (LIKELY(stream))
-    stream->Schedule(&stream_queue_);
+    scheduler_.Schedule(stream.get());
 }
 
 void DefaultApplication::UnscheduleStream(int64_t stream_id) {
@@ -80,6 +80,25 @@ void DefaultApplication::ResumeStream(int64_t stream_id) {
   ScheduleStream(stream_id);
 }
 
+// A QuicStream that is blocked by flow control is taken out of the
+// schedule until the peer extends the stream's flow control window.
+bool DefaultApplication::BlockStream(int64_t stream_id) {
+  UnscheduleStream(stream_id);
+  return true;
+}
+
+void DefaultApplication::ExtendMaxStreamData(
+    int64_t stream_id,
+    uint64_t max_data) {
+  ScheduleStream(stream_id);
+}
+
+void DefaultApplication::StreamPriorityChanged(int64_t stream_id) {
+  BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
+  if (LIKELY(stream))
+    scheduler_.Reschedule(stream.get());
+}
+
 bool DefaultApplication::ReceiveStreamData(
     int64_t stream_id,
     int fin,
@@ -115,7 +134,7 @@ bool DefaultApplication::ReceiveStreamData(
 }
 
 int DefaultApplication::GetStreamData(StreamData* stream_data) {
-  QuicStream* stream = stream_queue_.PopFront();
+  QuicStream* stream = scheduler_.PopFront();
   // If stream is nullptr, there are no streams with data pending.
   if (stream == nullptr)
     return 0;
@@ -141,7 +160,7 @@ int DefaultApplication::GetStreamData(StreamData* stream_data) {
     stream_data->count = count;
 
     if (count > 0) {
-      stream->Schedule(&stream_queue_);
+      scheduler_.Requeue(stream);
       stream_data->remaining = get_length(data, count);
     } else {
       stream_data->remaining = 0;
@@ -166,6 +185,7 @@ bool DefaultApplication::StreamCommit(
   CHECK(stream_data->stream);
   stream_data->remaining -= datalen;
   Consume(&stream_data->buf, &stream_data->count, datalen);
+  scheduler_.Commit(stream_data->stream.get(), datalen);
   stream_data->stream->Commit(datalen);
   return true;
 }
@@ -37,7 +37,10 @@ class DefaultApplication final : public QuicApplication {
 
   int GetStreamData(StreamData* stream_data) override;
 
+  bool BlockStream(int64_t stream_id) override;
+  void ExtendMaxStreamData(int64_t stream_id, uint64_t max_data) override;
   void ResumeStream(int64_t stream_id) override;
+  void StreamPriorityChanged(int64_t stream_id) override;
   void StreamClose(int64_t stream_id, uint64_t app_error_code) override;
   bool ShouldSetFin(const StreamData& stream_data) override;
   bool StreamCommit(StreamData* stream_data, size_t datalen) override;
@@ -50,7 +53,7 @@ class DefaultApplication final : public QuicApplication {
   void ScheduleStream(int64_t stream_id);
   void UnscheduleStream(int64_t stream_id);
 
-  QuicStream::Queue stream_queue_;
+  QuicStreamScheduler scheduler_;
 };
 
 }  // namespace quic
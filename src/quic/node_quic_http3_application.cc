@@ -41,6 +41,73 @@ const char* Http3HeaderTraits::ToHttpHeaderName(int32_t token) {
 #undef V1
 #undef V2
 
+namespace {
+inline bool IsPriorityHeader(const uint8_t* name, size_t namelen) {
+  static constexpr char kPriority[] = "priority";
+  return namelen == arraysize(kPriority) - 1 &&
+         StringEqualNoCaseN(
+             reinterpret_cast<const char*>(name),
+             kPriority,
+             namelen);
+}
+
+inline bool IsPriorityDelimiter(uint8_t c) {
+  return c == ',' || c == ';' || c == ' ' || c == '\t';
+}
+
+// Applies the urgency (u) and incremental (i) parameters of an
+// Extensible Priorities header value (e.g. "u=1, i") to the
+// QuicStream. The value is a Structured Fields dictionary; members
+// other than u and i, member parameters, and invalid values are
+// ignored, leaving the current priority in place.
+void ApplyPriorityHeader(
+    QuicStream* stream,
+    const uint8_t* value,
+    size_t valuelen) {
+  uint8_t urgency = stream->urgency();
+  bool incremental = stream->is_incremental();
+  const uint8_t* end = value + valuelen;
+  while (value < end) {
+    while (value < end && (*value == ',' || *value == ' ' || *value == '\t'))
+      value++;
+    const uint8_t* key = value;
+    while (value < end && *value != '=' && !IsPriorityDelimiter(*value))
+      value++;
+    size_t keylen = value - key;
+    const uint8_t* item = nullptr;
+    size_t itemlen = 0;
+    if (value < end && *value == '=') {
+      item = ++value;
+      while (value < end && !IsPriorityDelimiter(*value))
+        value++;
+      itemlen = value - item;
+    }
+    // Skip any parameters of the member.
+    while (value < end && *value != ',')
+      value++;
+
+    if (keylen != 1)
+      continue;
+    switch (key[0]) {
+      case 'u':
+        if (itemlen == 1 && item[0] >= '0' && item[0] <= '7')
+          urgency = item[0] - '0';
+        break;
+      case 'i':
+        // A bare key is the boolean true.
+        if (item == nullptr)
+          incremental = true;
+        else if (itemlen == 2 && item[0] == '?' && item[1] == '1')
+          incremental = true;
+        else if (itemlen == 2 && item[0] == '?' && item[1] == '0')
+          incremental = false;
+        break;
+    }
+  }
+  stream->SetPriority(urgency, incremental);
+}
+}  // namespace
+
 template <typename M, typename T>
 void Http3Application::SetConfig(
     int idx,
@@ -171,11 +238,15 @@ bool Http3Application::SubmitInformation(
       "Submitting %d informational headers for stream %" PRId64,
       headers.length(),
       id);
-  return nghttp3_conn_submit_info(
-      connection(),
-      id,
-      headers.data(),
-      headers.length()) == 0;
+  if (nghttp3_conn_submit_info(
+          connection(),
+          id,
+          headers.data(),
+          headers.length()) != 0) {
+    return false;
+  }
+  ScheduleStream(id);
+  return true;
 }
 
 bool Http3Application::SubmitTrailers(
@@ -187,11 +258,15 @@ bool Http3Application::SubmitTrailers(
       "Submitting %d trailing headers for stream %" PRId64,
       headers.length(),
       id);
-  return nghttp3_conn_submit_trailers(
-      connection(),
-      id,
-      headers.data(),
-      headers.length()) == 0;
+  if (nghttp3_conn_submit_trailers(
+          connection(),
+          id,
+          headers.data(),
+          headers.length()) != 0) {
+    return false;
+  }
+  ScheduleStream(id);
+  return true;
 }
 
 bool Http3Application::SubmitHeaders(
@@ -205,25 +280,41 @@ bool Http3Application::SubmitHeaders(
   if (!(flags & QUICSTREAM_HEADER_FLAGS_TERMINAL))
     reader_ptr = &reader;
 
+  int err;
   switch (session()->crypto_context()->side()) {
-    case NGTCP2_CRYPTO_SIDE_CLIENT:
-      return nghttp3_conn_submit_request(
+    case NGTCP2_CRYPTO_SIDE_CLIENT: {
+      // The priority a client signals for a request also
+      // orders the request data the client sends.
+      BaseObjectPtr<QuicStream> stream = session()->FindStream(id);
+      for (size_t n = 0; stream && n < headers.length(); n++) {
+        const nghttp3_nv& nv = headers.data()[n];
+        if (IsPriorityHeader(nv.name, nv.namelen))
+          ApplyPriorityHeader(stream.get(), nv.value, nv.valuelen);
+      }
+      err = nghttp3_conn_submit_request(
           connection(),
           id,
           headers.data(),
           headers.length(),
           reader_ptr,
-          nullptr) == 0;
+          nullptr);
+      break;
+    }
     case NGTCP2_CRYPTO_SIDE_SERVER:
-      return nghttp3_conn_submit_response(
+      err = nghttp3_conn_submit_response(
           connection(),
           id,
           headers.data(),
           headers.length(),
-          reader_ptr) == 0;
+          reader_ptr);
+      break;
     default:
       UNREACHABLE();
   }
+  if (err != 0)
+    return false;
+  ScheduleStream(id);
+  return true;
 }
 
 // SubmitPush initiates a push stream by first creating a push promise
@@ -300,6 +391,8 @@ void Http3Application::DecreaseAllocatedSize(size_t size) {
 void Http3Application::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackFieldWithSize("current_nghttp3_memory",
                               current_nghttp3_memory_);
+  tracker->TrackField("ready_streams", ready_streams_);
+  tracker->TrackField("priority_blocked", priority_blocked_);
 }
 
 // Creates the underlying nghttp3 connection state for the session.
@@ -437,6 +530,7 @@ void Http3Application::StreamClose(
     uint64_t app_error_code) {
   if (app_error_code == 0)
     app_error_code = NGTCP2_APP_NOERROR;
+  UnscheduleStream(stream_id);
   nghttp3_conn_close_stream(connection(), stream_id, app_error_code);
   QuicApplication::StreamClose(stream_id, app_error_code);
 }
@@ -452,6 +546,7 @@ void Http3Application::StreamReset(
 // is no data to send but the QuicStream is still writable, it will
 // be paused. When there's data available, the stream is resumed.
 void Http3Application::ResumeStream(int64_t stream_id) {
+  ScheduleStream(stream_id);
   nghttp3_conn_resume_stream(connection(), stream_id);
 }
 
@@ -461,12 +556,44 @@ void Http3Application::ResumeStream(int64_t stream_id) {
 void Http3Application::ExtendMaxStreamData(
     int64_t stream_id,
     uint64_t max_data) {
+  ScheduleStream(stream_id);
   nghttp3_conn_unblock_stream(connection(), stream_id);
 }
 
+void Http3Application::StreamPriorityChanged(int64_t stream_id) {
+  BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
+  if (LIKELY(stream))
+    ready_streams_.Reschedule(stream.get());
+}
+
+void Http3Application::ScheduleStream(int64_t stream_id) {
+  BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
+  if (LIKELY(stream))
+    ready_streams_.Schedule(stream.get());
+}
+
+void Http3Application::UnscheduleStream(int64_t stream_id) {
+  BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
+  if (LIKELY(stream))
+    stream->Unschedule();
+}
+
+// Lets nghttp3 select the streams held back by GetStreamData again.
+// Streams that have been closed in the meantime are no longer known
+// to nghttp3, so errors are ignored.
+void Http3Application::ReleasePriorityBlockedStreams() {
+  for (int64_t stream_id : priority_blocked_) {
+    Debug(session(), "Releasing stream %" PRId64, stream_id);
+    nghttp3_conn_unblock_stream(connection(), stream_id);
+  }
+  priority_blocked_.clear();
+  priority_blocked_urgency_ = kStreamUrgencyLevels;
+}
+
 // When stream data cannot be sent because of flow control, it is marked
 // as being blocked.
 bool Http3Application::BlockStream(int64_t stream_id) {
+  UnscheduleStream(stream_id);
   int err = nghttp3_conn_block_stream(connection(), stream_id);
   if (err != 0) {
     session()->set_last_error(QUIC_ERROR_APPLICATION, err);
@@ -496,20 +623,69 @@ bool Http3Application::StreamCommit(StreamData* stream_data, size_t datalen) {
 // provide any available stream data (if any). If nghttp3 is not sure if
 // there is data to send, it will subsequently call Http3Application::ReadData
 // to collect available data from the QuicStream.
+//
+// nghttp3 selects the stream to write without regard for the priority of
+// the QuicStreams. When it selects a request or push stream while a more
+// urgent QuicStream is ready to send, the selected stream is blocked in
+// nghttp3 and the selection is repeated. Held back streams are released
+// once no more urgent QuicStream remains ready.
 int Http3Application::GetStreamData(StreamData* stream_data) {
-  ssize_t ret = 0;
-  if (connection() && session()->max_data_left()) {
-    ret = nghttp3_conn_writev_stream(
-        connection(),
-        &stream_data->id,
-        &stream_data->fin,
-        reinterpret_cast<nghttp3_vec*>(stream_data->data),
-        sizeof(stream_data->data));
-    if (ret < 0)
-      return static_cast<int>(ret);
-    else
-      stream_data->remaining = stream_data->count = static_cast<size_t>(ret);
+  if (!priority_blocked_.empty() &&
+      ready_streams_.most_urgent() >= priority_blocked_urgency_) {
+    ReleasePriorityBlockedStreams();
+  }
+
+  for (;;) {
+    ssize_t ret = 0;
+    if (connection() && session()->max_data_left()) {
+      ret = nghttp3_conn_writev_stream(
+          connection(),
+          &stream_data->id,
+          &stream_data->fin,
+          reinterpret_cast<nghttp3_vec*>(stream_data->data),
+          sizeof(stream_data->data));
+      if (ret < 0)
+        return static_cast<int>(ret);
+      else
+        stream_data->remaining = stream_data->count = static_cast<size_t>(ret);
+    }
+
+    if (stream_data->id < 0) {
+      if (priority_blocked_.empty())
+        break;
+      // The more urgent QuicStreams that were thought to be ready
+      // had nothing to send, so the held back streams may proceed.
+      ready_streams_.UnscheduleMoreUrgentThan(priority_blocked_urgency_);
+      ReleasePriorityBlockedStreams();
+      continue;
+    }
+
+    if (is_control_stream(stream_data->id))
+      break;
+
+    BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_data->id);
+    if (!stream || stream->urgency() <= ready_streams_.most_urgent()) {
+      if (stream && stream_data->fin == 1)
+        stream->Unschedule();
+      break;
+    }
+
+    Debug(session(), "Holding back stream %" PRId64 " (urgency %d)",
+          stream_data->id,
+          static_cast<int>(stream->urgency()));
+    int err = nghttp3_conn_block_stream(connection(), stream_data->id);
+    if (err != 0) {
+      session()->set_last_error(QUIC_ERROR_APPLICATION, err);
+      return err;
+    }
+    priority_blocked_.push_back(stream_data->id);
+    priority_blocked_urgency_ =
+        std::min(priority_blocked_urgency_, stream->urgency());
+    stream_data->id = -1;
+    stream_data->fin = 0;
+    stream_data->remaining = stream_data->count = 0;
   }
+
   if (stream_data->id > -1) {
     Debug(session(), "Selected %" PRId64 " buffers for stream %" PRId64 "%s",
           stream_data->count,
@@ -577,6 +753,10 @@ ssize_t Http3Application::ReadData(
       veccnt,
       kMaxVectorCount), 0);
 
+  // Until the stream is resumed, it has nothing more to send.
+  if (ret == NGHTTP3_ERR_WOULDBLOCK)
+    stream->Unschedule();
+
   return ret;
 }
 
@@ -590,6 +770,7 @@ void Http3Application::StreamClosed(
     uint64_t app_error_code) {
   BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
   CHECK(stream);
+  stream->Unschedule();
   stream->ReceiveData(1, nullptr, 0, 0);
   session()->listener()->OnStreamClose(stream_id, app_error_code);
 }
@@ -655,6 +836,13 @@ bool Http3Application::ReceiveHeader(
     Debug(session(), "Receiving header for stream %" PRId64, stream_id);
     BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
     CHECK(stream);
+    if (session()->is_server()) {
+      nghttp3_vec vec = nghttp3_rcbuf_get_buf(name);
+      if (IsPriorityHeader(vec.base, vec.len)) {
+        vec = nghttp3_rcbuf_get_buf(value);
+        ApplyPriorityHeader(stream.get(), vec.base, vec.len);
+      }
+    }
     if (token == NGHTTP3_QPACK_TOKEN__STATUS) {
       nghttp3_vec vec = nghttp3_rcbuf_get_buf(value);
       if (vec.base[0] == '1')
@@ -14,6 +14,8 @@
 #include <nghttp3/nghttp3.h>
 
 #include <string>
+#include <vector>
+
 namespace node {
 
 namespace quic {
@@ -112,6 +114,8 @@ class Http3Application final :
 
   void ExtendMaxStreamData(int64_t stream_id, uint64_t max_data) override;
 
+  void StreamPriorityChanged(int64_t stream_id) override;
+
   bool SubmitInformation(
       int64_t stream_id,
       v8::Local<v8::Array> headers) override;
@@ -145,6 +149,10 @@ class Http3Application final :
   nghttp3_conn* connection() const { return connection_.get(); }
   BaseObjectPtr<QuicStream> FindOrCreateStream(int64_t stream_id);
 
+  void ScheduleStream(int64_t stream_id);
+  void UnscheduleStream(int64_t stream_id);
+  void ReleasePriorityBlockedStreams();
+
   bool CreateAndBindControlStream();
   bool CreateAndBindQPackStreams();
   int64_t CreateAndBindPushStream(int64_t push_id);
@@ -201,6 +209,15 @@ class Http3Application final :
   int64_t qpack_dec_stream_id_;
   size_t current_nghttp3_memory_ = 0;
 
+  // nghttp3 decides internally which stream to write next. The
+  // request and push streams that are known to have data to send
+  // are tracked here, by priority, so that less urgent streams
+  // selected by nghttp3 can be held back (blocked) while more
+  // urgent streams are ready.
+  QuicStreamScheduler ready_streams_;
+  std::vector<int64_t> priority_blocked_;
+  uint8_t priority_blocked_urgency_ = kStreamUrgencyLevels;
+
   Http3ApplicationConfig config_;
 
   void CreateConnection();
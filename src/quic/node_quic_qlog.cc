@@ -0,0 +1,193 @@
+#include "node_quic_qlog.h"  // NOLINT(build/include)
+#include "debug_utils-inl.h"
+#include "memory_tracker-inl.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#include <fcntl.h>
+
+#include <utility>
+
+namespace node {
+namespace quic {
+
+namespace {
+// Writes all of buf to file, retrying on short writes.
+void WriteAll(uv_file file, const uint8_t* data, size_t len) {
+  while (len > 0) {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init(
+        const_cast<char*>(reinterpret_cast<const char*>(data)),
+        len);
+    int ret = uv_fs_write(nullptr, &req, file, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (ret <= 0) {
+      per_process::Debug(
+          DebugCategory::QUICSOCKET,
+          "Unable to write qlog data: %s\n",
+          uv_strerror(ret));
+      return;
+    }
+    data += ret;
+    len -= ret;
+  }
+}
+
+void CloseFile(uv_file file) {
+  uv_fs_t req;
+  uv_fs_close(nullptr, &req, file, nullptr);
+  uv_fs_req_cleanup(&req);
+}
+}  // namespace
+
+std::shared_ptr<QuicQlogSink> QuicQlogSink::Create(
+    const std::string& dir,
+    size_t max_buffered) {
+  std::shared_ptr<QuicQlogSink> sink =
+      std::make_shared<QuicQlogSink>(dir, max_buffered);
+  if (!sink->Start())
+    return {};
+  return sink;
+}
+
+QuicQlogSink::QuicQlogSink(const std::string& dir, size_t max_buffered)
+    : dir_(dir),
+      max_buffered_(max_buffered) {}
+
+QuicQlogSink::~QuicQlogSink() {
+  if (!started_)
+    return;
+  {
+    Mutex::ScopedLock lock(mutex_);
+    stopping_ = true;
+    cond_.Signal(lock);
+  }
+  CHECK_EQ(uv_thread_join(&thread_), 0);
+}
+
+bool QuicQlogSink::Start() {
+  CHECK(!started_);
+  started_ = uv_thread_create(&thread_, Run, this) == 0;
+  return started_;
+}
+
+uint64_t QuicQlogSink::Open(const std::string& name) {
+  uint64_t trace = next_trace_++;
+  Enqueue({
+    Entry::Type::kOpen,
+    trace,
+    {},
+    dir_ + kPathSeparator + name + ".qlog"
+  });
+  return trace;
+}
+
+bool QuicQlogSink::Write(uint64_t trace, const uint8_t* data, size_t len) {
+  {
+    Mutex::ScopedLock lock(mutex_);
+    if (buffered_ + len > max_buffered_)
+      return false;
+  }
+  Enqueue({
+    Entry::Type::kWrite,
+    trace,
+    std::vector<uint8_t>(data, data + len),
+    std::string()
+  });
+  return true;
+}
+
+void QuicQlogSink::Close(uint64_t trace) {
+  Enqueue({ Entry::Type::kClose, trace, {}, std::string() });
+}
+
+size_t QuicQlogSink::buffered() const {
+  Mutex::ScopedLock lock(mutex_);
+  return buffered_;
+}
+
+void QuicQlogSink::Enqueue(Entry&& entry) {
+  Mutex::ScopedLock lock(mutex_);
+  buffered_ += entry.data.size();
+  queue_.emplace_back(std::move(entry));
+  cond_.Signal(lock);
+}
+
+// Runs on the writer thread. The queue is swapped out under the lock
+// and written with the lock released, so the event loop thread is only
+// ever blocked for as long as it takes to append to the queue.
+void QuicQlogSink::Run(void* arg) {
+  QuicQlogSink* sink = static_cast<QuicQlogSink*>(arg);
+  std::deque<Entry> entries;
+  for (;;) {
+    {
+      Mutex::ScopedLock lock(sink->mutex_);
+      while (sink->queue_.empty() && !sink->stopping_)
+        sink->cond_.Wait(lock);
+      if (sink->queue_.empty())
+        break;
+      entries.swap(sink->queue_);
+    }
+
+    size_t written = 0;
+    for (Entry& entry : entries) {
+      written += entry.data.size();
+      sink->Process(&entry);
+    }
+    entries.clear();
+
+    Mutex::ScopedLock lock(sink->mutex_);
+    sink->buffered_ -= written;
+  }
+
+  for (const auto& file : sink->files_)
+    CloseFile(file.second);
+  sink->files_.clear();
+}
+
+void QuicQlogSink::Process(Entry* entry) {
+  switch (entry->type) {
+    case Entry::Type::kOpen: {
+      uv_fs_t req;
+      int fd = uv_fs_open(
+          nullptr,
+          &req,
+          entry->path.c_str(),
+          O_WRONLY | O_CREAT | O_TRUNC,
+          0644,
+          nullptr);
+      uv_fs_req_cleanup(&req);
+      if (fd < 0) {
+        per_process::Debug(
+            DebugCategory::QUICSOCKET,
+            "Unable to open qlog file %s: %s\n",
+            entry->path,
+            uv_strerror(fd));
+        return;
+      }
+      files_[entry->trace] = fd;
+      return;
+    }
+    case Entry::Type::kWrite: {
+      auto it = files_.find(entry->trace);
+      if (it != files_.end())
+        WriteAll(it->second, entry->data.data(), entry->data.size());
+      return;
+    }
+    case Entry::Type::kClose: {
+      auto it = files_.find(entry->trace);
+      if (it != files_.end()) {
+        CloseFile(it->second);
+        files_.erase(it);
+      }
+      return;
+    }
+  }
+}
+
+void QuicQlogSink::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("queue", buffered());
+}
+
+}  // namespace quic
+}  // namespace node
@@ -0,0 +1,141 @@
+#ifndef SRC_QUIC_NODE_QUIC_QLOG_H_
+#define SRC_QUIC_NODE_QUIC_QLOG_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "memory_tracker.h"
+#include "node_mutex.h"
+#include "uv.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace node {
+
+namespace quic {
+
+// A QuicQlogSink writes the qlog output of QuicSessions to files in a
+// directory, one file per traced session. Fragments are copied into a
+// queue on the event loop thread and written to disk by a dedicated
+// writer thread, so tracing a session neither blocks on file I/O nor
+// calls into JavaScript.
+//
+// At most max_buffered bytes are queued at any one time. A fragment
+// that does not fit is dropped, along with every later fragment of the
+// same trace, so that the file on disk is always a truncated but
+// otherwise intact prefix of the trace.
+class QuicQlogSink final : public MemoryRetainer {
+ public:
+  static constexpr size_t kDefaultMaxBuffered = 4 * 1024 * 1024;
+
+  // Returns nullptr if the writer thread could not be started.
+  static std::shared_ptr<QuicQlogSink> Create(
+      const std::string& dir,
+      size_t max_buffered = kDefaultMaxBuffered);
+
+  QuicQlogSink(const std::string& dir, size_t max_buffered);
+
+  // Writes out everything that is still queued, closes all open
+  // files and joins the writer thread.
+  ~QuicQlogSink() override;
+
+  QuicQlogSink(const QuicQlogSink&) = delete;
+  QuicQlogSink& operator=(const QuicQlogSink&) = delete;
+
+  // Starts a new trace written to <dir>/<name>.qlog and returns
+  // the identifier to pass to Write() and Close().
+  uint64_t Open(const std::string& name);
+
+  // Queues len bytes to be appended to the trace. Returns false
+  // if the bytes were dropped because the queue is full.
+  bool Write(uint64_t trace, const uint8_t* data, size_t len);
+
+  // Closes the trace once everything queued for it has been written.
+  void Close(uint64_t trace);
+
+  const std::string& dir() const { return dir_; }
+  size_t max_buffered() const { return max_buffered_; }
+
+  // The number of bytes queued but not yet written.
+  size_t buffered() const;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(QuicQlogSink)
+  SET_SELF_SIZE(QuicQlogSink)
+
+ private:
+  struct Entry {
+    enum class Type {
+      kOpen,
+      kWrite,
+      kClose
+    };
+    Type type;
+    uint64_t trace;
+    std::vector<uint8_t> data;
+    std::string path;
+  };
+
+  bool Start();
+  void Enqueue(Entry&& entry);
+
+  static void Run(void* arg);
+  void Process(Entry* entry);
+
+  const std::string dir_;
+  const size_t max_buffered_;
+  uv_thread_t thread_;
+  bool started_ = false;
+
+  // Only accessed on the event loop thread.
+  uint64_t next_trace_ = 0;
+
+  // Guarded by mutex_.
+  mutable Mutex mutex_;
+  ConditionVariable cond_;
+  std::deque<Entry> queue_;
+  size_t buffered_ = 0;
+  bool stopping_ = false;
+
+  // Only accessed on the writer thread.
+  std::unordered_map<uint64_t, uv_file> files_;
+};
+
+// A QuicQlogTrace is the QuicSession's handle to its trace in a
+// QuicQlogSink. The trace is closed when the handle is destroyed.
+class QuicQlogTrace final {
+ public:
+  QuicQlogTrace(std::shared_ptr<QuicQlogSink> sink, const std::string& name)
+      : sink_(std::move(sink)),
+        id_(sink_->Open(name)) {}
+
+  ~QuicQlogTrace() { sink_->Close(id_); }
+
+  QuicQlogTrace(const QuicQlogTrace&) = delete;
+  QuicQlogTrace& operator=(const QuicQlogTrace&) = delete;
+
+  // Returns false if the fragment was dropped. Once a fragment has
+  // been dropped, all further fragments are dropped as well.
+  bool Write(const uint8_t* data, size_t len) {
+    if (!truncated_ && !sink_->Write(id_, data, len))
+      truncated_ = true;
+    return !truncated_;
+  }
+
+  bool is_truncated() const { return truncated_; }
+
+ private:
+  std::shared_ptr<QuicQlogSink> sink_;
+  uint64_t id_;
+  bool truncated_ = false;
+};
+
+}  // namespace quic
+
+}  // namespace node
+
+#endif  // NODE_WANT_INTERNALS
+#endif  // SRC_QUIC_NODE_QUIC_QLOG_H_
@@ -11,6 +11,7 @@
 #include "node_quic_socket-inl.h"
 #include "node_quic_stream-inl.h"
 
+#include <openssl/async.h>
 #include <openssl/ssl.h>
 #include <memory>
 #include <string>
@@ -96,14 +97,24 @@ ngtcp2_crypto_level QuicCryptoContext::write_crypto_level() const {
   return from_ossl_level(SSL_quic_write_level(ssl_.get()));
 }
 
+template <typename Fn>
+void QuicCryptoContext::RunOutsideAsyncJob(Fn&& fn) {
+  if (LIKELY(ASYNC_get_current_job() == nullptr))
+    return fn();
+  deferred_.emplace_back(std::forward<Fn>(fn));
+}
+
 // TLS Keylogging is enabled per-QuicSession by attaching an handler to the
 // "keylog" event. Each keylog line is emitted to JavaScript where it can
 // be routed to whatever destination makes sense. Typically, this will be
 // to a keylog file that can be consumed by tools like Wireshark to intercept
 // and decrypt QUIC network traffic.
 void QuicCryptoContext::Keylog(const char* line) {
-  if (UNLIKELY(session_->state_[IDX_QUIC_SESSION_STATE_KEYLOG_ENABLED] == 1))
-    session_->listener()->OnKeylog(line, strlen(line));
+  if (UNLIKELY(session_->state_[IDX_QUIC_SESSION_STATE_KEYLOG_ENABLED] == 1)) {
+    RunOutsideAsyncJob([this, line = std::string(line)]() {
+      session_->listener()->OnKeylog(line.c_str(), line.length());
+    });
+  }
 }
 
 void QuicCryptoContext::OnClientHelloDone() {
@@ -232,6 +243,7 @@ ssize_t QuicApplication::WriteVStream(
 
 std::unique_ptr<QuicPacket> QuicApplication::CreateStreamDataPacket() {
   return QuicPacket::Create(
+      session()->socket(),
       "stream data",
       session()->max_packet_length());
 }
@@ -332,6 +344,14 @@ void QuicSession::HandshakeConfirmed() {
   Debug(this, "Handshake is confirmed");
   RecordTimestamp(&QuicSessionStats::handshake_confirmed_at);
   state_[IDX_QUIC_SESSION_STATE_HANDSHAKE_CONFIRMED] = 1;
+  // The Initial, Handshake and 0-RTT keys are no longer used once the
+  // handshake is confirmed. Should ngtcp2 still need one of them, it
+  // falls back to its own implementation.
+  crypto_context_->packet_protection(NGTCP2_CRYPTO_LEVEL_INITIAL)->Discard();
+  crypto_context_->packet_protection(NGTCP2_CRYPTO_LEVEL_HANDSHAKE)->Discard();
+  crypto_context_->packet_protection(NGTCP2_CRYPTO_LEVEL_EARLY)->Discard();
+  if (is_server() && !SubmitNewToken())
+    Debug(this, "Unable to submit a NEW_TOKEN token");
 }
 
 bool QuicSession::is_handshake_completed() const {
@@ -379,10 +399,35 @@ QuicCID QuicSession::dcid() const {
 // of time is determined internally by ngtcp2 according to the
 // guidelines established by the QUIC spec but we use a libuv
 // timer to actually monitor. Here we take the calculated timeout
-// and extend out the libuv timer.
+// and extend out the timer on the QuicSocket's timer wheel.
 void QuicSession::UpdateRetransmitTimer(uint64_t timeout) {
-  DCHECK_NOT_NULL(retransmit_);
-  retransmit_->Update(timeout);
+  retransmit_.Update(timeout);
+}
+
+double QuicSession::GetPacingRate() const {
+  if (congestion_controller_) {
+    double rate = congestion_controller_->pacing_rate();
+    if (rate > 0)
+      return rate;
+  }
+  const ngtcp2_cc_stat* cc = ngtcp2_conn_get_cc_stat(connection());
+  const ngtcp2_rcvry_stat* rcvry = ngtcp2_conn_get_rcvry_stat(connection());
+  // Without an RTT estimate there is nothing to pace against.
+  if (rcvry->smoothed_rtt == 0)
+    return 0;
+  return QuicPacer::kGain * cc->cwnd / rcvry->smoothed_rtt;
+}
+
+size_t QuicSession::GetPacingBudget() {
+  if (!is_handshake_completed())
+    return pacer_.max_burst();
+  pacer_.Update(uv_hrtime(), GetPacingRate(), max_packet_length());
+  return pacer_.budget();
+}
+
+void QuicSession::ConsumePacingBudget(size_t length) {
+  if (is_handshake_completed())
+    pacer_.OnPacketSent(length);
 }
 
 void QuicSession::CheckAllocatedSize(size_t previous_size) const {
@@ -527,16 +572,15 @@ void QuicSession::set_remote_transport_params() {
   DCHECK(!is_flag_set(QUICSESSION_FLAG_DESTROYED));
   ngtcp2_conn_get_remote_transport_params(connection(), &transport_params_);
   set_flag(QUICSESSION_FLAG_HAS_TRANSPORT_PARAMS);
+  ResetPathMtu();
 }
 
 void QuicSession::StopIdleTimer() {
-  CHECK_NOT_NULL(idle_);
-  idle_->Stop();
+  idle_.Stop();
 }
 
 void QuicSession::StopRetransmitTimer() {
-  CHECK_NOT_NULL(retransmit_);
-  retransmit_->Stop();
+  retransmit_.Stop();
 }
 
 // Called by the OnVersionNegotiation callback when a version
@@ -171,6 +171,8 @@ void QuicSessionConfig::ResetToDefaults(QuicState* quic_state) {
   transport_params.disable_active_migration = 0;
   transport_params.preferred_address_present = 0;
   transport_params.stateless_reset_token_present = 0;
+  max_pacing_burst = DEFAULT_MAX_PACING_BURST;
+  cc_algorithm = QUIC_CC_ALGORITHM_NEWRENO;
 }
 
 // Sets the QuicSessionConfig using an AliasedBuffer for efficiency.
@@ -198,6 +200,10 @@ void QuicSessionConfig::Set(
             &transport_params.max_packet_size);
   SetConfig(quic_state, IDX_QUIC_SESSION_MAX_ACK_DELAY,
             &transport_params.max_ack_delay);
+  SetConfig(quic_state, IDX_QUIC_SESSION_MAX_PACING_BURST,
+            &max_pacing_burst);
+  SetConfig(quic_state, IDX_QUIC_SESSION_CC_ALGORITHM,
+            &cc_algorithm);
 
   transport_params.max_idle_timeout =
       transport_params.max_idle_timeout * 1000000000;
@@ -347,8 +353,20 @@ void QuicSessionListener::OnQLog(const uint8_t* data, size_t len) {
     previous_listener_->OnQLog(data, len);
 }
 
+QuicSocket* JSQuicSessionListener::batching_socket() const {
+  QuicSocket* socket = session()->socket();
+  return socket != nullptr && socket->is_batching_events() ? socket : nullptr;
+}
+
+void JSQuicSessionListener::FlushEvents() {
+  QuicSocket* socket = session()->socket();
+  if (socket != nullptr)
+    socket->FlushEvents();
+}
+
 void JSQuicSessionListener::OnKeylog(const char* line, size_t len) {
   Environment* env = session()->env();
+  FlushEvents();
 
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -368,6 +386,13 @@ void JSQuicSessionListener::OnStreamBlocked(int64_t stream_id) {
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
   BaseObjectPtr<QuicStream> stream = session()->FindStream(stream_id);
+  if (QuicSocket* socket = batching_socket()) {
+    socket->QueueEvent(
+        QUICSOCKET_EVENT_STREAM_BLOCKED,
+        stream.get(),
+        Local<Value>());
+    return;
+  }
   stream->MakeCallback(env->quic_on_stream_blocked_function(), 0, nullptr);
 }
 
@@ -376,6 +401,7 @@ void JSQuicSessionListener::OnClientHello(
     const char* server_name) {
 
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -408,6 +434,7 @@ void JSQuicSessionListener::OnClientHello(
 
 void JSQuicSessionListener::OnCert(const char* server_name) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -452,6 +479,18 @@ void JSQuicSessionListener::OnStreamHeaders(
   };
   if (kind == QUICSTREAM_HEADERS_KIND_PUSH)
     argv[3] = Number::New(env->isolate(), static_cast<double>(push_id));
+  if (QuicSocket* socket = batching_socket()) {
+    // The headers have to reach JavaScript before the stream's data.
+    socket->QueueEvent(
+        QUICSOCKET_EVENT_STREAM_HEADERS,
+        session(),
+        argv[1],
+        static_cast<double>(stream_id),
+        kind,
+        static_cast<double>(push_id),
+        session()->FindStream(stream_id).get());
+    return;
+  }
   BaseObjectPtr<QuicSession> ptr(session());
   session()->MakeCallback(
       env->quic_on_stream_headers_function(),
@@ -460,6 +499,7 @@ void JSQuicSessionListener::OnStreamHeaders(
 
 void JSQuicSessionListener::OnOCSP(Local<Value> ocsp) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
   BaseObjectPtr<QuicSession> ptr(session());
@@ -469,6 +509,16 @@ void JSQuicSessionListener::OnOCSP(Local<Value> ocsp) {
 void JSQuicSessionListener::OnStreamClose(
     int64_t stream_id,
     uint64_t app_error_code) {
+  if (QuicSocket* socket = batching_socket()) {
+    socket->QueueEvent(
+        QUICSOCKET_EVENT_STREAM_CLOSE,
+        session(),
+        Local<Value>(),
+        static_cast<double>(stream_id),
+        static_cast<double>(app_error_code));
+    return;
+  }
+
   Environment* env = session()->env();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -490,6 +540,16 @@ void JSQuicSessionListener::OnStreamClose(
 void JSQuicSessionListener::OnStreamReset(
     int64_t stream_id,
     uint64_t app_error_code) {
+  if (QuicSocket* socket = batching_socket()) {
+    socket->QueueEvent(
+        QUICSOCKET_EVENT_STREAM_RESET,
+        session(),
+        Local<Value>(),
+        static_cast<double>(stream_id),
+        static_cast<double>(app_error_code));
+    return;
+  }
+
   Environment* env = session()->env();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -509,6 +569,7 @@ void JSQuicSessionListener::OnStreamReset(
 
 void JSQuicSessionListener::OnSessionDestroyed() {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
   // Emit the 'close' event in JS. This needs to happen after destroying the
@@ -519,6 +580,7 @@ void JSQuicSessionListener::OnSessionDestroyed() {
 
 void JSQuicSessionListener::OnSessionClose(QuicError error) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -539,6 +601,18 @@ void JSQuicSessionListener::OnStreamReady(BaseObjectPtr<QuicStream> stream) {
   Environment* env = session()->env();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
+  if (QuicSocket* socket = batching_socket()) {
+    // The stream has to be known to JavaScript before its data.
+    socket->QueueEvent(
+        QUICSOCKET_EVENT_STREAM_READY,
+        session(),
+        stream->object(),
+        static_cast<double>(stream->id()),
+        static_cast<double>(stream->push_id()),
+        0,
+        stream.get());
+    return;
+  }
   Local<Value> argv[] = {
     stream->object(),
     Number::New(env->isolate(), static_cast<double>(stream->id())),
@@ -555,6 +629,7 @@ void JSQuicSessionListener::OnStreamReady(BaseObjectPtr<QuicStream> stream) {
 
 void JSQuicSessionListener::OnHandshakeCompleted() {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -604,6 +679,7 @@ void JSQuicSessionListener::OnPathValidation(
   // remote addresses have to converted into JavaScript objects. We
   // only do this if a pathValidation handler is registered.
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Local<Context> context = env->context();
   Context::Scope context_scope(context);
@@ -623,6 +699,7 @@ void JSQuicSessionListener::OnPathValidation(
 
 void JSQuicSessionListener::OnSessionTicket(int size, SSL_SESSION* sess) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -659,6 +736,7 @@ void JSQuicSessionListener::OnSessionSilentClose(
     bool stateless_reset,
     QuicError error) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -679,6 +757,7 @@ void JSQuicSessionListener::OnUsePreferredAddress(
     int family,
     const PreferredAddress& preferred_address) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Local<Context> context = env->context();
   Context::Scope context_scope(context);
@@ -708,6 +787,7 @@ void JSQuicSessionListener::OnVersionNegotiation(
     const uint32_t* vers,
     size_t vcnt) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope scope(env->isolate());
   Local<Context> context = env->context();
   Context::Scope context_scope(context);
@@ -738,6 +818,7 @@ void JSQuicSessionListener::OnVersionNegotiation(
 
 void JSQuicSessionListener::OnQLog(const uint8_t* data, size_t len) {
   Environment* env = session()->env();
+  FlushEvents();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -760,6 +841,21 @@ void QuicSession::RandomConnectionIDStrategy(
     EntropySource(cid->data, cidlen);
 }
 
+// Generates a new random connection ID whose first byte is the
+// worker id of the QuicSocket, so that any worker of a group sharing
+// a port can tell which worker a packet belongs to. A client
+// QuicSession may since have moved to a QuicSocket without a worker
+// id, in which case the connection ID is entirely random.
+void QuicSession::WorkerConnectionIDStrategy(
+    QuicSession* session,
+    ngtcp2_cid* cid,
+    size_t cidlen) {
+  RandomConnectionIDStrategy(session, cid, cidlen);
+  QuicSocket* socket = session->socket();
+  if (socket != nullptr && socket->has_worker_id())
+    cid->data[0] = socket->worker_id();
+}
+
 // Check required capabilities were not excluded from the OpenSSL build:
 // - OPENSSL_NO_SSL_TRACE excludes SSL_trace()
 // - OPENSSL_NO_STDIO excludes BIO_new_fp()
@@ -770,6 +866,8 @@ void QuicSession::RandomConnectionIDStrategy(
 # define HAVE_SSL_TRACE 1
 #endif
 
+thread_local QuicCryptoContext* QuicCryptoContext::current_handshake_ =
+    nullptr;
 
 void QuicCryptoContext::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("initial_crypto", handshake_[0]);
@@ -821,6 +919,21 @@ bool QuicCryptoContext::SetSecrets(
     return false;
   }
 
+  // 0-RTT keys are only used to send on the client and
+  // only used to receive on the server.
+  const ngtcp2_crypto_ctx* ctx =
+      ngtcp2_conn_get_crypto_ctx(session()->connection());
+  bool rx = level != NGTCP2_CRYPTO_LEVEL_EARLY ||
+            side_ == NGTCP2_CRYPTO_SIDE_SERVER;
+  bool tx = level != NGTCP2_CRYPTO_LEVEL_EARLY ||
+            side_ == NGTCP2_CRYPTO_SIDE_CLIENT;
+  packet_protection_[level].Install(
+      *ctx,
+      rx ? rx_key : nullptr,
+      rx_hp,
+      tx ? tx_key : nullptr,
+      tx_hp);
+
   switch (level) {
   case NGTCP2_CRYPTO_LEVEL_EARLY:
     crypto::LogSecret(
@@ -940,10 +1053,12 @@ int QuicCryptoContext::OnClientHello() {
     return -1;
   in_client_hello_ = true;
 
-  QuicCryptoContext* ctx = session_->crypto_context();
-  session_->listener()->OnClientHello(
-      ctx->hello_alpn(),
-      ctx->hello_servername());
+  RunOutsideAsyncJob([this]() {
+    QuicCryptoContext* ctx = session_->crypto_context();
+    session_->listener()->OnClientHello(
+        ctx->hello_alpn(),
+        ctx->hello_servername());
+  });
 
   // Returning -1 here will keep the TLS handshake paused until the
   // client hello callback is invoked. Returning 0 means that the
@@ -976,7 +1091,9 @@ int QuicCryptoContext::OnOCSP() {
     return -1;
   in_ocsp_request_ = true;
 
-  session_->listener()->OnCert(session_->crypto_context()->servername());
+  RunOutsideAsyncJob([this]() {
+    session_->listener()->OnCert(session_->crypto_context()->servername());
+  });
 
   // Returning -1 here means that we are still waiting for the OCSP
   // request to be completed. When the OnCert handler is invoked
@@ -1032,7 +1149,7 @@ bool QuicCryptoContext::OnSecrets(
 
   auto maybe_init_app = OnScopeLeave([&]() {
     if (level == NGTCP2_CRYPTO_LEVEL_APP)
-      session()->InitApplication();
+      RunOutsideAsyncJob([this]() { session()->InitApplication(); });
   });
 
   Debug(session(),
@@ -1111,14 +1228,38 @@ int QuicCryptoContext::Receive(
 
   Debug(session(), "Receiving %d bytes of crypto data", datalen);
 
-  // Internally, this passes the handshake data off to openssl
-  // for processing. The handshake may or may not complete.
-  int ret = ngtcp2_crypto_read_write_crypto_data(
-      session_->connection(),
-      ssl_.get(),
-      crypto_level,
-      data,
-      datalen);
+  int ret;
+  for (;;) {
+    // Internally, this passes the handshake data off to openssl
+    // for processing. The handshake may or may not complete.
+    QuicCryptoContext* previous = current_handshake_;
+    current_handshake_ = this;
+    ret = ngtcp2_crypto_read_write_crypto_data(
+        session_->connection(),
+        ssl_.get(),
+        crypto_level,
+        data,
+        datalen);
+    current_handshake_ = previous;
+
+    // Callbacks that could not enter JavaScript from within an
+    // offloaded handshake are run now. If they resolved a paused
+    // handshake synchronously, it is continued right away.
+    if (deferred_.empty())
+      break;
+    RunDeferred();
+    if (UNLIKELY(session_->is_destroyed()))
+      return NGTCP2_ERR_CALLBACK_FAILURE;
+    if (!((ret == NGTCP2_CRYPTO_ERR_TLS_WANT_CLIENT_HELLO_CB &&
+           !in_client_hello_) ||
+          (ret == NGTCP2_CRYPTO_ERR_TLS_WANT_X509_LOOKUP &&
+           !in_ocsp_request_))) {
+      break;
+    }
+    data = nullptr;
+    datalen = 0;
+  }
+
   switch (ret) {
     case 0:
       return 0;
@@ -1132,10 +1273,43 @@ int QuicCryptoContext::Receive(
       Debug(session(), "TLS handshake wants client hello callback");
       return 0;
     default:
+      // The handshake is paused waiting for an offloaded
+      // private key operation.
+      if (SSL_waiting_for_async(ssl_.get())) {
+        Debug(session(), "TLS handshake waits for private key operation");
+        return 0;
+      }
       return ret;
   }
 }
 
+void QuicCryptoContext::RunDeferred() {
+  TLSCallbackScope callback_scope(this);
+  std::vector<std::function<void()>> deferred;
+  deferred.swap(deferred_);
+  for (auto& fn : deferred) {
+    if (UNLIKELY(session_->is_destroyed()))
+      break;
+    fn();
+  }
+}
+
+void QuicCryptoContext::OnPrivateKeyOperationDone() {
+  // If the session was destroyed in the meantime, the job still
+  // needs to be resumed once so that it can fail and be released.
+  if (UNLIKELY(session_->is_destroyed())) {
+    SSL_do_handshake(ssl_.get());
+    ERR_clear_error();
+    return;
+  }
+
+  Debug(session(), "Private key operation is done");
+  Environment* env = session_->env();
+  HandleScope scope(env->isolate());
+  InternalCallbackScope callback_scope(session());
+  ResumeHandshake();
+}
+
 // Triggers key update to begin. This will fail and return false
 // if either a previous key update is in progress and has not been
 // confirmed or if the initial handshake has not yet been confirmed.
@@ -1222,21 +1396,40 @@ void QuicApplication::Acknowledge(
 }
 
 bool QuicApplication::SendPendingData() {
-  // The maximum number of packets to send per call
-  static constexpr size_t kMaxPackets = 16;
+  // The maximum number of packets carrying stream data to send per
+  // call, as allowed by the pacer. Packets that carry only ACK and
+  // other control frames are not paced, as holding them back would
+  // delay the peer's loss recovery and inflate its RTT samples.
+  const size_t max_packets = session()->GetPacingBudget();
   QuicPathStorage path;
   std::unique_ptr<QuicPacket> packet;
   uint8_t* pos = nullptr;
   size_t packets_sent = 0;
+  bool paced = false;
+  bool has_stream_data = false;
   int err;
 
   for (;;) {
     ssize_t ndatalen;
     StreamData stream_data;
-    err = GetStreamData(&stream_data);
-    if (err < 0) {
-      session()->set_last_error(QUIC_ERROR_APPLICATION, err);
-      return false;
+    if (!paced) {
+      err = GetStreamData(&stream_data);
+      if (err < 0) {
+        session()->set_last_error(QUIC_ERROR_APPLICATION, err);
+        return false;
+      }
+
+      // Once the budget is used up, the stream data is left queued
+      // and only session packets are written until the pacer allows
+      // more stream data to be sent.
+      if (stream_data.id > -1 && packets_sent >= max_packets) {
+        paced = true;
+        if (stream_data.count > 0 || stream_data.fin) {
+          ResumeStream(stream_data.id);
+          session()->SchedulePacedSend();
+        }
+        continue;
+      }
     }
 
     // If stream_data.id is -1, then we're not serializing any data for any
@@ -1283,6 +1476,7 @@ bool QuicApplication::SendPendingData() {
         case NGTCP2_ERR_WRITE_STREAM_MORE:
           CHECK_GT(ndatalen, 0);
           CHECK(StreamCommit(&stream_data, ndatalen));
+          has_stream_data = true;
           pos += ndatalen;
           continue;
       }
@@ -1292,20 +1486,24 @@ bool QuicApplication::SendPendingData() {
 
     pos += nwrite;
 
-    if (ndatalen >= 0)
+    if (ndatalen >= 0) {
       CHECK(StreamCommit(&stream_data, ndatalen));
+      has_stream_data = true;
+    }
 
     Debug(session(), "Sending %" PRIu64 " bytes in serialized packet", nwrite);
     packet->set_length(nwrite);
     if (!session()->SendPacket(std::move(packet), path))
       return false;
+    if (has_stream_data) {
+      session()->ConsumePacingBudget(nwrite);
+      packets_sent++;
+      has_stream_data = false;
+    }
     packet.reset();
     pos = nullptr;
     MaybeSetFin(stream_data);
-    if (++packets_sent == kMaxPackets)
-      break;
   }
-  return true;
 
  congestion_limited:
   // We are either congestion limited or done.
@@ -1314,8 +1512,11 @@ bool QuicApplication::SendPendingData() {
     packet->set_length(pos - packet->data());
     Debug(session(), "Congestion limited, but %" PRIu64 " bytes pending",
           packet->length());
+    size_t length = packet->length();
     if (!session()->SendPacket(std::move(packet), path))
       return false;
+    if (has_stream_data)
+      session()->ConsumePacingBudget(length);
   }
   return true;
 }
@@ -1447,18 +1648,25 @@ QuicSession::QuicSession(
   : AsyncWrap(socket->env(), wrap, provider_type),
     StatsBase(socket->env(), wrap,
               HistogramOptions::ACK |
-              HistogramOptions::RATE),
+              HistogramOptions::RATE,
+              socket->histogram_mode(),
+              socket->session_histograms()),
     alloc_info_(MakeAllocator()),
     socket_(socket),
     alpn_(alpn),
     hostname_(hostname),
-    idle_(new Timer(socket->env(), [this]() { OnIdleTimeout(); })),
-    retransmit_(new Timer(socket->env(), [this]() { MaybeTimeout(); })),
+    idle_(socket->timer_wheel(), [this]() { OnIdleTimeout(); }),
+    retransmit_(socket->timer_wheel(), [this]() { MaybeTimeout(); }),
+    pacing_(socket->timer_wheel(), [this]() { OnPacingTimeout(); }),
+    receive_slab_(socket->env()->isolate()),
     rcid_(rcid),
     state_(env()->isolate(), IDX_QUIC_SESSION_STATE_COUNT),
     quic_state_(socket->quic_state()) {
   PushListener(&default_listener_);
-  set_connection_id_strategy(RandomConnectionIDStrategy);
+  set_connection_id_strategy(
+      socket->has_worker_id() ?
+          WorkerConnectionIDStrategy :
+          RandomConnectionIDStrategy);
   set_preferred_address_strategy(preferred_address_strategy);
   crypto_context_.reset(
       new QuicCryptoContext(
@@ -1485,6 +1693,8 @@ QuicSession::~QuicSession() {
   CHECK(!Ngtcp2CallbackScope::InNgtcp2CallbackScope(this));
   crypto_context_->Cancel();
   connection_.reset();
+  // Destroying the connection writes out the last of the qlog data.
+  qlog_trace_.reset();
 
   QuicSessionListener* listener_ = listener();
   listener_->OnSessionDestroyed();
@@ -1700,9 +1910,10 @@ void QuicSession::Destroy() {
   set_flag(QUICSESSION_FLAG_CLOSING, false);
   set_flag(QUICSESSION_FLAG_GRACEFUL_CLOSING, false);
 
-  // Stop and free the idle and retransmission timers if they are active.
+  // Stop the idle, retransmission and pacing timers if they are active.
   StopIdleTimer();
   StopRetransmitTimer();
+  pacing_.Stop();
 
   // The QuicSession instances are kept alive using
   // BaseObjectPtr. The only persistent BaseObjectPtr
@@ -1742,7 +1953,7 @@ void QuicSession::HandleError() {
   }
 }
 
-// The the retransmit libuv timer fires, it will call MaybeTimeout,
+// The the retransmit timer fires, it will call MaybeTimeout,
 // which determines whether or not we need to retransmit data to
 // to packet loss or ack delay.
 void QuicSession::MaybeTimeout() {
@@ -1753,6 +1964,17 @@ void QuicSession::MaybeTimeout() {
   if (ngtcp2_conn_loss_detection_expiry(connection()) <= now) {
     Debug(this, "Retransmitting due to loss detection");
     CHECK_EQ(ngtcp2_conn_on_loss_detection_timer(connection(), now), 0);
+    UpdateCongestionControl();
+    // Consecutive probe timeouts while sending packets larger than
+    // the base suggest the path no longer carries them.
+    if (pmtud_.packet_length() > pmtud_.base() &&
+        ngtcp2_conn_get_rcvry_stat(connection())->pto_count >=
+            QuicPathMtuDiscovery::kBlackHoleTimeouts) {
+      Debug(this, "Path MTU black hole detected");
+      pmtud_.OnBlackHole();
+      max_pktlen_ = pmtud_.packet_length();
+      SetStat(&QuicSessionStats::path_mtu, max_pktlen_);
+    }
     IncrementStat(&QuicSessionStats::loss_retransmit_count);
     transmit = true;
   } else if (ngtcp2_conn_ack_delay_expiry(connection()) <= now) {
@@ -1792,6 +2014,9 @@ void QuicSession::PathValidation(
     ngtcp2_path_validation_result res) {
   if (res == NGTCP2_PATH_VALIDATION_RESULT_SUCCESS) {
     IncrementStat(&QuicSessionStats::path_validation_success_count);
+    // What was discovered about the previous path does not
+    // apply to the new one.
+    ResetPathMtu();
   } else {
     IncrementStat(&QuicSessionStats::path_validation_failure_count);
   }
@@ -1841,6 +2066,29 @@ bool QuicSession::ReceiveRetry() {
   return DeriveAndInstallInitialKey(*this, dcid());
 }
 
+// Stores a token received in a NEW_TOKEN frame so that the next client
+// QuicSession connecting to the same server address can present it in
+// place of a retry token.
+void QuicSession::ReceiveNewToken(const uint8_t* token, size_t tokenlen) {
+  CHECK(!is_server());
+  Debug(this, "Received a NEW_TOKEN token");
+  socket()->StoreNewToken(remote_address_, token, tokenlen);
+}
+
+// Once the handshake is confirmed, the server sends the client a token
+// that lets the client's next connection skip the RETRY round trip.
+bool QuicSession::SubmitNewToken() {
+  CHECK(is_server());
+  uint8_t token[kMaxNewTokenLen];
+  size_t tokenlen;
+  return GenerateNewToken(
+             token,
+             &tokenlen,
+             remote_address_,
+             socket()->token_secret()) &&
+         ngtcp2_conn_submit_new_token(connection(), token, tokenlen) == 0;
+}
+
 // When the QuicSocket receives a QUIC packet, it is forwarded on to here
 // for processing.
 bool QuicSession::Receive(
@@ -1944,6 +2192,7 @@ bool QuicSession::Receive(
     SilentClose();
     return true;
   }
+  UpdateCongestionControl();
   Debug(this, "Sending pending data after processing packet");
   SendPendingData();
   UpdateIdleTimer();
@@ -2170,7 +2419,7 @@ bool QuicSession::SendConnectionClose() {
     }
     case NGTCP2_CRYPTO_SIDE_CLIENT: {
       UpdateIdleTimer();
-      auto packet = QuicPacket::Create("client connection close");
+      auto packet = QuicPacket::Create(socket(), "client connection close");
 
       // If we're not already in the closing period,
       // first attempt to write any pending packets, then
@@ -2276,9 +2525,14 @@ void QuicSession::SendPendingData() {
     return;
   }
 
+  // Packets serialized by the application are flushed together
+  // when the QuicSocket has batched sends enabled.
+  QuicSocket::SendBatchScope send_batch_scope(socket());
   if (!application_->SendPendingData()) {
     Debug(this, "Error sending QUIC application data");
     HandleError();
+  } else {
+    MaybeProbePathMtu();
   }
 }
 
@@ -2409,6 +2663,7 @@ bool QuicSession::StartClosingPeriod() {
   // Once the CONNECTION_CLOSE packet is written,
   // is_in_closing_period will return true.
   conn_closebuf_ = QuicPacket::Create(
+      socket(),
       "server connection close");
   ssize_t nwrite =
       SelectCloseFn(error.family)(
@@ -2520,14 +2775,36 @@ void QuicSession::UpdateConnectionID(
 // will be silently closed. It is important to update this as activity
 // occurs to keep the idle timer from firing.
 void QuicSession::UpdateIdleTimer() {
-  CHECK_NOT_NULL(idle_);
   uint64_t now = uv_hrtime();
   uint64_t expiry = ngtcp2_conn_get_idle_expiry(connection());
   // nano to millis
   uint64_t timeout = expiry > now ? (expiry - now) / 1000000ULL : 1;
   if (timeout == 0) timeout = 1;
   Debug(this, "Updating idle timeout to %" PRIu64, timeout);
-  idle_->Update(timeout);
+  idle_.Update(timeout);
+}
+
+void QuicSession::SchedulePacedSend() {
+  if (pacing_.is_active())
+    return;
+  // The timer wheel has millisecond resolution. Whatever
+  // credit accrues in the meantime is used once it fires.
+  uint64_t interval =
+      std::max((pacer_.delay() + 999999) / 1000000, uint64_t{1});
+  Debug(this, "Pacing. Next send in %" PRIu64 " ms", interval);
+  IncrementStat(&QuicSessionStats::pacing_delay_count);
+  pacing_scheduled_at_ = uv_hrtime();
+  pacing_.Update(interval);
+}
+
+void QuicSession::OnPacingTimeout() {
+  pacing_.Cancel();
+  if (is_destroyed())
+    return;
+  IncrementStat(
+      &QuicSessionStats::pacing_delay_time,
+      uv_hrtime() - pacing_scheduled_at_);
+  SendPendingData();
 }
 
 
@@ -2558,9 +2835,10 @@ bool QuicSession::WritePackets(const char* diagnostic_label) {
   }
 
   // Otherwise, serialize and send pending frames
+  QuicSocket::SendBatchScope send_batch_scope(socket());
   QuicPathStorage path;
   for (;;) {
-    auto packet = QuicPacket::Create(diagnostic_label, max_pktlen_);
+    auto packet = QuicPacket::Create(socket(), diagnostic_label, max_pktlen_);
     // ngtcp2_conn_write_pkt will fill the created QuicPacket up
     // as much as possible, and then should be called repeatedly
     // until it returns 0 or fatally errors. On each call, it
@@ -2605,13 +2883,14 @@ void QuicSession::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("crypto_context", crypto_context_.get());
   tracker->TrackField("alpn", alpn_);
   tracker->TrackField("hostname", hostname_);
-  tracker->TrackField("idle", idle_);
-  tracker->TrackField("retransmit", retransmit_);
   tracker->TrackField("streams", streams_);
   tracker->TrackField("state", state_);
   tracker->TrackFieldWithSize("current_ngtcp2_memory", current_ngtcp2_memory_);
   tracker->TrackField("conn_closebuf", conn_closebuf_);
   tracker->TrackField("application", application_);
+  tracker->TrackField("congestion_controller", congestion_controller_);
+  tracker->TrackField("pmtud", pmtud_);
+  tracker->TrackField("receive_slab", receive_slab_);
   StatsBase::StatsMemoryInfo(tracker);
 }
 
@@ -2671,6 +2950,7 @@ void QuicSession::InitServer(
   local_address_ = local_addr;
   remote_address_ = remote_addr;
   max_pktlen_ = GetMaxPktLen(remote_addr);
+  pacer_.set_max_burst(config.max_pacing_burst);
 
   config.set_original_connection_id(ocid);
 
@@ -2681,8 +2961,11 @@ void QuicSession::InitServer(
 
   QuicPath path(local_addr, remote_address_);
 
-  // NOLINTNEXTLINE(readability/pointer_notation)
-  if (qlog == QlogMode::kEnabled) config.set_qlog({ *ocid, OnQlogWrite });
+  if (qlog == QlogMode::kEnabled) {
+    InitQlogTrace("server", ocid);
+    // NOLINTNEXTLINE(readability/pointer_notation)
+    config.set_qlog({ *ocid, OnQlogWrite });
+  }
 
   ngtcp2_conn* conn;
   CHECK_EQ(
@@ -2698,6 +2981,7 @@ void QuicSession::InitServer(
           static_cast<QuicSession*>(this)), 0);
 
   connection_.reset(conn);
+  InitCongestionControl(config.cc_algorithm);
 
   crypto_context_->Initialize();
   UpdateDataStats();
@@ -2745,6 +3029,120 @@ void QuicSession::UpdateRecoveryStats() {
   SetStat(&QuicSessionStats::min_rtt, stat->min_rtt);
   SetStat(&QuicSessionStats::latest_rtt, stat->latest_rtt);
   SetStat(&QuicSessionStats::smoothed_rtt, stat->smoothed_rtt);
+
+  const ngtcp2_cc_stat* cc = ngtcp2_conn_get_cc_stat(connection());
+  SetStat(&QuicSessionStats::congestion_window, cc->cwnd);
+  SetStat(&QuicSessionStats::slow_start_threshold, cc->ssthresh);
+  // Bytes per nanosecond to bytes per second.
+  SetStat(&QuicSessionStats::pacing_rate,
+          static_cast<uint64_t>(GetPacingRate() * 1e9));
+}
+
+void QuicSession::InitCongestionControl(uint64_t algorithm) {
+  switch (algorithm) {
+    case QUIC_CC_ALGORITHM_CUBIC:
+    case QUIC_CC_ALGORITHM_BBR:
+      break;
+    default:
+      algorithm = QUIC_CC_ALGORITHM_NEWRENO;
+  }
+  const ngtcp2_cc_stat* cc = ngtcp2_conn_get_cc_stat(connection());
+  congestion_controller_ = QuicCongestionController::Create(
+      static_cast<QuicCongestionControlAlgorithm>(algorithm),
+      cc->cwnd);
+  congestion_recovery_start_ = cc->congestion_recovery_start_ts;
+  congestion_window_ = cc->cwnd;
+  SetStat(&QuicSessionStats::congestion_control, algorithm);
+  Debug(this, "Using congestion control algorithm %" PRIu64, algorithm);
+}
+
+void QuicSession::ResetPathMtu() {
+  max_pktlen_ = GetMaxPktLen(remote_address_);
+  pmtud_.Reset(
+      max_pktlen_,
+      std::min<uint64_t>(
+          transport_params_.max_packet_size,
+          GetMaxPathMtu(remote_address_)),
+      GetPathMtuHint(remote_address_));
+  SetStat(&QuicSessionStats::path_mtu, max_pktlen_);
+}
+
+// Probes are sent in addition to, and after, the application's
+// packets. ngtcp2 declines to write one until the handshake is
+// confirmed or while the congestion window is too small for it.
+void QuicSession::MaybeProbePathMtu() {
+  if (is_destroyed() ||
+      !is_flag_set(QUICSESSION_FLAG_HAS_TRANSPORT_PARAMS) ||
+      !socket()->is_path_mtu_discovery_enabled()) {
+    return;
+  }
+
+  uint64_t now = uv_hrtime();
+  size_t length = pmtud_.NextProbe(now, ngtcp2_conn_get_pto(connection()));
+  if (length == 0)
+    return;
+
+  auto packet = QuicPacket::Create(socket(), "path mtu probe", length);
+  QuicPathStorage path;
+  ssize_t nwrite = ngtcp2_conn_write_pmtud_probe(
+      connection(),
+      &path.path,
+      packet->data(),
+      length,
+      now);
+  // Errors are left for the next regular write to report.
+  if (nwrite <= 0)
+    return;
+
+  Debug(this, "Probing path MTU with %" PRIu64 " bytes", length);
+  pmtud_.OnProbeSent(length, now);
+  IncrementStat(&QuicSessionStats::path_mtu_probe_count);
+  packet->set_length(nwrite);
+  ConsumePacingBudget(nwrite);
+  if (!SendPacket(std::move(packet), path))
+    HandleError();
+}
+
+void QuicSession::PathMtuProbeAcked(size_t length) {
+  if (!pmtud_.OnProbeAcked(length))
+    return;
+  Debug(this, "Path MTU raised to %" PRIu64, length);
+  max_pktlen_ = pmtud_.packet_length();
+  SetStat(&QuicSessionStats::path_mtu, max_pktlen_);
+}
+
+void QuicSession::UpdateCongestionControl() {
+  if (!congestion_controller_ || is_destroyed())
+    return;
+
+  const ngtcp2_cc_stat* cc = ngtcp2_conn_get_cc_stat(connection());
+  const ngtcp2_rcvry_stat* rcvry = ngtcp2_conn_get_rcvry_stat(connection());
+
+  QuicCongestionSample sample;
+  sample.now = uv_hrtime();
+  sample.bytes_in_flight = cc->bytes_in_flight;
+  sample.bytes_acked = congestion_bytes_acked_;
+  congestion_bytes_acked_ = 0;
+  sample.latest_rtt = rcvry->latest_rtt;
+  sample.min_rtt = rcvry->min_rtt;
+  sample.smoothed_rtt = rcvry->smoothed_rtt;
+
+  if (cc->congestion_recovery_start_ts != congestion_recovery_start_) {
+    congestion_recovery_start_ = cc->congestion_recovery_start_ts;
+    congestion_controller_->OnCongestionEvent(sample);
+  } else if (cc->cwnd < congestion_window_) {
+    // Persistent congestion collapses the window
+    // without starting a new recovery period.
+    congestion_controller_->OnPersistentCongestion(sample);
+  } else if (sample.bytes_acked > 0) {
+    congestion_controller_->OnAck(sample);
+  }
+
+  congestion_window_ = congestion_controller_->cwnd();
+  ngtcp2_conn_set_cc_window(
+      connection(),
+      congestion_window_,
+      congestion_controller_->ssthresh());
 }
 
 // Data stats are used to allow user code to keep track of important
@@ -2833,6 +3231,7 @@ void QuicSession::InitClient(
   max_pktlen_ = GetMaxPktLen(remote_address_);
 
   QuicSessionConfig config(quic_state());
+  pacer_.set_max_burst(config.max_pacing_burst);
   ExtendMaxStreamsBidi(DEFAULT_MAX_STREAMS_BIDI);
   ExtendMaxStreamsUni(DEFAULT_MAX_STREAMS_UNI);
 
@@ -2852,7 +3251,17 @@ void QuicSession::InitClient(
 
   QuicPath path(local_address_, remote_address_);
 
-  if (qlog == QlogMode::kEnabled) config.set_qlog({ dcid, OnQlogWrite });
+  if (qlog == QlogMode::kEnabled) {
+    InitQlogTrace("client", QuicCID(dcid));
+    config.set_qlog({ dcid, OnQlogWrite });
+  }
+
+  // ngtcp2_conn_client_new copies the token.
+  std::vector<uint8_t> token = socket()->TakeNewToken(remote_address_);
+  if (!token.empty()) {
+    Debug(this, "Presenting a NEW_TOKEN token");
+    config.token = { token.data(), token.size() };
+  }
 
   ngtcp2_conn* conn;
   CHECK_EQ(
@@ -2869,6 +3278,7 @@ void QuicSession::InitClient(
 
 
   connection_.reset(conn);
+  InitCongestionControl(config.cc_algorithm);
 
   crypto_context_->Initialize();
 
@@ -3090,6 +3500,48 @@ int QuicSession::OnHandshakeCompleted(
 
 // Called by ngtcp2 for clients when the handshake has been
 // confirmed. Confirmation occurs *after* handshake completion.
+int QuicSession::OnReceiveNewToken(
+    ngtcp2_conn* conn,
+    const ngtcp2_vec* token,
+    void* user_data) {
+  QuicSession* session = static_cast<QuicSession*>(user_data);
+  if (UNLIKELY(session->is_destroyed()))
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  QuicSession::Ngtcp2CallbackScope callback_scope(session);
+  session->ReceiveNewToken(token->base, token->len);
+  return 0;
+}
+
+// Called by ngtcp2 when a path MTU discovery probe written
+// by MaybeProbePathMtu has been acknowledged.
+int QuicSession::OnAckedPmtudProbe(
+    ngtcp2_conn* conn,
+    size_t probelen,
+    void* user_data) {
+  QuicSession* session = static_cast<QuicSession*>(user_data);
+  if (UNLIKELY(session->is_destroyed()))
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  QuicSession::Ngtcp2CallbackScope callback_scope(session);
+  session->PathMtuProbeAcked(probelen);
+  return 0;
+}
+
+// Called by ngtcp2 for every acknowledged packet that counted towards
+// the bytes in flight. The acknowledged bytes are passed on to the
+// congestion controller by the next UpdateCongestionControl.
+int QuicSession::OnAckedPacket(
+    ngtcp2_conn* conn,
+    size_t pktlen,
+    ngtcp2_tstamp ts_sent,
+    void* user_data) {
+  QuicSession* session = static_cast<QuicSession*>(user_data);
+  if (UNLIKELY(session->is_destroyed()))
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  if (session->congestion_controller_)
+    session->congestion_bytes_acked_ += pktlen;
+  return 0;
+}
+
 int QuicSession::OnHandshakeConfirmed(
     ngtcp2_conn* conn,
     void* user_data) {
@@ -3101,6 +3553,42 @@ int QuicSession::OnHandshakeConfirmed(
   return 0;
 }
 
+// Called by ngtcp2 to derive the packet protection keys for the next
+// key phase, either ahead of a locally initiated key update or when
+// the peer has initiated one.
+int QuicSession::OnUpdateKey(
+    ngtcp2_conn* conn,
+    uint8_t* rx_secret,
+    uint8_t* tx_secret,
+    uint8_t* rx_key,
+    uint8_t* rx_iv,
+    uint8_t* tx_key,
+    uint8_t* tx_iv,
+    const uint8_t* current_rx_secret,
+    const uint8_t* current_tx_secret,
+    size_t secretlen,
+    void* user_data) {
+  QuicSession* session = static_cast<QuicSession*>(user_data);
+  if (UNLIKELY(session->is_destroyed()))
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  if (NGTCP2_ERR(ngtcp2_crypto_update_key(
+          conn,
+          rx_secret,
+          tx_secret,
+          rx_key,
+          rx_iv,
+          tx_key,
+          tx_iv,
+          current_rx_secret,
+          current_tx_secret,
+          secretlen))) {
+    return NGTCP2_ERR_CALLBACK_FAILURE;
+  }
+  session->crypto_context()->packet_protection(NGTCP2_CRYPTO_LEVEL_APP)
+      ->Update(ngtcp2_conn_get_crypto_ctx(conn)->aead, rx_key, tx_key);
+  return 0;
+}
+
 // Called by ngtcp2 when a chunk of stream data has been received.
 // Currently, ngtcp2 ensures that this callback is always called
 // with an offset parameter strictly larger than the previous call's
@@ -3363,9 +3851,28 @@ int QuicSession::OnStatelessReset(
   return 0;
 }
 
+void QuicSession::InitQlogTrace(const char* side, const QuicCID& odcid) {
+  const std::shared_ptr<QuicQlogSink>& sink = socket()->qlog_sink();
+  if (!sink)
+    return;
+  std::string name = std::string(side) + "-" + odcid.ToString();
+  Debug(this, "Writing qlog output to %s%c%s.qlog",
+        sink->dir(), kPathSeparator, name);
+  qlog_trace_ = std::make_unique<QuicQlogTrace>(sink, name);
+}
+
 void QuicSession::OnQlogWrite(void* user_data, const void* data, size_t len) {
   QuicSession* session = static_cast<QuicSession*>(user_data);
-  session->listener()->OnQLog(reinterpret_cast<const uint8_t*>(data), len);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  if (session->qlog_trace_) {
+    if (!session->qlog_trace_->Write(bytes, len)) {
+      QuicSocket* socket = session->socket();
+      if (socket != nullptr)
+        socket->IncrementStat(&QuicSocketStats::qlog_bytes_dropped, len);
+    }
+    return;
+  }
+  session->listener()->OnQLog(bytes, len);
 }
 
 const ngtcp2_conn_callbacks QuicSession::callbacks[2] = {
@@ -3376,9 +3883,9 @@ const ngtcp2_conn_callbacks QuicSession::callbacks[2] = {
     OnReceiveCryptoData,
     OnHandshakeCompleted,
     OnVersionNegotiation,
-    ngtcp2_crypto_encrypt_cb,
-    ngtcp2_crypto_decrypt_cb,
-    ngtcp2_crypto_hp_mask_cb,
+    EncryptPacket,
+    DecryptPacket,
+    GetHeaderProtectionMask,
     OnReceiveStreamData,
     OnAckedCryptoOffset,
     OnAckedStreamDataOffset,
@@ -3391,7 +3898,7 @@ const ngtcp2_conn_callbacks QuicSession::callbacks[2] = {
     OnRand,
     OnGetNewConnectionID,
     OnRemoveConnectionID,
-    ngtcp2_crypto_update_key_cb,
+    OnUpdateKey,
     OnPathValidation,
     OnSelectPreferredAddress,
     OnStreamReset,
@@ -3399,7 +3906,10 @@ const ngtcp2_conn_callbacks QuicSession::callbacks[2] = {
     OnExtendMaxStreamsRemoteUni,
     OnExtendMaxStreamData,
     OnConnectionIDStatus,
-    OnHandshakeConfirmed
+    OnHandshakeConfirmed,
+    OnReceiveNewToken,
+    OnAckedPmtudProbe,
+    OnAckedPacket
   },
   // NGTCP2_CRYPTO_SIDE_SERVER
   {
@@ -3408,9 +3918,9 @@ const ngtcp2_conn_callbacks QuicSession::callbacks[2] = {
     OnReceiveCryptoData,
     OnHandshakeCompleted,
     nullptr,  // recv_version_negotiation
-    ngtcp2_crypto_encrypt_cb,
-    ngtcp2_crypto_decrypt_cb,
-    ngtcp2_crypto_hp_mask_cb,
+    EncryptPacket,
+    DecryptPacket,
+    GetHeaderProtectionMask,
     OnReceiveStreamData,
     OnAckedCryptoOffset,
     OnAckedStreamDataOffset,
@@ -3423,7 +3933,7 @@ const ngtcp2_conn_callbacks QuicSession::callbacks[2] = {
     OnRand,
     OnGetNewConnectionID,
     OnRemoveConnectionID,
-    ngtcp2_crypto_update_key_cb,
+    OnUpdateKey,
     OnPathValidation,
     nullptr,  // select_preferred_addr
     OnStreamReset,
@@ -3432,6 +3942,9 @@ const ngtcp2_conn_callbacks QuicSession::callbacks[2] = {
     OnExtendMaxStreamData,
     OnConnectionIDStatus,
     nullptr,  // handshake_confirmed
+    nullptr,  // recv_new_token
+    OnAckedPmtudProbe,
+    OnAckedPacket
   }
 };
 
@@ -3675,9 +4188,10 @@ void NewQuicClientSession(const FunctionCallbackInfo<Value>& args) {
           alpn,
           std::string(*servername),
           options,
-          args[ARG_IDX::QLOG]->IsTrue() ?
-              QlogMode::kEnabled :
-              QlogMode::kDisabled);
+          socket->SelectQlogMode(
+              args[ARG_IDX::QLOG]->IsTrue() ?
+                  QlogMode::kEnabled :
+                  QlogMode::kDisabled));
 
   // Start the TLS handshake if the autoStart option is true
   // (which it is by default).
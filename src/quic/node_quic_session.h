@@ -13,7 +13,9 @@
 #include "node_mem.h"
 #include "node_quic_state.h"
 #include "node_quic_buffer-inl.h"
+#include "node_quic_congestion.h"
 #include "node_quic_crypto.h"
+#include "node_quic_qlog.h"
 #include "node_quic_util.h"
 #include "node_sockaddr.h"
 #include "v8.h"
@@ -23,6 +25,7 @@
 #include <ngtcp2/ngtcp2_crypto.h>
 #include <openssl/ssl.h>
 
+#include <functional>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -75,6 +78,8 @@ class QuicSessionConfig : public ngtcp2_settings {
     qlog = config.qlog;
     log_printf = config.log_printf;
     token = config.token;
+    max_pacing_burst = config.max_pacing_burst;
+    cc_algorithm = config.cc_algorithm;
   }
 
   void ResetToDefaults(QuicState* quic_state);
@@ -100,6 +105,14 @@ class QuicSessionConfig : public ngtcp2_settings {
       QuicCID* pscid);
 
   inline void set_qlog(const ngtcp2_qlog_settings& qlog);
+
+  // The maximum number of packets the QuicSession may send
+  // back to back. This is not a transport parameter.
+  uint64_t max_pacing_burst = DEFAULT_MAX_PACING_BURST;
+
+  // One of QuicCongestionControlAlgorithm. This is not a
+  // transport parameter.
+  uint64_t cc_algorithm = QUIC_CC_ALGORITHM_NEWRENO;
 };
 
 // Options to alter the behavior of various functions on the
@@ -230,7 +243,16 @@ enum QuicSessionState : int {
   V(BLOCK_COUNT, block_count, "Block Count")                                   \
   V(MIN_RTT, min_rtt, "Minimum RTT")                                           \
   V(LATEST_RTT, latest_rtt, "Latest RTT")                                      \
-  V(SMOOTHED_RTT, smoothed_rtt, "Smoothed RTT")
+  V(SMOOTHED_RTT, smoothed_rtt, "Smoothed RTT")                                \
+  V(PACING_DELAY_COUNT, pacing_delay_count, "Pacing Delay Count")              \
+  V(PACING_DELAY_TIME, pacing_delay_time, "Pacing Delay Time")                \
+  V(CONGESTION_WINDOW, congestion_window, "Congestion Window")                 \
+  V(SLOW_START_THRESHOLD, slow_start_threshold, "Slow Start Threshold")        \
+  V(PACING_RATE, pacing_rate, "Pacing Rate")                                  \
+  V(PATH_MTU, path_mtu, "Path MTU")                                            \
+  V(PATH_MTU_PROBE_COUNT, path_mtu_probe_count, "Path MTU Probe Count")      \
+  V(CONGESTION_CONTROL, congestion_control, "Congestion Control Algorithm")    \
+  V(HANDSHAKE_OFFLOAD_COUNT, handshake_offload_count, "Handshake Offload Count")
 
 #define V(name, _, __) IDX_QUIC_SESSION_STATS_##name,
 enum QuicSessionStatsIdx : int {
@@ -344,6 +366,14 @@ class JSQuicSessionListener : public QuicSessionListener {
   void OnQLog(const uint8_t* data, size_t len) override;
 
  private:
+  // Returns the QuicSocket if it is batching events, in which case
+  // stream events are queued on it rather than passed to JavaScript.
+  QuicSocket* batching_socket() const;
+
+  // Passes the queued events to JavaScript ahead of an event that
+  // is not batched.
+  void FlushEvents();
+
   friend class QuicSession;
 };
 
@@ -411,6 +441,15 @@ class QuicCryptoContext : public MemoryRetainer {
   // OCSP callback
   inline void ResumeHandshake();
 
+  // Resumes the TLS handshake when a private key operation that was
+  // offloaded to the threadpool is done (see EnableHandshakeOffload).
+  void OnPrivateKeyOperationDone();
+
+  // The QuicCryptoContext whose TLS handshake is running on this
+  // thread, if any. Offloaded private key operations are called by
+  // OpenSSL without a reference to the SSL and use it instead.
+  static QuicCryptoContext* current_handshake() { return current_handshake_; }
+
   inline v8::MaybeLocal<v8::Value> cert() const;
   inline v8::MaybeLocal<v8::Value> cipher_name() const;
   inline v8::MaybeLocal<v8::Value> cipher_version() const;
@@ -444,6 +483,11 @@ class QuicCryptoContext : public MemoryRetainer {
 
   bool InitiateKeyUpdate();
 
+  // The prepared packet protection ciphers for the given level.
+  QuicPacketProtection* packet_protection(ngtcp2_crypto_level level) {
+    return &packet_protection_[level];
+  }
+
   int VerifyPeerIdentity(const char* hostname);
 
   QuicSession* session() const { return session_.get(); }
@@ -472,11 +516,23 @@ class QuicCryptoContext : public MemoryRetainer {
       const uint8_t* tx_secret,
       size_t secretlen);
 
+  // When handshake offload is enabled, the TLS handshake runs within
+  // an OpenSSL async job, on the job's own small stack, where
+  // JavaScript must not be entered. RunOutsideAsyncJob calls fn right
+  // away unless that is the case, in which case fn is queued and
+  // called by RunDeferred once the job has returned or paused.
+  template <typename Fn>
+  inline void RunOutsideAsyncJob(Fn&& fn);
+
+  void RunDeferred();
+
   BaseObjectWeakPtr<QuicSession> session_;
   BaseObjectPtr<crypto::SecureContext> secure_context_;
   ngtcp2_crypto_side side_;
   crypto::SSLPointer ssl_;
   QuicBuffer handshake_[3];
+  // Indexed by ngtcp2_crypto_level
+  QuicPacketProtection packet_protection_[4];
   bool is_handshake_started_ = false;
   bool in_tls_callback_ = false;
   bool in_key_update_ = false;
@@ -484,6 +540,9 @@ class QuicCryptoContext : public MemoryRetainer {
   bool in_client_hello_ = false;
   bool early_data_ = false;
   uint32_t options_;
+  std::vector<std::function<void()>> deferred_;
+
+  static thread_local QuicCryptoContext* current_handshake_;
 
   v8::Global<v8::ArrayBufferView> ocsp_response_;
   crypto::BIOPointer bio_trace_;
@@ -566,6 +625,7 @@ class QuicApplication : public MemoryRetainer,
   virtual void ExtendMaxStreamsRemoteBidi(uint64_t max_streams) {}
   virtual void ExtendMaxStreamData(int64_t stream_id, uint64_t max_data) {}
   virtual void ResumeStream(int64_t stream_id) {}
+  virtual void StreamPriorityChanged(int64_t stream_id) {}
   virtual void SetSessionTicketAppData(const SessionTicketAppData& app_data) {
     // TODO(@jasnell): Different QUIC applications may wish to set some
     // application data in the session ticket (e.g. http/3 would set
@@ -787,6 +847,8 @@ class QuicSession : public AsyncWrap,
 
   inline QuicCID dcid() const;
 
+  const QuicCID& scid() const { return scid_; }
+
   // When a client QuicSession is created, if the autoStart
   // option is true, the handshake will be immediately started.
   // If autoStart is false, the start of the handshake will be
@@ -868,6 +930,10 @@ class QuicSession : public AsyncWrap,
 
   ngtcp2_conn* connection() const { return connection_.get(); }
 
+  // Received stream data is copied into the receive slab before it
+  // is passed to JavaScript.
+  QuicReceiveSlab* receive_slab() { return &receive_slab_; }
+
   void AddStream(BaseObjectPtr<QuicStream> stream);
 
   void AddToSocket(QuicSocket* socket);
@@ -937,6 +1003,21 @@ class QuicSession : public AsyncWrap,
   // Causes pending ngtcp2 frames to be serialized and sent
   void SendPendingData();
 
+  // The number of packets SendPendingData may send before the
+  // pacer requires a pause. Packets are not paced until the
+  // handshake has completed.
+  inline size_t GetPacingBudget();
+
+  inline void ConsumePacingBudget(size_t length);
+
+  // Arranges for SendPendingData to be called again once the
+  // pacer allows another packet to be sent.
+  void SchedulePacedSend();
+
+  // The rate, in bytes per nanosecond, at which packets are to be
+  // paced, or 0 if there is not yet an RTT estimate.
+  inline double GetPacingRate() const;
+
   inline bool SendPacket(
       std::unique_ptr<QuicPacket> packet,
       const ngtcp2_path_storage& path);
@@ -1159,6 +1240,11 @@ class QuicSession : public AsyncWrap,
         ngtcp2_cid* cid,
         size_t cidlen);
 
+  static void WorkerConnectionIDStrategy(
+        QuicSession* session,
+        ngtcp2_cid* cid,
+        size_t cidlen);
+
   // Initialize the QuicSession as a server
   void InitServer(
       QuicSessionConfig config,
@@ -1180,6 +1266,9 @@ class QuicSession : public AsyncWrap,
 
   inline void InitApplication();
 
+  // Opens a trace in the QuicSocket's QuicQlogSink, if it has one.
+  void InitQlogTrace(const char* side, const QuicCID& odcid);
+
   void AckedStreamDataOffset(
       int64_t stream_id,
       uint64_t offset,
@@ -1219,10 +1308,14 @@ class QuicSession : public AsyncWrap,
 
   bool ReceiveRetry();
 
+  void ReceiveNewToken(const uint8_t* token, size_t tokenlen);
+
   inline void RemoveConnectionID(const QuicCID& cid);
 
   void ScheduleRetransmit();
 
+  bool SubmitNewToken();
+
   bool SendPacket(std::unique_ptr<QuicPacket> packet);
 
   inline void set_local_address(const ngtcp2_addr* addr);
@@ -1240,6 +1333,21 @@ class QuicSession : public AsyncWrap,
 
   void UpdateRecoveryStats();
 
+  // Feeds the congestion signals observed by ngtcp2 since the last
+  // call to the selected congestion controller, if any, and replaces
+  // ngtcp2's congestion window with the controller's.
+  void UpdateCongestionControl();
+
+  void InitCongestionControl(uint64_t algorithm);
+
+  // Restarts path MTU discovery for the current path.
+  void ResetPathMtu();
+
+  // Sends a path MTU discovery probe if one is due.
+  void MaybeProbePathMtu();
+
+  void PathMtuProbeAcked(size_t length);
+
   void UpdateConnectionID(
       int type,
       const QuicCID& cid,
@@ -1277,6 +1385,19 @@ class QuicSession : public AsyncWrap,
       ngtcp2_conn* conn,
       void* user_data);
 
+  static int OnUpdateKey(
+      ngtcp2_conn* conn,
+      uint8_t* rx_secret,
+      uint8_t* tx_secret,
+      uint8_t* rx_key,
+      uint8_t* rx_iv,
+      uint8_t* tx_key,
+      uint8_t* tx_iv,
+      const uint8_t* current_rx_secret,
+      const uint8_t* current_tx_secret,
+      size_t secretlen,
+      void* user_data);
+
   static int OnReceiveStreamData(
       ngtcp2_conn* conn,
       int64_t stream_id,
@@ -1293,6 +1414,22 @@ class QuicSession : public AsyncWrap,
       const ngtcp2_pkt_retry* retry,
       void* user_data);
 
+  static int OnReceiveNewToken(
+      ngtcp2_conn* conn,
+      const ngtcp2_vec* token,
+      void* user_data);
+
+  static int OnAckedPmtudProbe(
+      ngtcp2_conn* conn,
+      size_t probelen,
+      void* user_data);
+
+  static int OnAckedPacket(
+      ngtcp2_conn* conn,
+      size_t pktlen,
+      ngtcp2_tstamp ts_sent,
+      void* user_data);
+
   static int OnAckedCryptoOffset(
       ngtcp2_conn* conn,
       ngtcp2_crypto_level crypto_level,
@@ -1410,6 +1547,8 @@ class QuicSession : public AsyncWrap,
 
   void UpdateIdleTimer();
 
+  void OnPacingTimeout();
+
   inline void UpdateRetransmitTimer(uint64_t timeout);
 
   inline void StopRetransmitTimer();
@@ -1526,8 +1665,24 @@ class QuicSession : public AsyncWrap,
   QuicSessionListener* listener_ = nullptr;
   JSQuicSessionListener default_listener_;
 
-  TimerPointer idle_;
-  TimerPointer retransmit_;
+  QuicTimer idle_;
+  QuicTimer retransmit_;
+  QuicTimer pacing_;
+
+  QuicPacer pacer_;
+  uint64_t pacing_scheduled_at_ = 0;
+
+  std::unique_ptr<QuicCongestionController> congestion_controller_;
+  QuicPathMtuDiscovery pmtud_;
+
+  // Set when the QuicSocket writes qlog output to a QuicQlogSink
+  // rather than emitting it to JavaScript.
+  std::unique_ptr<QuicQlogTrace> qlog_trace_;
+
+  QuicReceiveSlab receive_slab_;
+  uint64_t congestion_bytes_acked_ = 0;
+  uint64_t congestion_recovery_start_ = 0;
+  uint64_t congestion_window_ = 0;
 
   QuicCID scid_;
   QuicCID rcid_;
@@ -15,10 +15,28 @@ using crypto::EntropySource;
 
 namespace quic {
 
+uint8_t* QuicPacketPool::Acquire(bool* reused) {
+  *reused = !free_.empty();
+  if (!*reused)
+    return new uint8_t[kSlotSize];
+  uint8_t* data = free_.back();
+  free_.pop_back();
+  return data;
+}
+
+void QuicPacketPool::Release(uint8_t* data) {
+  if (free_.size() >= kMaxFree) {
+    delete[] data;
+    return;
+  }
+  free_.push_back(data);
+}
+
 std::unique_ptr<QuicPacket> QuicPacket::Create(
+    QuicSocket* socket,
     const char* diagnostic_label,
     size_t len) {
-  return std::make_unique<QuicPacket>(diagnostic_label, len);
+  return std::make_unique<QuicPacket>(socket, diagnostic_label, len);
 }
 
 std::unique_ptr<QuicPacket> QuicPacket::Copy(
@@ -27,8 +45,8 @@ std::unique_ptr<QuicPacket> QuicPacket::Copy(
 }
 
 void QuicPacket::set_length(size_t len) {
-  CHECK_LE(len, data_.size());
-  data_.resize(len);
+  CHECK_LE(len, capacity_);
+  length_ = len;
 }
 
 int QuicEndpoint::Send(
@@ -41,6 +59,18 @@ int QuicEndpoint::Send(
   return ret;
 }
 
+ssize_t QuicEndpoint::TrySendBatch(
+    uv_buf_t* bufs,
+    size_t nbufs,
+    const sockaddr* addr) {
+  return udp_->TrySendBatch(bufs, nbufs, addr);
+}
+
+bool QuicEndpoint::is_receive_slab(const uv_buf_t& buf) const {
+  return buf.base >= receive_slab_.data &&
+         buf.base < receive_slab_.data + receive_slab_.size;
+}
+
 int QuicEndpoint::ReceiveStart() {
   return udp_->RecvStart();
 }
@@ -60,14 +90,21 @@ void QuicEndpoint::WaitForPendingCallbacks() {
 void QuicSocket::AssociateCID(
     const QuicCID& cid,
     const QuicCID& scid) {
-  if (cid && scid)
-    dcid_to_scid_[cid] = scid;
+  if (!cid || !scid)
+    return;
+  BaseObjectPtr<QuicSession>* session = sessions_.Find(scid);
+  if (session != nullptr)
+    sessions_.Insert(cid, *session);
 }
 
 void QuicSocket::DisassociateCID(const QuicCID& cid) {
   if (cid) {
+    // The session's own scid is only removed by RemoveSession.
+    BaseObjectPtr<QuicSession>* session = sessions_.Find(cid);
+    if (session == nullptr || (*session)->scid() == cid)
+      return;
     Debug(this, "Removing association for cid %s", cid);
-    dcid_to_scid_.erase(cid);
+    sessions_.Erase(cid);
   }
 }
 
@@ -75,7 +112,7 @@ void QuicSocket::AssociateStatelessResetToken(
     const StatelessResetToken& token,
     BaseObjectPtr<QuicSession> session) {
   Debug(this, "Associating stateless reset token %s", token);
-  token_map_[token] = session;
+  token_map_.Insert(token, session);
 }
 
 const SocketAddress& QuicSocket::local_address() {
@@ -86,7 +123,7 @@ const SocketAddress& QuicSocket::local_address() {
 void QuicSocket::DisassociateStatelessResetToken(
     const StatelessResetToken& token) {
   Debug(this, "Removing stateless reset token %s", token);
-  token_map_.erase(token);
+  token_map_.Erase(token);
 }
 
 // StopListening is called when the QuicSocket is no longer
@@ -103,21 +140,43 @@ void QuicSocket::StopListening() {
   }
 }
 
+// The forwarding endpoint is excluded: it starts receiving as soon as
+// it is bound, and keeps receiving for as long as it exists so that
+// packets of existing sessions forwarded by other workers are never
+// lost.
 void QuicSocket::ReceiveStart() {
-  for (const auto& endpoint : endpoints_)
-    CHECK_EQ(endpoint->ReceiveStart(), 0);
+  for (const auto& endpoint : endpoints_) {
+    if (!endpoint->is_forwarding())
+      CHECK_EQ(endpoint->ReceiveStart(), 0);
+  }
 }
 
 void QuicSocket::ReceiveStop() {
-  for (const auto& endpoint : endpoints_)
-    CHECK_EQ(endpoint->ReceiveStop(), 0);
+  for (const auto& endpoint : endpoints_) {
+    if (!endpoint->is_forwarding())
+      CHECK_EQ(endpoint->ReceiveStop(), 0);
+  }
 }
 
 void QuicSocket::RemoveSession(
     const QuicCID& cid,
     const SocketAddress& addr) {
   DecrementSocketAddressCounter(addr);
-  sessions_.erase(cid);
+  if (sessions_.Erase(cid))
+    session_count_--;
+}
+
+uint8_t* QuicSocket::AcquirePacketBuffer() {
+  bool reused;
+  uint8_t* data = packet_pool_.Acquire(&reused);
+  IncrementStat(reused ?
+      &QuicSocketStats::packet_pool_hits :
+      &QuicSocketStats::packet_pool_misses);
+  return data;
+}
+
+void QuicSocket::ReleasePacketBuffer(uint8_t* data) {
+  packet_pool_.Release(data);
 }
 
 void QuicSocket::ReportSendError(int error) {
@@ -125,33 +184,23 @@ void QuicSocket::ReportSendError(int error) {
 }
 
 void QuicSocket::IncrementStatelessResetCounter(const SocketAddress& addr) {
-  reset_counts_[addr]++;
+  reset_counts_.Increment(addr);
 }
 
 void QuicSocket::IncrementSocketAddressCounter(const SocketAddress& addr) {
-  addr_counts_[addr]++;
+  addr_counts_.Increment(addr);
 }
 
 void QuicSocket::DecrementSocketAddressCounter(const SocketAddress& addr) {
-  auto it = addr_counts_.find(addr);
-  if (it == std::end(addr_counts_))
-    return;
-  it->second--;
-  // Remove the address if the counter reaches zero again.
-  if (it->second == 0) {
-    addr_counts_.erase(addr);
-    reset_counts_.erase(addr);
-  }
+  addr_counts_.Decrement(addr);
 }
 
 size_t QuicSocket::GetCurrentSocketAddressCounter(const SocketAddress& addr) {
-  auto it = addr_counts_.find(addr);
-  return it == std::end(addr_counts_) ? 0 : it->second;
+  return addr_counts_.Get(addr);
 }
 
 size_t QuicSocket::GetCurrentStatelessResetCounter(const SocketAddress& addr) {
-  auto it = reset_counts_.find(addr);
-  return it == std::end(reset_counts_) ? 0 : it->second;
+  return reset_counts_.Get(addr);
 }
 
 void QuicSocket::set_server_busy(bool on) {
@@ -167,6 +216,17 @@ bool QuicSocket::is_diagnostic_packet_loss(double prob) const {
   return (static_cast<double>(c) / 255) < prob;
 }
 
+QlogMode QuicSocket::SelectQlogMode(QlogMode requested) const {
+  if (requested == QlogMode::kEnabled || qlog_sample_rate_ >= 1.0)
+    return QlogMode::kEnabled;
+  if (LIKELY(qlog_sample_rate_ <= 0.0))
+    return QlogMode::kDisabled;
+  uint32_t r;
+  EntropySource(reinterpret_cast<unsigned char*>(&r), sizeof(r));
+  return static_cast<double>(r) / UINT32_MAX < qlog_sample_rate_ ?
+      QlogMode::kEnabled : QlogMode::kDisabled;
+}
+
 void QuicSocket::set_diagnostic_packet_loss(double rx, double tx) {
   rx_loss_ = rx;
   tx_loss_ = tx;
@@ -180,28 +240,41 @@ bool QuicSocket::ToggleStatelessReset() {
 }
 
 void QuicSocket::set_validated_address(const SocketAddress& addr) {
-  if (is_option_set(QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU)) {
-    // Remove the oldest item if we've hit the LRU limit
-    validated_addrs_.push_back(SocketAddress::Hash()(addr));
-    if (validated_addrs_.size() > kMaxValidateAddressLru)
-      validated_addrs_.pop_front();
+  if (is_option_set(QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU))
+    validated_addrs_.Insert(addr);
+}
+
+void QuicSocket::StoreNewToken(
+    const SocketAddress& addr,
+    const uint8_t* token,
+    size_t tokenlen) {
+  if (new_tokens_.size() >= kMaxStoredNewTokens &&
+      new_tokens_.find(addr) == std::end(new_tokens_)) {
+    new_tokens_.erase(std::begin(new_tokens_));
   }
+  new_tokens_[addr].assign(token, token + tokenlen);
 }
 
-bool QuicSocket::is_validated_address(const SocketAddress& addr) const {
-  if (is_option_set(QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU)) {
-    auto res = std::find(std::begin(validated_addrs_),
-                         std::end(validated_addrs_),
-                         SocketAddress::Hash()(addr));
-    return res != std::end(validated_addrs_);
+std::vector<uint8_t> QuicSocket::TakeNewToken(const SocketAddress& addr) {
+  std::vector<uint8_t> token;
+  auto it = new_tokens_.find(addr);
+  if (it != std::end(new_tokens_)) {
+    token = std::move(it->second);
+    new_tokens_.erase(it);
   }
-  return false;
+  return token;
+}
+
+bool QuicSocket::is_validated_address(const SocketAddress& addr) const {
+  return is_option_set(QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU) &&
+         validated_addrs_.Contains(addr);
 }
 
 void QuicSocket::AddSession(
     const QuicCID& cid,
     BaseObjectPtr<QuicSession> session) {
-  sessions_[cid] = session;
+  sessions_.Insert(cid, session);
+  session_count_++;
   IncrementSocketAddressCounter(session->remote_address());
   IncrementStat(
       session->is_server() ?
@@ -211,15 +284,31 @@ void QuicSocket::AddSession(
 
 void QuicSocket::AddEndpoint(
     BaseObjectPtr<QuicEndpoint> endpoint_,
-    bool preferred) {
-  Debug(this, "Adding %sendpoint", preferred ? "preferred " : "");
-  if (preferred || endpoints_.empty())
+    bool preferred,
+    bool forwarding) {
+  Debug(this, "Adding %sendpoint",
+        forwarding ? "forwarding " : preferred ? "preferred " : "");
+  if (forwarding) {
+    // A forwarding endpoint never carries sessions of its own.
+    CHECK(!forwarding_endpoint_);
+    endpoint_->set_forwarding();
+    forwarding_endpoint_ = endpoint_;
+  } else if (preferred || !preferred_endpoint_) {
     preferred_endpoint_ = endpoint_;
+  }
   endpoints_.emplace_back(endpoint_);
-  if (is_flag_set(QUICSOCKET_FLAGS_SERVER_LISTENING))
+  if (!forwarding && is_flag_set(QUICSOCKET_FLAGS_SERVER_LISTENING))
     endpoint_->ReceiveStart();
 }
 
+void QuicSocket::AddForwardingPeer(
+    uint8_t worker_id,
+    const SocketAddress& addr) {
+  Debug(this, "Worker %d forwards at %s", worker_id, addr);
+  forwarding_peers_[worker_id] = addr;
+  forwarding_peer_ids_[addr] = worker_id;
+}
+
 void QuicSocket::SessionReady(BaseObjectPtr<QuicSession> session) {
   listener_->OnSessionReady(session);
 }
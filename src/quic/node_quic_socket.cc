@@ -25,9 +25,12 @@ namespace node {
 using crypto::EntropySource;
 using crypto::SecureContext;
 
+using v8::Array;
+using v8::ArrayBuffer;
 using v8::ArrayBufferView;
 using v8::Boolean;
 using v8::Context;
+using v8::Float64Array;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
@@ -39,6 +42,8 @@ using v8::Object;
 using v8::ObjectTemplate;
 using v8::PropertyAttribute;
 using v8::String;
+using v8::Uint32;
+using v8::Undefined;
 using v8::Value;
 
 namespace quic {
@@ -81,17 +86,104 @@ bool IsShortHeader(
          pscid == nullptr &&
          pscidlen == 0;
 }
+
+// A packet forwarded to another worker of the group is prefixed with
+// the address it was received from and the local address it was
+// received on, so that the owning worker can process it as though it
+// had received the packet itself:
+//
+//   family (4 or 6) | remote ip | remote port | local ip | local port
+//
+// Ports are in network byte order.
+constexpr size_t kMaxForwardHeaderLen =
+    1 + 2 * (sizeof(in6_addr) + sizeof(uint16_t));
+
+size_t WriteForwardedAddress(uint8_t* dest, const SocketAddress& addr) {
+  switch (addr.family()) {
+    case AF_INET: {
+      const sockaddr_in* ipv4 =
+          reinterpret_cast<const sockaddr_in*>(addr.raw());
+      memcpy(dest, &ipv4->sin_addr, sizeof(ipv4->sin_addr));
+      memcpy(dest + sizeof(ipv4->sin_addr), &ipv4->sin_port, sizeof(uint16_t));
+      return sizeof(ipv4->sin_addr) + sizeof(uint16_t);
+    }
+    case AF_INET6: {
+      const sockaddr_in6* ipv6 =
+          reinterpret_cast<const sockaddr_in6*>(addr.raw());
+      memcpy(dest, &ipv6->sin6_addr, sizeof(ipv6->sin6_addr));
+      memcpy(dest + sizeof(ipv6->sin6_addr), &ipv6->sin6_port,
+             sizeof(uint16_t));
+      return sizeof(ipv6->sin6_addr) + sizeof(uint16_t);
+    }
+    default:
+      UNREACHABLE();
+  }
+}
+
+size_t ReadForwardedAddress(
+    int family,
+    const uint8_t* data,
+    size_t len,
+    SocketAddress* addr) {
+  sockaddr_storage storage;
+  memset(&storage, 0, sizeof(storage));
+  if (family == AF_INET) {
+    sockaddr_in* ipv4 = reinterpret_cast<sockaddr_in*>(&storage);
+    if (len < sizeof(ipv4->sin_addr) + sizeof(uint16_t))
+      return 0;
+    ipv4->sin_family = AF_INET;
+    memcpy(&ipv4->sin_addr, data, sizeof(ipv4->sin_addr));
+    memcpy(&ipv4->sin_port, data + sizeof(ipv4->sin_addr), sizeof(uint16_t));
+    *addr = SocketAddress(reinterpret_cast<const sockaddr*>(&storage));
+    return sizeof(ipv4->sin_addr) + sizeof(uint16_t);
+  }
+  sockaddr_in6* ipv6 = reinterpret_cast<sockaddr_in6*>(&storage);
+  if (len < sizeof(ipv6->sin6_addr) + sizeof(uint16_t))
+    return 0;
+  ipv6->sin6_family = AF_INET6;
+  memcpy(&ipv6->sin6_addr, data, sizeof(ipv6->sin6_addr));
+  memcpy(&ipv6->sin6_port, data + sizeof(ipv6->sin6_addr), sizeof(uint16_t));
+  *addr = SocketAddress(reinterpret_cast<const sockaddr*>(&storage));
+  return sizeof(ipv6->sin6_addr) + sizeof(uint16_t);
+}
 }  // namespace
 
-QuicPacket::QuicPacket(const char* diagnostic_label, size_t len) :
-    data_(len),
+QuicPacketPool::~QuicPacketPool() {
+  for (uint8_t* data : free_)
+    delete[] data;
+}
+
+void QuicPacketPool::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("free", free_.size() * kSlotSize);
+}
+
+QuicPacket::QuicPacket(
+    QuicSocket* socket,
+    const char* diagnostic_label,
+    size_t len) :
+    length_(len),
+    capacity_(len),
     diagnostic_label_(diagnostic_label) {
   CHECK_LE(len, NGTCP2_MAX_PKT_SIZE);
+  if (socket != nullptr && len <= QuicPacketPool::kSlotSize) {
+    socket_.reset(socket);
+    data_ = socket->AcquirePacketBuffer();
+  } else {
+    data_ = new uint8_t[len];
+  }
 }
 
 QuicPacket::QuicPacket(const QuicPacket& other) :
-  QuicPacket(other.diagnostic_label_, other.data_.size()) {
-  memcpy(data_.data(), other.data_.data(), other.data_.size());
+  QuicPacket(other.socket_.get(), other.diagnostic_label_, other.length_) {
+  memcpy(data_, other.data_, other.length_);
+}
+
+QuicPacket::~QuicPacket() {
+  // If the QuicSocket is already gone, so is its pool.
+  if (socket_)
+    socket_->ReleasePacketBuffer(data_);
+  else
+    delete[] data_;
 }
 
 const char* QuicPacket::diagnostic_label() const {
@@ -100,7 +192,7 @@ const char* QuicPacket::diagnostic_label() const {
 }
 
 void QuicPacket::MemoryInfo(MemoryTracker* tracker) const {
-  tracker->TrackField("data", data_);
+  tracker->TrackFieldWithSize("data", capacity_);
 }
 
 QuicSocketListener::~QuicSocketListener() {
@@ -135,6 +227,7 @@ void QuicSocketListener::OnDestroy() {
 
 void JSQuicSocketListener::OnError(ssize_t code) {
   Environment* env = socket()->env();
+  socket()->FlushEvents();
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
   Local<Value> arg = Number::New(env->isolate(), static_cast<double>(code));
@@ -143,6 +236,7 @@ void JSQuicSocketListener::OnError(ssize_t code) {
 
 void JSQuicSocketListener::OnSessionReady(BaseObjectPtr<QuicSession> session) {
   Environment* env = socket()->env();
+  socket()->FlushEvents();
   Local<Value> arg = session->object();
   Context::Scope context_scope(env->context());
   socket()->MakeCallback(env->quic_on_session_ready_function(), 1, &arg);
@@ -150,6 +244,7 @@ void JSQuicSocketListener::OnSessionReady(BaseObjectPtr<QuicSession> session) {
 
 void JSQuicSocketListener::OnServerBusy(bool busy) {
   Environment* env = socket()->env();
+  socket()->FlushEvents();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
   Local<Value> arg = Boolean::New(env->isolate(), busy);
@@ -188,31 +283,80 @@ QuicEndpoint::QuicEndpoint(
   strong_ptr_.reset(udp_->GetAsyncWrap());
 }
 
-void QuicEndpoint::MemoryInfo(MemoryTracker* tracker) const {}
+void QuicEndpoint::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("receive_slab", receive_slab_.size);
+}
 
+// Hands out the reusable receive slab. When the UDP handle was
+// created with UV_UDP_RECVMMSG, libuv splits the slab into
+// kReceiveSlotSize chunks and fills as many of them as it can
+// with a single recvmmsg() call. Otherwise, the slab is simply
+// used for one datagram at a time. A fresh allocation is only
+// made in the unlikely event that the slab is still in use.
 uv_buf_t QuicEndpoint::OnAlloc(size_t suggested_size) {
-  return env()->AllocateManaged(suggested_size).release();
+  if (UNLIKELY(receive_slab_in_use_ || suggested_size > kReceiveSlotSize))
+    return env()->AllocateManaged(suggested_size).release();
+
+  if (receive_slab_.is_empty()) {
+    receive_slab_ = MallocedBuffer<char>(
+        kReceiveSlabDatagrams * kReceiveSlotSize);
+  }
+  receive_slab_in_use_ = true;
+  return uv_buf_init(receive_slab_.data, receive_slab_.size);
+}
+
+void QuicEndpoint::ReleaseReceiveBuffer(const uv_buf_t& buf) {
+  if (is_receive_slab(buf)) {
+    receive_slab_in_use_ = false;
+    return;
+  }
+  // Frees the fallback allocation made by OnAlloc().
+  AllocatedBuffer fallback(env(), buf);
 }
 
 void QuicEndpoint::OnRecv(
     ssize_t nread,
-    const uv_buf_t& buf_,
+    const uv_buf_t& buf,
     const sockaddr* addr,
     unsigned int flags) {
-  AllocatedBuffer buf(env(), buf_);
+  // Datagrams read with recvmmsg() point into the buffer returned by
+  // OnAlloc(). libuv follows them with one final zero-length call
+  // that hands back that buffer, so that is when it is released.
+  // The events generated by all of those datagrams are batched
+  // together when the QuicSocket is batching events.
+  const bool is_chunk = flags & UV_UDP_MMSG_CHUNK;
+  BaseObjectPtr<QuicEndpoint> ptr(this);
 
   if (nread <= 0) {
+    if (!is_chunk) {
+      ReleaseReceiveBuffer(buf);
+      listener_->OnReceiveBatchEnd();
+    }
     if (nread < 0)
       listener_->OnError(this, nread);
     return;
   }
 
-  listener_->OnReceive(
-      nread,
-      std::move(buf),
-      local_address(),
-      SocketAddress(addr),
-      flags);
+  if (is_chunk)
+    listener_->OnReceiveBatchStart();
+  if (UNLIKELY(forwarding_)) {
+    listener_->OnReceiveForwarded(
+        nread,
+        reinterpret_cast<const uint8_t*>(buf.base),
+        local_address(),
+        SocketAddress(addr),
+        flags & ~UV_UDP_MMSG_CHUNK);
+  } else {
+    listener_->OnReceive(
+        nread,
+        reinterpret_cast<const uint8_t*>(buf.base),
+        local_address(),
+        SocketAddress(addr),
+        flags & ~UV_UDP_MMSG_CHUNK);
+  }
+
+  if (!is_chunk)
+    ReleaseReceiveBuffer(buf);
 }
 
 ReqWrap<uv_udp_send_t>* QuicEndpoint::CreateSendWrap(size_t msg_size) {
@@ -226,7 +370,25 @@ void QuicEndpoint::OnSendDone(ReqWrap<uv_udp_send_t>* wrap, int status) {
     listener_->OnEndpointDone(this);
 }
 
+uv_udp_send_t* QuicEndpoint::CreateNativeSendReq(size_t msg_size) {
+  return listener_->OnCreateNativeSendReq(msg_size);
+}
+
+void QuicEndpoint::OnNativeSendDone(uv_udp_send_t* req, int status) {
+  DecrementPendingCallbacks();
+  // The QuicSocket may have been destroyed while the send was pending,
+  // along with its pool of send requests.
+  if (!listener_) {
+    QuicSocket::FreeSendRequest(req);
+    return;
+  }
+  listener_->OnNativeSendDone(req, status);
+  if (!has_pending_callbacks() && waiting_for_callbacks_)
+    listener_->OnEndpointDone(this);
+}
+
 void QuicEndpoint::OnAfterBind() {
+  dont_fragment_ = udp_->SetDontFragment() == 0;
   listener_->OnBind(this);
 }
 
@@ -240,28 +402,56 @@ QuicSocket::QuicSocket(
     uint32_t options,
     QlogMode qlog,
     const uint8_t* session_reset_secret,
-    bool disable_stateless_reset)
+    bool disable_stateless_reset,
+    const std::string& qlog_dir,
+    double qlog_sample_rate,
+    QuicHistogramMode histogram_mode,
+    size_t validate_address_lru_size,
+    size_t address_sketch_size,
+    const uint8_t* token_secret,
+    int worker_id,
+    const uint8_t* ticket_key_secret,
+    uint64_t ticket_key_rotation)
   : AsyncWrap(quic_state->env(), wrap, AsyncWrap::PROVIDER_QUICSOCKET),
     StatsBase(quic_state->env(), wrap),
     alloc_info_(MakeAllocator()),
+    timer_wheel_(new QuicTimerWheel(quic_state->env())),
     options_(options),
     max_connections_(max_connections),
     max_connections_per_host_(max_connections_per_host),
     max_stateless_resets_per_host_(max_stateless_resets_per_host),
     retry_token_expiration_(retry_token_expiration),
     qlog_(qlog),
+    qlog_sample_rate_(qlog_sample_rate),
+    histogram_mode_(histogram_mode),
     server_alpn_(NGTCP2_ALPN_H3),
+    ticket_keys_(ticket_key_secret, ticket_key_rotation),
+    addr_counts_(address_sketch_size),
+    reset_counts_(address_sketch_size, STATELESS_RESET_COUNT_DECAY),
+    validated_addrs_(validate_address_lru_size),
+    worker_id_(worker_id),
     quic_state_(quic_state) {
   MakeWeak();
   PushListener(&default_listener_);
 
   Debug(this, "New QuicSocket created");
 
-  EntropySource(token_secret_, kTokenSecretLen);
+  CHECK_LE(worker_id, static_cast<int>(MAX_WORKER_ID));
+
+  if (token_secret != nullptr)
+    memcpy(token_secret_, token_secret, kTokenSecretLen);
+  else
+    EntropySource(token_secret_, kTokenSecretLen);
 
   if (disable_stateless_reset)
     set_flag(QUICSOCKET_FLAGS_DISABLE_STATELESS_RESET);
 
+  if (!qlog_dir.empty()) {
+    qlog_sink_ = QuicQlogSink::Create(qlog_dir);
+    if (!qlog_sink_)
+      Debug(this, "Unable to start the qlog writer thread");
+  }
+
   // Set the session reset secret to the one provided or random.
   // Note that a random secret is going to make it exceedingly
   // difficult for the session reset token to be useful.
@@ -294,11 +484,16 @@ void QuicSocketStatsTraits::ToString(const QuicSocket& ptr, Fn&& add_field) {
 void QuicSocket::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("endpoints", endpoints_);
   tracker->TrackField("sessions", sessions_);
-  tracker->TrackField("dcid_to_scid", dcid_to_scid_);
   tracker->TrackField("addr_counts", addr_counts_);
   tracker->TrackField("reset_counts", reset_counts_);
+  tracker->TrackField("ticket_keys", ticket_keys_);
   tracker->TrackField("token_map", token_map_);
   tracker->TrackField("validated_addrs", validated_addrs_);
+  tracker->TrackField("new_tokens", new_tokens_);
+  tracker->TrackField("packet_pool", packet_pool_);
+  tracker->TrackField("qlog_sink", qlog_sink_);
+  tracker->TrackField("session_histograms", session_histograms_);
+  tracker->TrackField("stream_histograms", stream_histograms_);
   StatsBase::StatsMemoryInfo(tracker);
   tracker->TrackFieldWithSize(
       "current_ngtcp2_memory",
@@ -336,6 +531,44 @@ ReqWrap<uv_udp_send_t>* QuicSocket::OnCreateSendWrap(size_t msg_size) {
   return last_created_send_wrap_ = new SendWrap(quic_state(), obj, msg_size);
 }
 
+uv_udp_send_t* QuicSocket::OnCreateNativeSendReq(size_t msg_size) {
+  // Fall back to a JavaScript-visible SendWrap if async_hooks
+  // are tracking resource creation.
+  if (env()->async_hooks()->fields()[AsyncHooks::kInit] > 0)
+    return nullptr;
+
+  SendRequest* request;
+  if (send_request_pool_.empty()) {
+    request = new SendRequest();
+  } else {
+    request = send_request_pool_.back().release();
+    send_request_pool_.pop_back();
+  }
+  last_created_send_request_ = request;
+  return &request->req;
+}
+
+void QuicSocket::OnNativeSendDone(uv_udp_send_t* req, int status) {
+  SendRequest* request = ContainerOf(&SendRequest::req, req);
+  OnSend(status, request->packet.get());
+  ReleaseSendRequest(request);
+}
+
+void QuicSocket::FreeSendRequest(uv_udp_send_t* req) {
+  SendRequest* request = ContainerOf(&SendRequest::req, req);
+  delete request;
+}
+
+void QuicSocket::ReleaseSendRequest(SendRequest* request) {
+  request->packet.reset();
+  request->session.reset();
+  if (send_request_pool_.size() >= kMaxFreeSendRequests) {
+    delete request;
+    return;
+  }
+  send_request_pool_.emplace_back(request);
+}
+
 void QuicSocket::OnEndpointDone(QuicEndpoint* endpoint) {
   Debug(this, "Endpoint has no pending callbacks");
   listener_->OnEndpointDone(endpoint);
@@ -347,22 +580,15 @@ void QuicSocket::OnBind(QuicEndpoint* endpoint) {
       BaseObjectWeakPtr<QuicEndpoint>(endpoint);
   Debug(this, "Endpoint %s bound", local_address);
   RecordTimestamp(&QuicSocketStats::bound_at);
+  if (!endpoint->is_dont_fragment())
+    set_flag(QUICSOCKET_FLAGS_FRAGMENTING);
+  if (endpoint->is_forwarding())
+    CHECK_EQ(endpoint->ReceiveStart(), 0);
 }
 
 BaseObjectPtr<QuicSession> QuicSocket::FindSession(const QuicCID& cid) {
-  BaseObjectPtr<QuicSession> session;
-  auto session_it = sessions_.find(cid);
-  if (session_it == std::end(sessions_)) {
-    auto scid_it = dcid_to_scid_.find(cid);
-    if (scid_it != std::end(dcid_to_scid_)) {
-      session_it = sessions_.find(scid_it->second);
-      CHECK_NE(session_it, std::end(sessions_));
-      session = session_it->second;
-    }
-  } else {
-    session = session_it->second;
-  }
-  return session;
+  BaseObjectPtr<QuicSession>* session = sessions_.Find(cid);
+  return session != nullptr ? *session : BaseObjectPtr<QuicSession>();
 }
 
 // When a received packet contains a QUIC short header but cannot be
@@ -391,11 +617,109 @@ bool QuicSocket::MaybeStatelessReset(
   StatelessResetToken possible_token(
       data + nread - NGTCP2_STATELESS_RESET_TOKENLEN);
   Debug(this, "Possible stateless reset token: %s", possible_token);
-  auto it = token_map_.find(possible_token);
-  if (it == token_map_.end())
+  BaseObjectPtr<QuicSession>* session = token_map_.Find(possible_token);
+  if (session == nullptr)
     return false;
   Debug(this, "Received a stateless reset token %s", possible_token);
-  return it->second->Receive(nread, data, local_addr, remote_addr, flags);
+  return (*session)->Receive(nread, data, local_addr, remote_addr, flags);
+}
+
+// When this QuicSocket is one of a group of workers sharing a port,
+// the kernel may deliver a short header packet to a worker other than
+// the one that issued its destination connection ID -- for instance,
+// after the peer migrated or a NAT rebinding changed the 4-tuple.
+// The first byte of the connection ID identifies the owning worker,
+// and the packet is passed on to that worker's forwarding endpoint.
+// Returns true if the packet belongs to another worker, even if it
+// could not be forwarded: such a packet must never elicit a stateless
+// reset, which would terminate the connection at the owning worker.
+bool QuicSocket::MaybeForwardPacket(
+    const QuicCID& dcid,
+    ssize_t nread,
+    const uint8_t* data,
+    const SocketAddress& local_addr,
+    const SocketAddress& remote_addr) {
+  if (!has_worker_id() || !dcid)
+    return false;
+  uint8_t owner = dcid.data()[0];
+  if (owner == worker_id())
+    return false;
+
+  auto peer = forwarding_peers_.find(owner);
+  // A packet that was itself forwarded is never forwarded again so
+  // that a misconfigured group cannot bounce packets between workers.
+  if (peer == std::end(forwarding_peers_) ||
+      !forwarding_endpoint_ ||
+      receiving_forwarded_ ||
+      nread + kMaxForwardHeaderLen > NGTCP2_MAX_PKT_SIZE ||
+      bound_endpoints_.find(forwarding_endpoint_->local_address()) ==
+          std::end(bound_endpoints_)) {
+    Debug(this, "Ignoring packet for worker %d", owner);
+    IncrementStat(&QuicSocketStats::packets_ignored);
+    return true;
+  }
+
+  Debug(this, "Forwarding packet to worker %d", owner);
+  std::unique_ptr<QuicPacket> packet =
+      QuicPacket::Create(this, "forward", kMaxForwardHeaderLen + nread);
+  uint8_t* pos = packet->data();
+  *pos++ = remote_addr.family() == AF_INET6 ? 6 : 4;
+  pos += WriteForwardedAddress(pos, remote_addr);
+  pos += WriteForwardedAddress(pos, local_addr);
+  memcpy(pos, data, nread);
+  packet->set_length(pos - packet->data() + nread);
+
+  IncrementStat(&QuicSocketStats::packets_forwarded);
+  SendPacket(
+      forwarding_endpoint_->local_address(),
+      peer->second,
+      std::move(packet));
+  return true;
+}
+
+// Receives a packet that another worker of the group forwarded to
+// this QuicSocket's forwarding endpoint. Packets are only accepted
+// from the forwarding endpoints of the group, and only if they were
+// received on an address this QuicSocket is also bound to.
+void QuicSocket::OnReceiveForwarded(
+    ssize_t nread,
+    const uint8_t* data,
+    const SocketAddress& local_addr,
+    const SocketAddress& remote_addr,
+    unsigned int flags) {
+  if (forwarding_peer_ids_.find(remote_addr) ==
+          std::end(forwarding_peer_ids_) ||
+      nread < 1 ||
+      (data[0] != 4 && data[0] != 6)) {
+    IncrementStat(&QuicSocketStats::packets_ignored);
+    return;
+  }
+
+  int family = data[0] == 6 ? AF_INET6 : AF_INET;
+  const uint8_t* pos = data + 1;
+  size_t remaining = nread - 1;
+  SocketAddress original_remote;
+  SocketAddress original_local;
+  size_t len = ReadForwardedAddress(family, pos, remaining, &original_remote);
+  if (len > 0) {
+    pos += len;
+    remaining -= len;
+    len = ReadForwardedAddress(family, pos, remaining, &original_local);
+  }
+  if (len == 0 ||
+      remaining == len ||
+      bound_endpoints_.find(original_local) == std::end(bound_endpoints_)) {
+    IncrementStat(&QuicSocketStats::packets_ignored);
+    return;
+  }
+  pos += len;
+  remaining -= len;
+
+  Debug(this, "Received a packet forwarded by worker %d",
+        forwarding_peer_ids_[remote_addr]);
+  receiving_forwarded_ = true;
+  OnReceive(remaining, pos, original_local, original_remote, flags);
+  receiving_forwarded_ = false;
 }
 
 // When a packet is received here, we do not yet know if we can
@@ -407,7 +731,7 @@ bool QuicSocket::MaybeStatelessReset(
 // Any packet we choose not to process must be ignored.
 void QuicSocket::OnReceive(
     ssize_t nread,
-    AllocatedBuffer buf,
+    const uint8_t* data,
     const SocketAddress& local_addr,
     const SocketAddress& remote_addr,
     unsigned int flags) {
@@ -420,9 +744,9 @@ void QuicSocket::OnReceive(
     return;
   }
 
-  IncrementStat(&QuicSocketStats::bytes_received, nread);
+  EventBatchScope event_batch_scope(this);
 
-  const uint8_t* data = reinterpret_cast<const uint8_t*>(buf.data());
+  IncrementStat(&QuicSocketStats::bytes_received, nread);
 
   uint32_t pversion;
   const uint8_t* pdcid;
@@ -497,6 +821,13 @@ void QuicSocket::OnReceive(
       return;
     }
 
+    // A short header packet for a connection ID issued by another
+    // worker of the group is handed to that worker.
+    if (is_short_header &&
+        MaybeForwardPacket(dcid, nread, data, local_addr, remote_addr)) {
+      return;
+    }
+
     // AcceptInitialPacket will first validate that the packet can be
     // accepted, then create a new server QuicSession instance if able
     // to do so. If a new instance cannot be created (for any reason),
@@ -581,7 +912,7 @@ void QuicSocket::SendVersionNegotiation(
 
   size_t pktlen = dcid.length() + scid.length() + (sizeof(sv)) + 7;
 
-  auto packet = QuicPacket::Create("version negotiation", pktlen);
+  auto packet = QuicPacket::Create(this, "version negotiation", pktlen);
   ssize_t nwrite = ngtcp2_pkt_write_version_negotiation(
       packet->data(),
       NGTCP2_MAX_PKTLEN_IPV6,
@@ -636,7 +967,7 @@ bool QuicSocket::SendStatelessReset(
   StatelessResetToken token(reset_token_secret_, cid);
   EntropySource(random, kRandlen);
 
-  auto packet = QuicPacket::Create("stateless reset", pktlen);
+  auto packet = QuicPacket::Create(this, "stateless reset", pktlen);
   ssize_t nwrite =
       ngtcp2_pkt_write_stateless_reset(
         packet->data(),
@@ -678,9 +1009,17 @@ bool QuicSocket::SendRetry(
     const SocketAddress& local_addr,
     const SocketAddress& remote_addr) {
   std::unique_ptr<QuicPacket> packet =
-      GenerateRetryPacket(token_secret_, dcid, scid, local_addr, remote_addr);
-  return packet ?
-      SendPacket(local_addr, remote_addr, std::move(packet)) == 0 : false;
+      GenerateRetryPacket(
+          this,
+          token_secret_,
+          dcid,
+          scid,
+          local_addr,
+          remote_addr);
+  if (!packet || SendPacket(local_addr, remote_addr, std::move(packet)) != 0)
+    return false;
+  IncrementStat(&QuicSocketStats::retry_count);
+  return true;
 }
 
 // Shutdown a connection prematurely, before a QuicSession is created.
@@ -691,7 +1030,7 @@ void QuicSocket::ImmediateConnectionClose(
     const SocketAddress& remote_addr,
     int64_t reason) {
   Debug(this, "Sending stateless connection close to %s", scid);
-  auto packet = QuicPacket::Create("immediate connection close");
+  auto packet = QuicPacket::Create(this, "immediate connection close");
   ssize_t nwrite = ngtcp2_crypto_write_connection_close(
       packet->data(),
       packet->length(),
@@ -749,7 +1088,7 @@ BaseObjectPtr<QuicSession> QuicSocket::AcceptInitialPacket(
   // has been exceeded. If the count has been exceeded, shutdown the connection
   // immediately after the initial keys are installed.
   if (UNLIKELY(is_flag_set(QUICSOCKET_FLAGS_SERVER_BUSY)) ||
-      sessions_.size() >= max_connections_ ||
+      session_count_ >= max_connections_ ||
       GetCurrentSocketAddressCounter(remote_addr) >=
           max_connections_per_host_) {
     Debug(this, "QuicSocket is busy or connection count exceeded");
@@ -766,9 +1105,13 @@ BaseObjectPtr<QuicSession> QuicSocket::AcceptInitialPacket(
   // QUIC has address validation built in to the handshake but allows for
   // an additional explicit validation request using RETRY frames. If we
   // are using explicit validation, we check for the existence of a valid
-  // retry token in the packet. If one does not exist, we send a retry with
-  // a new token. If it does exist, and if it's valid, we grab the original
-  // cid and continue.
+  // token in the packet. If one does not exist, we send a retry with
+  // a new token. If it is a valid retry token, we grab the original
+  // cid and continue. If it is a valid token from a NEW_TOKEN frame sent
+  // in an earlier session, the address is already validated and there
+  // is no original cid. A NEW_TOKEN token that is not valid, perhaps
+  // because it expired or was issued by another server, is not an
+  // error, and the client is asked to validate its address again.
   if (!is_validated_address(remote_addr)) {
     switch (hd.type) {
       case NGTCP2_PKT_INITIAL:
@@ -781,18 +1124,33 @@ BaseObjectPtr<QuicSession> QuicSocket::AcceptInitialPacket(
             // Sending a retry token terminates this connection attempt.
             return {};
           }
-          if (InvalidRetryToken(
-                  hd,
-                  remote_addr,
-                  &ocid,
-                  token_secret_,
-                  retry_token_expiration_)) {
-            Debug(this, "Invalid retry token was detected. Failing");
-            ImmediateConnectionClose(
-                QuicCID(hd.scid),
-                QuicCID(hd.dcid),
-                local_addr,
-                remote_addr);
+          if (hd.token[0] != kNewTokenMagic) {
+            if (InvalidRetryToken(
+                    hd,
+                    remote_addr,
+                    &ocid,
+                    token_secret_,
+                    retry_token_expiration_)) {
+              Debug(this, "Invalid retry token was detected. Failing");
+              ImmediateConnectionClose(
+                  QuicCID(hd.scid),
+                  QuicCID(hd.dcid),
+                  local_addr,
+                  remote_addr);
+              return {};
+            }
+            set_validated_address(remote_addr);
+          } else if (!InvalidNewToken(
+                         hd,
+                         remote_addr,
+                         token_secret_,
+                         NEWTOKEN_EXPIRATION)) {
+            Debug(this, "Address was validated by a NEW_TOKEN token");
+            IncrementStat(&QuicSocketStats::new_token_count);
+            set_validated_address(remote_addr);
+          } else if (is_option_set(QUICSOCKET_OPTIONS_VALIDATE_ADDRESS)) {
+            Debug(this, "Invalid NEW_TOKEN token was detected. Retrying");
+            SendRetry(dcid, scid, local_addr, remote_addr);
             return {};
           }
         }
@@ -815,7 +1173,7 @@ BaseObjectPtr<QuicSession> QuicSocket::AcceptInitialPacket(
           version,
           server_alpn_,
           server_options_,
-          qlog_);
+          SelectQlogMode(qlog_));
   CHECK(session);
 
   listener_->OnSessionReady(session);
@@ -862,7 +1220,25 @@ int QuicSocket::SendPacket(
     return 0;
   }
 
+  if (send_batch_depth_ > 0 && is_option_set(QUICSOCKET_OPTIONS_BATCH_SEND)) {
+    pending_packets_.push_back({
+        local_addr,
+        remote_addr,
+        std::move(packet),
+        session });
+    return 0;
+  }
+
+  return TransmitPacket(local_addr, remote_addr, std::move(packet), session);
+}
+
+int QuicSocket::TransmitPacket(
+    const SocketAddress& local_addr,
+    const SocketAddress& remote_addr,
+    std::unique_ptr<QuicPacket> packet,
+    BaseObjectPtr<QuicSession> session) {
   last_created_send_wrap_ = nullptr;
+  last_created_send_request_ = nullptr;
   uv_buf_t buf = packet->buf();
 
   auto endpoint = bound_endpoints_.find(local_addr);
@@ -870,8 +1246,18 @@ int QuicSocket::SendPacket(
   int err = endpoint->second->Send(&buf, 1, remote_addr.data());
 
   if (err != 0) {
+    // A native send request that could not be dispatched is still ours.
+    if (last_created_send_request_ != nullptr)
+      ReleaseSendRequest(last_created_send_request_);
     if (err > 0) err = 0;
     OnSend(err, packet.get());
+    // A datagram larger than the local interface carries, such as
+    // a path MTU probe, is lost like any other.
+    if (err == UV_EMSGSIZE)
+      err = 0;
+  } else if (last_created_send_request_ != nullptr) {
+    last_created_send_request_->packet = std::move(packet);
+    last_created_send_request_->session = session;
   } else {
     CHECK_NOT_NULL(last_created_send_wrap_);
     last_created_send_wrap_->set_packet(std::move(packet));
@@ -881,6 +1267,161 @@ int QuicSocket::SendPacket(
   return err;
 }
 
+// Consecutive pending packets that share the same local and remote
+// address are handed to the endpoint as a single batch. Whatever the
+// endpoint cannot write synchronously is sent individually, exactly
+// as it would have been without batching.
+void QuicSocket::FlushPendingPackets() {
+  if (pending_packets_.empty())
+    return;
+
+  std::vector<PendingPacket> pending;
+  pending.swap(pending_packets_);
+
+  Debug(this, "Flushing %" PRIu64 " pending packets", pending.size());
+
+  size_t start = 0;
+  while (start < pending.size()) {
+    const PendingPacket& first = pending[start];
+    size_t count = 1;
+    while (start + count < pending.size() &&
+           count < kMaxSendBatch &&
+           pending[start + count].local_addr == first.local_addr &&
+           pending[start + count].remote_addr == first.remote_addr) {
+      count++;
+    }
+
+    uv_buf_t bufs[kMaxSendBatch];
+    for (size_t n = 0; n < count; n++)
+      bufs[n] = pending[start + n].packet->buf();
+
+    auto endpoint = bound_endpoints_.find(first.local_addr);
+    CHECK_NE(endpoint, bound_endpoints_.end());
+    ssize_t sent =
+        endpoint->second->TrySendBatch(bufs, count, first.remote_addr.data());
+    if (sent > 0) {
+      Debug(this, "Sent %" PRId64 " packets in a single batch", sent);
+      IncrementStat(&QuicSocketStats::send_batch_count);
+    } else {
+      sent = 0;
+    }
+
+    for (size_t n = 0; n < count; n++) {
+      PendingPacket& item = pending[start + n];
+      if (n < static_cast<size_t>(sent)) {
+        OnSend(0, item.packet.get());
+        continue;
+      }
+      int err = TransmitPacket(
+          item.local_addr,
+          item.remote_addr,
+          std::move(item.packet),
+          item.session);
+      if (err != 0 && item.session && !item.session->is_destroyed()) {
+        item.session->set_last_error(QUIC_ERROR_SESSION, err);
+        item.session->HandleError();
+      }
+    }
+    start += count;
+  }
+
+  // Hold on to the allocated storage for the next pass.
+  pending.clear();
+  if (pending_packets_.empty())
+    pending_packets_.swap(pending);
+}
+
+void QuicSocket::QueueEvent(
+    QuicSocketEventType type,
+    BaseObject* target,
+    Local<Value> value,
+    double arg0,
+    double arg1,
+    double arg2,
+    QuicStream* stream) {
+  CHECK(is_batching_events());
+  QueuedEvent event;
+  event.target = BaseObjectPtr<BaseObject>(target);
+  if (!value.IsEmpty())
+    event.value.Reset(env()->isolate(), value);
+  if (stream != nullptr) {
+    stream->set_queued_event(true);
+    event.stream = BaseObjectPtr<QuicStream>(stream);
+  }
+  queued_events_.emplace_back(std::move(event));
+  queued_event_fields_.insert(
+      queued_event_fields_.end(),
+      { static_cast<double>(type), arg0, arg1, arg2 });
+}
+
+// The queued events are passed to JavaScript as an Array holding the
+// handle each event is for followed by its value, and a Float64Array
+// holding kQuicSocketEventFields numbers per event.
+void QuicSocket::FlushEvents() {
+  if (queued_events_.empty())
+    return;
+
+  std::vector<QueuedEvent> events;
+  std::vector<double> fields;
+  events.swap(queued_events_);
+  fields.swap(queued_event_fields_);
+
+  Debug(this, "Flushing %" PRIu64 " queued events", events.size());
+  IncrementStat(&QuicSocketStats::event_batch_count);
+  IncrementStat(&QuicSocketStats::batched_event_count, events.size());
+
+  Environment* env = this->env();
+  Isolate* isolate = env->isolate();
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env->context());
+
+  MaybeStackBuffer<Local<Value>, 64> objects(events.size() * 2);
+  for (size_t n = 0; n < events.size(); n++) {
+    QueuedEvent& event = events[n];
+    if (event.stream)
+      event.stream->set_queued_event(false);
+    objects[n * 2] = event.target->object();
+    if (event.value.IsEmpty())
+      objects[n * 2 + 1] = Undefined(isolate);
+    else
+      objects[n * 2 + 1] = event.value.Get(isolate);
+  }
+
+  Local<ArrayBuffer> buffer =
+      ArrayBuffer::New(isolate, fields.size() * sizeof(double));
+  memcpy(buffer->GetBackingStore()->Data(),
+         fields.data(),
+         fields.size() * sizeof(double));
+
+  Local<Value> argv[] = {
+    Array::New(isolate, objects.out(), objects.length()),
+    Float64Array::New(buffer, 0, fields.size())
+  };
+
+  // Grab a shared pointer to this to prevent the QuicSocket
+  // from being freed while the MakeCallback is running.
+  BaseObjectPtr<QuicSocket> ptr(this);
+  MakeCallback(
+      env->quic_on_socket_events_function(),
+      arraysize(argv),
+      argv);
+}
+
+void QuicSocket::OnReceiveBatchStart() {
+  if (in_receive_batch_)
+    return;
+  in_receive_batch_ = true;
+  event_batch_depth_++;
+}
+
+void QuicSocket::OnReceiveBatchEnd() {
+  if (!in_receive_batch_)
+    return;
+  in_receive_batch_ = false;
+  if (--event_batch_depth_ == 0)
+    FlushEvents();
+}
+
 void QuicSocket::OnSend(int status, QuicPacket* packet) {
   if (status == 0) {
     Debug(this, "Sent %" PRIu64 " bytes (label: %s)",
@@ -989,6 +1530,63 @@ void NewQuicSocket(const FunctionCallbackInfo<Value>& args) {
     session_reset_secret = buf.data();
   }
 
+  std::string qlog_dir;
+  if (args[8]->IsString()) {
+    Utf8Value dir(env->isolate(), args[8]);
+    qlog_dir = *dir;
+  }
+
+  double qlog_sample_rate = 0.0;
+  if (args[9]->IsNumber())
+    qlog_sample_rate = args[9].As<Number>()->Value();
+
+  uint32_t histogram_mode = QUIC_HISTOGRAM_MODE_LAZY;
+  if (args[10]->IsUint32()) {
+    histogram_mode = args[10].As<Uint32>()->Value();
+    CHECK_LE(histogram_mode, QUIC_HISTOGRAM_MODE_SHARED);
+  }
+
+  uint32_t validate_address_lru_size = DEFAULT_VALIDATE_ADDRESS_LRU_SIZE;
+  if (args[11]->IsUint32()) {
+    validate_address_lru_size = args[11].As<Uint32>()->Value();
+    CHECK_GE(validate_address_lru_size, 1);
+    CHECK_LE(validate_address_lru_size, MAX_VALIDATE_ADDRESS_LRU_SIZE);
+  }
+
+  uint32_t address_sketch_size = DEFAULT_ADDRESS_SKETCH_SIZE;
+  if (args[12]->IsUint32()) {
+    address_sketch_size = args[12].As<Uint32>()->Value();
+    CHECK_GE(address_sketch_size, MIN_ADDRESS_SKETCH_SIZE);
+    CHECK_LE(address_sketch_size, MAX_ADDRESS_SKETCH_SIZE);
+  }
+
+  const uint8_t* token_secret = nullptr;
+  if (args[13]->IsArrayBufferView()) {
+    ArrayBufferViewContents<uint8_t> buf(args[13].As<ArrayBufferView>());
+    CHECK_EQ(buf.length(), kTokenSecretLen);
+    token_secret = buf.data();
+  }
+
+  int worker_id = -1;
+  if (args[14]->IsUint32()) {
+    worker_id = args[14].As<Uint32>()->Value();
+    CHECK_LE(worker_id, static_cast<int>(MAX_WORKER_ID));
+  }
+
+  const uint8_t* ticket_key_secret = nullptr;
+  if (args[15]->IsArrayBufferView()) {
+    ArrayBufferViewContents<uint8_t> buf(args[15].As<ArrayBufferView>());
+    CHECK_EQ(buf.length(), kTicketKeySecretLen);
+    ticket_key_secret = buf.data();
+  }
+
+  uint32_t ticket_key_rotation = DEFAULT_TICKET_KEY_ROTATION;
+  if (args[16]->IsUint32()) {
+    ticket_key_rotation = args[16].As<Uint32>()->Value();
+    CHECK_GE(ticket_key_rotation, MIN_TICKET_KEY_ROTATION);
+    CHECK_LE(ticket_key_rotation, MAX_TICKET_KEY_ROTATION);
+  }
+
   new QuicSocket(
       state,
       args.This(),
@@ -999,7 +1597,16 @@ void NewQuicSocket(const FunctionCallbackInfo<Value>& args) {
       options,
       args[5]->IsTrue() ? QlogMode::kEnabled : QlogMode::kDisabled,
       session_reset_secret,
-      args[7]->IsTrue());
+      args[7]->IsTrue(),
+      qlog_dir,
+      qlog_sample_rate,
+      static_cast<QuicHistogramMode>(histogram_mode),
+      validate_address_lru_size,
+      address_sketch_size,
+      token_secret,
+      worker_id,
+      ticket_key_secret,
+      ticket_key_rotation);
 }
 
 void QuicSocketAddEndpoint(const FunctionCallbackInfo<Value>& args) {
@@ -1010,7 +1617,41 @@ void QuicSocketAddEndpoint(const FunctionCallbackInfo<Value>& args) {
   ASSIGN_OR_RETURN_UNWRAP(&endpoint, args[0].As<Object>());
   socket->AddEndpoint(
       BaseObjectPtr<QuicEndpoint>(endpoint),
-      args[1]->IsTrue());
+      args[1]->IsTrue(),
+      args[2]->IsTrue());
+}
+
+// Registers the forwarding endpoint of another worker of the group
+// by worker id, IP address and port.
+void QuicSocketAddForwardingPeer(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  QuicSocket* socket;
+  ASSIGN_OR_RETURN_UNWRAP(&socket, args.Holder());
+  CHECK(args[0]->IsUint32());
+  CHECK(args[1]->IsString());
+  CHECK(args[2]->IsUint32());
+  uint32_t worker_id = args[0].As<Uint32>()->Value();
+  CHECK_LE(worker_id, MAX_WORKER_ID);
+  Utf8Value address(env->isolate(), args[1]);
+  SocketAddress addr;
+  if (!SocketAddress::New(*address, args[2].As<Uint32>()->Value(), &addr))
+    return args.GetReturnValue().Set(UV_EINVAL);
+  socket->AddForwardingPeer(static_cast<uint8_t>(worker_id), addr);
+  args.GetReturnValue().Set(0);
+}
+
+// Replaces the session ticket keys with explicit ones, given as a
+// buffer of one or more keys of kTicketKeyLen bytes each. The first
+// key is used to encrypt new tickets.
+void QuicSocketSetTicketKeys(const FunctionCallbackInfo<Value>& args) {
+  QuicSocket* socket;
+  ASSIGN_OR_RETURN_UNWRAP(&socket, args.Holder());
+  CHECK(args[0]->IsArrayBufferView());
+  ArrayBufferViewContents<uint8_t> keys(args[0].As<ArrayBufferView>());
+  CHECK_GT(keys.length(), 0);
+  CHECK_EQ(keys.length() % kTicketKeyLen, 0);
+  CHECK_LE(keys.length() / kTicketKeyLen, MAX_TICKET_KEYS);
+  socket->ticket_keys()->SetKeys(keys.data(), keys.length() / kTicketKeyLen);
 }
 
 // Enabling diagnostic packet loss enables a mode where the QuicSocket
@@ -1150,6 +1791,9 @@ void QuicSocket::Initialize(
   env->SetProtoMethod(socket,
                       "addEndpoint",
                       QuicSocketAddEndpoint);
+  env->SetProtoMethod(socket,
+                      "addForwardingPeer",
+                      QuicSocketAddForwardingPeer);
   env->SetProtoMethod(socket,
                       "destroy",
                       QuicSocketDestroy);
@@ -1162,6 +1806,9 @@ void QuicSocket::Initialize(
   env->SetProtoMethod(socket,
                       "setServerBusy",
                       QuicSocketset_server_busy);
+  env->SetProtoMethod(socket,
+                      "setTicketKeys",
+                      QuicSocketSetTicketKeys);
   env->SetProtoMethod(socket,
                       "stopListening",
                       QuicSocketStopListening);
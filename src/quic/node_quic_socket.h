@@ -7,6 +7,7 @@
 #include "node.h"
 #include "node_crypto.h"
 #include "node_internals.h"
+#include "node_quic_crypto.h"
 #include "ngtcp2/ngtcp2.h"
 #include "node_quic_state.h"
 #include "node_quic_session.h"
@@ -20,6 +21,7 @@
 #include <deque>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace node {
@@ -42,8 +44,40 @@ enum QuicSocketOptions : uint32_t {
   // validated addresses. Address validation will be skipped
   // if the address is currently in the cache.
   QUICSOCKET_OPTIONS_VALIDATE_ADDRESS_LRU = 0x2,
+
+  // When enabled, packets serialized during a single send pass
+  // are queued per endpoint and destination and are flushed to
+  // the network together using as few system calls as the
+  // platform allows (sendmmsg and UDP GSO on Linux).
+  QUICSOCKET_OPTIONS_BATCH_SEND = 0x4,
+
+  // When enabled, the session and stream events generated while
+  // processing a batch of received datagrams are queued and passed
+  // to JavaScript with a single callback once the batch has been
+  // processed.
+  QUICSOCKET_OPTIONS_BATCH_EVENTS = 0x8,
+};
+
+// The session and stream events that are queued while a QuicSocket
+// is batching events. Each event is passed to JavaScript as
+// kQuicSocketEventFields numbers: the event type followed by up to
+// three event specific arguments, along with the handle the event is
+// for and an event specific value.
+enum QuicSocketEventType : int {
+  // value: the QuicStream handle, args: stream id, push id
+  QUICSOCKET_EVENT_STREAM_READY,
+  // value: the headers, args: stream id, headers kind, push id
+  QUICSOCKET_EVENT_STREAM_HEADERS,
+  // args: stream id, application error code
+  QUICSOCKET_EVENT_STREAM_CLOSE,
+  // args: stream id, application error code
+  QUICSOCKET_EVENT_STREAM_RESET,
+  // Dispatched to the QuicStream handle, without arguments
+  QUICSOCKET_EVENT_STREAM_BLOCKED
 };
 
+constexpr size_t kQuicSocketEventFields = 4;
+
 #define SOCKET_STATS(V)                                                        \
   V(CREATED_AT, created_at, "Created At")                                      \
   V(BOUND_AT, bound_at, "Bound At")                                            \
@@ -56,7 +90,16 @@ enum QuicSocketOptions : uint32_t {
   V(SERVER_SESSIONS, server_sessions, "Server Sessions")                       \
   V(CLIENT_SESSIONS, client_sessions, "Client Sessions")                       \
   V(STATELESS_RESET_COUNT, stateless_reset_count, "Stateless Reset Count")     \
-  V(SERVER_BUSY_COUNT, server_busy_count, "Server Busy Count")
+  V(SERVER_BUSY_COUNT, server_busy_count, "Server Busy Count")                 \
+  V(SEND_BATCH_COUNT, send_batch_count, "Send Batch Count")                    \
+  V(PACKET_POOL_HITS, packet_pool_hits, "Packet Pool Hits")                    \
+  V(PACKET_POOL_MISSES, packet_pool_misses, "Packet Pool Misses")              \
+  V(QLOG_BYTES_DROPPED, qlog_bytes_dropped, "Qlog Bytes Dropped")              \
+  V(RETRY_COUNT, retry_count, "Retry Count")                                   \
+  V(NEW_TOKEN_COUNT, new_token_count, "New Token Count")                       \
+  V(PACKETS_FORWARDED, packets_forwarded, "Packets Forwarded")                 \
+  V(EVENT_BATCH_COUNT, event_batch_count, "Event Batch Count")                 \
+  V(BATCHED_EVENT_COUNT, batched_event_count, "Batched Event Count")
 
 #define V(name, _, __) IDX_QUIC_SOCKET_STATS_##name,
 enum QuicSocketStatsIdx : int {
@@ -112,12 +155,50 @@ class JSQuicSocketListener : public QuicSocketListener {
   void OnDestroy() override;
 };
 
+// A free-list of fixed size buffers backing the QuicPacket
+// instances created for a QuicSocket. Buffers are returned to
+// the free-list when the QuicPacket is destroyed so that, once
+// warmed up, the transmit path does not touch the allocator.
+class QuicPacketPool : public MemoryRetainer {
+ public:
+  // Every buffer is large enough to hold a packet the size of
+  // the UDP payload of an Ethernet frame, the packet length path
+  // MTU discovery settles on for most paths. Larger packets are
+  // allocated individually.
+  static constexpr size_t kSlotSize = 1500 - 28;
+
+  // The maximum number of unused buffers retained by the pool.
+  // Buffers released beyond this are freed immediately.
+  static constexpr size_t kMaxFree = 256;
+
+  QuicPacketPool() = default;
+  QuicPacketPool(const QuicPacketPool&) = delete;
+  QuicPacketPool& operator=(const QuicPacketPool&) = delete;
+  ~QuicPacketPool() override;
+
+  // Returns a buffer of kSlotSize bytes. reused is set to true
+  // if the buffer was taken from the free-list.
+  inline uint8_t* Acquire(bool* reused);
+
+  inline void Release(uint8_t* data);
+
+  size_t free_count() const { return free_.size(); }
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(QuicPacketPool)
+  SET_SELF_SIZE(QuicPacketPool)
+
+ private:
+  std::vector<uint8_t*> free_;
+};
+
 // A serialized QuicPacket to be sent by a QuicSocket instance.
 class QuicPacket : public MemoryRetainer {
  public:
-  // Creates a new QuicPacket. By default the packet will be
-  // stack allocated with a max size of NGTCP2_MAX_PKTLEN_IPV4.
-  // If a larger packet size is specified, it will be heap
+  // Creates a new QuicPacket with a max size of len bytes. When
+  // a QuicSocket is given and len fits within a QuicPacketPool
+  // slot, the packet buffer is taken from, and later returned to,
+  // the QuicSocket's packet pool. Otherwise the buffer is heap
   // allocated. Generally speaking, a QUIC packet should never
   // be larger than the current MTU to avoid IP fragmentation.
   //
@@ -140,6 +221,7 @@ class QuicPacket : public MemoryRetainer {
   // SendWrap instance. When the SendWrap is cleaned up, the
   // QuicPacket instance will be freed.
   static inline std::unique_ptr<QuicPacket> Create(
+      QuicSocket* socket,
       const char* diagnostic_label = nullptr,
       size_t len = NGTCP2_MAX_PKTLEN_IPV4);
 
@@ -149,14 +231,13 @@ class QuicPacket : public MemoryRetainer {
   static inline std::unique_ptr<QuicPacket> Copy(
       const std::unique_ptr<QuicPacket>& other);
 
-  QuicPacket(const char* diagnostic_label, size_t len);
+  QuicPacket(QuicSocket* socket, const char* diagnostic_label, size_t len);
   QuicPacket(const QuicPacket& other);
-  uint8_t* data() { return data_.data(); }
-  size_t length() const { return data_.size(); }
+  ~QuicPacket() override;
+  uint8_t* data() { return data_; }
+  size_t length() const { return length_; }
   uv_buf_t buf() const {
-    return uv_buf_init(
-      const_cast<char*>(reinterpret_cast<const char*>(data_.data())),
-      length());
+    return uv_buf_init(reinterpret_cast<char*>(data_), length_);
   }
   inline void set_length(size_t len);
   const char* diagnostic_label() const;
@@ -166,7 +247,11 @@ class QuicPacket : public MemoryRetainer {
   SET_SELF_SIZE(QuicPacket);
 
  private:
-  std::vector<uint8_t> data_;
+  // Only set when data_ was taken from the socket's packet pool.
+  BaseObjectWeakPtr<QuicSocket> socket_;
+  uint8_t* data_ = nullptr;
+  size_t length_ = 0;
+  size_t capacity_ = 0;
   const char* diagnostic_label_ = nullptr;
 };
 
@@ -176,14 +261,25 @@ class QuicEndpointListener {
   virtual void OnError(QuicEndpoint* endpoint, ssize_t error) = 0;
   virtual void OnReceive(
       ssize_t nread,
-      AllocatedBuffer buf,
+      const uint8_t* data,
+      const SocketAddress& local_addr,
+      const SocketAddress& remote_addr,
+      unsigned int flags) = 0;
+  virtual void OnReceiveForwarded(
+      ssize_t nread,
+      const uint8_t* data,
       const SocketAddress& local_addr,
       const SocketAddress& remote_addr,
       unsigned int flags) = 0;
   virtual ReqWrap<uv_udp_send_t>* OnCreateSendWrap(size_t msg_size) = 0;
   virtual void OnSendDone(ReqWrap<uv_udp_send_t>* wrap, int status) = 0;
+  virtual uv_udp_send_t* OnCreateNativeSendReq(size_t msg_size) = 0;
+  virtual void OnNativeSendDone(uv_udp_send_t* req, int status) = 0;
   virtual void OnBind(QuicEndpoint* endpoint) = 0;
   virtual void OnEndpointDone(QuicEndpoint* endpoint) = 0;
+  // Bracket the datagrams read with a single recvmmsg() call.
+  virtual void OnReceiveBatchStart() {}
+  virtual void OnReceiveBatchEnd() {}
 };
 
 // A QuicEndpoint wraps a UDPBaseWrap. A single QuicSocket may
@@ -208,6 +304,12 @@ class QuicEndpoint : public BaseObject,
     return local_address_;
   }
 
+  // A forwarding endpoint only receives packets that another worker
+  // of the same group forwarded to this QuicSocket. See
+  // QuicSocket::MaybeForwardPacket().
+  bool is_forwarding() const { return forwarding_; }
+  void set_forwarding() { forwarding_ = true; }
+
   // Implementation for UDPListener
   uv_buf_t OnAlloc(size_t suggested_size) override;
 
@@ -220,6 +322,10 @@ class QuicEndpoint : public BaseObject,
 
   void OnSendDone(ReqWrap<uv_udp_send_t>* wrap, int status) override;
 
+  uv_udp_send_t* CreateNativeSendReq(size_t msg_size) override;
+
+  void OnNativeSendDone(uv_udp_send_t* req, int status) override;
+
   void OnAfterBind() override;
 
   inline int ReceiveStart();
@@ -231,6 +337,15 @@ class QuicEndpoint : public BaseObject,
       size_t len,
       const sockaddr* addr);
 
+  inline ssize_t TrySendBatch(
+      uv_buf_t* bufs,
+      size_t nbufs,
+      const sockaddr* addr);
+
+  // True if datagrams sent from this endpoint are never fragmented,
+  // which path MTU discovery depends on.
+  bool is_dont_fragment() const { return dont_fragment_; }
+
   void IncrementPendingCallbacks() { pending_callbacks_++; }
   void DecrementPendingCallbacks() { pending_callbacks_--; }
   bool has_pending_callbacks() { return pending_callbacks_ > 0; }
@@ -243,13 +358,26 @@ class QuicEndpoint : public BaseObject,
   SET_SELF_SIZE(QuicEndpoint)
 
  private:
+  inline bool is_receive_slab(const uv_buf_t& buf) const;
+
+  void ReleaseReceiveBuffer(const uv_buf_t& buf);
+
   mutable SocketAddress local_address_;
   BaseObjectWeakPtr<QuicSocket> listener_;
   UDPWrapBase* udp_;
   BaseObjectPtr<AsyncWrap> strong_ptr_;
   size_t pending_callbacks_ = 0;
   bool waiting_for_callbacks_ = false;
+  bool forwarding_ = false;
+  bool dont_fragment_ = false;
   BaseObjectPtr<QuicState> quic_state_;
+
+  // Received datagrams are processed synchronously, so a single
+  // slab is reused for every read. The slab is divided into
+  // kReceiveSlabDatagrams slots of kReceiveSlotSize bytes, which
+  // is the layout libuv uses to fill it with recvmmsg().
+  MallocedBuffer<char> receive_slab_;
+  bool receive_slab_in_use_ = false;
 };
 
 // QuicSocket manages the flow of data from the UDP socket to the
@@ -282,7 +410,34 @@ class QuicSocket : public AsyncWrap,
       uint32_t options = 0,
       QlogMode qlog = QlogMode::kDisabled,
       const uint8_t* session_reset_secret = nullptr,
-      bool disable_session_reset = false);
+      bool disable_session_reset = false,
+      // When set, the qlog output of traced sessions is written
+      // to files in this directory rather than emitted to JavaScript.
+      const std::string& qlog_dir = "",
+      // The fraction of sessions that are traced regardless of
+      // whether qlog has been enabled for them explicitly.
+      double qlog_sample_rate = 0.0,
+      QuicHistogramMode histogram_mode = QUIC_HISTOGRAM_MODE_LAZY,
+      // The number of recently validated addresses remembered when
+      // the VALIDATE_ADDRESS_LRU option is set.
+      size_t validate_address_lru_size = DEFAULT_VALIDATE_ADDRESS_LRU_SIZE,
+      // The width of the sketches used to count connections and
+      // stateless resets per remote address.
+      size_t address_sketch_size = DEFAULT_ADDRESS_SKETCH_SIZE,
+      // The secret used to protect address validation tokens. Workers
+      // of the same group share it so that a token issued by one is
+      // accepted by the others. Random if not provided.
+      const uint8_t* token_secret = nullptr,
+      // The identifier of this QuicSocket within a group of workers
+      // sharing a port, or -1. When set, it is embedded in the first
+      // byte of every locally issued connection ID.
+      int worker_id = -1,
+      // The secret session ticket keys are derived from. Servers that
+      // share it accept each other's session tickets. Random if not
+      // provided.
+      const uint8_t* ticket_key_secret = nullptr,
+      // The interval, in seconds, at which ticket keys are rotated.
+      uint64_t ticket_key_rotation = DEFAULT_TICKET_KEY_ROTATION);
 
   ~QuicSocket() override;
 
@@ -333,6 +488,10 @@ class QuicSocket : public AsyncWrap,
       std::unique_ptr<QuicPacket> packet,
       BaseObjectPtr<QuicSession> session = BaseObjectPtr<QuicSession>());
 
+  // Sends all of the packets that have been queued while the
+  // QUICSOCKET_OPTIONS_BATCH_SEND option is enabled.
+  void FlushPendingPackets();
+
   inline void SessionReady(BaseObjectPtr<QuicSession> session);
 
   inline void set_server_busy(bool on);
@@ -352,6 +511,32 @@ class QuicSocket : public AsyncWrap,
 
   QuicState* quic_state() { return quic_state_.get(); }
 
+  // The timer wheel that drives the idle and retransmission
+  // timers of all QuicSessions on this QuicSocket.
+  QuicTimerWheel* timer_wheel() const { return timer_wheel_.get(); }
+
+  // The sink that qlog output is written to, or nullptr if qlog
+  // output is to be emitted to JavaScript.
+  const std::shared_ptr<QuicQlogSink>& qlog_sink() const { return qlog_sink_; }
+
+  // How the histograms of QuicSessions and QuicStreams created
+  // by this QuicSocket are allocated.
+  QuicHistogramMode histogram_mode() const { return histogram_mode_; }
+
+  // The histograms shared by all QuicSessions, and by all
+  // QuicStreams, when QUIC_HISTOGRAM_MODE_SHARED is used.
+  QuicStatsHistograms* session_histograms() { return &session_histograms_; }
+  QuicStatsHistograms* stream_histograms() { return &stream_histograms_; }
+
+  // Returns kEnabled if qlog was requested or the session has been
+  // selected by the qlog sample rate.
+  inline QlogMode SelectQlogMode(QlogMode requested) const;
+
+  // Returns a QuicPacketPool::kSlotSize buffer for a new QuicPacket.
+  inline uint8_t* AcquirePacketBuffer();
+
+  inline void ReleasePacketBuffer(uint8_t* data);
+
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_MEMORY_INFO_NAME(QuicSocket)
   SET_SELF_SIZE(QuicSocket)
@@ -365,19 +550,52 @@ class QuicSocket : public AsyncWrap,
 
   const uint8_t* session_reset_secret() { return reset_token_secret_; }
 
+  const uint8_t* token_secret() { return token_secret_; }
+
+  QuicTicketKeyRing* ticket_keys() { return &ticket_keys_; }
+
+  // A client QuicSocket keeps the most recent token received in a
+  // NEW_TOKEN frame from each server address so that the next
+  // connection to that server can skip the RETRY round trip. Each
+  // token is presented only once.
+  inline void StoreNewToken(
+      const SocketAddress& addr,
+      const uint8_t* token,
+      size_t tokenlen);
+
+  inline std::vector<uint8_t> TakeNewToken(const SocketAddress& addr);
+
   // Implementation for QuicListener
   ReqWrap<uv_udp_send_t>* OnCreateSendWrap(size_t msg_size) override;
 
   // Implementation for QuicListener
   void OnSendDone(ReqWrap<uv_udp_send_t>* wrap, int status) override;
 
+  // Implementation for QuicListener
+  uv_udp_send_t* OnCreateNativeSendReq(size_t msg_size) override;
+
+  // Implementation for QuicListener
+  void OnNativeSendDone(uv_udp_send_t* req, int status) override;
+
+  // Frees a native send request that completed after the
+  // QuicSocket that created it was destroyed.
+  static void FreeSendRequest(uv_udp_send_t* req);
+
   // Implementation for QuicListener
   void OnBind(QuicEndpoint* endpoint) override;
 
   // Implementation for QuicListener
   void OnReceive(
       ssize_t nread,
-      AllocatedBuffer buf,
+      const uint8_t* data,
+      const SocketAddress& local_addr,
+      const SocketAddress& remote_addr,
+      unsigned int flags) override;
+
+  // Implementation for QuicListener
+  void OnReceiveForwarded(
+      ssize_t nread,
+      const uint8_t* data,
       const SocketAddress& local_addr,
       const SocketAddress& remote_addr,
       unsigned int flags) override;
@@ -417,7 +635,27 @@ class QuicSocket : public AsyncWrap,
 
   inline void AddEndpoint(
       BaseObjectPtr<QuicEndpoint> endpoint,
-      bool preferred = false);
+      bool preferred = false,
+      bool forwarding = false);
+
+  // Records the address of the forwarding endpoint of another
+  // worker in the group.
+  inline void AddForwardingPeer(
+      uint8_t worker_id,
+      const SocketAddress& addr);
+
+  // Path MTU discovery is only used if every bound endpoint sends
+  // datagrams that are never fragmented.
+  bool is_path_mtu_discovery_enabled() const {
+    return !bound_endpoints_.empty() &&
+           !is_flag_set(QUICSOCKET_FLAGS_FRAGMENTING);
+  }
+
+  bool has_worker_id() const { return worker_id_ >= 0; }
+  uint8_t worker_id() const {
+    CHECK(has_worker_id());
+    return static_cast<uint8_t>(worker_id_);
+  }
 
   void ImmediateConnectionClose(
       const QuicCID& scid,
@@ -426,6 +664,75 @@ class QuicSocket : public AsyncWrap,
       const SocketAddress& remote_addr,
       int64_t reason = NGTCP2_INVALID_TOKEN);
 
+  // True while events are to be queued rather than passed to
+  // JavaScript right away. See EventBatchScope.
+  bool is_batching_events() const {
+    return event_batch_depth_ > 0 &&
+           is_option_set(QUICSOCKET_OPTIONS_BATCH_EVENTS);
+  }
+
+  // Queues an event for target, a QuicSession or QuicStream. If the
+  // event has to reach JavaScript before data is read from a
+  // QuicStream, the QuicStream is passed as stream.
+  void QueueEvent(
+      QuicSocketEventType type,
+      BaseObject* target,
+      v8::Local<v8::Value> value,
+      double arg0 = 0,
+      double arg1 = 0,
+      double arg2 = 0,
+      QuicStream* stream = nullptr);
+
+  // Passes all queued events to JavaScript. Called before any
+  // callback that is not batched so that JavaScript sees every
+  // event in the order it occurred.
+  void FlushEvents();
+
+  // The EventBatchScope groups the events generated while processing
+  // received datagrams. When the QUICSOCKET_OPTIONS_BATCH_EVENTS
+  // option is enabled, the events are queued until the outermost
+  // scope exits and are then flushed together.
+  class EventBatchScope {
+   public:
+    explicit EventBatchScope(QuicSocket* socket) : socket_(socket) {
+      socket_->event_batch_depth_++;
+    }
+
+    ~EventBatchScope() {
+      if (--socket_->event_batch_depth_ == 0)
+        socket_->FlushEvents();
+    }
+
+   private:
+    BaseObjectPtr<QuicSocket> socket_;
+  };
+
+  // Implementation for QuicListener
+  void OnReceiveBatchStart() override;
+
+  // Implementation for QuicListener
+  void OnReceiveBatchEnd() override;
+
+  // The SendBatchScope groups the packets serialized during a
+  // single send pass. When the QUICSOCKET_OPTIONS_BATCH_SEND
+  // option is enabled, the packets are held until the outermost
+  // scope exits and are then flushed together.
+  class SendBatchScope {
+   public:
+    explicit SendBatchScope(QuicSocket* socket) : socket_(socket) {
+      if (socket_)
+        socket_->send_batch_depth_++;
+    }
+
+    ~SendBatchScope() {
+      if (socket_ && --socket_->send_batch_depth_ == 0)
+        socket_->FlushPendingPackets();
+    }
+
+   private:
+    BaseObjectPtr<QuicSocket> socket_;
+  };
+
  private:
   static void OnAlloc(
       uv_handle_t* handle,
@@ -434,6 +741,12 @@ class QuicSocket : public AsyncWrap,
 
   void OnSend(int status, QuicPacket* packet);
 
+  int TransmitPacket(
+      const SocketAddress& local_addr,
+      const SocketAddress& remote_addr,
+      std::unique_ptr<QuicPacket> packet,
+      BaseObjectPtr<QuicSession> session);
+
   inline void set_validated_address(const SocketAddress& addr);
 
   inline bool is_validated_address(const SocketAddress& addr) const;
@@ -447,6 +760,13 @@ class QuicSocket : public AsyncWrap,
       const SocketAddress& remote_addr,
       unsigned int flags);
 
+  bool MaybeForwardPacket(
+      const QuicCID& dcid,
+      ssize_t nread,
+      const uint8_t* data,
+      const SocketAddress& local_addr,
+      const SocketAddress& remote_addr);
+
   BaseObjectPtr<QuicSession> AcceptInitialPacket(
       uint32_t version,
       const QuicCID& dcid,
@@ -486,7 +806,8 @@ class QuicSocket : public AsyncWrap,
     QUICSOCKET_FLAGS_WAITING_FOR_CALLBACKS = 0x2,
     QUICSOCKET_FLAGS_SERVER_LISTENING = 0x4,
     QUICSOCKET_FLAGS_SERVER_BUSY = 0x8,
-    QUICSOCKET_FLAGS_DISABLE_STATELESS_RESET = 0x10
+    QUICSOCKET_FLAGS_DISABLE_STATELESS_RESET = 0x10,
+    QUICSOCKET_FLAGS_FRAGMENTING = 0x20
   };
 
   void set_flag(QuicSocketFlags flag, bool on = true) {
@@ -513,6 +834,12 @@ class QuicSocket : public AsyncWrap,
 
   ngtcp2_mem alloc_info_;
 
+  // Declared ahead of anything that may own a QuicPacket so that
+  // it is destroyed last.
+  QuicPacketPool packet_pool_;
+
+  QuicTimerWheelPointer timer_wheel_;
+
   std::vector<BaseObjectPtr<QuicEndpoint>> endpoints_;
   SocketAddress::Map<BaseObjectWeakPtr<QuicEndpoint>> bound_endpoints_;
   BaseObjectWeakPtr<QuicEndpoint> preferred_endpoint_;
@@ -536,44 +863,62 @@ class QuicSocket : public AsyncWrap,
   JSQuicSocketListener default_listener_;
   QuicSessionConfig server_session_config_;
   QlogMode qlog_ = QlogMode::kDisabled;
+  double qlog_sample_rate_ = 0.0;
+  std::shared_ptr<QuicQlogSink> qlog_sink_;
+  QuicHistogramMode histogram_mode_;
+  QuicStatsHistograms session_histograms_;
+  QuicStatsHistograms stream_histograms_;
   BaseObjectPtr<crypto::SecureContext> server_secure_context_;
   std::string server_alpn_;
-  QuicCID::Map<BaseObjectPtr<QuicSession>> sessions_;
-  QuicCID::Map<QuicCID> dcid_to_scid_;
+
+  // Maps every CID associated with a QuicSession -- its own scid as
+  // well as any alternative CIDs -- directly to the QuicSession, so
+  // that each received packet is routed with a single lookup.
+  // session_count_ is the number of distinct QuicSessions in it.
+  QuicRoutingTable<BaseObjectPtr<QuicSession>> sessions_;
+  size_t session_count_ = 0;
 
   uint8_t token_secret_[kTokenSecretLen];
   uint8_t reset_token_secret_[NGTCP2_STATELESS_RESET_TOKENLEN];
+  QuicTicketKeyRing ticket_keys_;
 
   // Counts the number of active connections per remote
-  // address. A custom std::hash specialization for
-  // sockaddr instances is used. Values are incremented
-  // when a QuicSession is added to the socket, and
-  // decremented when the QuicSession is removed. If the
-  // value reaches the value of max_connections_per_host_,
-  // attempts to create new connections will be ignored
-  // until the value falls back below the limit.
-  SocketAddress::Map<size_t> addr_counts_;
+  // address. Values are incremented when a QuicSession is
+  // added to the socket, and decremented when the QuicSession
+  // is removed. If the value reaches the value of
+  // max_connections_per_host_, attempts to create new
+  // connections will be ignored until the value falls back
+  // below the limit. Both this and reset_counts_ use a fixed
+  // amount of memory however many remote addresses are seen,
+  // so that a flood of packets with spoofed source addresses
+  // cannot grow them.
+  QuicAddressCounter addr_counts_;
 
   // Counts the number of stateless resets sent per
-  // remote address.
-  // TODO(@jasnell): this counter persists through the
-  // lifetime of the QuicSocket, and therefore can become
-  // a possible risk. Specifically, a malicious peer could
-  // attempt the local peer to count an increasingly large
-  // number of remote addresses. Need to mitigate the
-  // potential risk.
-  SocketAddress::Map<size_t> reset_counts_;
-
-  // Counts the number of retry attempts sent per
-  // remote address.
-
-  StatelessResetToken::Map<QuicSession> token_map_;
-
-  // The validated_addrs_ vector is used as an LRU cache for
-  // validated addresses only when the VALIDATE_ADDRESS_LRU
-  // option is set.
-  typedef size_t SocketAddressHash;
-  std::deque<SocketAddressHash> validated_addrs_;
+  // remote address. The counts decay over time.
+  QuicAddressCounter reset_counts_;
+
+  QuicRoutingTable<BaseObjectPtr<QuicSession>> token_map_;
+
+  // The validated_addrs_ LRU cache is used for validated
+  // addresses only when the VALIDATE_ADDRESS_LRU option is set.
+  QuicAddressLRU validated_addrs_;
+
+  // Tokens received in NEW_TOKEN frames, keyed by server address.
+  // At most kMaxStoredNewTokens are kept.
+  SocketAddress::Map<std::vector<uint8_t>> new_tokens_;
+
+  // When this QuicSocket is one of a group of workers sharing a
+  // port, short header packets for connection IDs issued by another
+  // worker are forwarded to that worker's forwarding endpoint.
+  // forwarding_peers_ maps worker ids to those endpoints, and
+  // forwarding_peer_ids_ is its inverse, used to accept forwarded
+  // packets only from members of the group.
+  int worker_id_ = -1;
+  std::unordered_map<uint8_t, SocketAddress> forwarding_peers_;
+  SocketAddress::Map<uint8_t> forwarding_peer_ids_;
+  BaseObjectWeakPtr<QuicEndpoint> forwarding_endpoint_;
+  bool receiving_forwarded_ = false;
 
   class SendWrap : public ReqWrap<uv_udp_send_t> {
    public:
@@ -605,6 +950,46 @@ class QuicSocket : public AsyncWrap,
   };
 
   SendWrap* last_created_send_wrap_ = nullptr;
+
+  // A send request that is not backed by a JavaScript object.
+  // These are used whenever no async_hooks init hook is installed,
+  // as JavaScript then has no way of observing the request, and
+  // are recycled through send_request_pool_.
+  struct SendRequest {
+    uv_udp_send_t req;
+    std::unique_ptr<QuicPacket> packet;
+    BaseObjectPtr<QuicSession> session;
+  };
+
+  void ReleaseSendRequest(SendRequest* request);
+
+  SendRequest* last_created_send_request_ = nullptr;
+  std::vector<std::unique_ptr<SendRequest>> send_request_pool_;
+
+  // Packets waiting to be flushed by FlushPendingPackets() when
+  // the QUICSOCKET_OPTIONS_BATCH_SEND option is enabled.
+  struct PendingPacket {
+    SocketAddress local_addr;
+    SocketAddress remote_addr;
+    std::unique_ptr<QuicPacket> packet;
+    BaseObjectPtr<QuicSession> session;
+  };
+  std::vector<PendingPacket> pending_packets_;
+  size_t send_batch_depth_ = 0;
+
+  // Events waiting to be flushed by FlushEvents() when the
+  // QUICSOCKET_OPTIONS_BATCH_EVENTS option is enabled.
+  struct QueuedEvent {
+    BaseObjectPtr<BaseObject> target;
+    v8::Global<v8::Value> value;
+    BaseObjectPtr<QuicStream> stream;
+  };
+  std::vector<QueuedEvent> queued_events_;
+  std::vector<double> queued_event_fields_;
+  size_t event_batch_depth_ = 0;
+  // Set from OnReceiveBatchStart() to OnReceiveBatchEnd().
+  bool in_receive_batch_ = false;
+
   BaseObjectPtr<QuicState> quic_state_;
 
   friend class QuicSocketListener;
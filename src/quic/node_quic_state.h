@@ -21,6 +21,8 @@ enum QuicSessionConfigIndex : int {
   IDX_QUIC_SESSION_ACK_DELAY_EXPONENT,
   IDX_QUIC_SESSION_DISABLE_MIGRATION,
   IDX_QUIC_SESSION_MAX_ACK_DELAY,
+  IDX_QUIC_SESSION_MAX_PACING_BURST,
+  IDX_QUIC_SESSION_CC_ALGORITHM,
   IDX_QUIC_SESSION_CONFIG_COUNT
 };
 
@@ -8,6 +8,8 @@
 #include "node_quic_stream.h"
 #include "node_quic_buffer-inl.h"
 
+#include <algorithm>
+
 namespace node {
 namespace quic {
 
@@ -34,6 +36,14 @@ void QuicStream::set_flag(int32_t flag, bool on) {
     flags_ &= ~(1 << flag);
 }
 
+bool QuicStream::has_queued_event() const {
+  return is_flag_set(QUICSTREAM_FLAG_EVENT_QUEUED);
+}
+
+void QuicStream::set_queued_event(bool on) {
+  set_flag(QUICSTREAM_FLAG_EVENT_QUEUED, on);
+}
+
 void QuicStream::set_final_size(uint64_t final_size) {
   CHECK_EQ(GetStat(&QuicStreamStats::final_size), 0);
   SetStat(&QuicStreamStats::final_size, final_size);
@@ -80,6 +90,16 @@ bool QuicStream::is_write_finished() const {
          streambuf_.length() == 0;
 }
 
+size_t QuicStream::buffer_size() const {
+  // The data of writes that have not completed is left out, as
+  // JavaScript still counts it. The writes still pending are the
+  // most recent, so once their data is being acknowledged,
+  // everything before it has been.
+  size_t uncompleted = pending_write_bytes_ + zero_copy_bytes_;
+  return streambuf_.length() > uncompleted ?
+      streambuf_.length() - uncompleted : 0;
+}
+
 bool QuicStream::SubmitInformation(v8::Local<v8::Array> headers) {
   return session_->SubmitInformation(stream_id_, headers);
 }
@@ -125,6 +145,8 @@ void QuicStream::BeginHeaders(QuicStreamHeadersKind kind) {
 void QuicStream::Commit(size_t amount) {
   CHECK(!is_destroyed());
   streambuf_.Seek(amount);
+  if (file_reader_)
+    file_reader_->MaybeRead();
 }
 
 void QuicStream::ResetStream(uint64_t app_error_code) {
@@ -136,18 +158,83 @@ void QuicStream::ResetStream(uint64_t app_error_code) {
   BaseObjectPtr<QuicSession> ptr(session_);
   set_flag(QUICSTREAM_FLAG_READ_CLOSED);
   session_->ResetStream(stream_id_, app_error_code);
+  file_reader_.reset();
   streambuf_.Cancel();
   streambuf_.End();
+  CompletePendingWrites(UV_ECANCELED);
 }
 
-void QuicStream::Schedule(Queue* queue) {
-  if (!stream_queue_.IsEmpty())  // Already scheduled?
+void QuicStream::Unschedule() {
+  stream_queue_.Remove();
+}
+
+bool QuicStream::is_scheduled() const {
+  return !stream_queue_.IsEmpty();
+}
+
+void QuicStream::SetPriority(uint8_t urgency, bool incremental) {
+  urgency = std::min<uint8_t>(urgency, kStreamUrgencyLevels - 1);
+  if (urgency == urgency_ && incremental == incremental_)
     return;
-  queue->PushBack(this);
+  Debug(this, "Priority set to urgency %d%s",
+        static_cast<int>(urgency),
+        incremental ? ", incremental" : "");
+  urgency_ = urgency;
+  incremental_ = incremental;
+  if (session_ && session_->application() != nullptr)
+    session_->application()->StreamPriorityChanged(stream_id_);
 }
 
-void QuicStream::Unschedule() {
-  stream_queue_.Remove();
+void QuicStreamScheduler::Schedule(QuicStream* stream) {
+  if (stream->is_scheduled())
+    return;
+  stream->scheduling_credit_ = kStreamSchedulingQuantum;
+  queues_[stream->urgency()].PushBack(stream);
+}
+
+void QuicStreamScheduler::Reschedule(QuicStream* stream) {
+  if (!stream->is_scheduled())
+    return;
+  stream->Unschedule();
+  Schedule(stream);
+}
+
+QuicStream* QuicStreamScheduler::PopFront() {
+  for (QuicStream::Queue& queue : queues_) {
+    if (!queue.IsEmpty())
+      return queue.PopFront();
+  }
+  return nullptr;
+}
+
+void QuicStreamScheduler::Requeue(QuicStream* stream) {
+  if (stream->is_scheduled())
+    return;
+  QuicStream::Queue& queue = queues_[stream->urgency()];
+  if (!stream->is_incremental() || stream->scheduling_credit_ > 0) {
+    queue.PushFront(stream);
+    return;
+  }
+  stream->scheduling_credit_ = kStreamSchedulingQuantum;
+  queue.PushBack(stream);
+}
+
+void QuicStreamScheduler::Commit(QuicStream* stream, size_t datalen) {
+  stream->scheduling_credit_ -=
+      std::min(stream->scheduling_credit_, datalen);
+}
+
+void QuicStreamScheduler::UnscheduleMoreUrgentThan(uint8_t urgency) {
+  for (uint8_t n = 0; n < urgency && n < kStreamUrgencyLevels; n++) {
+    while (queues_[n].PopFront() != nullptr) {}
+  }
+}
+
+uint8_t QuicStreamScheduler::most_urgent() const {
+  uint8_t urgency = 0;
+  while (urgency < kStreamUrgencyLevels && queues_[urgency].IsEmpty())
+    urgency++;
+  return urgency;
 }
 
 }  // namespace quic
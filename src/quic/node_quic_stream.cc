@@ -22,14 +22,21 @@
 namespace node {
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::Boolean;
 using v8::Context;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::HandleScope;
+using v8::Int32;
+using v8::Integer;
 using v8::Isolate;
 using v8::Local;
+using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::String;
+using v8::Uint32;
 using v8::Value;
 
 namespace quic {
@@ -44,7 +51,9 @@ QuicStream::QuicStream(
     StatsBase(sess->env(), wrap,
               HistogramOptions::ACK |
               HistogramOptions::RATE |
-              HistogramOptions::SIZE),
+              HistogramOptions::SIZE,
+              sess->socket()->histogram_mode(),
+              sess->socket()->stream_histograms()),
     session_(sess),
     stream_id_(stream_id),
     push_id_(push_id),
@@ -52,6 +61,7 @@ QuicStream::QuicStream(
   CHECK_NOT_NULL(sess);
   Debug(this, "Created");
   StreamBase::AttachToObject(GetObject());
+  PushStreamListener(&stream_listener_);
   ngtcp2_transport_params params;
   ngtcp2_conn_get_local_transport_params(session()->connection(), &params);
   IncrementStat(&QuicStreamStats::max_offset, params.initial_max_data);
@@ -88,11 +98,29 @@ void QuicStream::Acknowledge(uint64_t offset, size_t datalen) {
   // Consumes the given number of bytes in the buffer. This may
   // have the side-effect of causing the onwrite callback to be
   // invoked if a complete chunk of buffered data has been acknowledged.
-  streambuf_.Consume(datalen);
+  size_t consumed = streambuf_.Consume(datalen);
+
+  // The data of zero-copy writes is always at the head of the
+  // streambuf_, ahead of any file data.
+  zero_copy_bytes_ -= std::min(consumed, zero_copy_bytes_);
+
+  if (streambuf_.length() < write_high_water_mark_)
+    CompletePendingWrites(0);
 
   RecordAck(&QuicStreamStats::acked_at);
 }
 
+void QuicStream::CompletePendingWrites(int status) {
+  if (pending_writes_.empty())
+    return;
+  // Completing a write may lead to another one being queued.
+  std::deque<DoneCB> writes;
+  writes.swap(pending_writes_);
+  pending_write_bytes_ = 0;
+  for (const DoneCB& done : writes)
+    done(status);
+}
+
 // While not all QUIC applications will support headers, QuicStream
 // includes basic, generic support for storing them.
 bool QuicStream::AddHeader(std::unique_ptr<QuicHeader> header) {
@@ -123,6 +151,7 @@ void QuicStream::Destroy() {
     return;
   set_flag(QUICSTREAM_FLAG_DESTROYED);
   set_flag(QUICSTREAM_FLAG_READ_CLOSED);
+  file_reader_.reset();
   streambuf_.End();
 
   // If there is data currently buffered in the streambuf_,
@@ -132,6 +161,7 @@ void QuicStream::Destroy() {
   // be usable to send or receive data.
   streambuf_.Cancel();
   CHECK_EQ(streambuf_.length(), 0);
+  CompletePendingWrites(UV_ECANCELED);
 
   // The QuicSession maintains a map of std::unique_ptrs to
   // QuicStream instances. Removing this here will cause
@@ -160,6 +190,119 @@ int QuicStream::DoShutdown(ShutdownWrap* req_wrap) {
   return 1;
 }
 
+int QuicStream::DoTryWrite(uv_buf_t** bufs, size_t* count) {
+  if (write_high_water_mark_ == 0 ||
+      streambuf_.length() >= write_high_water_mark_ ||
+      is_destroyed() ||
+      !is_writable()) {
+    return 0;
+  }
+
+  size_t length = get_length(*bufs, *count);
+  if (length == 0)
+    return 0;
+
+  size_t headroom = write_high_water_mark_ - streambuf_.length();
+  if (length <= headroom) {
+    Debug(this, "Buffering %" PRIu64 " bytes of data from %d buffers",
+          length, *count);
+    CopyIntoBuffer(*bufs, *count, length);
+    *count = 0;
+    return 0;
+  }
+
+  // Only the data up to the mark is copied. The remainder is left
+  // for DoWrite, and the write completes once acknowledgements bring
+  // the unacknowledged data back below the mark.
+  Debug(this, "Buffering %" PRIu64 " of %" PRIu64 " bytes of data",
+        headroom, length);
+  uv_buf_t* vbufs = *bufs;
+  size_t vcount = *count;
+  MaybeStackBuffer<uv_buf_t, 16> slices(vcount);
+  size_t nslices = 0;
+  for (size_t remaining = headroom; remaining > 0; nslices++) {
+    size_t len = std::min(vbufs[0].len, remaining);
+    slices[nslices] = uv_buf_init(vbufs[0].base, len);
+    remaining -= len;
+    if (len == vbufs[0].len) {
+      vbufs++;
+      vcount--;
+    } else {
+      vbufs[0].base += len;
+      vbufs[0].len -= len;
+    }
+  }
+  CopyIntoBuffer(slices.out(), nslices, headroom);
+  // The copied data belongs to the write that DoWrite completes.
+  pending_write_bytes_ += headroom;
+
+  *bufs = vbufs;
+  *count = vcount;
+  return 0;
+}
+
+void QuicStream::CopyIntoBuffer(
+    const uv_buf_t* bufs,
+    size_t nbufs,
+    size_t length) {
+  QuicSession::SendSessionScope send_scope(session(), true);
+  IncrementStat(&QuicStreamStats::bytes_sent, static_cast<uint64_t>(length));
+
+  streambuf_.Copy(bufs, nbufs);
+
+  session()->ResumeStream(stream_id_);
+}
+
+int QuicStream::SendFile(
+    uv_file fd,
+    int64_t offset,
+    int64_t length,
+    bool owns_fd) {
+  if (is_destroyed() || !is_writable())
+    return UV_EPIPE;
+  CHECK(!file_reader_);
+  Debug(this, "Sending file %d", fd);
+  file_reader_ =
+      std::make_unique<QuicFileReader>(this, fd, offset, length, owns_fd);
+  file_reader_->MaybeRead();
+  return 0;
+}
+
+void QuicStream::OnFileChunk(std::unique_ptr<QuicBufferChunk> chunk) {
+  QuicSession::SendSessionScope send_scope(session(), true);
+  IncrementStat(
+      &QuicStreamStats::bytes_sent,
+      static_cast<uint64_t>(chunk->remaining()));
+  streambuf_.Push(std::move(chunk));
+  session()->ResumeStream(stream_id_);
+}
+
+void QuicStream::OnFileDone(int status) {
+  if (status == 0) {
+    QuicSession::SendSessionScope send_scope(session(), true);
+    Debug(this, "File sent, shutting down writable side");
+    RecordTimestamp(&QuicStreamStats::closing_at);
+    streambuf_.End();
+    session()->ResumeStream(stream_id_);
+    return;
+  }
+
+  Debug(this, "Reading the file failed: %s", uv_strerror(status));
+  BaseObjectPtr<QuicStream> ptr(this);
+  if (session()->socket() != nullptr)
+    session()->socket()->FlushEvents();
+  HandleScope handle_scope(env()->isolate());
+  Context::Scope context_scope(env()->context());
+  Local<Value> argv[] = {
+    object(),
+    UVException(env()->isolate(), status, "sendFD")
+  };
+  MakeCallback(
+      env()->quic_on_stream_error_function(),
+      arraysize(argv),
+      argv);
+}
+
 int QuicStream::DoWrite(
     WriteWrap* req_wrap,
     uv_buf_t* bufs,
@@ -181,13 +324,30 @@ int QuicStream::DoWrite(
     return 0;
   }
 
+  BaseObjectPtr<AsyncWrap> strong_ref{req_wrap->GetAsyncWrap()};
+
+  // DoTryWrite only leaves data for DoWrite once the amount of
+  // unacknowledged data has reached the write high water mark.
+  // The write then completes once acknowledgements bring it
+  // back below the mark.
+  if (write_high_water_mark_ > 0) {
+    Debug(this, "Buffering %" PRIu64 " bytes of data above the "
+          "high water mark", length);
+    CopyIntoBuffer(bufs, nbufs, length);
+    pending_writes_.emplace_back([req_wrap, strong_ref](int status) {
+      req_wrap->Done(status);
+    });
+    pending_write_bytes_ += length;
+    return 0;
+  }
+
   QuicSession::SendSessionScope send_scope(session(), true);
 
   Debug(this, "Queuing %" PRIu64 " bytes of data from %d buffers",
         length, nbufs);
   IncrementStat(&QuicStreamStats::bytes_sent, static_cast<uint64_t>(length));
+  zero_copy_bytes_ += length;
 
-  BaseObjectPtr<AsyncWrap> strong_ref{req_wrap->GetAsyncWrap()};
   // The list of buffers will be appended onto streambuf_ without
   // copying. Those will remain in the buffer until the serialized
   // stream frames are acknowledged.
@@ -249,6 +409,7 @@ void QuicStream::IncrementStats(size_t datalen) {
 
 void QuicStream::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("buffer", &streambuf_);
+  tracker->TrackField("file_reader", file_reader_);
   StatsBase::StatsMemoryInfo(tracker);
   tracker->TrackField("headers", headers_);
 }
@@ -321,34 +482,34 @@ void QuicStream::ReceiveData(
     // slow.
     IncrementStats(datalen);
 
-    while (datalen > 0) {
-      uv_buf_t buf = EmitAlloc(datalen);
-      size_t avail = std::min(static_cast<size_t>(buf.len), datalen);
-
-      // For now, we're allocating and copying. Once we determine if we can
-      // safely switch to a non-allocated mode like we do with http2 streams,
-      // we can make this branch more efficient by using the LIKELY
-      // optimization. The way ngtcp2 currently works, however, we have
-      // to memcpy here.
-      if (UNLIKELY(buf.base == nullptr))
-        buf.base = reinterpret_cast<char*>(const_cast<uint8_t*>(data));
-      else
-        memcpy(buf.base, data, avail);
-      data += avail;
-      datalen -= avail;
-      // Capture read_paused before EmitRead in case user code callbacks
-      // alter the state when EmitRead is called.
-      bool read_paused = is_flag_set(QUICSTREAM_FLAG_READ_PAUSED);
-      EmitRead(avail, buf);
-      // Reading can be paused while we are processing. If that's
-      // the case, we still want to acknowledge the current bytes
-      // so that pausing does not throw off our flow control.
-      if (read_paused) {
-        inbound_consumed_data_while_paused_ += avail;
-      } else {
-        IncrementStat(&QuicStreamStats::max_offset, avail);
-        session_->ExtendStreamOffset(id(), avail);
-      }
+    // ngtcp2 reuses the buffer the data was received in, so it has to
+    // be copied before this returns. It is copied into the session's
+    // receive slab, and passed to JavaScript as a view over the slab.
+    receive_buffer_ =
+        session_->receive_slab()->Copy(data, datalen, &receive_offset_);
+    uv_buf_t buf = uv_buf_init(
+        static_cast<char*>(receive_buffer_->GetBackingStore()->Data()) +
+            receive_offset_,
+        datalen);
+
+    // Capture read_paused before EmitRead in case user code callbacks
+    // alter the state when EmitRead is called.
+    bool read_paused = is_flag_set(QUICSTREAM_FLAG_READ_PAUSED);
+    EmitRead(datalen, buf);
+    receive_buffer_ = Local<ArrayBuffer>();
+
+    // Once the data has been passed to JavaScript, the stream flow
+    // control credit for it is extended, unless reading has been
+    // paused because JavaScript is not keeping up. The credit is then
+    // withheld until reading resumes, bounding the amount of data
+    // waiting to be read. This does not bound the slab memory that
+    // views JavaScript holds on to keep alive, which is only released
+    // once those views are garbage collected.
+    if (read_paused) {
+      inbound_consumed_data_while_paused_ += datalen;
+    } else {
+      IncrementStat(&QuicStreamStats::max_offset, datalen);
+      session_->ExtendStreamOffset(id(), datalen);
     }
   }
 
@@ -361,6 +522,137 @@ void QuicStream::ReceiveData(
   }
 }
 
+struct QuicFileReader::ReadRequest {
+  uv_fs_t req;
+  // Set to nullptr if the QuicFileReader is destroyed while the
+  // read is in progress, in which case the request closes the file
+  // descriptor if it is owned.
+  QuicFileReader* reader;
+  std::unique_ptr<QuicBufferChunk> chunk;
+  uv_file fd;
+  bool owns_fd = false;
+};
+
+QuicFileReader::QuicFileReader(
+    QuicStream* stream,
+    uv_file fd,
+    int64_t offset,
+    int64_t length,
+    bool owns_fd)
+    : stream_(stream),
+      fd_(fd),
+      offset_(offset < 0 ? -1 : offset),
+      remaining_(length < 0 ? -1 : length),
+      owns_fd_(owns_fd) {}
+
+QuicFileReader::~QuicFileReader() {
+  if (request_ != nullptr) {
+    request_->reader = nullptr;
+    request_->owns_fd = owns_fd_;
+  } else if (owns_fd_) {
+    Close(stream_->env()->event_loop(), fd_);
+  }
+}
+
+void QuicFileReader::Close(uv_loop_t* loop, uv_file fd) {
+  uv_fs_t* req = new uv_fs_t;
+  int err = uv_fs_close(loop, req, fd, [](uv_fs_t* req) {
+    uv_fs_req_cleanup(req);
+    delete req;
+  });
+  if (err < 0) {
+    uv_fs_req_cleanup(req);
+    delete req;
+  }
+}
+
+void QuicFileReader::MaybeRead() {
+  if (request_ != nullptr ||
+      done_ ||
+      stream_->streambuf_.remaining() >= kReadAhead) {
+    return;
+  }
+
+  size_t length = kChunkSize;
+  if (remaining_ >= 0)
+    length = std::min(length, static_cast<size_t>(remaining_));
+  if (length == 0)
+    return Finish(0);
+
+  request_ = new ReadRequest();
+  request_->req.data = request_;
+  request_->reader = this;
+  request_->chunk = std::make_unique<QuicBufferChunk>(length);
+  request_->fd = fd_;
+  uv_buf_t buf = uv_buf_init(
+      reinterpret_cast<char*>(request_->chunk->out()),
+      length);
+  // uv_fs_read only fails synchronously for invalid arguments.
+  CHECK_EQ(uv_fs_read(
+      stream_->env()->event_loop(),
+      &request_->req,
+      fd_,
+      &buf,
+      1,
+      offset_,
+      OnRead), 0);
+}
+
+void QuicFileReader::OnRead(uv_fs_t* req) {
+  std::unique_ptr<ReadRequest> request(static_cast<ReadRequest*>(req->data));
+  ssize_t result = req->result;
+  uv_fs_req_cleanup(req);
+
+  QuicFileReader* reader = request->reader;
+  if (reader == nullptr) {
+    if (request->owns_fd)
+      Close(req->loop, request->fd);
+    return;
+  }
+  reader->request_ = nullptr;
+  reader->OnChunkRead(std::move(request->chunk), result);
+}
+
+void QuicFileReader::OnChunkRead(
+    std::unique_ptr<QuicBufferChunk> chunk,
+    ssize_t result) {
+  if (result <= 0)
+    return Finish(static_cast<int>(result));
+
+  size_t nread = static_cast<size_t>(result);
+  if (offset_ >= 0)
+    offset_ += nread;
+  if (remaining_ >= 0)
+    remaining_ -= nread;
+
+  // Short reads only happen at the end of the file, so the
+  // copy into a chunk of the exact length is made at most once.
+  if (nread < chunk->remaining()) {
+    auto exact = std::make_unique<QuicBufferChunk>(nread);
+    memcpy(exact->out(), chunk->out(), nread);
+    chunk = std::move(exact);
+  }
+
+  // Pushing the chunk may send data and lead to the
+  // QuicStream, and this QuicFileReader, being destroyed.
+  BaseObjectPtr<QuicStream> stream(stream_);
+  stream->OnFileChunk(std::move(chunk));
+  if (stream->file_reader_.get() != this)
+    return;
+  if (remaining_ == 0)
+    return Finish(0);
+  MaybeRead();
+}
+
+void QuicFileReader::Finish(int status) {
+  done_ = true;
+  if (owns_fd_) {
+    Close(stream_->env()->event_loop(), fd_);
+    owns_fd_ = false;
+  }
+  stream_->OnFileDone(status);
+}
+
 int QuicStream::DoPull(
     bob::Next<ngtcp2_vec> next,
     int options,
@@ -375,6 +667,37 @@ int QuicStream::DoPull(
       max_count_hint);
 }
 
+uv_buf_t QuicStreamListener::OnStreamAlloc(size_t suggested_size) {
+  // See comment in QuicStream::ReceiveData().
+  return uv_buf_init(nullptr, suggested_size);
+}
+
+void QuicStreamListener::OnStreamRead(ssize_t nread, const uv_buf_t& buf) {
+  QuicStream* stream = static_cast<QuicStream*>(stream_);
+  Environment* env = stream->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  // Events queued for the stream while the QuicSocket is batching
+  // them have to reach JavaScript before the data does.
+  QuicSocket* socket = stream->session()->socket();
+  if (stream->has_queued_event() && socket != nullptr)
+    socket->FlushEvents();
+
+  if (nread < 0) {
+    PassReadErrorToPreviousListener(nread);
+    return;
+  }
+
+  CHECK(!stream->receive_buffer_.IsEmpty());
+  CHECK_LE(stream->receive_offset_ + nread,
+           stream->receive_buffer_->ByteLength());
+  stream->CallJSOnreadMethod(
+      nread,
+      stream->receive_buffer_,
+      stream->receive_offset_);
+}
+
 // JavaScript API
 namespace {
 void QuicStreamGetID(const FunctionCallbackInfo<Value>& args) {
@@ -429,6 +752,57 @@ void QuicStreamReset(const FunctionCallbackInfo<Value>& args) {
           error.code : static_cast<uint64_t>(NGTCP2_NO_ERROR));
 }
 
+void QuicStreamSetPriority(const FunctionCallbackInfo<Value>& args) {
+  QuicStream* stream;
+  ASSIGN_OR_RETURN_UNWRAP(&stream, args.Holder());
+  CHECK(args[0]->IsUint32());
+  CHECK(args[1]->IsBoolean());
+  stream->SetPriority(
+      static_cast<uint8_t>(args[0].As<Uint32>()->Value()),
+      args[1]->IsTrue());
+}
+
+void QuicStreamSetWriteHighWaterMark(
+    const FunctionCallbackInfo<Value>& args) {
+  QuicStream* stream;
+  ASSIGN_OR_RETURN_UNWRAP(&stream, args.Holder());
+  CHECK(args[0]->IsNumber());
+  stream->set_write_high_water_mark(
+      static_cast<size_t>(args[0].As<Number>()->Value()));
+}
+
+void QuicStreamGetBufferSize(const FunctionCallbackInfo<Value>& args) {
+  QuicStream* stream;
+  ASSIGN_OR_RETURN_UNWRAP(&stream, args.Holder());
+  args.GetReturnValue().Set(static_cast<double>(stream->buffer_size()));
+}
+
+void QuicStreamSendFD(const FunctionCallbackInfo<Value>& args) {
+  QuicStream* stream;
+  ASSIGN_OR_RETURN_UNWRAP(&stream, args.Holder());
+  CHECK(args[0]->IsInt32());
+  CHECK(args[1]->IsNumber());
+  CHECK(args[2]->IsNumber());
+  args.GetReturnValue().Set(stream->SendFile(
+      args[0].As<Int32>()->Value(),
+      static_cast<int64_t>(args[1].As<Number>()->Value()),
+      static_cast<int64_t>(args[2].As<Number>()->Value()),
+      args[3]->IsTrue()));
+}
+
+// Returns the priority as an [urgency, incremental] pair.
+void QuicStreamGetPriority(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  QuicStream* stream;
+  ASSIGN_OR_RETURN_UNWRAP(&stream, args.Holder());
+  Local<Value> priority[] = {
+    Integer::NewFromUnsigned(env->isolate(), stream->urgency()),
+    Boolean::New(env->isolate(), stream->is_incremental())
+  };
+  args.GetReturnValue().Set(
+      Array::New(env->isolate(), priority, arraysize(priority)));
+}
+
 // Requests transmission of a block of informational headers. Not all
 // QUIC Applications will support headers. If headers are not supported,
 // This will set the return value to false, otherwise the return value
@@ -496,6 +870,14 @@ void QuicStream::Initialize(
   env->SetProtoMethod(stream, "destroy", QuicStreamDestroy);
   env->SetProtoMethod(stream, "resetStream", QuicStreamReset);
   env->SetProtoMethod(stream, "id", QuicStreamGetID);
+  env->SetProtoMethod(stream, "setPriority", QuicStreamSetPriority);
+  env->SetProtoMethod(stream, "getPriority", QuicStreamGetPriority);
+  env->SetProtoMethod(
+      stream,
+      "setWriteHighWaterMark",
+      QuicStreamSetWriteHighWaterMark);
+  env->SetProtoMethod(stream, "getBufferSize", QuicStreamGetBufferSize);
+  env->SetProtoMethod(stream, "sendFD", QuicStreamSendFD);
   env->SetProtoMethod(stream, "submitInformation", QuicStreamSubmitInformation);
   env->SetProtoMethod(stream, "submitHeaders", QuicStreamSubmitHeaders);
   env->SetProtoMethod(stream, "submitTrailers", QuicStreamSubmitTrailers);
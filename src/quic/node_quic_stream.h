@@ -13,6 +13,8 @@
 #include "util-inl.h"
 #include "v8.h"
 
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -37,6 +39,16 @@ enum QuicStreamHeaderFlags : uint32_t {
   QUICSTREAM_HEADER_FLAGS_TERMINAL = 1
 };
 
+// QuicStream priorities follow the urgency and incremental parameters
+// of the extensible prioritization scheme for HTTP. Urgency ranges
+// from 0, the most urgent, to kStreamUrgencyLevels - 1.
+constexpr uint8_t kStreamUrgencyLevels = 8;
+constexpr uint8_t DEFAULT_STREAM_URGENCY = 3;
+
+// The number of bytes an incremental QuicStream may send before it
+// yields to the next incremental QuicStream of the same urgency.
+constexpr size_t kStreamSchedulingQuantum = 8192;
+
 enum QuicStreamHeadersKind : int {
   QUICSTREAM_HEADERS_KIND_NONE = 0,
   QUICSTREAM_HEADERS_KIND_INFORMATIONAL,
@@ -100,7 +112,11 @@ enum QuicStreamStates : uint32_t {
   QUICSTREAM_FLAG_FIN_SENT,
 
   // QuicStream has been destroyed
-  QUICSTREAM_FLAG_DESTROYED
+  QUICSTREAM_FLAG_DESTROYED,
+
+  // An event that JavaScript has to see before the QuicStream's data
+  // is queued on the QuicSocket (see QUICSOCKET_OPTIONS_BATCH_EVENTS)
+  QUICSTREAM_FLAG_EVENT_QUEUED
 };
 
 enum QuicStreamDirection {
@@ -120,6 +136,66 @@ enum QuicStreamOrigin {
   QUIC_STREAM_CLIENT
 };
 
+// Passes received data to JavaScript as views over the QuicSession's
+// QuicReceiveSlab rather than as separately allocated buffers.
+class QuicStreamListener : public StreamListener {
+ public:
+  uv_buf_t OnStreamAlloc(size_t suggested_size) override;
+  void OnStreamRead(ssize_t nread, const uv_buf_t& buf) override;
+};
+
+// Sends the contents of a file on a QuicStream without passing them
+// through JavaScript. Chunks of the file are read on the threadpool
+// directly into the QuicStream's streambuf_, from which they are
+// serialized into packets and released once acknowledged. Reading
+// stays at most kReadAhead bytes ahead of the data that has been sent.
+class QuicFileReader final : public MemoryRetainer {
+ public:
+  static constexpr size_t kChunkSize = 64 * 1024;
+  static constexpr size_t kReadAhead = 4 * kChunkSize;
+
+  // A negative offset reads from the current position of the file
+  // descriptor, and a negative length reads until the end of the file.
+  // If owns_fd is true, the file descriptor is closed once the file
+  // has been read or the QuicFileReader is destroyed.
+  QuicFileReader(
+      QuicStream* stream,
+      uv_file fd,
+      int64_t offset,
+      int64_t length,
+      bool owns_fd);
+
+  ~QuicFileReader() override;
+
+  // Starts reading the next chunk of the file unless a read is
+  // already in progress, the whole file has been read, or there
+  // is enough data waiting to be sent.
+  void MaybeRead();
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(QuicFileReader)
+  SET_SELF_SIZE(QuicFileReader)
+
+ private:
+  struct ReadRequest;
+
+  static void OnRead(uv_fs_t* req);
+  static void Close(uv_loop_t* loop, uv_file fd);
+
+  void OnChunkRead(std::unique_ptr<QuicBufferChunk> chunk, ssize_t result);
+  void Finish(int status);
+
+  QuicStream* stream_;
+  uv_file fd_;
+  int64_t offset_;
+  // The number of bytes left to read, or -1 to read until
+  // the end of the file.
+  int64_t remaining_;
+  bool owns_fd_;
+  bool done_ = false;
+  ReadRequest* request_ = nullptr;
+};
+
 // QuicStream's are simple data flows that, fortunately, do not
 // require much. They may be:
 //
@@ -221,6 +297,15 @@ class QuicStream : public AsyncWrap,
 
   QuicSession* session() const { return session_.get(); }
 
+  // The urgency and incremental flag the QuicApplication uses to
+  // decide which QuicStream is sent next.
+  uint8_t urgency() const { return urgency_; }
+  bool is_incremental() const { return incremental_; }
+
+  // Updates the priority of the QuicStream and notifies the
+  // QuicApplication so that it can reorder pending streams.
+  inline void SetPriority(uint8_t urgency, bool incremental);
+
   // A QuicStream can be either uni- or bi-directional.
   inline QuicStreamDirection direction() const;
 
@@ -256,6 +341,11 @@ class QuicStream : public AsyncWrap,
   // Specifies the kind of headers currently being processed.
   inline void set_headers_kind(QuicStreamHeadersKind kind);
 
+  // True while an event that JavaScript has to see before the
+  // QuicStream's data is queued on the QuicSocket.
+  inline bool has_queued_event() const;
+  inline void set_queued_event(bool on);
+
   // Set the final size for the QuicStream
   inline void set_final_size(uint64_t final_size);
 
@@ -273,6 +363,11 @@ class QuicStream : public AsyncWrap,
   // Destroy the QuicStream and render it no longer usable.
   void Destroy();
 
+  // With a write high water mark set, copies the data to be written
+  // into the streambuf_ so that the write completes synchronously,
+  // unless the amount of unacknowledged data has reached the mark.
+  int DoTryWrite(uv_buf_t** bufs, size_t* count) override;
+
   // Buffers chunks of data to be written to the QUIC connection.
   int DoWrite(
       WriteWrap* req_wrap,
@@ -343,6 +438,23 @@ class QuicStream : public AsyncWrap,
 
   QuicState* quic_state() { return quic_state_.get(); }
 
+  // By default, a write completes once the peer has acknowledged
+  // all of its data. With a write high water mark, writes complete
+  // once their data has been copied into the streambuf_, as long as
+  // there are fewer unacknowledged bytes than the mark. 0 restores
+  // the default.
+  void set_write_high_water_mark(size_t mark) {
+    write_high_water_mark_ = mark;
+  }
+
+  // The number of unacknowledged bytes held for writes that have
+  // already completed.
+  inline size_t buffer_size() const;
+
+  // Sends the contents of the file as the remainder of the
+  // QuicStream's data, then ends the writable side.
+  int SendFile(uv_file fd, int64_t offset, int64_t length, bool owns_fd);
+
   // Required for MemoryRetainer
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_MEMORY_INFO_NAME(QuicStream)
@@ -374,8 +486,34 @@ class QuicStream : public AsyncWrap,
 
   void IncrementStats(size_t datalen);
 
+  // Copies the data into the streambuf_ and schedules the
+  // QuicStream to be sent.
+  void CopyIntoBuffer(const uv_buf_t* bufs, size_t nbufs, size_t length);
+
+  // Completes the writes waiting for the amount of unacknowledged
+  // data to drop below the write high water mark.
+  void CompletePendingWrites(int status);
+
+  // Called by the QuicFileReader with each chunk read from the
+  // file, and once the file has been read or reading has failed.
+  void OnFileChunk(std::unique_ptr<QuicBufferChunk> chunk);
+  void OnFileDone(int status);
+
   BaseObjectWeakPtr<QuicSession> session_;
   QuicBuffer streambuf_;
+  size_t write_high_water_mark_ = 0;
+  std::deque<DoneCB> pending_writes_;
+  size_t pending_write_bytes_ = 0;
+  // The unacknowledged bytes of zero-copy writes, which only
+  // complete once all of their data has been acknowledged.
+  size_t zero_copy_bytes_ = 0;
+  std::unique_ptr<QuicFileReader> file_reader_;
+  QuicStreamListener stream_listener_;
+
+  // The slab ArrayBuffer holding the chunk currently being passed to
+  // the QuicStreamListener, and the chunk's offset within it.
+  v8::Local<v8::ArrayBuffer> receive_buffer_;
+  size_t receive_offset_ = 0;
 
   int64_t stream_id_ = 0;
   int64_t push_id_ = 0;
@@ -386,6 +524,13 @@ class QuicStream : public AsyncWrap,
   QuicStreamHeadersKind headers_kind_;
   size_t current_headers_length_ = 0;
 
+  uint8_t urgency_ = DEFAULT_STREAM_URGENCY;
+  bool incremental_ = false;
+
+  // The bytes remaining in the QuicStream's current
+  // turn when it is incremental.
+  size_t scheduling_credit_ = kStreamSchedulingQuantum;
+
   ListNode<QuicStream> stream_queue_;
 
   BaseObjectPtr<QuicState> quic_state_;
@@ -394,9 +539,54 @@ class QuicStream : public AsyncWrap,
   // Linked List of QuicStream objects
   using Queue = ListHead<QuicStream, &QuicStream::stream_queue_>;
 
-  inline void Schedule(Queue* queue);
-
   inline void Unschedule();
+
+  inline bool is_scheduled() const;
+
+  friend class QuicStreamScheduler;
+  friend class QuicStreamListener;
+  friend class QuicFileReader;
+};
+
+// Orders the QuicStreams that have data to send. Streams are served
+// strictly in order of urgency. Among QuicStreams of the same urgency,
+// non-incremental streams are served one at a time in the order they
+// were scheduled, while incremental streams take turns, each sending
+// up to kStreamSchedulingQuantum bytes per turn.
+class QuicStreamScheduler final : public MemoryRetainer {
+ public:
+  // Adds the QuicStream to the back of the queue for its
+  // urgency, unless it is already scheduled.
+  inline void Schedule(QuicStream* stream);
+
+  // Moves an already scheduled QuicStream to the
+  // queue for its current urgency.
+  inline void Reschedule(QuicStream* stream);
+
+  // Removes and returns the QuicStream that is to send next,
+  // or nullptr if no QuicStreams are scheduled.
+  inline QuicStream* PopFront();
+
+  // Returns a QuicStream taken by PopFront() that still has data to
+  // send. It remains at the front of its queue until its turn is over.
+  inline void Requeue(QuicStream* stream);
+
+  // Records that datalen bytes were sent for the QuicStream.
+  inline void Commit(QuicStream* stream, size_t datalen);
+
+  // Removes every QuicStream that is more urgent than urgency.
+  inline void UnscheduleMoreUrgentThan(uint8_t urgency);
+
+  // The urgency of the most urgent scheduled QuicStream, or
+  // kStreamUrgencyLevels if no QuicStreams are scheduled.
+  inline uint8_t most_urgent() const;
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(QuicStreamScheduler)
+  SET_SELF_SIZE(QuicStreamScheduler)
+
+ private:
+  QuicStream::Queue queues_[kStreamUrgencyLevels];
 };
 
 }  // namespace quic
@@ -33,15 +33,6 @@ QuicPath::QuicPath(
       const_cast<SocketAddress*>(&remote));
 }
 
-size_t QuicCID::Hash::operator()(const QuicCID& token) const {
-  size_t hash = 0;
-  for (size_t n = 0; n < token->datalen; n++) {
-    hash ^= std::hash<uint8_t>{}(token->data[n]) + 0x9e3779b9 +
-            (hash << 6) + (hash >> 2);
-  }
-  return hash;
-}
-
 QuicCID& QuicCID::operator=(const QuicCID& cid) {
   if (this == &cid) return *this;
   this->~QuicCID();
@@ -73,47 +64,62 @@ size_t GetMaxPktLen(const SocketAddress& addr) {
       NGTCP2_MAX_PKTLEN_IPV4;
 }
 
-Timer::Timer(Environment* env, std::function<void()> fn)
-  : env_(env),
+// The IP and UDP headers are subtracted from the link MTU.
+size_t GetMaxPathMtu(const SocketAddress& addr) {
+  return addr.family() == AF_INET6 ? 9000 - 48 : 9000 - 28;
+}
+
+size_t GetPathMtuHint(const SocketAddress& addr) {
+  return addr.family() == AF_INET6 ? 1500 - 48 : 1500 - 28;
+}
+
+QuicTimer::QuicTimer(QuicTimerWheel* wheel, std::function<void()> fn)
+  : wheel_(wheel),
     fn_(fn) {
-  uv_timer_init(env_->event_loop(), &timer_);
-  timer_.data = this;
+  CHECK_NOT_NULL(wheel_);
+  if (wheel_->closed_)
+    wheel_ = nullptr;
+  else
+    wheel_->timers_.PushBack(this);
 }
 
-void Timer::Stop() {
+QuicTimer::~QuicTimer() {
+  Stop();
+}
+
+void QuicTimer::Stop() {
   if (stopped_)
     return;
   stopped_ = true;
+  if (wheel_ != nullptr && is_active())
+    wheel_->Remove(this);
+}
 
-  if (timer_.data == this) {
-    uv_timer_stop(&timer_);
-    timer_.data = nullptr;
-  }
+void QuicTimer::Cancel() {
+  if (wheel_ != nullptr && is_active())
+    wheel_->Remove(this);
 }
 
-// If the timer is not currently active, interval must be either 0 or greater.
-// If the timer is already active, interval is ignored.
-void Timer::Update(uint64_t interval) {
-  if (stopped_)
+void QuicTimer::Update(uint64_t interval) {
+  // The wheel is gone once the QuicSocket has been destroyed.
+  if (stopped_ || wheel_ == nullptr)
     return;
-  uv_timer_start(&timer_, OnTimeout, interval, interval);
-  uv_unref(reinterpret_cast<uv_handle_t*>(&timer_));
+  if (is_active())
+    wheel_->Remove(this);
+  interval_ = interval;
+  deadline_ = wheel_->now() + std::max(interval, uint64_t{1});
+  wheel_->Insert(this);
 }
 
-void Timer::Free(Timer* timer) {
-  timer->env_->CloseHandle(
-      reinterpret_cast<uv_handle_t*>(&timer->timer_),
-      [&](uv_handle_t* timer) {
-        Timer* t = ContainerOf(
-            &Timer::timer_,
-            reinterpret_cast<uv_timer_t*>(timer));
-        delete t;
-      });
+uint64_t QuicTimerWheel::now() const {
+  return uv_now(env_->event_loop());
 }
 
-void Timer::OnTimeout(uv_timer_t* timer) {
-  Timer* t = ContainerOf(&Timer::timer_, timer);
-  t->fn_();
+void QuicTimerWheel::Remove(QuicTimer* timer) {
+  // The slot's bit in occupied_ is left set and is cleared lazily
+  // by NextDeadline() once the slot is found to be empty.
+  timer->node_.Remove();
+  timer_count_--;
 }
 
 QuicError::QuicError(
@@ -309,15 +315,6 @@ std::string StatelessResetToken::ToString() const {
   return std::string(dest.data(), written);
 }
 
-size_t StatelessResetToken::Hash::operator()(
-    const StatelessResetToken& token) const {
-  size_t hash = 0;
-  for (size_t n = 0; n < NGTCP2_STATELESS_RESET_TOKENLEN; n++)
-    hash ^= std::hash<uint8_t>{}(token.token_[n]) + 0x9e3779b9 +
-            (hash << 6) + (hash >> 2);
-  return hash;
-}
-
 bool StatelessResetToken::operator==(const StatelessResetToken& other) const {
   return memcmp(data(), other.data(), NGTCP2_STATELESS_RESET_TOKENLEN) == 0;
 }
@@ -326,13 +323,324 @@ bool StatelessResetToken::operator!=(const StatelessResetToken& other) const {
   return !(*this == other);
 }
 
+#define SIP_ROTL(x, b) (((x) << (b)) | ((x) >> (64 - (b))))
+#define SIP_ROUND(v0, v1, v2, v3)                                              \
+  do {                                                                         \
+    v0 += v1; v1 = SIP_ROTL(v1, 13); v1 ^= v0; v0 = SIP_ROTL(v0, 32);          \
+    v2 += v3; v3 = SIP_ROTL(v3, 16); v3 ^= v2;                                 \
+    v0 += v3; v3 = SIP_ROTL(v3, 21); v3 ^= v0;                                 \
+    v2 += v1; v1 = SIP_ROTL(v1, 17); v1 ^= v2; v2 = SIP_ROTL(v2, 32);          \
+  } while (0)
+
+uint64_t QuicSipHash(const uint64_t key[2], const uint8_t* data, size_t len) {
+  uint64_t v0 = key[0] ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = key[1] ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = key[0] ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = key[1] ^ 0x7465646279746573ULL;
+
+  const uint8_t* end = data + (len & ~static_cast<size_t>(7));
+  for (; data != end; data += 8) {
+    uint64_t m;
+    memcpy(&m, data, sizeof(m));
+    v3 ^= m;
+    SIP_ROUND(v0, v1, v2, v3);
+    v0 ^= m;
+  }
+
+  uint64_t b = static_cast<uint64_t>(len) << 56;
+  for (size_t n = 0; n < (len & 7); n++)
+    b |= static_cast<uint64_t>(data[n]) << (8 * n);
+  v3 ^= b;
+  SIP_ROUND(v0, v1, v2, v3);
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  SIP_ROUND(v0, v1, v2, v3);
+  SIP_ROUND(v0, v1, v2, v3);
+  SIP_ROUND(v0, v1, v2, v3);
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+#undef SIP_ROUND
+#undef SIP_ROTL
+
+uint64_t QuicAddressHash(const uint64_t key[2], const SocketAddress& addr) {
+  uint8_t data[sizeof(in6_addr) + sizeof(uint16_t)];
+  size_t len;
+  switch (addr.family()) {
+    case AF_INET: {
+      const sockaddr_in* ipv4 =
+          reinterpret_cast<const sockaddr_in*>(addr.raw());
+      memcpy(data, &ipv4->sin_addr, sizeof(ipv4->sin_addr));
+      memcpy(data + sizeof(ipv4->sin_addr), &ipv4->sin_port, sizeof(uint16_t));
+      len = sizeof(ipv4->sin_addr) + sizeof(uint16_t);
+      break;
+    }
+    case AF_INET6: {
+      const sockaddr_in6* ipv6 =
+          reinterpret_cast<const sockaddr_in6*>(addr.raw());
+      memcpy(data, &ipv6->sin6_addr, sizeof(ipv6->sin6_addr));
+      memcpy(data + sizeof(ipv6->sin6_addr), &ipv6->sin6_port,
+             sizeof(uint16_t));
+      len = sizeof(ipv6->sin6_addr) + sizeof(uint16_t);
+      break;
+    }
+    default:
+      UNREACHABLE();
+  }
+  return QuicSipHash(key, data, len);
+}
+
+QuicAddressCounter::QuicAddressCounter(
+    size_t width,
+    uint64_t decay_interval)
+    : decay_interval_(decay_interval),
+      decayed_at_(decay_interval > 0 ? uv_hrtime() : 0) {
+  size_t size = 1;
+  while (size < width)
+    size <<= 1;
+  mask_ = size - 1;
+  counters_.resize(size * kDepth);
+  CHECK(crypto::EntropySource(
+      reinterpret_cast<unsigned char*>(hash_key_),
+      sizeof(hash_key_)));
+}
+
+// The kDepth counters of an address are derived from the two halves
+// of a single 64-bit hash, which is as good as kDepth independent
+// hashes for a count-min sketch.
+void QuicAddressCounter::Slots(
+    const SocketAddress& addr,
+    size_t slots[kDepth]) const {
+  uint64_t hash = QuicAddressHash(hash_key_, addr);
+  uint32_t h1 = static_cast<uint32_t>(hash);
+  uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+  for (size_t n = 0; n < kDepth; n++)
+    slots[n] = n * width() + ((h1 + n * h2) & mask_);
+}
+
+void QuicAddressCounter::MaybeDecay() {
+  if (decay_interval_ == 0)
+    return;
+  uint64_t now = uv_hrtime();
+  uint64_t intervals = (now - decayed_at_) / decay_interval_;
+  if (intervals == 0)
+    return;
+  decayed_at_ += intervals * decay_interval_;
+  for (uint32_t& counter : counters_)
+    counter = intervals >= 32 ? 0 : counter >> intervals;
+}
+
+void QuicAddressCounter::Increment(const SocketAddress& addr) {
+  MaybeDecay();
+  size_t slots[kDepth];
+  Slots(addr, slots);
+  for (size_t slot : slots) {
+    if (counters_[slot] < std::numeric_limits<uint32_t>::max())
+      counters_[slot]++;
+  }
+}
+
+void QuicAddressCounter::Decrement(const SocketAddress& addr) {
+  size_t slots[kDepth];
+  Slots(addr, slots);
+  for (size_t slot : slots) {
+    if (counters_[slot] > 0)
+      counters_[slot]--;
+  }
+}
+
+size_t QuicAddressCounter::Get(const SocketAddress& addr) {
+  MaybeDecay();
+  size_t slots[kDepth];
+  Slots(addr, slots);
+  uint32_t count = std::numeric_limits<uint32_t>::max();
+  for (size_t slot : slots)
+    count = std::min(count, counters_[slot]);
+  return count;
+}
+
+QuicAddressLRU::QuicAddressLRU(size_t capacity) : capacity_(capacity) {
+  CHECK_GT(capacity, 0);
+  CHECK(crypto::EntropySource(
+      reinterpret_cast<unsigned char*>(hash_key_),
+      sizeof(hash_key_)));
+}
+
+void QuicAddressLRU::Insert(const SocketAddress& addr) {
+  uint64_t hash = QuicAddressHash(hash_key_, addr);
+  auto it = index_.find(hash);
+  if (it != std::end(index_)) {
+    order_.splice(std::begin(order_), order_, it->second);
+    return;
+  }
+  if (order_.size() == capacity_) {
+    index_.erase(order_.back());
+    order_.pop_back();
+  }
+  order_.push_front(hash);
+  index_[hash] = std::begin(order_);
+}
+
+bool QuicAddressLRU::Contains(const SocketAddress& addr) const {
+  return index_.find(QuicAddressHash(hash_key_, addr)) != std::end(index_);
+}
+
+template <typename T>
+QuicRoutingTable<T>::QuicRoutingTable() {
+  CHECK(crypto::EntropySource(
+      reinterpret_cast<unsigned char*>(hash_key_),
+      sizeof(hash_key_)));
+}
+
+template <typename T>
+QuicRoutingTable<T>::QuicRoutingTable(const uint8_t* hash_key) {
+  memcpy(hash_key_, hash_key, sizeof(hash_key_));
+}
+
+template <typename T>
+T* QuicRoutingTable<T>::Find(const QuicCID& cid) {
+  return Find(cid.data(), cid.length());
+}
+
+template <typename T>
+T* QuicRoutingTable<T>::Find(const StatelessResetToken& token) {
+  return Find(token.data(), NGTCP2_STATELESS_RESET_TOKENLEN);
+}
+
+template <typename T>
+void QuicRoutingTable<T>::Insert(const QuicCID& cid, T value) {
+  Insert(cid.data(), cid.length(), std::move(value));
+}
+
+template <typename T>
+void QuicRoutingTable<T>::Insert(
+    const StatelessResetToken& token,
+    T value) {
+  Insert(token.data(), NGTCP2_STATELESS_RESET_TOKENLEN, std::move(value));
+}
+
+template <typename T>
+bool QuicRoutingTable<T>::Erase(const QuicCID& cid) {
+  return Erase(cid.data(), cid.length());
+}
+
+template <typename T>
+bool QuicRoutingTable<T>::Erase(const StatelessResetToken& token) {
+  return Erase(token.data(), NGTCP2_STATELESS_RESET_TOKENLEN);
+}
+
+// Returns the index of the entry for the key, or kNotFound. Because
+// entries are never left as tombstones, the probe sequence for a key
+// always ends at the first unused entry.
+template <typename T>
+size_t QuicRoutingTable<T>::Lookup(
+    const uint8_t* key,
+    size_t len,
+    uint64_t hash) const {
+  if (entries_.empty())
+    return kNotFound;
+  size_t mask = entries_.size() - 1;
+  for (size_t n = hash & mask;; n = (n + 1) & mask) {
+    const Entry& entry = entries_[n];
+    if (!entry.used)
+      return kNotFound;
+    if (entry.hash == hash &&
+        entry.len == len &&
+        memcmp(entry.key, key, len) == 0) {
+      return n;
+    }
+  }
+}
+
+template <typename T>
+T* QuicRoutingTable<T>::Find(const uint8_t* key, size_t len) {
+  size_t n = Lookup(key, len, QuicSipHash(hash_key_, key, len));
+  return n == kNotFound ? nullptr : &entries_[n].value;
+}
+
+template <typename T>
+void QuicRoutingTable<T>::Insert(
+    const uint8_t* key,
+    size_t len,
+    T value) {
+  CHECK_LE(len, kMaxKeyLen);
+  uint64_t hash = QuicSipHash(hash_key_, key, len);
+  size_t n = Lookup(key, len, hash);
+  if (n != kNotFound) {
+    entries_[n].value = std::move(value);
+    return;
+  }
+
+  // Keep the table at most three quarters full so that probe
+  // sequences stay short.
+  if ((size_ + 1) * 4 > entries_.size() * 3)
+    Resize(entries_.empty() ? kMinCapacity : entries_.size() * 2);
+
+  size_t mask = entries_.size() - 1;
+  n = hash & mask;
+  while (entries_[n].used)
+    n = (n + 1) & mask;
+  Entry& entry = entries_[n];
+  entry.hash = hash;
+  entry.used = true;
+  entry.len = static_cast<uint8_t>(len);
+  memcpy(entry.key, key, len);
+  entry.value = std::move(value);
+  size_++;
+}
+
+// Removes the entry by shifting back any later entries in the same
+// probe sequence that would otherwise become unreachable, which
+// keeps lookups from having to skip over deleted entries.
+template <typename T>
+bool QuicRoutingTable<T>::Erase(const uint8_t* key, size_t len) {
+  size_t n = Lookup(key, len, QuicSipHash(hash_key_, key, len));
+  if (n == kNotFound)
+    return false;
+
+  size_t mask = entries_.size() - 1;
+  for (size_t next = (n + 1) & mask;
+       entries_[next].used;
+       next = (next + 1) & mask) {
+    // An entry can only be moved back to n if n lies cyclically
+    // between its home slot and its current slot.
+    size_t home = entries_[next].hash & mask;
+    if (((next - home) & mask) >= ((next - n) & mask)) {
+      entries_[n] = std::move(entries_[next]);
+      n = next;
+    }
+  }
+
+  Entry& entry = entries_[n];
+  entry.used = false;
+  entry.value = T();
+  size_--;
+  return true;
+}
+
+template <typename T>
+void QuicRoutingTable<T>::Resize(size_t capacity) {
+  std::vector<Entry> entries(capacity);
+  size_t mask = capacity - 1;
+  for (Entry& entry : entries_) {
+    if (!entry.used)
+      continue;
+    size_t n = entry.hash & mask;
+    while (entries[n].used)
+      n = (n + 1) & mask;
+    entries[n] = std::move(entry);
+  }
+  entries_.swap(entries);
+}
+
 template <typename T>
 StatsBase<T>::StatsBase(
     Environment* env,
     v8::Local<v8::Object> wrap,
-    int options) {
-  static constexpr uint64_t kMax = std::numeric_limits<int64_t>::max();
-
+    int options,
+    QuicHistogramMode mode,
+    QuicStatsHistograms* shared) {
   // Create the backing store for the statistics
   size_t size = sizeof(Stats);
   size_t count = size / sizeof(uint64_t);
@@ -354,32 +662,74 @@ StatsBase<T>::StatsBase(
       stats_array,
       v8::PropertyAttribute::ReadOnly));
 
+  CHECK_IMPLIES(mode == QUIC_HISTOGRAM_MODE_SHARED, shared != nullptr);
+
   if (options & HistogramOptions::ACK) {
-    ack_ = HistogramBase::New(env, 1, kMax);
-    wrap->DefineOwnProperty(
-        env->context(),
-        env->ack_string(),
-        ack_->object(),
-        v8::PropertyAttribute::ReadOnly).Check();
+    InitHistogram<&StatsBase<T>::ack_>(
+        env, wrap, env->ack_string(), mode,
+        shared != nullptr ? &shared->ack : nullptr);
   }
 
   if (options & HistogramOptions::RATE) {
-    rate_ = HistogramBase::New(env, 1, kMax);
-    wrap->DefineOwnProperty(
-        env->context(),
-        env->rate_string(),
-        rate_->object(),
-        v8::PropertyAttribute::ReadOnly).Check();
+    InitHistogram<&StatsBase<T>::rate_>(
+        env, wrap, env->rate_string(), mode,
+        shared != nullptr ? &shared->rate : nullptr);
   }
 
   if (options & HistogramOptions::SIZE) {
-    size_ = HistogramBase::New(env, 1, kMax);
-    wrap->DefineOwnProperty(
-        env->context(),
-        env->size_string(),
-        size_->object(),
-        v8::PropertyAttribute::ReadOnly).Check();
+    InitHistogram<&StatsBase<T>::size_>(
+        env, wrap, env->size_string(), mode,
+        shared != nullptr ? &shared->size : nullptr);
+  }
+}
+
+template <typename T>
+template <BaseObjectPtr<HistogramBase> StatsBase<T>::*member>
+void StatsBase<T>::InitHistogram(
+    Environment* env,
+    v8::Local<v8::Object> wrap,
+    v8::Local<v8::String> name,
+    QuicHistogramMode mode,
+    BaseObjectPtr<HistogramBase>* shared) {
+  static constexpr uint64_t kMax = std::numeric_limits<int64_t>::max();
+  switch (mode) {
+    case QUIC_HISTOGRAM_MODE_LAZY:
+      wrap->SetLazyDataProperty(
+          env->context(),
+          name,
+          GetHistogram<member>,
+          v8::Local<v8::Value>(),
+          v8::PropertyAttribute::ReadOnly).Check();
+      return;
+    case QUIC_HISTOGRAM_MODE_EAGER:
+      this->*member = HistogramBase::New(env, 1, kMax);
+      break;
+    case QUIC_HISTOGRAM_MODE_SHARED:
+      if (!*shared)
+        *shared = HistogramBase::New(env, 1, kMax);
+      this->*member = *shared;
+      break;
   }
+  wrap->DefineOwnProperty(
+      env->context(),
+      name,
+      (this->*member)->object(),
+      v8::PropertyAttribute::ReadOnly).Check();
+}
+
+template <typename T>
+template <BaseObjectPtr<HistogramBase> StatsBase<T>::*member>
+void StatsBase<T>::GetHistogram(
+    v8::Local<v8::Name> name,
+    const v8::PropertyCallbackInfo<v8::Value>& info) {
+  static constexpr uint64_t kMax = std::numeric_limits<int64_t>::max();
+  typename T::Base* ptr;
+  ASSIGN_OR_RETURN_UNWRAP(&ptr, info.Holder());
+  StatsBase<T>* stats = ptr;
+  if (!(stats->*member))
+    stats->*member = HistogramBase::New(ptr->env(), 1, kMax);
+  if (stats->*member)
+    info.GetReturnValue().Set((stats->*member)->object());
 }
 
 template <typename T>
@@ -405,26 +755,24 @@ uint64_t StatsBase<T>::GetStat(uint64_t Stats::*member) const {
 
 template <typename T>
 inline void StatsBase<T>::RecordRate(uint64_t Stats::*member) {
-  CHECK(rate_);
   uint64_t received_at = GetStat(member);
   uint64_t now = uv_hrtime();
-  if (received_at > 0)
+  if (received_at > 0 && rate_)
     rate_->Record(now - received_at);
   SetStat(member, now);
 }
 
 template <typename T>
 inline void StatsBase<T>::RecordSize(uint64_t val) {
-  CHECK(size_);
-  size_->Record(val);
+  if (size_)
+    size_->Record(val);
 }
 
 template <typename T>
 inline void StatsBase<T>::RecordAck(uint64_t Stats::*member) {
-  CHECK(ack_);
   uint64_t acked_at = GetStat(member);
   uint64_t now = uv_hrtime();
-  if (acked_at > 0)
+  if (acked_at > 0 && ack_)
     ack_->Record(now - acked_at);
   SetStat(member, now);
 }
@@ -458,6 +806,40 @@ std::string StatsBase<T>::StatsDebug::ToString() const {
   return out;
 }
 
+void QuicPacer::Update(uint64_t now, double rate, size_t packet_length) {
+  packet_length_ = packet_length;
+  rate_ = rate;
+  double max_credit = static_cast<double>(max_burst_ * packet_length);
+  if (rate == 0) {
+    credit_ = max_credit;
+  } else {
+    credit_ = last_update_ == 0 ?
+        max_credit :
+        std::min(max_credit, credit_ + (now - last_update_) * rate_);
+  }
+  last_update_ = now;
+}
+
+void QuicPacer::OnPacketSent(size_t length) {
+  // Credit is allowed to go negative by at most one burst so
+  // that a short packet budgeted as a full one is repaid.
+  credit_ = std::max(
+      credit_ - length,
+      -static_cast<double>(max_burst_ * packet_length_));
+}
+
+size_t QuicPacer::budget() const {
+  if (packet_length_ == 0 || credit_ < packet_length_)
+    return 0;
+  return static_cast<size_t>(credit_ / packet_length_);
+}
+
+uint64_t QuicPacer::delay() const {
+  if (rate_ == 0 || credit_ >= packet_length_)
+    return 0;
+  return static_cast<uint64_t>((packet_length_ - credit_) / rate_);
+}
+
 template <typename T>
 size_t get_length(const T* vec, size_t count) {
   CHECK_NOT_NULL(vec);
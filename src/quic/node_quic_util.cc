@@ -0,0 +1,273 @@
+#include "node_quic_util-inl.h"  // NOLINT(build/include)
+#include "env-inl.h"
+#include "node_sockaddr-inl.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#include <algorithm>
+
+namespace node {
+namespace quic {
+
+namespace {
+inline size_t SlotFor(uint64_t time, size_t level) {
+  return (time >> (level * QuicTimerWheel::kSlotBits)) &
+      (QuicTimerWheel::kSlots - 1);
+}
+
+// Rotates bits right by n so that bit 0 corresponds to slot n.
+inline uint64_t RotateRight(uint64_t bits, size_t n) {
+  n &= QuicTimerWheel::kSlots - 1;
+  return n == 0 ? bits : (bits >> n) | (bits << (64 - n));
+}
+
+// bits must not be zero.
+inline size_t CountTrailingZeros(uint64_t bits) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(bits);
+#else
+  size_t n = 0;
+  while ((bits & 1) == 0) {
+    bits >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+}  // namespace
+
+QuicTimerWheel::QuicTimerWheel(Environment* env)
+  : env_(env) {
+  uv_timer_init(env_->event_loop(), &timer_);
+  timer_.data = this;
+  current_ = now();
+}
+
+void QuicTimerWheel::Free(QuicTimerWheel* wheel) {
+  wheel->closed_ = true;
+  for (auto& level : wheel->slots_) {
+    for (Slot& slot : level) {
+      while (slot.PopFront() != nullptr) {}
+    }
+  }
+  // Timers that are not armed still point at the wheel.
+  while (QuicTimer* timer = wheel->timers_.PopFront())
+    timer->wheel_ = nullptr;
+  wheel->timer_count_ = 0;
+  uv_timer_stop(&wheel->timer_);
+  wheel->env_->CloseHandle(
+      reinterpret_cast<uv_handle_t*>(&wheel->timer_),
+      [](uv_handle_t* timer) {
+        QuicTimerWheel* w = ContainerOf(
+            &QuicTimerWheel::timer_,
+            reinterpret_cast<uv_timer_t*>(timer));
+        delete w;
+      });
+}
+
+void QuicTimerWheel::Insert(QuicTimer* timer) {
+  if (closed_) {
+    timer->wheel_ = nullptr;
+    return;
+  }
+
+  // The wheel only advances while it has timers, so catch up
+  // with the loop time before inserting into an empty wheel.
+  if (timer_count_ == 0 && !advancing_)
+    current_ = now();
+
+  uint64_t deadline = std::max(timer->deadline_, current_ + 1);
+  uint64_t delta = deadline - current_;
+  size_t level = 0;
+  while (level < kLevels - 1 &&
+         delta >= (uint64_t{1} << ((level + 1) * kSlotBits))) {
+    level++;
+  }
+  constexpr uint64_t kRange = uint64_t{1} << (kLevels * kSlotBits);
+  if (delta >= kRange)
+    deadline = current_ + kRange - 1;
+
+  size_t slot = SlotFor(deadline, level);
+  slots_[level][slot].PushBack(timer);
+  occupied_[level] |= uint64_t{1} << slot;
+  timer_count_++;
+
+  size_t shift = level * kSlotBits;
+  uint64_t due = (deadline >> shift) << shift;
+  if (!advancing_ && due < armed_)
+    Arm(due);
+}
+
+uint64_t QuicTimerWheel::NextDeadline() {
+  uint64_t next = kNoDeadline;
+  for (size_t level = 0; level < kLevels; level++) {
+    size_t shift = level * kSlotBits;
+    uint64_t base = (current_ >> shift) + 1;
+    while (occupied_[level] != 0) {
+      uint64_t bits = RotateRight(occupied_[level], base);
+      uint64_t due = (base + CountTrailingZeros(bits)) << shift;
+      size_t slot = SlotFor(due, level);
+      if (slots_[level][slot].IsEmpty()) {
+        occupied_[level] &= ~(uint64_t{1} << slot);
+        continue;
+      }
+      next = std::min(next, due);
+      break;
+    }
+  }
+  return next;
+}
+
+void QuicTimerWheel::Advance(uint64_t now) {
+  advancing_ = true;
+  while (!closed_) {
+    uint64_t due = NextDeadline();
+    if (due > now) {
+      current_ = now;
+      break;
+    }
+    current_ = due;
+
+    // Starting from the highest level whose slot boundary has been
+    // reached, move timers down the wheel and collect those that
+    // have expired.
+    Slot expired;
+    for (size_t level = kLevels; level-- > 0;) {
+      size_t shift = level * kSlotBits;
+      if ((due & ((uint64_t{1} << shift) - 1)) != 0)
+        continue;
+      size_t slot = SlotFor(due, level);
+      occupied_[level] &= ~(uint64_t{1} << slot);
+      while (QuicTimer* timer = slots_[level][slot].PopFront()) {
+        if (timer->deadline_ <= due) {
+          expired.PushBack(timer);
+        } else {
+          timer_count_--;
+          Insert(timer);
+        }
+      }
+    }
+
+    // Expired timers are re-armed before their callback is invoked,
+    // matching a repeating uv_timer_t. The callback may update, stop
+    // or destroy the timer, or any of the other expired timers.
+    while (QuicTimer* timer = expired.PopFront()) {
+      timer_count_--;
+      timer->deadline_ = now + std::max(timer->interval_, uint64_t{1});
+      Insert(timer);
+      timer->fn_();
+      if (closed_)
+        break;
+    }
+
+    while (QuicTimer* timer = expired.PopFront())
+      timer->wheel_ = nullptr;
+  }
+  advancing_ = false;
+
+  if (!closed_)
+    Schedule();
+}
+
+void QuicTimerWheel::Arm(uint64_t due) {
+  armed_ = due;
+  uint64_t now = this->now();
+  uv_timer_start(&timer_, OnTimeout, due > now ? due - now : 0, 0);
+  uv_unref(reinterpret_cast<uv_handle_t*>(&timer_));
+}
+
+void QuicTimerWheel::Schedule() {
+  uint64_t due = NextDeadline();
+  if (due == kNoDeadline) {
+    armed_ = kNoDeadline;
+    uv_timer_stop(&timer_);
+    return;
+  }
+  Arm(due);
+}
+
+void QuicTimerWheel::OnTimeout(uv_timer_t* timer) {
+  QuicTimerWheel* wheel = ContainerOf(&QuicTimerWheel::timer_, timer);
+  wheel->armed_ = kNoDeadline;
+  wheel->Advance(wheel->now());
+}
+
+void QuicPathMtuDiscovery::Reset(size_t base, size_t max, size_t hint) {
+  base_ = base;
+  max_ = std::max(max, base);
+  hint_ = hint;
+  packet_length_ = base;
+  ceiling_ = max_ + 1;
+  probe_ = 0;
+  probe_count_ = 0;
+  searching_ = true;
+}
+
+size_t QuicPathMtuDiscovery::NextProbe(uint64_t now, uint64_t timeout) {
+  if (probe_ != 0) {
+    if (now - probe_sent_at_ < timeout)
+      return 0;
+    if (probe_count_ < kMaxProbes)
+      return probe_;
+    // The path does not deliver packets of this length.
+    ceiling_ = probe_;
+    probe_ = 0;
+    probe_count_ = 0;
+  }
+
+  if (ceiling_ - packet_length_ <= kSearchGranularity) {
+    if (searching_) {
+      searching_ = false;
+      search_done_at_ = now;
+    }
+    if (now - search_done_at_ < kRaiseInterval)
+      return 0;
+    // Look again for a larger length, in case the path has changed.
+    ceiling_ = max_ + 1;
+    search_done_at_ = now;
+    if (ceiling_ - packet_length_ <= kSearchGranularity)
+      return 0;
+    searching_ = true;
+  }
+
+  if (hint_ > packet_length_ && hint_ < ceiling_)
+    return hint_;
+  // Try the largest length once before searching in between.
+  if (ceiling_ > max_)
+    return max_;
+  return packet_length_ + (ceiling_ - packet_length_) / 2;
+}
+
+void QuicPathMtuDiscovery::OnProbeSent(size_t length, uint64_t now) {
+  if (length == probe_) {
+    probe_count_++;
+  } else {
+    probe_ = length;
+    probe_count_ = 1;
+  }
+  probe_sent_at_ = now;
+}
+
+bool QuicPathMtuDiscovery::OnProbeAcked(size_t length) {
+  if (length == probe_) {
+    probe_ = 0;
+    probe_count_ = 0;
+  }
+  if (length <= packet_length_ || length > max_)
+    return false;
+  packet_length_ = length;
+  if (ceiling_ <= length)
+    ceiling_ = max_ + 1;
+  return true;
+}
+
+void QuicPathMtuDiscovery::OnBlackHole() {
+  ceiling_ = packet_length_;
+  packet_length_ = base_;
+  probe_ = 0;
+  probe_count_ = 0;
+  searching_ = true;
+}
+
+}  // namespace quic
+}  // namespace node
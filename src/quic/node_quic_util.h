@@ -9,6 +9,7 @@
 #include "v8.h"
 #include "histogram.h"
 #include "memory_tracker.h"
+#include "util.h"
 
 #include <ngtcp2/ngtcp2.h>
 #include <openssl/ssl.h>
@@ -16,8 +17,10 @@
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <list>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace node {
 namespace quic {
@@ -25,12 +28,24 @@ namespace quic {
 // k-constants are used internally, all-caps constants
 // are exposed to javascript as constants (see node_quic.cc)
 
+constexpr size_t kMaxFreeSendRequests = 256;
+constexpr size_t kMaxSendBatch = 64;
+constexpr size_t kReceiveSlabDatagrams = 8;
+constexpr size_t kReceiveSlotSize = 64 * 1024;
 constexpr size_t kMaxSizeT = std::numeric_limits<size_t>::max();
-constexpr size_t kMaxValidateAddressLru = 10;
 constexpr size_t kMinInitialQuicPktSize = 1200;
 constexpr size_t kScidLen = NGTCP2_MAX_CIDLEN;
 constexpr size_t kTokenRandLen = 16;
 constexpr size_t kTokenSecretLen = 16;
+constexpr size_t kMaxNewTokenLen = 64;
+constexpr size_t kMaxStoredNewTokens = 32;
+constexpr size_t kTicketKeyLen = 48;
+constexpr size_t kTicketKeySecretLen = 32;
+
+// The first byte of every address validation token identifies
+// whether it was sent in a RETRY packet or a NEW_TOKEN frame.
+constexpr uint8_t kRetryTokenMagic = 0xb6;
+constexpr uint8_t kNewTokenMagic = 0x36;
 
 constexpr uint64_t DEFAULT_ACTIVE_CONNECTION_ID_LIMIT = 2;
 constexpr uint64_t DEFAULT_MAX_CONNECTIONS =
@@ -44,9 +59,27 @@ constexpr uint64_t DEFAULT_MAX_STATELESS_RESETS_PER_HOST = 10;
 constexpr uint64_t DEFAULT_MAX_STREAMS_BIDI = 100;
 constexpr uint64_t DEFAULT_MAX_STREAMS_UNI = 3;
 constexpr uint64_t DEFAULT_MAX_IDLE_TIMEOUT = 10;
+constexpr uint64_t DEFAULT_MAX_PACING_BURST = 10;
 constexpr uint64_t DEFAULT_RETRYTOKEN_EXPIRATION = 10;
 constexpr uint64_t MIN_RETRYTOKEN_EXPIRATION = 1;
 constexpr uint64_t MAX_RETRYTOKEN_EXPIRATION = 60;
+constexpr uint64_t NEWTOKEN_EXPIRATION = 24 * 60 * 60;
+constexpr uint64_t DEFAULT_VALIDATE_ADDRESS_LRU_SIZE = 10;
+constexpr uint64_t MAX_VALIDATE_ADDRESS_LRU_SIZE = 1 << 16;
+constexpr uint64_t DEFAULT_ADDRESS_SKETCH_SIZE = 1024;
+constexpr uint64_t MIN_ADDRESS_SKETCH_SIZE = 16;
+constexpr uint64_t MAX_ADDRESS_SKETCH_SIZE = 1 << 20;
+// Stateless reset counts are halved once per interval (in nanoseconds).
+constexpr uint64_t STATELESS_RESET_COUNT_DECAY = 60 * NGTCP2_SECONDS;
+// The worker identifier embedded in connection IDs is a single byte.
+constexpr uint64_t MAX_WORKER_ID = 255;
+// Session ticket keys derived from a shared secret are rotated
+// once per interval (in seconds).
+constexpr uint64_t DEFAULT_TICKET_KEY_ROTATION = 60 * 60;
+constexpr uint64_t MIN_TICKET_KEY_ROTATION = 60;
+constexpr uint64_t MAX_TICKET_KEY_ROTATION = 7 * 24 * 60 * 60;
+// The number of explicitly set session ticket keys accepted.
+constexpr uint64_t MAX_TICKET_KEYS = 16;
 constexpr uint64_t NGTCP2_APP_NOERROR = 0xff00;
 
 constexpr int ERR_FAILED_TO_CREATE_SESSION = -1;
@@ -91,6 +124,36 @@ enum QuicErrorFamily : int32_t {
 
 template <typename T> class StatsBase;
 
+// Selects how the rate, size and ack histograms of QuicSessions
+// and QuicStreams are allocated.
+enum QuicHistogramMode : uint32_t {
+  // Each histogram is allocated on first access from JavaScript.
+  // Nothing is recorded until then.
+  QUIC_HISTOGRAM_MODE_LAZY,
+  // Each histogram is allocated along with its QuicSession or
+  // QuicStream.
+  QUIC_HISTOGRAM_MODE_EAGER,
+  // All QuicSessions of a QuicSocket record into one set of
+  // histograms, and all of their QuicStreams into another.
+  QUIC_HISTOGRAM_MODE_SHARED
+};
+
+// The set of histograms shared by StatsBase instances when
+// QUIC_HISTOGRAM_MODE_SHARED is used.
+struct QuicStatsHistograms : public MemoryRetainer {
+  BaseObjectPtr<HistogramBase> rate;
+  BaseObjectPtr<HistogramBase> size;
+  BaseObjectPtr<HistogramBase> ack;
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackField("rate", rate);
+    tracker->TrackField("size", size);
+    tracker->TrackField("ack", ack);
+  }
+  SET_MEMORY_INFO_NAME(QuicStatsHistograms)
+  SET_SELF_SIZE(QuicStatsHistograms)
+};
+
 template <typename T, typename Q>
 struct StatsTraits {
   using Stats = T;
@@ -116,7 +179,11 @@ class StatsBase {
   // that records size of data chunk, and one that records
   // rate of data ackwowledgement. These may be used in
   // slightly different ways of different StatsBase
-  // instances or may be turned off entirely.
+  // instances or may be turned off entirely. How the
+  // histograms are allocated is determined by the
+  // QuicHistogramMode; when QUIC_HISTOGRAM_MODE_SHARED
+  // is used, shared must point to the set of histograms
+  // to record into.
   enum HistogramOptions {
     NONE = 0,
     RATE = 1,
@@ -127,7 +194,9 @@ class StatsBase {
   inline StatsBase(
       Environment* env,
       v8::Local<v8::Object> wrap,
-      int options = HistogramOptions::NONE);
+      int options = HistogramOptions::NONE,
+      QuicHistogramMode mode = QUIC_HISTOGRAM_MODE_LAZY,
+      QuicStatsHistograms* shared = nullptr);
 
   inline ~StatsBase() { if (stats_ != nullptr) stats_->~Stats(); }
 
@@ -154,16 +223,17 @@ class StatsBase {
   // Gets the current value of the given stat field
   inline uint64_t GetStat(uint64_t Stats::*member) const;
 
-  // If the rate histogram is used, records the time elapsed
-  // between now and the timestamp specified by the member
-  // field.
+  // If the rate histogram has been allocated, records the time
+  // elapsed between now and the timestamp specified by the
+  // member field.
   inline void RecordRate(uint64_t Stats::*member);
 
-  // If the size histogram is used, records the given size.
+  // If the size histogram has been allocated, records the
+  // given size.
   inline void RecordSize(uint64_t val);
 
-  // If the ack rate histogram is used, records the time
-  // elapsed between now and the timestamp specified by
+  // If the ack rate histogram has been allocated, records the
+  // time elapsed between now and the timestamp specified by
   // the member field.
   inline void RecordAck(uint64_t Stats::*member);
 
@@ -172,6 +242,21 @@ class StatsBase {
   inline void DebugStats();
 
  private:
+  // Allocates the histogram stored in member on first access
+  // of the corresponding property from JavaScript.
+  template <BaseObjectPtr<HistogramBase> StatsBase<T>::*member>
+  static void GetHistogram(
+      v8::Local<v8::Name> name,
+      const v8::PropertyCallbackInfo<v8::Value>& info);
+
+  template <BaseObjectPtr<HistogramBase> StatsBase<T>::*member>
+  inline void InitHistogram(
+      Environment* env,
+      v8::Local<v8::Object> wrap,
+      v8::Local<v8::String> name,
+      QuicHistogramMode mode,
+      BaseObjectPtr<HistogramBase>* shared);
+
   BaseObjectPtr<HistogramBase> rate_;
   BaseObjectPtr<HistogramBase> size_;
   BaseObjectPtr<HistogramBase> ack_;
@@ -258,6 +343,12 @@ struct QuicError {
 // the given socket address.
 inline size_t GetMaxPktLen(const SocketAddress& addr);
 
+// Path MTU discovery searches for packet lengths up to the UDP
+// payload of a jumbo Ethernet frame, starting with that of a
+// standard Ethernet frame, which most paths carry.
+inline size_t GetMaxPathMtu(const SocketAddress& addr);
+inline size_t GetPathMtuHint(const SocketAddress& addr);
+
 // QuicPath is a utility class that wraps ngtcp2_path to adapt
 // it to work with SocketAddress
 struct QuicPath : public ngtcp2_path {
@@ -270,6 +361,118 @@ struct QuicPathStorage : public ngtcp2_path_storage {
   }
 };
 
+// Packetization layer path MTU discovery, after RFC 8899. Packets
+// start out at a length every path is assumed to carry (the base).
+// Once the handshake is confirmed, padded probe packets of larger
+// lengths are sent alongside the regular traffic. An acknowledged
+// probe raises the packet length, and a length that has been probed
+// kMaxProbes times without an acknowledgement bounds a binary search
+// between the two. The search is repeated every kRaiseInterval in
+// case the path has changed. If the path stops delivering packets of
+// the discovered length (a black hole), the length falls back to the
+// base. Lengths are those of the UDP payload and all times are in
+// nanoseconds.
+class QuicPathMtuDiscovery final : public MemoryRetainer {
+ public:
+  static constexpr size_t kMaxProbes = 3;
+  // The search ends once the packet length is within this many
+  // bytes of the smallest length known not to be delivered.
+  static constexpr size_t kSearchGranularity = 16;
+  static constexpr uint64_t kRaiseInterval = 600000000000;  // 10 minutes
+  // The number of consecutive probe timeouts (PTO) after which
+  // the path is considered a black hole.
+  static constexpr size_t kBlackHoleTimeouts = 2;
+
+  // Starts a new search, for a new path. max is the largest length
+  // to search for, and hint a length that is probed first because
+  // it is likely to be delivered.
+  void Reset(size_t base, size_t max, size_t hint);
+
+  // Returns the length of the probe to send, or 0 if no probe is to
+  // be sent now. A probe that has not been acknowledged within
+  // timeout is considered lost.
+  size_t NextProbe(uint64_t now, uint64_t timeout);
+
+  void OnProbeSent(size_t length, uint64_t now);
+
+  // Returns true if the packet length has been raised.
+  bool OnProbeAcked(size_t length);
+
+  // Called when packets of the current length appear to no
+  // longer be delivered.
+  void OnBlackHole();
+
+  size_t base() const { return base_; }
+  size_t packet_length() const { return packet_length_; }
+  bool is_searching() const { return searching_; }
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(QuicPathMtuDiscovery)
+  SET_SELF_SIZE(QuicPathMtuDiscovery)
+
+ private:
+  size_t base_ = 0;
+  size_t max_ = 0;
+  size_t hint_ = 0;
+  size_t packet_length_ = 0;
+  // The smallest length known not to be delivered,
+  // or max_ + 1 if there is none.
+  size_t ceiling_ = 0;
+  // The length of the outstanding probe, or 0 if there is none.
+  size_t probe_ = 0;
+  size_t probe_count_ = 0;
+  uint64_t probe_sent_at_ = 0;
+  bool searching_ = false;
+  uint64_t search_done_at_ = 0;
+};
+
+// Spreads the packets sent by a QuicSession over time rather than
+// sending everything the congestion window allows in one burst.
+// Credit accrues at the pacing rate, which is given by the congestion
+// controller or derived from the congestion window and the smoothed
+// RTT, and is capped at max_burst full size packets.
+class QuicPacer final : public MemoryRetainer {
+ public:
+  // Pace slightly faster than cwnd / smoothed_rtt so that the
+  // pacer does not itself limit the congestion window.
+  static constexpr double kGain = 1.25;
+
+  explicit QuicPacer(size_t max_burst = DEFAULT_MAX_PACING_BURST)
+      : max_burst_(max_burst) {}
+
+  // Accrues credit for the time elapsed since the previous update.
+  // rate is in bytes per nanosecond, or 0 if packets are not to
+  // be paced.
+  inline void Update(uint64_t now, double rate, size_t packet_length);
+
+  inline void OnPacketSent(size_t length);
+
+  // The number of full size packets that may be sent now.
+  inline size_t budget() const;
+
+  // The number of nanoseconds until another full
+  // size packet may be sent.
+  inline uint64_t delay() const;
+
+  size_t max_burst() const { return max_burst_; }
+  double rate() const { return rate_; }
+
+  void set_max_burst(size_t max_burst) {
+    max_burst_ = std::max(max_burst, size_t{1});
+  }
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(QuicPacer)
+  SET_SELF_SIZE(QuicPacer)
+
+ private:
+  size_t max_burst_;
+  size_t packet_length_ = 0;
+  double rate_ = 0;  // Bytes per nanosecond, 0 if unknown.
+  double credit_ = 0;  // Bytes
+  uint64_t last_update_ = 0;
+};
+
 // Simple wrapper for ngtcp2_cid that handles hex encoding
 // CIDs are used to identify QuicSession instances and may
 // be between 0 and 20 bytes in length.
@@ -293,10 +496,6 @@ class QuicCID : public MemoryRetainer {
     ptr_ = ptr;
   }
 
-  struct Hash {
-    inline size_t operator()(const QuicCID& cid) const;
-  };
-
   inline bool operator==(const QuicCID& other) const;
   inline bool operator!=(const QuicCID& other) const;
   inline QuicCID& operator=(const QuicCID& cid);
@@ -330,45 +529,128 @@ class QuicCID : public MemoryRetainer {
   SET_MEMORY_INFO_NAME(QuicCID)
   SET_SELF_SIZE(QuicCID)
 
-  template <typename T>
-  using Map = std::unordered_map<QuicCID, T, QuicCID::Hash>;
-
  private:
   ngtcp2_cid cid_{};
   const ngtcp2_cid* ptr_;
 };
 
-// Simple timer wrapper that is used to implement the internals
-// for idle and retransmission timeouts. Call Update to start or
-// reset the timer; Stop to halt the timer.
-class Timer final : public MemoryRetainer {
+class QuicTimerWheel;
+
+// A millisecond resolution timer that is driven by a QuicTimerWheel
+// rather than by its own uv_timer_t. It is used to implement the
+// internals for the idle and retransmission timeouts of QuicSession
+// instances. Call Update to start or reset the timer; Stop to halt
+// the timer. Both are O(1).
+class QuicTimer final {
  public:
-  inline explicit Timer(Environment* env, std::function<void()> fn);
+  inline QuicTimer(QuicTimerWheel* wheel, std::function<void()> fn);
+  inline ~QuicTimer();
+
+  QuicTimer(const QuicTimer&) = delete;
+  QuicTimer& operator=(const QuicTimer&) = delete;
 
   // Stops the timer with the side effect of the timer no longer being usable.
-  // It will be cleaned up and the Timer object will be destroyed.
   inline void Stop();
 
-  // If the timer is not currently active, interval must be either 0 or greater.
-  // If the timer is already active, interval is ignored.
+  // Disarms the timer. Unlike Stop, the timer may be re-armed with Update.
+  inline void Cancel();
+
+  // Arms the timer to fire after interval milliseconds, and then every
+  // interval milliseconds after that until it is updated or stopped. If
+  // the timer is already active, the previous deadline is replaced.
   inline void Update(uint64_t interval);
 
-  static inline void Free(Timer* timer);
+  bool is_active() const { return !node_.IsEmpty(); }
+
+ private:
+  friend class QuicTimerWheel;
+
+  QuicTimerWheel* wheel_;
+  std::function<void()> fn_;
+  bool stopped_ = false;
+  uint64_t deadline_ = 0;
+  uint64_t interval_ = 0;
+  // Links the timer into its slot of the wheel while it is active.
+  ListNode<QuicTimer> node_;
+  // Links the timer into the wheel's list of all of its timers, so
+  // that the wheel can detach them when it is freed.
+  ListNode<QuicTimer> wheel_node_;
+};
+
+// A hierarchical timing wheel that multiplexes any number of QuicTimer
+// instances on a single uv_timer_t. Each QuicSocket owns one wheel that
+// is shared by all of its QuicSessions, so that re-arming a session
+// deadline is a list splice rather than an update of libuv's timer heap.
+//
+// There are kLevels levels of kSlots slots each. Level n slots are
+// kSlots^n milliseconds wide; timers are moved down a level as the
+// wheel reaches their slot until they land in, and fire from, level 0.
+// Deadlines beyond the range of the wheel are parked in the last level
+// and re-inserted when that slot is reached.
+class QuicTimerWheel final : public MemoryRetainer {
+ public:
+  static constexpr size_t kSlotBits = 6;
+  static constexpr size_t kSlots = 1 << kSlotBits;
+  static constexpr size_t kLevels = 4;
+
+  explicit QuicTimerWheel(Environment* env);
+
+  QuicTimerWheel(const QuicTimerWheel&) = delete;
+  QuicTimerWheel& operator=(const QuicTimerWheel&) = delete;
+
+  // Detaches all remaining timers, active or not, which become inert,
+  // then closes the uv_timer_t and deletes the wheel once libuv is
+  // done with it.
+  static void Free(QuicTimerWheel* wheel);
+
+  size_t timer_count() const { return timer_count_; }
 
   SET_NO_MEMORY_INFO()
-  SET_MEMORY_INFO_NAME(Timer)
-  SET_SELF_SIZE(Timer)
+  SET_MEMORY_INFO_NAME(QuicTimerWheel)
+  SET_SELF_SIZE(QuicTimerWheel)
 
  private:
-  static inline void OnTimeout(uv_timer_t* timer);
+  using Slot = ListHead<QuicTimer, &QuicTimer::node_>;
+  static constexpr uint64_t kNoDeadline = std::numeric_limits<uint64_t>::max();
+
+  inline uint64_t now() const;
+
+  // Places the timer in the slot covering its deadline and, if that
+  // slot is due before the uv_timer_t would next fire, re-arms it.
+  void Insert(QuicTimer* timer);
+  inline void Remove(QuicTimer* timer);
+
+  // Processes every slot that is due at or before now, cascading
+  // timers down the levels and invoking those that have expired.
+  void Advance(uint64_t now);
+
+  // Returns the next time at which a non-empty slot is due, or
+  // kNoDeadline if the wheel is empty.
+  uint64_t NextDeadline();
+
+  // Re-arms the uv_timer_t to fire at the given time.
+  void Arm(uint64_t due);
+
+  // Re-arms the uv_timer_t for the next non-empty slot, if any.
+  void Schedule();
+
+  static void OnTimeout(uv_timer_t* timer);
 
-  bool stopped_ = false;
   Environment* env_;
-  std::function<void()> fn_;
   uv_timer_t timer_;
+  uint64_t current_;
+  uint64_t armed_ = kNoDeadline;
+  size_t timer_count_ = 0;
+  bool advancing_ = false;
+  bool closed_ = false;
+  uint64_t occupied_[kLevels] = {};
+  Slot slots_[kLevels][kSlots];
+  ListHead<QuicTimer, &QuicTimer::wheel_node_> timers_;
+
+  friend class QuicTimer;
 };
 
-using TimerPointer = DeleteFnPtr<Timer, Timer::Free>;
+using QuicTimerWheelPointer = DeleteFnPtr<QuicTimerWheel, QuicTimerWheel::Free>;
 
 // A Stateless Reset Token is a mechanism by which a QUIC
 // endpoint can discreetly signal to a peer that it has
@@ -394,10 +676,6 @@ class StatelessResetToken : public MemoryRetainer {
 
   const uint8_t* data() const { return token_; }
 
-  struct Hash {
-    inline size_t operator()(const StatelessResetToken& token) const;
-  };
-
   inline bool operator==(const StatelessResetToken& other) const;
   inline bool operator!=(const StatelessResetToken& other) const;
 
@@ -405,18 +683,168 @@ class StatelessResetToken : public MemoryRetainer {
   SET_MEMORY_INFO_NAME(StatelessResetToken)
   SET_SELF_SIZE(StatelessResetToken)
 
-  template <typename T>
-  using Map =
-      std::unordered_map<
-          StatelessResetToken,
-          BaseObjectPtr<T>,
-          StatelessResetToken::Hash>;
-
  private:
   uint8_t buf_[NGTCP2_STATELESS_RESET_TOKENLEN]{};
   const uint8_t* token_;
 };
 
+// Computes SipHash-1-3 of the given bytes under a 128-bit key.
+inline uint64_t QuicSipHash(
+    const uint64_t key[2],
+    const uint8_t* data,
+    size_t len);
+
+// A QuicRoutingTable maps connection IDs and stateless reset tokens
+// to values. The QuicSocket consults it for every packet it receives,
+// so it is kept as a single flat array searched by linear probing,
+// and each entry caches the full hash of its key so that most
+// mismatches are rejected without comparing key bytes. Keys are
+// hashed with SipHash under a random per-table key so that a peer
+// choosing connection IDs cannot predict which of them will collide.
+template <typename T>
+class QuicRoutingTable final : public MemoryRetainer {
+ public:
+  static constexpr size_t kMaxKeyLen = NGTCP2_MAX_CIDLEN;
+  static constexpr size_t kHashKeyLen = 16;
+  static constexpr size_t kMinCapacity = 16;
+
+  // Creates a table hashed with a randomly generated key.
+  inline QuicRoutingTable();
+
+  // Creates a table hashed with the given kHashKeyLen byte key.
+  explicit inline QuicRoutingTable(const uint8_t* hash_key);
+
+  // Returns nullptr if there is no entry for the key.
+  inline T* Find(const QuicCID& cid);
+  inline T* Find(const StatelessResetToken& token);
+
+  // Adds an entry for the key, replacing any existing entry. The
+  // value is taken by value because it may refer to an entry of the
+  // table itself, which would not survive the table being resized.
+  inline void Insert(const QuicCID& cid, T value);
+  inline void Insert(const StatelessResetToken& token, T value);
+
+  // Returns false if there was no entry for the key.
+  inline bool Erase(const QuicCID& cid);
+  inline bool Erase(const StatelessResetToken& token);
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return entries_.size(); }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackFieldWithSize("entries", capacity() * sizeof(Entry));
+  }
+  SET_MEMORY_INFO_NAME(QuicRoutingTable)
+  SET_SELF_SIZE(QuicRoutingTable)
+
+ private:
+  struct Entry {
+    uint64_t hash = 0;
+    bool used = false;
+    uint8_t len = 0;
+    uint8_t key[kMaxKeyLen];
+    T value;
+  };
+
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  inline size_t Lookup(const uint8_t* key, size_t len, uint64_t hash) const;
+  inline T* Find(const uint8_t* key, size_t len);
+  inline void Insert(const uint8_t* key, size_t len, T value);
+  inline bool Erase(const uint8_t* key, size_t len);
+  inline void Resize(size_t capacity);
+
+  uint64_t hash_key_[2];
+  std::vector<Entry> entries_;
+  size_t size_ = 0;
+};
+
+// Computes a keyed hash of the IP address and port of addr.
+inline uint64_t QuicAddressHash(
+    const uint64_t key[2],
+    const SocketAddress& addr);
+
+// A QuicAddressCounter approximately counts events per remote address
+// in a fixed amount of memory, no matter how many distinct addresses
+// it sees. It is a count-min sketch: each address maps to one counter
+// in each of kDepth rows, and its count is the smallest of those
+// counters. A count may be overestimated when addresses share
+// counters but is never underestimated. Addresses are hashed with a
+// random per-instance key so that a peer cannot pick addresses whose
+// counters collide with those of another peer.
+//
+// When a decay interval is given, all counts are halved once per
+// interval so that old events are gradually forgotten.
+class QuicAddressCounter final : public MemoryRetainer {
+ public:
+  static constexpr size_t kDepth = 4;
+
+  // width is the number of counters in each row, and is rounded up
+  // to a power of two. decay_interval is in nanoseconds.
+  inline explicit QuicAddressCounter(
+      size_t width,
+      uint64_t decay_interval = 0);
+
+  inline void Increment(const SocketAddress& addr);
+
+  // Must only be called for an address that has been incremented
+  // at least as many times.
+  inline void Decrement(const SocketAddress& addr);
+
+  inline size_t Get(const SocketAddress& addr);
+
+  size_t width() const { return mask_ + 1; }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackFieldWithSize(
+        "counters",
+        counters_.size() * sizeof(uint32_t));
+  }
+  SET_MEMORY_INFO_NAME(QuicAddressCounter)
+  SET_SELF_SIZE(QuicAddressCounter)
+
+ private:
+  inline void Slots(const SocketAddress& addr, size_t slots[kDepth]) const;
+  inline void MaybeDecay();
+
+  uint64_t hash_key_[2];
+  size_t mask_;
+  uint64_t decay_interval_;
+  uint64_t decayed_at_;
+  std::vector<uint32_t> counters_;
+};
+
+// A QuicAddressLRU remembers up to capacity of the most recently
+// inserted addresses and tells in constant time whether an address is
+// among them. Only a keyed hash of each address is stored.
+class QuicAddressLRU final : public MemoryRetainer {
+ public:
+  inline explicit QuicAddressLRU(size_t capacity);
+
+  inline void Insert(const SocketAddress& addr);
+
+  inline bool Contains(const SocketAddress& addr) const;
+
+  size_t size() const { return order_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    // Each entry is stored once in the list and once in the index.
+    tracker->TrackFieldWithSize(
+        "entries",
+        size() * (sizeof(uint64_t) * 2 + sizeof(void*) * 4));
+  }
+  SET_MEMORY_INFO_NAME(QuicAddressLRU)
+  SET_SELF_SIZE(QuicAddressLRU)
+
+ private:
+  uint64_t hash_key_[2];
+  size_t capacity_;
+  // The most recently inserted hash is at the front.
+  std::list<uint64_t> order_;
+  std::unordered_map<uint64_t, std::list<uint64_t>::iterator> index_;
+};
+
 template <typename T>
 inline size_t get_length(const T*, size_t len);
 
@@ -27,6 +27,17 @@
 #include "req_wrap-inl.h"
 #include "util-inl.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <netinet/udp.h>
+#endif
+
 namespace node {
 
 using v8::Array;
@@ -98,6 +109,16 @@ void UDPWrapBase::set_listener(UDPListener* listener) {
   }
 }
 
+ssize_t UDPWrapBase::TrySendBatch(uv_buf_t* bufs,
+                                  size_t nbufs,
+                                  const sockaddr* addr) {
+  return 0;
+}
+
+int UDPWrapBase::SetDontFragment() {
+  return UV_ENOTSUP;
+}
+
 UDPWrapBase* UDPWrapBase::FromObject(Local<Object> obj) {
   CHECK_GT(obj->InternalFieldCount(), UDPWrapBase::kUDPWrapBaseField);
   return static_cast<UDPWrapBase*>(
@@ -109,7 +130,7 @@ void UDPWrapBase::AddMethods(Environment* env, Local<FunctionTemplate> t) {
   env->SetProtoMethod(t, "recvStop", RecvStop);
 }
 
-UDPWrap::UDPWrap(Environment* env, Local<Object> object)
+UDPWrap::UDPWrap(Environment* env, Local<Object> object, unsigned int flags)
     : HandleWrap(env,
                  object,
                  reinterpret_cast<uv_handle_t*>(&handle_),
@@ -117,7 +138,11 @@ UDPWrap::UDPWrap(Environment* env, Local<Object> object)
   object->SetAlignedPointerInInternalField(
       UDPWrapBase::kUDPWrapBaseField, static_cast<UDPWrapBase*>(this));
 
-  int r = uv_udp_init(env->event_loop(), &handle_);
+#ifdef _WIN32
+  // recvmmsg() is not available on Windows.
+  flags &= ~UV_UDP_RECVMMSG;
+#endif
+  int r = uv_udp_init_ex(env->event_loop(), &handle_, AF_UNSPEC | flags);
   CHECK_EQ(r, 0);  // can't fail anyway
 
   set_listener(this);
@@ -201,6 +226,10 @@ void UDPWrap::Initialize(Local<Object> target,
   Local<Object> constants = Object::New(env->isolate());
   NODE_DEFINE_CONSTANT(constants, UV_UDP_IPV6ONLY);
   NODE_DEFINE_CONSTANT(constants, UV_UDP_REUSEADDR);
+  NODE_DEFINE_CONSTANT(constants, UV_UDP_RECVMMSG);
+  constants->Set(context,
+                 FIXED_ONE_BYTE_STRING(env->isolate(), "UDP_REUSEPORT"),
+                 Integer::NewFromUnsigned(env->isolate(), kReusePort)).Check();
   target->Set(context,
               env->constants_string(),
               constants).Check();
@@ -210,7 +239,10 @@ void UDPWrap::Initialize(Local<Object> target,
 void UDPWrap::New(const FunctionCallbackInfo<Value>& args) {
   CHECK(args.IsConstructCall());
   Environment* env = Environment::GetCurrent(args);
-  new UDPWrap(env, args.This());
+  unsigned int flags = 0;
+  if (args[0]->IsUint32())
+    flags = args[0].As<Uint32>()->Value() & UV_UDP_RECVMMSG;
+  new UDPWrap(env, args.This(), flags);
 }
 
 
@@ -255,6 +287,10 @@ void UDPWrap::DoBind(const FunctionCallbackInfo<Value>& args, int family) {
     return;
   struct sockaddr_storage addr_storage;
   int err = sockaddr_for_family(family, address.out(), port, &addr_storage);
+  if (err == 0 && (flags & kReusePort)) {
+    flags &= ~kReusePort;
+    err = wrap->OpenReusePort(family);
+  }
   if (err == 0) {
     err = uv_udp_bind(&wrap->handle_,
                       reinterpret_cast<const sockaddr*>(&addr_storage),
@@ -268,6 +304,32 @@ void UDPWrap::DoBind(const FunctionCallbackInfo<Value>& args, int family) {
 }
 
 
+// libuv only offers SO_REUSEADDR, which on Linux does not spread
+// datagrams across the sockets sharing a port, so the socket is
+// created here with SO_REUSEPORT set and handed to libuv, which
+// then binds it like any other socket.
+int UDPWrap::OpenReusePort(int family) {
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+  int fd = ::socket(family, SOCK_DGRAM, 0);
+  if (fd == -1)
+    return uv_translate_sys_error(errno);
+  int on = 1;
+  int err = 0;
+  if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1 ||
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1) {
+    err = uv_translate_sys_error(errno);
+  }
+  if (err == 0)
+    err = uv_udp_open(&handle_, fd);
+  if (err != 0)
+    ::close(fd);
+  return err;
+#else
+  return UV_ENOTSUP;
+#endif
+}
+
+
 void UDPWrap::DoConnect(const FunctionCallbackInfo<Value>& args, int family) {
   UDPWrap* wrap;
   ASSIGN_OR_RETURN_UNWRAP(&wrap,
@@ -585,6 +647,20 @@ ssize_t UDPWrap::Send(uv_buf_t* bufs_ptr,
   }
 
   if (err == 0) {
+    uv_udp_send_t* native_req = listener()->CreateNativeSendReq(msg_size);
+    if (native_req != nullptr) {
+      return uv_udp_send(
+          native_req,
+          &handle_,
+          bufs_ptr,
+          count,
+          addr,
+          [](uv_udp_send_t* req, int status) {
+            UDPWrap* self = ContainerOf(&UDPWrap::handle_, req->handle);
+            self->listener()->OnNativeSendDone(req, status);
+          });
+    }
+
     AsyncHooks::DefaultTriggerAsyncIdScope trigger_scope(this);
     ReqWrap<uv_udp_send_t>* req_wrap = listener()->CreateSendWrap(msg_size);
     if (req_wrap == nullptr) return UV_ENOSYS;
@@ -607,6 +683,210 @@ ssize_t UDPWrap::Send(uv_buf_t* bufs_ptr,
   return err;
 }
 
+#ifdef __linux__
+namespace {
+// Upper bound on the number of datagrams passed to the kernel at once.
+// This matches the number of segments accepted by a single UDP GSO send.
+constexpr size_t kMaxBatchDatagrams = 64;
+
+// The total payload of a single UDP GSO send must fit within one IP packet.
+// Leave room for the IPv6 and UDP headers.
+constexpr size_t kMaxGSOBytes = 65535 - 40 - 8;
+
+inline socklen_t SockaddrLength(const sockaddr* addr) {
+  if (addr == nullptr)
+    return 0;
+  return addr->sa_family == AF_INET6 ?
+      sizeof(sockaddr_in6) :
+      sizeof(sockaddr_in);
+}
+
+// Returns the number of leading datagrams that can be coalesced into a
+// single UDP GSO send. Every segment must have the same size, except for
+// the last one which is permitted to be shorter.
+size_t CountGSOSegments(const uv_buf_t* bufs, size_t nbufs) {
+#ifdef UDP_SEGMENT
+  if (nbufs < 2 || bufs[0].len == 0)
+    return 0;
+  const size_t segment_size = bufs[0].len;
+  size_t total = segment_size;
+  size_t count = 1;
+  while (count < nbufs && count < kMaxBatchDatagrams) {
+    const size_t len = bufs[count].len;
+    if (len == 0 || len > segment_size || total + len > kMaxGSOBytes)
+      break;
+    total += len;
+    count++;
+    if (len < segment_size)
+      break;
+  }
+  return count > 1 ? count : 0;
+#else
+  return 0;
+#endif
+}
+
+// Sends nbufs datagrams, all but the last of which share the same size,
+// using a single sendmsg() call with the UDP_SEGMENT control message.
+// Returns nbufs on success, or a negative libuv error code.
+ssize_t SendGSO(int fd,
+                const uv_buf_t* bufs,
+                size_t nbufs,
+                const sockaddr* addr) {
+#ifdef UDP_SEGMENT
+  iovec iov[kMaxBatchDatagrams];
+  CHECK_LE(nbufs, kMaxBatchDatagrams);
+  for (size_t n = 0; n < nbufs; n++) {
+    iov[n].iov_base = bufs[n].base;
+    iov[n].iov_len = bufs[n].len;
+  }
+
+  char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+  msghdr msg = {};
+  msg.msg_name = const_cast<sockaddr*>(addr);
+  msg.msg_namelen = SockaddrLength(addr);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = nbufs;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+  cm->cmsg_level = SOL_UDP;
+  cm->cmsg_type = UDP_SEGMENT;
+  cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  uint16_t segment_size = static_cast<uint16_t>(bufs[0].len);
+  memcpy(CMSG_DATA(cm), &segment_size, sizeof(segment_size));
+
+  ssize_t ret;
+  do {
+    ret = sendmsg(fd, &msg, 0);
+  } while (ret == -1 && errno == EINTR);
+
+  if (ret == -1)
+    return uv_translate_sys_error(errno);
+  return nbufs;
+#else
+  return UV_ENOTSUP;
+#endif
+}
+
+// Sends up to nbufs datagrams using a single sendmmsg() call. Returns the
+// number of datagrams that were sent, or a negative libuv error code.
+ssize_t SendMultiple(int fd,
+                     const uv_buf_t* bufs,
+                     size_t nbufs,
+                     const sockaddr* addr) {
+  iovec iov[kMaxBatchDatagrams];
+  mmsghdr msgs[kMaxBatchDatagrams];
+  nbufs = std::min(nbufs, kMaxBatchDatagrams);
+  for (size_t n = 0; n < nbufs; n++) {
+    iov[n].iov_base = bufs[n].base;
+    iov[n].iov_len = bufs[n].len;
+    memset(&msgs[n], 0, sizeof(msgs[n]));
+    msgs[n].msg_hdr.msg_name = const_cast<sockaddr*>(addr);
+    msgs[n].msg_hdr.msg_namelen = SockaddrLength(addr);
+    msgs[n].msg_hdr.msg_iov = &iov[n];
+    msgs[n].msg_hdr.msg_iovlen = 1;
+  }
+
+  int ret;
+  do {
+    ret = sendmmsg(fd, msgs, nbufs, 0);
+  } while (ret == -1 && errno == EINTR);
+
+  if (ret == -1)
+    return uv_translate_sys_error(errno);
+  return ret;
+}
+}  // namespace
+#endif  // __linux__
+
+ssize_t UDPWrap::TrySendBatch(uv_buf_t* bufs,
+                              size_t nbufs,
+                              const sockaddr* addr) {
+  if (IsHandleClosing()) return UV_EBADF;
+
+#ifdef __linux__
+  // Datagrams already queued inside libuv have to be written first, otherwise
+  // the batch would overtake them.
+  if (UNLIKELY(env()->options()->test_udp_no_try_send) ||
+      uv_udp_get_send_queue_count(&handle_) > 0) {
+    return 0;
+  }
+
+  uv_os_fd_t fd;
+  if (uv_fileno(reinterpret_cast<uv_handle_t*>(&handle_), &fd) != 0)
+    return 0;
+
+  size_t sent = 0;
+  while (sent < nbufs) {
+    ssize_t ret;
+    size_t segments =
+        gso_disabled_ ? 0 : CountGSOSegments(bufs + sent, nbufs - sent);
+    if (segments > 0) {
+      ret = SendGSO(fd, bufs + sent, segments, addr);
+      // The kernel or the network device does not support UDP GSO
+      // for this socket. Fall back to sendmmsg() from now on.
+      if (ret == UV_EINVAL || ret == UV_EIO || ret == UV_ENOTSUP ||
+          ret == UV_ENOPROTOOPT) {
+        gso_disabled_ = true;
+        continue;
+      }
+    } else {
+      ret = SendMultiple(fd, bufs + sent, nbufs - sent, addr);
+    }
+
+    if (ret < 0) {
+      // Whatever could not be written is left for the caller to send
+      // using the regular, possibly asynchronous, Send() path.
+      if (sent > 0 || ret == UV_EAGAIN || ret == UV_ENOBUFS)
+        break;
+      return ret;
+    }
+    sent += ret;
+  }
+  return sent;
+#else
+  return 0;
+#endif  // __linux__
+}
+
+// libuv has no option for the DF bit. On Linux, the PROBE modes
+// set DF without limiting datagrams to the path MTU cached by the
+// kernel, which would otherwise defeat probing for a larger one.
+int UDPWrap::SetDontFragment() {
+#ifndef _WIN32
+  uv_os_fd_t fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(&handle_), &fd);
+  if (err != 0)
+    return err;
+  int ret = -1;
+  if (GetSockName().family() == AF_INET6) {
+#if defined(IPV6_MTU_DISCOVER) && defined(IPV6_PMTUDISC_PROBE)
+    int val = IPV6_PMTUDISC_PROBE;
+    ret = setsockopt(fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &val, sizeof(val));
+#elif defined(IPV6_DONTFRAG)
+    int val = 1;
+    ret = setsockopt(fd, IPPROTO_IPV6, IPV6_DONTFRAG, &val, sizeof(val));
+#else
+    return UV_ENOTSUP;
+#endif
+  } else {
+#if defined(IP_MTU_DISCOVER) && defined(IP_PMTUDISC_PROBE)
+    int val = IP_PMTUDISC_PROBE;
+    ret = setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, &val, sizeof(val));
+#elif defined(IP_DONTFRAG)
+    int val = 1;
+    ret = setsockopt(fd, IPPROTO_IP, IP_DONTFRAG, &val, sizeof(val));
+#else
+    return UV_ENOTSUP;
+#endif
+  }
+  return ret == 0 ? 0 : uv_translate_sys_error(errno);
+#else
+  return UV_ENOTSUP;
+#endif  // _WIN32
+}
 
 ReqWrap<uv_udp_send_t>* UDPWrap::CreateSendWrap(size_t msg_size) {
   SendWrap* req_wrap = new SendWrap(env(),
@@ -63,6 +63,17 @@ class UDPListener {
   // error code.
   virtual void OnSendDone(ReqWrap<uv_udp_send_t>* wrap, int status) = 0;
 
+  // Optional fast path for listeners whose send requests are never exposed
+  // to JavaScript. If this returns a non-null request, it is passed to
+  // libuv directly instead of calling CreateSendWrap(), and completion is
+  // reported through OnNativeSendDone(). If the send cannot be dispatched,
+  // the request remains owned by the listener.
+  virtual uv_udp_send_t* CreateNativeSendReq(size_t msg_size) {
+    return nullptr;
+  }
+
+  virtual void OnNativeSendDone(uv_udp_send_t* req, int status) {}
+
   // Optional callback that is called after the socket has been bound.
   virtual void OnAfterBind() {}
 
@@ -96,6 +107,21 @@ class UDPWrapBase {
                        size_t nbufs,
                        const sockaddr* addr) = 0;
 
+  // Attempt to synchronously send several datagrams to the same destination
+  // using as few system calls as the platform allows. Unlike Send(), each
+  // entry in `bufs` is a complete datagram. Returns the number of leading
+  // datagrams that were sent; the caller is responsible for sending the rest
+  // using Send(). The default implementation does not send anything.
+  virtual ssize_t TrySendBatch(uv_buf_t* bufs,
+                               size_t nbufs,
+                               const sockaddr* addr);
+
+  // Prevent datagrams sent from this socket from being fragmented, so
+  // that those larger than the path carries are dropped instead. Must
+  // be called after binding. Returns 0 or a libuv error code; the
+  // default implementation returns UV_ENOTSUP.
+  virtual int SetDontFragment();
+
   virtual SocketAddress GetPeerName() = 0;
   virtual SocketAddress GetSockName() = 0;
 
@@ -122,6 +148,14 @@ class UDPWrap final : public HandleWrap,
   enum SocketType {
     SOCKET
   };
+
+  // A bind() flag that is handled by UDPWrap rather than libuv. When
+  // set, the socket is created with SO_REUSEPORT before it is bound,
+  // so that several sockets -- typically in different processes --
+  // can bind to the same address and port and have the kernel
+  // distribute incoming datagrams among them. Binding fails with
+  // UV_ENOTSUP where SO_REUSEPORT is not available.
+  static constexpr unsigned int kReusePort = 1 << 16;
   static void Initialize(v8::Local<v8::Object> target,
                          v8::Local<v8::Value> unused,
                          v8::Local<v8::Context> context,
@@ -166,6 +200,10 @@ class UDPWrap final : public HandleWrap,
   ssize_t Send(uv_buf_t* bufs,
                size_t nbufs,
                const sockaddr* addr) override;
+  ssize_t TrySendBatch(uv_buf_t* bufs,
+                       size_t nbufs,
+                       const sockaddr* addr) override;
+  int SetDontFragment() override;
 
   SocketAddress GetPeerName() override;
   SocketAddress GetSockName() override;
@@ -186,10 +224,13 @@ class UDPWrap final : public HandleWrap,
             int (*F)(const typename T::HandleType*, sockaddr*, int*)>
   friend void GetSockOrPeerName(const v8::FunctionCallbackInfo<v8::Value>&);
 
-  UDPWrap(Environment* env, v8::Local<v8::Object> object);
+  UDPWrap(Environment* env,
+          v8::Local<v8::Object> object,
+          unsigned int flags = 0);
 
   static void DoBind(const v8::FunctionCallbackInfo<v8::Value>& args,
                      int family);
+  int OpenReusePort(int family);
   static void DoConnect(const v8::FunctionCallbackInfo<v8::Value>& args,
                      int family);
   static void DoSend(const v8::FunctionCallbackInfo<v8::Value>& args,
@@ -211,6 +252,10 @@ class UDPWrap final : public HandleWrap,
 
   uv_udp_t handle_;
 
+  // Set once the kernel rejects a UDP_SEGMENT send so that TrySendBatch()
+  // falls back to sendmmsg() for the remaining lifetime of the socket.
+  bool gso_disabled_ = false;
+
   bool current_send_has_callback_;
   v8::Local<v8::Object> current_send_req_wrap_;
 };
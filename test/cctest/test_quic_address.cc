@@ -0,0 +1,91 @@
+#include "quic/node_quic_util-inl.h"
+#include "node_sockaddr-inl.h"
+#include "util-inl.h"
+#include "gtest/gtest.h"
+
+using node::SocketAddress;
+using node::quic::QuicAddressCounter;
+using node::quic::QuicAddressLRU;
+
+namespace {
+SocketAddress MakeAddress(
+    const char* host,
+    uint16_t port,
+    int family = AF_INET) {
+  sockaddr_storage storage;
+  CHECK(SocketAddress::ToSockAddr(family, host, port, &storage));
+  return SocketAddress(reinterpret_cast<const sockaddr*>(&storage));
+}
+}  // namespace
+
+TEST(QuicAddressCounter, Simple) {
+  QuicAddressCounter counter(100);
+  CHECK_EQ(counter.width(), 128);
+
+  SocketAddress addr1 = MakeAddress("123.123.123.123", 443);
+  SocketAddress addr2 = MakeAddress("1.1.1.1", 443);
+  SocketAddress addr3 = MakeAddress("::1", 443, AF_INET6);
+
+  CHECK_EQ(counter.Get(addr1), 0);
+  counter.Increment(addr1);
+  counter.Increment(addr1);
+  counter.Increment(addr3);
+  CHECK_EQ(counter.Get(addr1), 2);
+  CHECK_EQ(counter.Get(addr2), 0);
+  CHECK_EQ(counter.Get(addr3), 1);
+
+  counter.Decrement(addr1);
+  CHECK_EQ(counter.Get(addr1), 1);
+  counter.Decrement(addr1);
+  counter.Decrement(addr3);
+  CHECK_EQ(counter.Get(addr1), 0);
+  CHECK_EQ(counter.Get(addr3), 0);
+}
+
+TEST(QuicAddressCounter, NeverUnderestimates) {
+  // Far more addresses than counters, so that most of them share
+  // counters with other addresses.
+  QuicAddressCounter counter(16);
+  for (uint16_t port = 1; port <= 1000; port++) {
+    SocketAddress addr = MakeAddress("10.0.0.1", port);
+    for (uint16_t n = 0; n < port % 4; n++)
+      counter.Increment(addr);
+  }
+  for (uint16_t port = 1; port <= 1000; port++) {
+    SocketAddress addr = MakeAddress("10.0.0.1", port);
+    CHECK_GE(counter.Get(addr), port % 4);
+  }
+}
+
+TEST(QuicAddressLRU, Simple) {
+  QuicAddressLRU lru(3);
+  CHECK_EQ(lru.capacity(), 3);
+
+  SocketAddress addr1 = MakeAddress("10.0.0.1", 1);
+  SocketAddress addr2 = MakeAddress("10.0.0.2", 1);
+  SocketAddress addr3 = MakeAddress("10.0.0.3", 1);
+  SocketAddress addr4 = MakeAddress("10.0.0.4", 1);
+
+  CHECK(!lru.Contains(addr1));
+  lru.Insert(addr1);
+  lru.Insert(addr2);
+  lru.Insert(addr3);
+  CHECK_EQ(lru.size(), 3);
+  CHECK(lru.Contains(addr1));
+  CHECK(lru.Contains(addr2));
+  CHECK(lru.Contains(addr3));
+
+  // Inserting a known address makes it the most recent one, so the
+  // next insertion evicts addr2 instead.
+  lru.Insert(addr1);
+  CHECK_EQ(lru.size(), 3);
+  lru.Insert(addr4);
+  CHECK_EQ(lru.size(), 3);
+  CHECK(lru.Contains(addr1));
+  CHECK(!lru.Contains(addr2));
+  CHECK(lru.Contains(addr3));
+  CHECK(lru.Contains(addr4));
+
+  // The port is part of the address.
+  CHECK(!lru.Contains(MakeAddress("10.0.0.1", 2)));
+}
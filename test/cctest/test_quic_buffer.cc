@@ -1,5 +1,6 @@
 #include "quic/node_quic_buffer-inl.h"
 #include "node_bob-inl.h"
+#include "node_test_fixture.h"
 #include "util-inl.h"
 #include "uv.h"
 
@@ -9,6 +10,8 @@
 
 using node::quic::QuicBuffer;
 using node::quic::QuicBufferChunk;
+using node::quic::QuicReceiveSlab;
+using node::quic::kMaxVectorCount;
 using node::bob::Status;
 using node::bob::Options;
 using node::bob::Done;
@@ -20,10 +23,14 @@ using ::testing::AssertionFailure;
       AssertionFailure() << actual << " is not equal to " << expected;
 }
 
+// Writes of up to QuicBuffer::kMaxCopyLength bytes are copied into
+// blocks. The tests of the zero-copy path use larger writes.
+constexpr size_t kLength = QuicBuffer::kMaxCopyLength + 100;
+constexpr size_t kQuarter = kLength / 4;
+
 TEST(QuicBuffer, Simple) {
-  char data[100];
-  memset(&data, 0, node::arraysize(data));
-  uv_buf_t buf = uv_buf_init(data, node::arraysize(data));
+  std::vector<char> data(kLength);
+  uv_buf_t buf = uv_buf_init(data.data(), data.size());
 
   bool done = false;
 
@@ -33,12 +40,12 @@ TEST(QuicBuffer, Simple) {
     done = true;
   });
 
-  buffer.Consume(100);
+  buffer.Consume(kLength);
   ASSERT_TRUE(IsEqual(buffer.length(), 0));
 
   // We have to move the read head forward in order to consume
   buffer.Seek(1);
-  buffer.Consume(100);
+  buffer.Consume(kLength);
   ASSERT_TRUE(done);
   ASSERT_TRUE(IsEqual(buffer.length(), 0));
 }
@@ -63,9 +70,11 @@ TEST(QuicBuffer, ConsumeMore) {
 }
 
 TEST(QuicBuffer, Multiple) {
+  std::vector<char> a(kLength / 2, 'a');
+  std::vector<char> b(kLength / 2, 'b');
   uv_buf_t bufs[] {
-    uv_buf_init(const_cast<char*>("abcdefghijklmnopqrstuvwxyz"), 26),
-    uv_buf_init(const_cast<char*>("zyxwvutsrqponmlkjihgfedcba"), 26)
+    uv_buf_init(a.data(), a.size()),
+    uv_buf_init(b.data(), b.size())
   };
 
   QuicBuffer buf;
@@ -73,27 +82,30 @@ TEST(QuicBuffer, Multiple) {
   buf.Push(bufs, 2, [&](int status) { done = true; });
 
   buf.Seek(2);
-  ASSERT_TRUE(IsEqual(buf.remaining(), 50));
-  ASSERT_TRUE(IsEqual(buf.length(), 52));
+  ASSERT_TRUE(IsEqual(buf.remaining(), kLength - 2));
+  ASSERT_TRUE(IsEqual(buf.length(), kLength));
 
-  buf.Consume(25);
-  ASSERT_TRUE(IsEqual(buf.length(), 27));
+  buf.Consume(kLength / 2 - 1);
+  ASSERT_TRUE(IsEqual(buf.length(), kLength / 2 + 1));
 
-  buf.Consume(25);
+  buf.Consume(kLength / 2 - 1);
   ASSERT_TRUE(IsEqual(buf.length(), 2));
+  ASSERT_FALSE(done);
 
+  buf.Seek(kLength);
   buf.Consume(2);
   ASSERT_TRUE(IsEqual(buf.length(), 0));
+  ASSERT_TRUE(done);
 }
 
 TEST(QuicBuffer, Multiple2) {
-  char* ptr = new char[100];
-  memset(ptr, 0, 50);
-  memset(ptr + 50, 1, 50);
+  char* ptr = new char[kLength];
+  memset(ptr, 0, kLength / 2);
+  memset(ptr + kLength / 2, 1, kLength / 2);
 
   uv_buf_t bufs[] = {
-    uv_buf_init(ptr, 50),
-    uv_buf_init(ptr + 50, 50)
+    uv_buf_init(ptr, kLength / 2),
+    uv_buf_init(ptr + kLength / 2, kLength / 2)
   };
 
   int count = 0;
@@ -106,15 +118,15 @@ TEST(QuicBuffer, Multiple2) {
     ASSERT_EQ(0, status);
     delete[] ptr;
   });
-  buffer.Seek(node::arraysize(bufs));
-
-  buffer.Consume(25);
-  ASSERT_TRUE(IsEqual(buffer.length(), 75));
-  buffer.Consume(25);
-  ASSERT_TRUE(IsEqual(buffer.length(), 50));
-  buffer.Consume(25);
-  ASSERT_TRUE(IsEqual(buffer.length(), 25));
-  buffer.Consume(25);
+  buffer.Seek(kLength);
+
+  buffer.Consume(kQuarter);
+  ASSERT_TRUE(IsEqual(buffer.length(), 3 * kQuarter));
+  buffer.Consume(kQuarter);
+  ASSERT_TRUE(IsEqual(buffer.length(), 2 * kQuarter));
+  buffer.Consume(kQuarter);
+  ASSERT_TRUE(IsEqual(buffer.length(), kQuarter));
+  buffer.Consume(kQuarter);
   ASSERT_TRUE(IsEqual(buffer.length(), 0));
 
   // The callback was only called once tho
@@ -122,13 +134,13 @@ TEST(QuicBuffer, Multiple2) {
 }
 
 TEST(QuicBuffer, Cancel) {
-  char* ptr = new char[100];
-  memset(ptr, 0, 50);
-  memset(ptr + 50, 1, 50);
+  char* ptr = new char[kLength];
+  memset(ptr, 0, kLength / 2);
+  memset(ptr + kLength / 2, 1, kLength / 2);
 
   uv_buf_t bufs[] = {
-    uv_buf_init(ptr, 50),
-    uv_buf_init(ptr + 50, 50)
+    uv_buf_init(ptr, kLength / 2),
+    uv_buf_init(ptr + kLength / 2, kLength / 2)
   };
 
   int count = 0;
@@ -142,9 +154,9 @@ TEST(QuicBuffer, Cancel) {
     delete[] ptr;
   });
 
-  buffer.Seek(1);
-  buffer.Consume(25);
-  ASSERT_TRUE(IsEqual(buffer.length(), 75));
+  buffer.Seek(kQuarter);
+  buffer.Consume(kQuarter);
+  ASSERT_TRUE(IsEqual(buffer.length(), 3 * kQuarter));
   buffer.Cancel();
   ASSERT_TRUE(IsEqual(buffer.length(), 0));
 
@@ -156,17 +168,16 @@ TEST(QuicBuffer, Move) {
   QuicBuffer buffer1;
   QuicBuffer buffer2;
 
-  char data[100];
-  memset(&data, 0, node::arraysize(data));
-  uv_buf_t buf = uv_buf_init(data, node::arraysize(data));
+  std::vector<char> data(kLength);
+  uv_buf_t buf = uv_buf_init(data.data(), data.size());
 
   buffer1.Push(&buf, 1);
 
-  ASSERT_TRUE(IsEqual(buffer1.length(), 100));
+  ASSERT_TRUE(IsEqual(buffer1.length(), kLength));
 
   buffer2 = std::move(buffer1);
   ASSERT_TRUE(IsEqual(buffer1.length(), 0));
-  ASSERT_TRUE(IsEqual(buffer2.length(), 100));
+  ASSERT_TRUE(IsEqual(buffer2.length(), kLength));
 }
 
 TEST(QuicBuffer, QuicBufferChunk) {
@@ -204,3 +215,280 @@ TEST(QuicBuffer, QuicBufferChunk) {
   buffer.Consume(50);
   ASSERT_TRUE(IsEqual(buffer.length(), 0));
 }
+
+TEST(QuicBuffer, CoalescesSmallWrites) {
+  QuicBuffer buffer;
+  std::vector<int> done;
+  char data[10];
+  for (int n = 0; n < 100; n++) {
+    memset(data, n, sizeof(data));
+    uv_buf_t buf = uv_buf_init(data, sizeof(data));
+    buffer.Push(&buf, 1, [&done, n](int status) {
+      EXPECT_EQ(0, status);
+      done.push_back(n);
+    });
+  }
+  ASSERT_TRUE(IsEqual(buffer.length(), 1000));
+  ASSERT_TRUE(IsEqual(buffer.remaining(), 1000));
+
+  // All of the writes are pulled as a single vector.
+  auto next = [&](
+      int status,
+      const ngtcp2_vec* data,
+      size_t count,
+      Done done) {
+    ASSERT_TRUE(IsEqual(count, 1));
+    ASSERT_TRUE(IsEqual(data[0].len, 1000));
+    for (size_t n = 0; n < 1000; n++)
+      ASSERT_EQ(data[0].base[n], n / 10);
+    done(1000);
+  };
+  ngtcp2_vec vec[kMaxVectorCount];
+  buffer.Pull(next, Options::OPTIONS_SYNC, vec, node::arraysize(vec));
+  ASSERT_TRUE(IsEqual(buffer.remaining(), 0));
+
+  // Writes complete as the data up to their end is acknowledged.
+  buffer.Consume(55);
+  ASSERT_TRUE(IsEqual(done.size(), 5));
+  buffer.Consume(5);
+  ASSERT_TRUE(IsEqual(done.size(), 6));
+  buffer.Consume(940);
+  ASSERT_TRUE(IsEqual(done.size(), 100));
+  for (int n = 0; n < 100; n++)
+    ASSERT_EQ(done[n], n);
+  ASSERT_TRUE(IsEqual(buffer.length(), 0));
+}
+
+TEST(QuicBuffer, CopySpansBlocks) {
+  std::vector<char> data(QuicBuffer::kBlockSize + 100, 'a');
+  uv_buf_t buf = uv_buf_init(data.data(), data.size());
+
+  QuicBuffer buffer;
+  int count = 0;
+  buffer.Copy(&buf, 1, [&](int status) {
+    EXPECT_EQ(0, status);
+    count++;
+  });
+  ASSERT_TRUE(IsEqual(buffer.remaining(), data.size()));
+
+  auto next = [&](
+      int status,
+      const ngtcp2_vec* data,
+      size_t count,
+      Done done) {
+    ASSERT_TRUE(IsEqual(count, 2));
+    ASSERT_TRUE(IsEqual(data[0].len, QuicBuffer::kBlockSize));
+    ASSERT_TRUE(IsEqual(data[1].len, 100));
+    done(QuicBuffer::kBlockSize + 100);
+  };
+  ngtcp2_vec vec[kMaxVectorCount];
+  buffer.Pull(next, Options::OPTIONS_SYNC, vec, node::arraysize(vec));
+
+  // The first block is released, but the write is not complete
+  // until the data in the second block has been acknowledged.
+  buffer.Consume(QuicBuffer::kBlockSize);
+  ASSERT_EQ(0, count);
+  ASSERT_TRUE(IsEqual(buffer.length(), 100));
+  buffer.Consume(100);
+  ASSERT_EQ(1, count);
+}
+
+TEST(QuicBuffer, LargeWritesAreNotCopied) {
+  std::vector<char> data(QuicBuffer::kMaxCopyLength + 1, 'a');
+  uv_buf_t small = uv_buf_init(data.data(), 10);
+  uv_buf_t large = uv_buf_init(data.data(), data.size());
+
+  QuicBuffer buffer;
+  buffer.Push(&small, 1);
+  buffer.Push(&large, 1);
+  buffer.Push(&small, 1);
+
+  auto next = [&](
+      int status,
+      const ngtcp2_vec* vec,
+      size_t count,
+      Done done) {
+    ASSERT_TRUE(IsEqual(count, 3));
+    ASSERT_NE(vec[0].base, reinterpret_cast<uint8_t*>(data.data()));
+    ASSERT_EQ(vec[1].base, reinterpret_cast<uint8_t*>(data.data()));
+    ASSERT_TRUE(IsEqual(vec[1].len, data.size()));
+    ASSERT_TRUE(IsEqual(vec[2].len, 10));
+    done(data.size() + 20);
+  };
+  ngtcp2_vec vec[kMaxVectorCount];
+  buffer.Pull(next, Options::OPTIONS_SYNC, vec, node::arraysize(vec));
+  buffer.Consume(data.size() + 20);
+  ASSERT_TRUE(IsEqual(buffer.length(), 0));
+}
+
+TEST(QuicBuffer, CancelCopied) {
+  char data[10] = {};
+  uv_buf_t buf = uv_buf_init(data, sizeof(data));
+
+  QuicBuffer buffer;
+  int count = 0;
+  for (int n = 0; n < 3; n++) {
+    buffer.Push(&buf, 1, [&](int status) {
+      ASSERT_EQ(UV_ECANCELED, status);
+      count++;
+    });
+  }
+  buffer.Seek(15);
+  buffer.Cancel();
+  ASSERT_EQ(3, count);
+  ASSERT_TRUE(IsEqual(buffer.length(), 0));
+}
+
+TEST(QuicBuffer, ReusesBlocks) {
+  char data[10] = {};
+  uv_buf_t buf = uv_buf_init(data, sizeof(data));
+
+  QuicBuffer buffer;
+  uint8_t* block = nullptr;
+  for (int n = 0; n < 3; n++) {
+    memset(data, n, sizeof(data));
+    buffer.Push(&buf, 1);
+    auto next = [&](
+        int status,
+        const ngtcp2_vec* vec,
+        size_t count,
+        Done done) {
+      ASSERT_TRUE(IsEqual(count, 1));
+      ASSERT_TRUE(IsEqual(vec[0].len, 10));
+      ASSERT_EQ(vec[0].base[0], n);
+      // Every write is copied into the same block.
+      if (block == nullptr)
+        block = vec[0].base;
+      ASSERT_EQ(vec[0].base, block);
+      done(10);
+    };
+    ngtcp2_vec vec[kMaxVectorCount];
+    buffer.Pull(next, Options::OPTIONS_SYNC, vec, node::arraysize(vec));
+    buffer.Consume(10);
+    ASSERT_TRUE(IsEqual(buffer.length(), 0));
+    ASSERT_TRUE(IsEqual(buffer.remaining(), 0));
+  }
+}
+
+class QuicReceiveSlabTest : public NodeTestFixture {};
+
+TEST_F(QuicReceiveSlabTest, PacksChunks) {
+  const v8::HandleScope handle_scope(isolate_);
+  QuicReceiveSlab slab(isolate_);
+  ASSERT_TRUE(IsEqual(slab.remaining(), 0));
+
+  const uint8_t a[] = { 1, 2, 3 };
+  const uint8_t b[] = { 4, 5 };
+  size_t offset_a;
+  size_t offset_b;
+  v8::Local<v8::ArrayBuffer> buffer_a = slab.Copy(a, sizeof(a), &offset_a);
+  v8::Local<v8::ArrayBuffer> buffer_b = slab.Copy(b, sizeof(b), &offset_b);
+
+  // Both chunks are views over the same slab.
+  ASSERT_EQ(buffer_a, buffer_b);
+  ASSERT_TRUE(IsEqual(offset_a, 0));
+  ASSERT_TRUE(IsEqual(offset_b, 3));
+  ASSERT_TRUE(IsEqual(buffer_a->ByteLength(), QuicReceiveSlab::kSlabSize));
+  ASSERT_TRUE(IsEqual(slab.remaining(), QuicReceiveSlab::kSlabSize - 5));
+
+  const uint8_t* data =
+      static_cast<uint8_t*>(buffer_a->GetBackingStore()->Data());
+  ASSERT_EQ(0, memcmp(data, a, sizeof(a)));
+  ASSERT_EQ(0, memcmp(data + offset_b, b, sizeof(b)));
+}
+
+TEST_F(QuicReceiveSlabTest, LargeChunk) {
+  const v8::HandleScope handle_scope(isolate_);
+  QuicReceiveSlab slab(isolate_);
+
+  const uint8_t small[] = { 1 };
+  size_t offset;
+  v8::Local<v8::ArrayBuffer> slab_buffer = slab.Copy(small, 1, &offset);
+
+  // A chunk larger than kMaxSlabChunk gets a buffer of its own
+  // and leaves the current slab alone.
+  std::vector<uint8_t> large(QuicReceiveSlab::kMaxSlabChunk + 1, 7);
+  v8::Local<v8::ArrayBuffer> buffer =
+      slab.Copy(large.data(), large.size(), &offset);
+  ASSERT_NE(buffer, slab_buffer);
+  ASSERT_TRUE(IsEqual(offset, 0));
+  ASSERT_TRUE(IsEqual(buffer->ByteLength(), large.size()));
+  ASSERT_TRUE(IsEqual(slab.remaining(), QuicReceiveSlab::kSlabSize - 1));
+
+  ASSERT_EQ(slab.Copy(small, 1, &offset), slab_buffer);
+  ASSERT_TRUE(IsEqual(offset, 1));
+}
+
+TEST_F(QuicReceiveSlabTest, ReplacesFullSlab) {
+  const v8::HandleScope handle_scope(isolate_);
+  QuicReceiveSlab slab(isolate_);
+
+  std::vector<uint8_t> chunk(QuicReceiveSlab::kMaxSlabChunk, 1);
+  size_t offset;
+  v8::Local<v8::ArrayBuffer> first;
+  for (size_t n = 0; n < 4; n++) {
+    chunk.assign(chunk.size(), static_cast<uint8_t>(n));
+    v8::Local<v8::ArrayBuffer> buffer =
+        slab.Copy(chunk.data(), chunk.size(), &offset);
+    if (first.IsEmpty())
+      first = buffer;
+    ASSERT_EQ(buffer, first);
+  }
+  ASSERT_TRUE(IsEqual(slab.remaining(), 0));
+
+  // The next chunk starts a new slab. The old one stays valid
+  // for as long as it is referenced.
+  chunk.assign(chunk.size(), 9);
+  v8::Local<v8::ArrayBuffer> second =
+      slab.Copy(chunk.data(), chunk.size(), &offset);
+  ASSERT_NE(second, first);
+  ASSERT_TRUE(IsEqual(offset, 0));
+  const uint8_t* data =
+      static_cast<uint8_t*>(first->GetBackingStore()->Data());
+  ASSERT_TRUE(IsEqual(data[3 * QuicReceiveSlab::kMaxSlabChunk], 3));
+}
+
+TEST_F(QuicReceiveSlabTest, LimitsRetiredSlabs) {
+  const v8::HandleScope handle_scope(isolate_);
+  QuicReceiveSlab slab(isolate_);
+
+  // The handles keep every slab that is filled alive.
+  std::vector<uint8_t> chunk(QuicReceiveSlab::kMaxSlabChunk, 1);
+  size_t chunks_per_slab =
+      QuicReceiveSlab::kSlabSize / QuicReceiveSlab::kMaxSlabChunk;
+  size_t offset;
+  for (size_t n = 0;
+       n < chunks_per_slab * (QuicReceiveSlab::kMaxRetiredSlabs + 1);
+       n++) {
+    v8::Local<v8::ArrayBuffer> buffer =
+        slab.Copy(chunk.data(), chunk.size(), &offset);
+    ASSERT_TRUE(IsEqual(buffer->ByteLength(), QuicReceiveSlab::kSlabSize));
+  }
+  ASSERT_TRUE(IsEqual(slab.remaining(), 0));
+  ASSERT_TRUE(
+      IsEqual(slab.retired_count(), QuicReceiveSlab::kMaxRetiredSlabs));
+
+  // With as many replaced slabs alive as allowed, the next chunk
+  // gets a buffer of its own rather than a new slab.
+  v8::Local<v8::ArrayBuffer> buffer =
+      slab.Copy(chunk.data(), chunk.size(), &offset);
+  ASSERT_TRUE(IsEqual(offset, 0));
+  ASSERT_TRUE(IsEqual(buffer->ByteLength(), chunk.size()));
+  ASSERT_TRUE(
+      IsEqual(slab.retired_count(), QuicReceiveSlab::kMaxRetiredSlabs));
+}
+
+TEST_F(QuicReceiveSlabTest, ReplacesDetachedSlab) {
+  const v8::HandleScope handle_scope(isolate_);
+  QuicReceiveSlab slab(isolate_);
+
+  const uint8_t data[] = { 1, 2, 3 };
+  size_t offset;
+  v8::Local<v8::ArrayBuffer> first = slab.Copy(data, sizeof(data), &offset);
+  first->Detach();
+
+  v8::Local<v8::ArrayBuffer> second = slab.Copy(data, sizeof(data), &offset);
+  ASSERT_NE(second, first);
+  ASSERT_TRUE(IsEqual(offset, 0));
+  ASSERT_TRUE(IsEqual(second->ByteLength(), QuicReceiveSlab::kSlabSize));
+}
@@ -29,3 +29,109 @@ TEST(QuicCID, Simple) {
   memset(qcid1.data(), 1, 5);
   CHECK_EQ(qcid1.ToString(), "0101010101");
 }
+
+using node::quic::QuicRoutingTable;
+using node::quic::QuicSipHash;
+using node::quic::StatelessResetToken;
+
+namespace {
+const uint8_t kHashKey[QuicRoutingTable<int>::kHashKeyLen] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+QuicCID MakeCID(uint32_t n, size_t len = 8) {
+  uint8_t data[NGTCP2_MAX_CIDLEN] = {};
+  memcpy(data, &n, sizeof(n));
+  return QuicCID(data, len);
+}
+}  // namespace
+
+TEST(QuicCID, SipHash) {
+  // The key and messages used by the SipHash reference test vectors.
+  const uint64_t key[2] = {
+    0x0706050403020100ULL,
+    0x0f0e0d0c0b0a0908ULL
+  };
+  uint8_t data[16];
+  for (size_t n = 0; n < sizeof(data); n++)
+    data[n] = n;
+  CHECK_EQ(QuicSipHash(key, data, 0), 0xabac0158050fc4dcULL);
+  CHECK_EQ(QuicSipHash(key, data, 7), 0xd3927d989bb11140ULL);
+  CHECK_EQ(QuicSipHash(key, data, 8), 0x369095118d299a8eULL);
+  CHECK_EQ(QuicSipHash(key, data, 15), 0xd320d86d2a519956ULL);
+  CHECK_EQ(QuicSipHash(key, data, 16), 0xcc4fdd1a7d908b66ULL);
+}
+
+TEST(QuicCID, RoutingTable) {
+  QuicRoutingTable<int> table(kHashKey);
+  CHECK_EQ(table.size(), 0);
+  CHECK_NULL(table.Find(MakeCID(1)));
+  CHECK(!table.Erase(MakeCID(1)));
+
+  for (int n = 0; n < 1000; n++)
+    table.Insert(MakeCID(n), n);
+  CHECK_EQ(table.size(), 1000);
+  CHECK_LE(table.size() * 4, table.capacity() * 3);
+
+  // CIDs of different lengths are distinct keys.
+  CHECK_NULL(table.Find(MakeCID(1, 9)));
+  table.Insert(MakeCID(1, 9), -1);
+  CHECK_EQ(*table.Find(MakeCID(1, 9)), -1);
+  CHECK_EQ(*table.Find(MakeCID(1)), 1);
+
+  // Inserting an existing key replaces its value.
+  table.Insert(MakeCID(2), -2);
+  CHECK_EQ(*table.Find(MakeCID(2)), -2);
+  CHECK_EQ(table.size(), 1001);
+
+  // Every other entry is removed. The remaining entries must still
+  // be found after the entries around them have been shifted.
+  for (int n = 0; n < 1000; n += 2)
+    CHECK(table.Erase(MakeCID(n)));
+  CHECK_EQ(table.size(), 501);
+  for (int n = 0; n < 1000; n++) {
+    int* value = table.Find(MakeCID(n));
+    if (n % 2 == 0) {
+      CHECK_NULL(value);
+    } else {
+      CHECK_NOT_NULL(value);
+      CHECK_EQ(*value, n);
+    }
+  }
+}
+
+TEST(QuicCID, RoutingTableAliasedInsert) {
+  // A QuicSession is routed to by every CID associated with it,
+  // each added with the value found for one of the others.
+  QuicRoutingTable<std::shared_ptr<int>> table(kHashKey);
+  table.Insert(MakeCID(0), std::make_shared<int>(42));
+  const size_t capacity = table.capacity();
+  uint32_t n = 1;
+  while (table.capacity() < 4 * capacity) {
+    std::shared_ptr<int>* value = table.Find(MakeCID(0));
+    CHECK_NOT_NULL(value);
+    table.Insert(MakeCID(n++), *value);
+  }
+  std::shared_ptr<int>* session = table.Find(MakeCID(0));
+  CHECK_NOT_NULL(session);
+  CHECK_EQ(session->use_count(), n);
+  for (uint32_t m = 1; m < n; m++) {
+    std::shared_ptr<int>* value = table.Find(MakeCID(m));
+    CHECK_NOT_NULL(value);
+    CHECK_EQ(value->get(), session->get());
+  }
+  CHECK_EQ(**session, 42);
+}
+
+TEST(QuicCID, RoutingTableResetTokens) {
+  QuicRoutingTable<int> table(kHashKey);
+  uint8_t data[NGTCP2_STATELESS_RESET_TOKENLEN] = {};
+  StatelessResetToken token(data);
+  table.Insert(token, 1);
+  CHECK_EQ(*table.Find(StatelessResetToken(data)), 1);
+  data[0] = 1;
+  CHECK_NULL(table.Find(StatelessResetToken(data)));
+  data[0] = 0;
+  CHECK(table.Erase(StatelessResetToken(data)));
+  CHECK_EQ(table.size(), 0);
+}
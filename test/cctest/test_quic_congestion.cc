@@ -0,0 +1,91 @@
+#include "quic/node_quic_congestion.h"
+#include "util-inl.h"
+
+#include "gtest/gtest.h"
+#include <memory>
+
+using node::quic::QuicCongestionController;
+using node::quic::QuicCongestionSample;
+using node::quic::QUIC_CC_ALGORITHM_BBR;
+using node::quic::QUIC_CC_ALGORITHM_CUBIC;
+using node::quic::QUIC_CC_ALGORITHM_NEWRENO;
+
+namespace {
+constexpr uint64_t kInitialWindow = 10 * 1200;
+constexpr uint64_t kRtt = 10000000;  // 10 ms
+
+QuicCongestionSample Sample(uint64_t now, uint64_t acked, uint64_t rtt) {
+  QuicCongestionSample sample;
+  sample.now = now;
+  sample.bytes_acked = acked;
+  sample.bytes_in_flight = 0;
+  sample.latest_rtt = rtt;
+  sample.min_rtt = rtt;
+  sample.smoothed_rtt = rtt;
+  return sample;
+}
+}  // namespace
+
+TEST(QuicCongestionController, NewRenoIsBuiltIn) {
+  CHECK(!QuicCongestionController::Create(
+      QUIC_CC_ALGORITHM_NEWRENO,
+      kInitialWindow));
+}
+
+TEST(QuicCongestionController, Cubic) {
+  std::unique_ptr<QuicCongestionController> cc =
+      QuicCongestionController::Create(
+          QUIC_CC_ALGORITHM_CUBIC,
+          kInitialWindow);
+  CHECK_EQ(cc->algorithm(), QUIC_CC_ALGORITHM_CUBIC);
+  CHECK_EQ(cc->cwnd(), kInitialWindow);
+
+  // Slow start grows the window by the bytes acknowledged.
+  uint64_t now = 1;
+  cc->OnAck(Sample(now, 12000, kRtt));
+  CHECK_EQ(cc->cwnd(), 24000);
+
+  // A congestion event reduces the window by beta.
+  cc->OnCongestionEvent(Sample(now, 0, kRtt));
+  CHECK_EQ(cc->cwnd(), 16800);
+  CHECK_EQ(cc->ssthresh(), 16800);
+
+  // The window grows back past where loss occurred, slowly at first.
+  uint64_t previous = cc->cwnd();
+  for (int n = 0; n < 500; n++) {
+    now += kRtt;
+    cc->OnAck(Sample(now, cc->cwnd(), kRtt));
+    CHECK_GE(cc->cwnd(), previous);
+    if (n == 10)
+      CHECK_LT(cc->cwnd(), 24000);
+    previous = cc->cwnd();
+  }
+  CHECK_GT(cc->cwnd(), 24000);
+
+  cc->OnPersistentCongestion(Sample(now, 0, kRtt));
+  CHECK_EQ(cc->cwnd(), QuicCongestionController::kMinWindow);
+}
+
+TEST(QuicCongestionController, Bbr) {
+  std::unique_ptr<QuicCongestionController> cc =
+      QuicCongestionController::Create(
+          QUIC_CC_ALGORITHM_BBR,
+          kInitialWindow);
+  CHECK_EQ(cc->algorithm(), QUIC_CC_ALGORITHM_BBR);
+  CHECK_EQ(cc->pacing_rate(), 0);
+
+  // Deliver a steady 1200 bytes per millisecond. Once startup has
+  // found the bandwidth, the window converges on twice the
+  // bandwidth-delay product and loss is ignored.
+  uint64_t now = 1;
+  for (int n = 0; n < 2000; n++) {
+    now += 1000000;
+    cc->OnAck(Sample(now, 1200, kRtt));
+    if (n == 1000)
+      cc->OnCongestionEvent(Sample(now, 0, kRtt));
+  }
+  uint64_t bdp = 1200 * kRtt / 1000000;
+  CHECK_GE(cc->cwnd(), 2 * bdp * 9 / 10);
+  CHECK_LE(cc->cwnd(), 2 * bdp * 11 / 10);
+  CHECK_GT(cc->pacing_rate(), 0);
+}
@@ -0,0 +1,90 @@
+#include "quic/node_quic_util-inl.h"
+#include "node_sockaddr-inl.h"
+#include "util-inl.h"
+
+#include "gtest/gtest.h"
+
+using node::quic::QuicPacer;
+
+namespace {
+constexpr size_t kPacketLength = 1200;
+constexpr size_t kMaxBurst = 4;
+// One packet per millisecond.
+constexpr double kRate = kPacketLength / 1000000.0;
+constexpr uint64_t kStart = 1000000000;
+}  // namespace
+
+TEST(QuicPacer, StartsWithFullBurst) {
+  QuicPacer pacer(kMaxBurst);
+  CHECK_EQ(pacer.budget(), 0);
+  pacer.Update(kStart, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), kMaxBurst);
+  CHECK_EQ(pacer.delay(), 0);
+}
+
+TEST(QuicPacer, Refill) {
+  QuicPacer pacer(kMaxBurst);
+  pacer.Update(kStart, kRate, kPacketLength);
+  for (size_t n = 0; n < kMaxBurst; n++)
+    pacer.OnPacketSent(kPacketLength);
+  CHECK_EQ(pacer.budget(), 0);
+  CHECK_EQ(pacer.delay(), 1000000);
+
+  // Credit accrues at the pacing rate.
+  pacer.Update(kStart + 500000, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), 0);
+  CHECK_EQ(pacer.delay(), 500000);
+  pacer.Update(kStart + 1000000, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), 1);
+  CHECK_EQ(pacer.delay(), 0);
+  pacer.Update(kStart + 3000000, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), 3);
+}
+
+TEST(QuicPacer, BurstLimit) {
+  QuicPacer pacer(kMaxBurst);
+  pacer.Update(kStart, kRate, kPacketLength);
+  pacer.OnPacketSent(kPacketLength);
+
+  // However long the pacer has been idle, no more
+  // than max_burst packets may be sent at once.
+  pacer.Update(kStart + 1000000000, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), kMaxBurst);
+
+  pacer.set_max_burst(2);
+  pacer.Update(kStart + 2000000000, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), 2);
+
+  // At least one packet may always be sent.
+  pacer.set_max_burst(0);
+  CHECK_EQ(pacer.max_burst(), 1);
+}
+
+TEST(QuicPacer, ShortPacketsAreRepaid) {
+  QuicPacer pacer(kMaxBurst);
+  pacer.Update(kStart, kRate, kPacketLength);
+  for (size_t n = 0; n < kMaxBurst; n++)
+    pacer.OnPacketSent(kPacketLength / 2);
+  CHECK_EQ(pacer.budget(), kMaxBurst / 2);
+
+  // The debt is capped at one burst.
+  for (size_t n = 0; n < 10 * kMaxBurst; n++)
+    pacer.OnPacketSent(kPacketLength);
+  pacer.Update(kStart + kMaxBurst * 1000000, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), 0);
+  pacer.Update(kStart + (kMaxBurst + 1) * 1000000, kRate, kPacketLength);
+  CHECK_EQ(pacer.budget(), 1);
+}
+
+TEST(QuicPacer, Unpaced) {
+  QuicPacer pacer(kMaxBurst);
+  pacer.Update(kStart, kRate, kPacketLength);
+  for (size_t n = 0; n < kMaxBurst; n++)
+    pacer.OnPacketSent(kPacketLength);
+  CHECK_EQ(pacer.budget(), 0);
+
+  // Without a pacing rate, a full burst may be sent at any time.
+  pacer.Update(kStart, 0, kPacketLength);
+  CHECK_EQ(pacer.budget(), kMaxBurst);
+  CHECK_EQ(pacer.delay(), 0);
+}
@@ -0,0 +1,158 @@
+#include "base_object-inl.h"
+#include "quic/node_quic_crypto.h"
+#include "quic/node_quic_util-inl.h"
+#include "node_sockaddr-inl.h"
+#include "util.h"
+#include "gtest/gtest.h"
+
+#include <ngtcp2/ngtcp2.h>
+#include <ngtcp2/ngtcp2_crypto.h>
+#include <openssl/evp.h>
+
+#include <cstring>
+#include <memory>
+
+using node::quic::DecryptPacket;
+using node::quic::EncryptPacket;
+using node::quic::GetHeaderProtectionMask;
+using node::quic::QuicPacketCipher;
+
+namespace {
+constexpr size_t kPlaintextLength = 100;
+constexpr size_t kTagLength = 16;
+
+struct PacketData {
+  uint8_t key[QuicPacketCipher::kMaxKeyLength];
+  uint8_t nonce[QuicPacketCipher::kNonceLength];
+  uint8_t ad[20];
+  uint8_t plaintext[kPlaintextLength];
+
+  PacketData() {
+    for (size_t n = 0; n < sizeof(key); n++) key[n] = n * 7;
+    for (size_t n = 0; n < sizeof(nonce); n++) nonce[n] = n + 1;
+    for (size_t n = 0; n < sizeof(ad); n++) ad[n] = n;
+    for (size_t n = 0; n < sizeof(plaintext); n++) plaintext[n] = n * 3;
+  }
+};
+
+ngtcp2_crypto_aead Aead(const EVP_CIPHER* cipher) {
+  ngtcp2_crypto_aead aead;
+  aead.native_handle = const_cast<EVP_CIPHER*>(cipher);
+  return aead;
+}
+
+void TestAead(const EVP_CIPHER* cipher) {
+  PacketData data;
+  ngtcp2_crypto_aead aead = Aead(cipher);
+  uint8_t expected[kPlaintextLength + kTagLength];
+  uint8_t actual[kPlaintextLength + kTagLength];
+  uint8_t decrypted[kPlaintextLength];
+
+  CHECK_EQ(ngtcp2_crypto_encrypt(
+      expected, &aead, data.plaintext, kPlaintextLength, data.key,
+      data.nonce, sizeof(data.nonce), data.ad, sizeof(data.ad)), 0);
+
+  std::unique_ptr<QuicPacketCipher> encrypt =
+      QuicPacketCipher::Create(cipher, QuicPacketCipher::ENCRYPT, data.key);
+  std::unique_ptr<QuicPacketCipher> decrypt =
+      QuicPacketCipher::Create(cipher, QuicPacketCipher::DECRYPT, data.key);
+  CHECK(encrypt);
+  CHECK(decrypt);
+  CHECK_EQ(QuicPacketCipher::Find(
+      cipher, QuicPacketCipher::ENCRYPT, data.key), encrypt.get());
+  CHECK_EQ(QuicPacketCipher::Find(
+      cipher, QuicPacketCipher::DECRYPT, data.key), decrypt.get());
+
+  // The prepared contexts are reused for every packet.
+  for (int n = 0; n < 3; n++) {
+    CHECK_EQ(EncryptPacket(
+        actual, &aead, data.plaintext, kPlaintextLength, data.key,
+        data.nonce, sizeof(data.nonce), data.ad, sizeof(data.ad)), 0);
+    CHECK_EQ(memcmp(expected, actual, sizeof(expected)), 0);
+
+    CHECK_EQ(DecryptPacket(
+        decrypted, &aead, actual, sizeof(actual), data.key,
+        data.nonce, sizeof(data.nonce), data.ad, sizeof(data.ad)), 0);
+    CHECK_EQ(memcmp(data.plaintext, decrypted, kPlaintextLength), 0);
+  }
+
+  actual[0] ^= 1;
+  CHECK_EQ(DecryptPacket(
+      decrypted, &aead, actual, sizeof(actual), data.key,
+      data.nonce, sizeof(data.nonce), data.ad, sizeof(data.ad)),
+      NGTCP2_ERR_TLS_DECRYPT);
+
+  // Once released, the key is handled by ngtcp2 again.
+  encrypt.reset();
+  CHECK_NULL(QuicPacketCipher::Find(
+      cipher, QuicPacketCipher::ENCRYPT, data.key));
+  memset(actual, 0, sizeof(actual));
+  CHECK_EQ(EncryptPacket(
+      actual, &aead, data.plaintext, kPlaintextLength, data.key,
+      data.nonce, sizeof(data.nonce), data.ad, sizeof(data.ad)), 0);
+  CHECK_EQ(memcmp(expected, actual, sizeof(expected)), 0);
+}
+
+void TestHeaderProtection(const EVP_CIPHER* cipher) {
+  PacketData data;
+  ngtcp2_crypto_cipher hp;
+  hp.native_handle = const_cast<EVP_CIPHER*>(cipher);
+  uint8_t sample[16];
+  uint8_t expected[16];
+  uint8_t actual[16];
+
+  std::unique_ptr<QuicPacketCipher> mask = QuicPacketCipher::Create(
+      cipher, QuicPacketCipher::HEADER_PROTECTION, data.key);
+  CHECK(mask);
+
+  for (int n = 0; n < 3; n++) {
+    for (size_t i = 0; i < sizeof(sample); i++) sample[i] = i * n + 1;
+    CHECK_EQ(ngtcp2_crypto_hp_mask(expected, &hp, data.key, sample), 0);
+    CHECK_EQ(GetHeaderProtectionMask(actual, &hp, data.key, sample), 0);
+    CHECK_EQ(memcmp(expected, actual, 5), 0);
+  }
+}
+}  // namespace
+
+TEST(QuicPacketCipher, Aes128Gcm) {
+  TestAead(EVP_aes_128_gcm());
+}
+
+TEST(QuicPacketCipher, Aes256Gcm) {
+  TestAead(EVP_aes_256_gcm());
+}
+
+TEST(QuicPacketCipher, ChaCha20Poly1305) {
+  TestAead(EVP_chacha20_poly1305());
+}
+
+TEST(QuicPacketCipher, HeaderProtection) {
+  TestHeaderProtection(EVP_aes_128_ctr());
+  TestHeaderProtection(EVP_aes_256_ctr());
+  TestHeaderProtection(EVP_chacha20());
+}
+
+TEST(QuicPacketCipher, CcmIsNotPrepared) {
+  PacketData data;
+  CHECK(!QuicPacketCipher::Create(
+      EVP_aes_128_ccm(), QuicPacketCipher::ENCRYPT, data.key));
+}
+
+TEST(QuicPacketCipher, DuplicateKeys) {
+  PacketData data;
+  const EVP_CIPHER* cipher = EVP_aes_128_gcm();
+  std::unique_ptr<QuicPacketCipher> first =
+      QuicPacketCipher::Create(cipher, QuicPacketCipher::ENCRYPT, data.key);
+  std::unique_ptr<QuicPacketCipher> second =
+      QuicPacketCipher::Create(cipher, QuicPacketCipher::ENCRYPT, data.key);
+  CHECK_EQ(QuicPacketCipher::Find(
+      cipher, QuicPacketCipher::ENCRYPT, data.key), first.get());
+
+  // Releasing the unregistered duplicate leaves the first in place.
+  second.reset();
+  CHECK_EQ(QuicPacketCipher::Find(
+      cipher, QuicPacketCipher::ENCRYPT, data.key), first.get());
+  first.reset();
+  CHECK_NULL(QuicPacketCipher::Find(
+      cipher, QuicPacketCipher::ENCRYPT, data.key));
+}
@@ -0,0 +1,118 @@
+#include "quic/node_quic_util-inl.h"
+#include "node_sockaddr-inl.h"
+#include "util-inl.h"
+
+#include "gtest/gtest.h"
+
+using node::quic::QuicPathMtuDiscovery;
+
+namespace {
+constexpr size_t kBase = 1252;
+constexpr size_t kHint = 1472;
+constexpr size_t kMax = 8972;
+constexpr uint64_t kTimeout = 100000000;  // 100 ms
+
+// Runs the search against a path that delivers packets up to
+// path_mtu bytes, returning the number of probes sent.
+size_t Search(QuicPathMtuDiscovery* pmtud, size_t path_mtu, uint64_t* now) {
+  size_t probes = 0;
+  for (;;) {
+    size_t length = pmtud->NextProbe(*now, kTimeout);
+    if (length == 0) {
+      if (!pmtud->is_searching())
+        return probes;
+      *now += kTimeout;
+      continue;
+    }
+    pmtud->OnProbeSent(length, *now);
+    probes++;
+    if (length <= path_mtu)
+      pmtud->OnProbeAcked(length);
+  }
+}
+}  // namespace
+
+TEST(QuicPathMtuDiscovery, HintIsProbedFirst) {
+  QuicPathMtuDiscovery pmtud;
+  pmtud.Reset(kBase, kMax, kHint);
+  CHECK_EQ(pmtud.packet_length(), kBase);
+  CHECK_EQ(pmtud.NextProbe(0, kTimeout), kHint);
+  pmtud.OnProbeSent(kHint, 0);
+
+  // Nothing more is probed while a probe is outstanding.
+  CHECK_EQ(pmtud.NextProbe(1, kTimeout), 0);
+  CHECK(pmtud.OnProbeAcked(kHint));
+  CHECK_EQ(pmtud.packet_length(), kHint);
+
+  // The maximum is then tried once before searching in between.
+  CHECK_EQ(pmtud.NextProbe(2, kTimeout), kMax);
+}
+
+TEST(QuicPathMtuDiscovery, BinarySearch) {
+  QuicPathMtuDiscovery pmtud;
+  pmtud.Reset(kBase, kMax, kHint);
+  uint64_t now = 0;
+  size_t probes = Search(&pmtud, 4000, &now);
+  CHECK_LE(pmtud.packet_length(), 4000);
+  CHECK_GT(pmtud.packet_length() + QuicPathMtuDiscovery::kSearchGranularity,
+           4000);
+  // The search is logarithmic in the range searched, with each
+  // undelivered length probed kMaxProbes times.
+  CHECK_LE(probes, 12 * QuicPathMtuDiscovery::kMaxProbes);
+}
+
+TEST(QuicPathMtuDiscovery, LossRetries) {
+  QuicPathMtuDiscovery pmtud;
+  pmtud.Reset(kBase, kMax, kHint);
+  for (size_t n = 0; n < QuicPathMtuDiscovery::kMaxProbes; n++) {
+    CHECK_EQ(pmtud.NextProbe(n * kTimeout, kTimeout), kHint);
+    pmtud.OnProbeSent(kHint, n * kTimeout);
+  }
+  // After kMaxProbes losses the hint bounds the search.
+  size_t next = pmtud.NextProbe(3 * kTimeout, kTimeout);
+  CHECK_GT(next, kBase);
+  CHECK_LT(next, kHint);
+
+  // A late acknowledgement still raises the packet length.
+  CHECK(pmtud.OnProbeAcked(kHint));
+  CHECK_EQ(pmtud.packet_length(), kHint);
+  CHECK(!pmtud.OnProbeAcked(next));
+}
+
+TEST(QuicPathMtuDiscovery, BlackHole) {
+  QuicPathMtuDiscovery pmtud;
+  pmtud.Reset(kBase, kMax, kHint);
+  uint64_t now = 0;
+  Search(&pmtud, kMax, &now);
+  CHECK_EQ(pmtud.packet_length(), kMax);
+
+  pmtud.OnBlackHole();
+  CHECK_EQ(pmtud.packet_length(), kBase);
+  CHECK(pmtud.is_searching());
+  // The length that stopped working is not probed again.
+  Search(&pmtud, kMax, &now);
+  CHECK_LT(pmtud.packet_length(), kMax);
+  CHECK_GE(pmtud.packet_length(), kHint);
+}
+
+TEST(QuicPathMtuDiscovery, Raise) {
+  QuicPathMtuDiscovery pmtud;
+  pmtud.Reset(kBase, kMax, kHint);
+  uint64_t now = 0;
+  Search(&pmtud, kHint, &now);
+  CHECK_EQ(pmtud.packet_length(), kHint);
+
+  CHECK_EQ(pmtud.NextProbe(now + kTimeout, kTimeout), 0);
+  // The path is searched again after kRaiseInterval.
+  now += QuicPathMtuDiscovery::kRaiseInterval;
+  CHECK_EQ(pmtud.NextProbe(now, kTimeout), kMax);
+  CHECK(pmtud.is_searching());
+}
+
+TEST(QuicPathMtuDiscovery, MaxBelowBase) {
+  QuicPathMtuDiscovery pmtud;
+  pmtud.Reset(kBase, 1200, kHint);
+  CHECK_EQ(pmtud.NextProbe(0, kTimeout), 0);
+  CHECK(!pmtud.is_searching());
+  CHECK_EQ(pmtud.packet_length(), kBase);
+}
@@ -0,0 +1,115 @@
+#include "quic/node_quic_qlog.h"
+#include "util-inl.h"
+#include "uv.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+using node::quic::QuicQlogSink;
+using node::quic::QuicQlogTrace;
+
+namespace {
+class QuicQlogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmp[1024];
+    size_t len = sizeof(tmp);
+    CHECK_EQ(uv_os_tmpdir(tmp, &len), 0);
+    std::string tmpl = std::string(tmp) + "/quic-qlog-XXXXXX";
+    uv_fs_t req;
+    CHECK_EQ(uv_fs_mkdtemp(nullptr, &req, tmpl.c_str(), nullptr), 0);
+    dir_ = req.path;
+    uv_fs_req_cleanup(&req);
+  }
+
+  void TearDown() override {
+    uv_fs_t req;
+    uv_dirent_t ent;
+    CHECK_GE(uv_fs_scandir(nullptr, &req, dir_.c_str(), 0, nullptr), 0);
+    while (uv_fs_scandir_next(&req, &ent) != UV_EOF)
+      Unlink(Path(ent.name));
+    uv_fs_req_cleanup(&req);
+    CHECK_EQ(uv_fs_rmdir(nullptr, &req, dir_.c_str(), nullptr), 0);
+    uv_fs_req_cleanup(&req);
+  }
+
+  std::string Path(const std::string& name) const {
+    return dir_ + "/" + name;
+  }
+
+  static void Unlink(const std::string& path) {
+    uv_fs_t req;
+    uv_fs_unlink(nullptr, &req, path.c_str(), nullptr);
+    uv_fs_req_cleanup(&req);
+  }
+
+  static std::string ReadFile(const std::string& path) {
+    std::string contents;
+    uv_fs_t req;
+    uv_file file = uv_fs_open(nullptr, &req, path.c_str(), 0, 0, nullptr);
+    uv_fs_req_cleanup(&req);
+    CHECK_GE(file, 0);
+    char data[256];
+    uv_buf_t buf = uv_buf_init(data, sizeof(data));
+    int ret;
+    while ((ret = uv_fs_read(nullptr, &req, file, &buf, 1, -1, nullptr)) > 0) {
+      contents.append(data, ret);
+      uv_fs_req_cleanup(&req);
+    }
+    uv_fs_req_cleanup(&req);
+    uv_fs_close(nullptr, &req, file, nullptr);
+    uv_fs_req_cleanup(&req);
+    return contents;
+  }
+
+  std::string dir_;
+};
+
+const uint8_t* Bytes(const char* str) {
+  return reinterpret_cast<const uint8_t*>(str);
+}
+}  // namespace
+
+TEST_F(QuicQlogTest, WritesTracesToFiles) {
+  {
+    std::shared_ptr<QuicQlogSink> sink = QuicQlogSink::Create(dir_);
+    ASSERT_TRUE(sink);
+    QuicQlogTrace a(sink, "a");
+    QuicQlogTrace b(sink, "b");
+    CHECK(a.Write(Bytes("{\"a\":"), 5));
+    CHECK(b.Write(Bytes("[1,"), 3));
+    CHECK(a.Write(Bytes("1}"), 2));
+    CHECK(b.Write(Bytes("2]"), 2));
+  }
+
+  // Destroying the sink flushes everything that is still queued.
+  CHECK_EQ(ReadFile(Path("a.qlog")), "{\"a\":1}");
+  CHECK_EQ(ReadFile(Path("b.qlog")), "[1,2]");
+}
+
+TEST_F(QuicQlogTest, TruncatesWhenFull) {
+  {
+    std::shared_ptr<QuicQlogSink> sink = QuicQlogSink::Create(dir_, 4);
+    ASSERT_TRUE(sink);
+    QuicQlogTrace trace(sink, "trace");
+    CHECK(trace.Write(Bytes("abc"), 3));
+
+    // A fragment larger than the queue can never be buffered, and
+    // once it has been dropped the rest of the trace is dropped too.
+    CHECK(!trace.Write(Bytes("defgh"), 5));
+    CHECK(trace.is_truncated());
+    CHECK(!trace.Write(Bytes("i"), 1));
+  }
+
+  CHECK_EQ(ReadFile(Path("trace.qlog")), "abc");
+}
+
+TEST_F(QuicQlogTest, UnwritableDirectory) {
+  std::shared_ptr<QuicQlogSink> sink =
+      QuicQlogSink::Create(Path("missing"));
+  ASSERT_TRUE(sink);
+  QuicQlogTrace trace(sink, "trace");
+
+  // The fragments are still accepted, but have nowhere to go.
+  CHECK(trace.Write(Bytes("abc"), 3));
+}
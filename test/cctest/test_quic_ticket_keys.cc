@@ -0,0 +1,120 @@
+#include "quic/node_quic_crypto.h"
+#include "quic/node_quic_util-inl.h"
+#include "node_sockaddr-inl.h"
+#include "util.h"
+#include "gtest/gtest.h"
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <cstring>
+
+using node::quic::QuicTicketKeyRing;
+using node::quic::kTicketKeyLen;
+using node::quic::kTicketKeySecretLen;
+
+namespace {
+constexpr uint64_t kRotation = 3600;
+constexpr uint64_t kNow = 1600000000;
+
+struct Secret {
+  uint8_t data[kTicketKeySecretLen];
+
+  explicit Secret(uint8_t seed) {
+    for (size_t n = 0; n < sizeof(data); n++) data[n] = seed + n;
+  }
+};
+
+bool SameKey(
+    const QuicTicketKeyRing::Key& a,
+    const QuicTicketKeyRing::Key& b) {
+  return memcmp(&a, &b, sizeof(a)) == 0;
+}
+}  // namespace
+
+TEST(QuicTicketKeyRing, SharedSecret) {
+  Secret secret(1);
+  QuicTicketKeyRing ring1(secret.data, kRotation);
+  QuicTicketKeyRing ring2(secret.data, kRotation);
+  QuicTicketKeyRing ring3(Secret(2).data, kRotation);
+  ring1.Update(kNow);
+  ring2.Update(kNow);
+  ring3.Update(kNow);
+
+  CHECK_EQ(ring1.size(), 3);
+  CHECK(SameKey(ring1.current(), ring2.current()));
+  CHECK(!SameKey(ring1.current(), ring3.current()));
+  CHECK_EQ(ring3.Find(ring1.current().name), -1);
+
+  // Rings with different clocks in the same interval agree.
+  ring2.Update(kNow - kNow % kRotation + kRotation - 1);
+  CHECK(SameKey(ring1.current(), ring2.current()));
+}
+
+TEST(QuicTicketKeyRing, Rotation) {
+  Secret secret(1);
+  QuicTicketKeyRing ring(secret.data, kRotation);
+  ring.Update(kNow);
+  QuicTicketKeyRing::Key first = ring.current();
+
+  ring.Update(kNow + kRotation);
+  CHECK(!SameKey(first, ring.current()));
+  // The key of the previous interval is still accepted.
+  CHECK_EQ(ring.Find(first.name), 1);
+
+  // As is the key of the next interval, for servers that
+  // have rotated slightly earlier.
+  QuicTicketKeyRing ahead(secret.data, kRotation);
+  ahead.Update(kNow + 2 * kRotation);
+  CHECK_EQ(ring.Find(ahead.current().name), 2);
+
+  ring.Update(kNow + 2 * kRotation);
+  CHECK_EQ(ring.Find(first.name), -1);
+}
+
+TEST(QuicTicketKeyRing, ExplicitKeys) {
+  uint8_t keys[2 * kTicketKeyLen];
+  for (size_t n = 0; n < sizeof(keys); n++) keys[n] = n;
+
+  QuicTicketKeyRing ring(nullptr, kRotation);
+  ring.SetKeys(keys, 2);
+  CHECK_EQ(ring.size(), 2);
+  CHECK_EQ(memcmp(ring.current().name, keys, 16), 0);
+  CHECK_EQ(ring.Find(keys), 0);
+  CHECK_EQ(ring.Find(keys + kTicketKeyLen), 1);
+
+  // Explicit keys are not rotated.
+  ring.Update(kNow + 10 * kRotation);
+  CHECK_EQ(ring.size(), 2);
+  CHECK_EQ(ring.Find(keys), 0);
+}
+
+TEST(QuicTicketKeyRing, Callback) {
+  Secret secret(1);
+  QuicTicketKeyRing ring1(secret.data, kRotation);
+  QuicTicketKeyRing ring2(secret.data, kRotation);
+  QuicTicketKeyRing ring3(Secret(2).data, kRotation);
+
+  unsigned char name[16];
+  unsigned char iv[16];
+  EVP_CIPHER_CTX* ectx = EVP_CIPHER_CTX_new();
+  HMAC_CTX* hctx = HMAC_CTX_new();
+
+  CHECK_EQ(ring1.Callback(name, iv, ectx, hctx, 1), 1);
+  CHECK_EQ(memcmp(name, ring1.current().name, sizeof(name)), 0);
+
+  // A ticket encrypted by one server is decrypted by another
+  // sharing the secret, but not by one with another secret.
+  CHECK_EQ(ring2.Callback(name, iv, ectx, hctx, 0), 1);
+  CHECK_EQ(ring3.Callback(name, iv, ectx, hctx, 0), 0);
+
+  // A ticket encrypted with an older key is renewed.
+  uint8_t keys[2 * kTicketKeyLen];
+  for (size_t n = 0; n < sizeof(keys); n++) keys[n] = n;
+  ring3.SetKeys(keys, 2);
+  memcpy(name, keys + kTicketKeyLen, sizeof(name));
+  CHECK_EQ(ring3.Callback(name, iv, ectx, hctx, 0), 2);
+
+  HMAC_CTX_free(hctx);
+  EVP_CIPHER_CTX_free(ectx);
+}
@@ -0,0 +1,140 @@
+#include "quic/node_quic_util-inl.h"
+#include "env-inl.h"
+#include "node_sockaddr-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+#include "uv.h"
+#include "gtest/gtest.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+using node::quic::QuicTimer;
+using node::quic::QuicTimerWheel;
+using node::quic::QuicTimerWheelPointer;
+
+class QuicTimerWheelTest : public EnvironmentTestFixture {};
+
+namespace {
+// The wheel's uv_timer_t is unref'd, so a referenced timer is
+// used to keep the loop alive until done() returns true.
+void RunUntil(uv_loop_t* loop, std::function<bool()> done) {
+  uv_timer_t keepalive;
+  uv_timer_init(loop, &keepalive);
+  uv_timer_start(&keepalive, [](uv_timer_t*) {}, 1, 1);
+  while (!done())
+    uv_run(loop, UV_RUN_ONCE);
+  uv_close(reinterpret_cast<uv_handle_t*>(&keepalive), nullptr);
+  uv_run(loop, UV_RUN_NOWAIT);
+}
+}  // namespace
+
+TEST_F(QuicTimerWheelTest, FiresInDeadlineOrder) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  QuicTimerWheelPointer wheel(new QuicTimerWheel(*env));
+  std::vector<int> fired;
+  std::unique_ptr<QuicTimer> timers[3];
+  for (int n = 0; n < 3; n++) {
+    timers[n] = std::make_unique<QuicTimer>(wheel.get(), [&, n]() {
+      fired.push_back(n);
+      timers[n]->Stop();
+    });
+  }
+
+  // 70ms is beyond the first level of the wheel and must
+  // be cascaded down before it fires.
+  timers[0]->Update(70);
+  timers[1]->Update(5);
+  timers[2]->Update(20);
+  CHECK_EQ(wheel->timer_count(), 3);
+
+  RunUntil((*env)->event_loop(), [&]() { return fired.size() == 3; });
+
+  CHECK_EQ(fired[0], 1);
+  CHECK_EQ(fired[1], 2);
+  CHECK_EQ(fired[2], 0);
+  CHECK_EQ(wheel->timer_count(), 0);
+}
+
+TEST_F(QuicTimerWheelTest, UpdateAndStop) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  QuicTimerWheelPointer wheel(new QuicTimerWheel(*env));
+  int repeating_count = 0;
+  int stopped_count = 0;
+  std::unique_ptr<QuicTimer> repeating;
+  repeating = std::make_unique<QuicTimer>(wheel.get(), [&]() {
+    if (++repeating_count == 3)
+      repeating->Stop();
+  });
+  QuicTimer stopped(wheel.get(), [&]() { stopped_count++; });
+
+  // Updating an active timer replaces its deadline.
+  repeating->Update(1000);
+  repeating->Update(2);
+  stopped.Update(1);
+  CHECK_EQ(wheel->timer_count(), 2);
+
+  // A stopped timer can no longer be used.
+  stopped.Stop();
+  stopped.Update(1);
+  CHECK(!stopped.is_active());
+  CHECK_EQ(wheel->timer_count(), 1);
+
+  RunUntil((*env)->event_loop(), [&]() { return repeating_count == 3; });
+
+  CHECK_EQ(stopped_count, 0);
+  CHECK(!repeating->is_active());
+  CHECK_EQ(wheel->timer_count(), 0);
+}
+
+TEST_F(QuicTimerWheelTest, TimersOutliveWheel) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  QuicTimerWheelPointer wheel(new QuicTimerWheel(*env));
+  QuicTimer timer(wheel.get(), []() { UNREACHABLE(); });
+  timer.Update(100000000);
+  CHECK(timer.is_active());
+
+  wheel.reset();
+  CHECK(!timer.is_active());
+
+  // The timer is inert once the wheel is gone.
+  timer.Update(1);
+  CHECK(!timer.is_active());
+}
+
+TEST_F(QuicTimerWheelTest, UnarmedTimersOutliveWheel) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env {handle_scope, argv};
+
+  QuicTimerWheelPointer wheel(new QuicTimerWheel(*env));
+  QuicTimer armed(wheel.get(), []() { UNREACHABLE(); });
+  QuicTimer unarmed(wheel.get(), []() { UNREACHABLE(); });
+  QuicTimer cancelled(wheel.get(), []() { UNREACHABLE(); });
+  armed.Update(100000000);
+  cancelled.Update(100000000);
+  cancelled.Cancel();
+  CHECK(!unarmed.is_active());
+  CHECK(!cancelled.is_active());
+
+  // Free the wheel and let libuv delete it, so that any use of
+  // the wheel by the timers below is a use after free.
+  wheel.reset();
+  uv_run((*env)->event_loop(), UV_RUN_NOWAIT);
+
+  unarmed.Update(1);
+  cancelled.Update(1);
+  CHECK(!unarmed.is_active());
+  CHECK(!cancelled.is_active());
+  unarmed.Cancel();
+  cancelled.Stop();
+}
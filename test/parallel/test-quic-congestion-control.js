@@ -0,0 +1,70 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that the congestion control algorithm selected with the
+// congestionControl option is used by both ends of a QuicSession,
+// and that data is transferred with each of them.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { once } = require('events');
+
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'zzz' };
+const data = Buffer.alloc(200000, 'a');
+
+async function test(congestionControl) {
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+
+  server.listen({ congestionControl });
+
+  server.on('session', common.mustCall((session) => {
+    session.on('secure', common.mustCall(() => {
+      assert.strictEqual(session.congestionControl,
+                         congestionControl || 'newreno');
+    }));
+    session.on('stream', common.mustCall((stream) => {
+      stream.resume();
+      stream.on('end', () => stream.end());
+    }));
+  }));
+
+  await once(server, 'ready');
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+    congestionControl,
+  });
+
+  await once(req, 'secure');
+  assert.strictEqual(req.congestionControl, congestionControl || 'newreno');
+
+  const stream = req.openStream();
+  stream.end(data);
+  stream.resume();
+  await once(stream, 'end');
+
+  // The window is maintained by the selected controller.
+  assert(req.congestionWindow > 0n);
+  assert.strictEqual(req.congestionControl, congestionControl || 'newreno');
+
+  server.close();
+  client.close();
+
+  await Promise.allSettled([
+    once(server, 'close'),
+    once(client, 'close')
+  ]);
+}
+
+(async () => {
+  for (const congestionControl of [undefined, 'newreno', 'cubic', 'bbr'])
+    await test(congestionControl);
+})().then(common.mustCall());
@@ -66,6 +66,18 @@ server.on('ready', common.mustCall(() => {
     });
   });
 
+  [0, Number.MAX_SAFE_INTEGER + 1].forEach((writeHighWaterMark) => {
+    assert.throws(() => req.openStream({ writeHighWaterMark }), {
+      code: 'ERR_OUT_OF_RANGE'
+    });
+  });
+
+  ['a', 1n, [], {}, false].forEach((writeHighWaterMark) => {
+    assert.throws(() => req.openStream({ writeHighWaterMark }), {
+      code: 'ERR_INVALID_ARG_TYPE'
+    });
+  });
+
   req.on('ready', common.mustCall());
   req.on('secure', common.mustCall());
 
@@ -101,12 +101,14 @@ const client = createQuicSocket();
   'maxAckDelay',
   'maxData',
   'maxPacketSize',
+  'maxPacingBurst',
   'maxStreamDataBidiLocal',
   'maxStreamDataBidiRemote',
   'maxStreamDataUni',
   'maxStreamsBidi',
   'maxStreamsUni',
   'highWaterMark',
+  'writeHighWaterMark',
 ].forEach((prop) => {
   assert.throws(() => client.connect({ [prop]: -1 }), {
     code: 'ERR_OUT_OF_RANGE'
@@ -124,6 +126,18 @@ const client = createQuicSocket();
   });
 });
 
+[1, 1n, false, [], {}, null].forEach((congestionControl) => {
+  assert.throws(() => client.connect({ congestionControl }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+['', 'reno', 'CUBIC'].forEach((congestionControl) => {
+  assert.throws(() => client.connect({ congestionControl }), {
+    code: 'ERR_INVALID_ARG_VALUE'
+  });
+});
+
 // activeConnectionIdLimit must be between 2 and 8, inclusive
 [1, 9].forEach((activeConnectionIdLimit) => {
   assert.throws(() => client.connect({ activeConnectionIdLimit }), {
@@ -204,9 +218,11 @@ assert.throws(() => client.connect(), {
 //  [x] idleTimeout - must be a number greater than zero
 //  [x] ipv6Only - must be a boolean
 //  [x] activeConnectionIdLimit - must be a number between 2 and 8
+//  [x] congestionControl - must be 'newreno', 'cubic' or 'bbr'
 //  [x] maxAckDelay - must be a number greater than zero
 //  [x] maxData - must be a number greater than zero
 //  [x] maxPacketSize - must be a number greater than zero
+//  [x] maxPacingBurst - must be a number greater than zero
 //  [x] maxStreamDataBidiLocal - must be a number greater than zero
 //  [x] maxStreamDataBidiRemote - must be a number greater than zero
 //  [x] maxStreamDataUni - must be a number greater than zero
@@ -89,6 +89,20 @@ const { createQuicSocket } = require('net');
   });
 });
 
+// Test invalid QuicSocket batchEvents argument option
+[1, NaN, 1n, null, {}, []].forEach((batchEvents) => {
+  assert.throws(() => createQuicSocket({ batchEvents }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+// Test invalid QuicSocket batchSend argument option
+[1, NaN, 1n, null, {}, []].forEach((batchSend) => {
+  assert.throws(() => createQuicSocket({ batchSend }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
 // Test invalid QuicSocket qlog argument option
 [1, NaN, 1n, null, {}, []].forEach((qlog) => {
   assert.throws(() => createQuicSocket({ qlog }), {
@@ -96,6 +110,37 @@ const { createQuicSocket } = require('net');
   });
 });
 
+// Test invalid QuicSocket histograms argument option
+[1, 1n, null, {}, [], false].forEach((histograms) => {
+  assert.throws(() => createQuicSocket({ histograms }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+assert.throws(() => createQuicSocket({ histograms: 'always' }), {
+  code: 'ERR_INVALID_ARG_VALUE'
+});
+
+// Test invalid QuicSocket qlogDir argument option
+[1, 1n, null, {}, [], false].forEach((qlogDir) => {
+  assert.throws(() => createQuicSocket({ qlogDir }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+// Test invalid QuicSocket qlogSampleRate argument option
+['test', 1n, null, {}, [], false].forEach((qlogSampleRate) => {
+  assert.throws(() => createQuicSocket({ qlogSampleRate }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+[-0.1, 1.1, NaN].forEach((qlogSampleRate) => {
+  assert.throws(() => createQuicSocket({ qlogSampleRate }), {
+    code: 'ERR_OUT_OF_RANGE'
+  });
+});
+
 
 // Test invalid QuicSocket retryTokenTimeout option
 [0, 61, NaN].forEach((retryTokenTimeout) => {
@@ -174,6 +219,121 @@ const { createQuicSocket } = require('net');
   });
 });
 
+// Test invalid QuicSocket validateAddressLRUSize and addressSketchSize options
+[0, 65537, 1.5, NaN].forEach((validateAddressLRUSize) => {
+  assert.throws(() => createQuicSocket({ validateAddressLRUSize }), {
+    code: 'ERR_OUT_OF_RANGE'
+  });
+});
+
+[0, 15, 1048577, 1.5, NaN].forEach((addressSketchSize) => {
+  assert.throws(() => createQuicSocket({ addressSketchSize }), {
+    code: 'ERR_OUT_OF_RANGE'
+  });
+});
+
+['test', null, 1n, {}, [], false].forEach((value) => {
+  assert.throws(() => createQuicSocket({ validateAddressLRUSize: value }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+  assert.throws(() => createQuicSocket({ addressSketchSize: value }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+// Test invalid QuicSocket tokenSecret option
+[1, 1n, false, 'test', {}, []].forEach((tokenSecret) => {
+  assert.throws(() => createQuicSocket({ tokenSecret }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+assert.throws(() => createQuicSocket({ tokenSecret: Buffer.alloc(15) }), {
+  code: 'ERR_INVALID_ARG_VALUE'
+});
+
+// Test invalid QuicSocket ticketKeySecret option
+[1, 1n, false, 'test', {}, []].forEach((ticketKeySecret) => {
+  assert.throws(() => createQuicSocket({ ticketKeySecret }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+assert.throws(() => createQuicSocket({ ticketKeySecret: Buffer.alloc(16) }), {
+  code: 'ERR_INVALID_ARG_VALUE'
+});
+
+// Test invalid QuicSocket ticketKeyRotation option
+[0, 59, 7 * 24 * 60 * 60 + 1, 1.5, NaN].forEach((ticketKeyRotation) => {
+  assert.throws(() => createQuicSocket({ ticketKeyRotation }), {
+    code: 'ERR_OUT_OF_RANGE'
+  });
+});
+['test', null, 1n, {}, [], false].forEach((ticketKeyRotation) => {
+  assert.throws(() => createQuicSocket({ ticketKeyRotation }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+// Test invalid QuicSocket workerId option
+[-1, 256, 1.5, NaN].forEach((workerId) => {
+  assert.throws(() => createQuicSocket({ workerId }), {
+    code: 'ERR_OUT_OF_RANGE'
+  });
+});
+['test', null, 1n, {}, [], false].forEach((workerId) => {
+  assert.throws(() => createQuicSocket({ workerId }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
+// Test invalid QuicSocket workerForwarding option
+[1, 1n, false, 'test', {}, null].forEach((workerForwarding) => {
+  assert.throws(() => createQuicSocket({ workerId: 0, workerForwarding }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+{
+  const peer = { address: '127.0.0.1', port: 1234 };
+  // The workerId option is required, and must index the array.
+  assert.throws(() => createQuicSocket({ workerForwarding: [peer] }), {
+    code: 'ERR_INVALID_ARG_VALUE'
+  });
+  assert.throws(() => createQuicSocket({
+    workerId: 1,
+    workerForwarding: [peer],
+  }), {
+    code: 'ERR_INVALID_ARG_VALUE'
+  });
+  [1, 'test', null].forEach((entry) => {
+    assert.throws(() => createQuicSocket({
+      workerId: 0,
+      workerForwarding: [entry],
+    }), {
+      code: 'ERR_INVALID_ARG_TYPE'
+    });
+  });
+  assert.throws(() => createQuicSocket({
+    workerId: 0,
+    workerForwarding: [{ address: 'localhost', port: 1234 }],
+  }), {
+    code: 'ERR_INVALID_ARG_VALUE'
+  });
+  [0, -1, 65536].forEach((port) => {
+    assert.throws(() => createQuicSocket({
+      workerId: 0,
+      workerForwarding: [{ address: '127.0.0.1', port }],
+    }), {
+      code: 'ERR_SOCKET_BAD_PORT'
+    });
+  });
+}
+
+// Test invalid QuicSocket endpoint reusePort option
+[1, 1n, 'test', {}, [], null].forEach((reusePort) => {
+  assert.throws(() => createQuicSocket({ endpoint: { reusePort } }), {
+    code: 'ERR_INVALID_ARG_TYPE'
+  });
+});
+
 [1, 1n, false, 'test'].forEach((options) => {
   assert.throws(() => createQuicSocket({ endpoint: options }), {
     code: 'ERR_INVALID_ARG_TYPE'
@@ -56,12 +56,14 @@ const { createQuicSocket } = require('net');
     'maxAckDelay',
     'maxData',
     'maxPacketSize',
+    'maxPacingBurst',
     'maxStreamDataBidiLocal',
     'maxStreamDataBidiRemote',
     'maxStreamDataUni',
     'maxStreamsBidi',
     'maxStreamsUni',
     'highWaterMark',
+    'writeHighWaterMark',
   ].forEach((prop) => {
     assert.throws(() => server.listen({ [prop]: -1 }), {
       code: 'ERR_OUT_OF_RANGE'
@@ -79,6 +81,18 @@ const { createQuicSocket } = require('net');
     });
   });
 
+  [1, 1n, false, [], {}, null].forEach((congestionControl) => {
+    assert.throws(() => server.listen({ congestionControl }), {
+      code: 'ERR_INVALID_ARG_TYPE'
+    });
+  });
+
+  ['', 'reno', 'CUBIC'].forEach((congestionControl) => {
+    assert.throws(() => server.listen({ congestionControl }), {
+      code: 'ERR_INVALID_ARG_VALUE'
+    });
+  });
+
   [1, 1n, 'test', {}, []].forEach((rejectUnauthorized) => {
     assert.throws(() => server.listen({ rejectUnauthorized }), {
       code: 'ERR_INVALID_ARG_TYPE'
@@ -133,6 +147,12 @@ const { createQuicSocket } = require('net');
     });
   });
 
+  [1, 1n, 'true', [], {}, null].forEach((offloadHandshake) => {
+    assert.throws(() => server.listen({ offloadHandshake }), {
+      code: 'ERR_INVALID_ARG_TYPE'
+    });
+  });
+
   ['', 1n, {}, [], false, 'zebra'].forEach((defaultEncoding) => {
     assert.throws(() => server.listen({ defaultEncoding }), {
       code: 'ERR_INVALID_ARG_VALUE'
@@ -150,9 +170,11 @@ const { createQuicSocket } = require('net');
 // * [x] alpn
 // * [x] idleTimeout
 // * [x] activeConnectionIdLimit
+// * [x] congestionControl
 // * [x] maxAckDelay
 // * [x] maxData
 // * [x] maxPacketSize
+// * [x] maxPacingBurst
 // * [x] maxStreamsBidi
 // * [x] maxStreamsUni
 // * [x] maxStreamDataBidiLocal
@@ -173,6 +195,7 @@ const { createQuicSocket } = require('net');
 // * [ ] ecdhCurve
 // * [ ] honorCipherOrder
 // * [ ] key
+// * [x] offloadHandshake
 // * [ ] passphrase
 // * [ ] pfx
 // * [ ] secureOptions
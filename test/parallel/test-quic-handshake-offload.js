@@ -0,0 +1,77 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that a server handshake completes, and that the clientHello and
+// keylog events are still emitted, when the handshake signature is
+// offloaded to the threadpool.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { once } = require('events');
+
+const { createQuicSocket } = require('net');
+
+const kALPN = 'zzz';
+const options = { key, cert, ca, alpn: kALPN };
+
+(async () => {
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+
+  server.listen({ offloadHandshake: true });
+
+  server.on('session', common.mustCall((session) => {
+    session.on('clientHello', common.mustCall(
+      (alpn, servername, ciphers, cb) => {
+        assert.strictEqual(alpn, kALPN);
+        // Resolved asynchronously, while the handshake is paused.
+        setImmediate(cb);
+      }));
+
+    session.on('keylog', common.mustCallAtLeast((line) => {
+      assert(Buffer.isBuffer(line));
+    }));
+
+    session.on('secure', common.mustCall(() => {
+      // The signature was computed on the threadpool rather
+      // than on the event loop.
+      assert(session.handshakeOffloadCount > 0n);
+    }));
+
+    session.on('stream', common.mustCall((stream) => {
+      stream.end('hello');
+      stream.resume();
+    }));
+  }));
+
+  await once(server, 'ready');
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+  });
+
+  await once(req, 'secure');
+  // Only the server offloads its handshake.
+  assert.strictEqual(req.handshakeOffloadCount, 0n);
+
+  const stream = req.openStream();
+  stream.end('world');
+  let data = '';
+  stream.setEncoding('utf8');
+  stream.on('data', (chunk) => data += chunk);
+  await once(stream, 'end');
+  assert.strictEqual(data, 'hello');
+
+  server.close();
+  client.close();
+
+  await Promise.allSettled([
+    once(server, 'close'),
+    once(client, 'close')
+  ]);
+})().then(common.mustCall());
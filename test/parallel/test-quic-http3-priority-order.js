@@ -0,0 +1,86 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that the response for a more urgent request is sent ahead of
+// the response for a less urgent request that was received earlier.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const { key, cert, ca, kHttp3Alpn } = require('../common/quic');
+const { once } = require('events');
+
+const { createQuicSocket } = require('net');
+
+// Large enough that the responses cannot be sent in one flight.
+const kResponse = Buffer.alloc(1024 * 1024, 'a');
+const options = { key, cert, ca, alpn: kHttp3Alpn };
+
+// The less urgent request is sent first.
+const requests = [ 'u=7', 'u=0' ];
+
+(async () => {
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+
+  server.listen();
+
+  server.on('session', common.mustCall((session) => {
+    const streams = [];
+    session.on('stream', common.mustCall((stream) => {
+      stream.on('initialHeaders', common.mustCall(() => {
+        stream.resume();
+        // Both responses are queued only once both requests have been
+        // received, the less urgent one first, so that their data has
+        // to be ordered by priority.
+        streams.push(stream);
+        if (streams.length < requests.length)
+          return;
+        streams.sort((a, b) => b.priority.urgency - a.priority.urgency);
+        for (const stream of streams) {
+          assert(stream.submitInitialHeaders({ ':status': '200' }));
+          stream.end(kResponse);
+        }
+      }));
+    }, requests.length));
+  }));
+
+  await once(server, 'ready');
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+  });
+
+  await once(req, 'secure');
+
+  const finished = [];
+  await Promise.all(requests.map(async (priority) => {
+    const stream = req.openStream();
+    assert(stream.submitInitialHeaders({
+      ':method': 'GET',
+      ':scheme': 'https',
+      ':authority': 'localhost',
+      ':path': '/',
+      priority,
+    }));
+    stream.end();
+    let received = 0;
+    stream.on('data', (chunk) => received += chunk.length);
+    await once(stream, 'end');
+    assert.strictEqual(received, kResponse.length);
+    finished.push(priority);
+  }));
+
+  assert.deepStrictEqual(finished, [ 'u=0', 'u=7' ]);
+
+  server.close();
+  client.close();
+
+  await Promise.allSettled([
+    once(server, 'close'),
+    once(client, 'close')
+  ]);
+})().then(common.mustCall());
@@ -0,0 +1,84 @@
+// Flags: --expose-internals --no-warnings
+'use strict';
+
+// Tests that the urgency and incremental parameters of the HTTP/3
+// priority header are applied to the QuicStream on both ends.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const Countdown = require('../common/countdown');
+const assert = require('assert');
+const { key, cert, ca, kHttp3Alpn } = require('../common/quic');
+
+const { createQuicSocket } = require('net');
+
+let client;
+const server = createQuicSocket();
+
+const countdown = new Countdown(2, () => {
+  server.close();
+  client.close();
+});
+
+const options = { key, cert, ca, alpn: kHttp3Alpn };
+
+// Each request is sent with the given priority header value
+// and is expected to result in the given priority.
+const requests = [
+  [ 'u=1, i', { urgency: 1, incremental: true } ],
+  [ 'i=?0;a=1, x=2, u=9', { urgency: 3, incremental: false } ],
+];
+
+server.listen(options);
+
+server.on('session', common.mustCall((session) => {
+  session.on('stream', common.mustCall((stream) => {
+    stream.on('initialHeaders', common.mustCall((headers) => {
+      const path = headers.find(([name]) => name === ':path')[1];
+      const [, expected] = requests[path.slice(1)];
+      assert.deepStrictEqual(stream.priority, expected);
+
+      assert(stream.submitInitialHeaders({ ':status': '200' }));
+      stream.end('hello world');
+    }));
+    stream.resume();
+  }, requests.length));
+
+  session.on('close', common.mustCall());
+}));
+
+server.on('ready', common.mustCall(() => {
+  client = createQuicSocket({ client: options });
+  client.on('close', common.mustCall());
+
+  const req = client.connect({
+    address: 'localhost',
+    port: server.endpoints[0].address.port,
+  });
+
+  req.on('close', common.mustCall());
+  req.on('secure', common.mustCall(() => {
+    requests.forEach(([priority, expected], n) => {
+      const stream = req.openStream();
+
+      assert(stream.submitInitialHeaders({
+        ':method': 'POST',
+        ':scheme': 'https',
+        ':authority': 'localhost',
+        ':path': `/${n}`,
+        priority,
+      }));
+      assert.deepStrictEqual(stream.priority, expected);
+
+      stream.end('hello world');
+      stream.resume();
+      stream.on('initialHeaders', common.mustCall());
+      stream.on('close', common.mustCall(() => countdown.dec()));
+    });
+  }));
+}));
+
+server.on('listening', common.mustCall());
+server.on('close', common.mustCall());
@@ -0,0 +1,54 @@
+// Flags: --no-warnings
+'use strict';
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+// Tests that a client that reconnects to a server that requires address
+// validation presents the token it received in a NEW_TOKEN frame and is
+// not sent a second RETRY.
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'meow' };
+
+const server = createQuicSocket({ validateAddress: true, server: options });
+let client;
+
+server.listen();
+server.on('session', common.mustCall((session) => {
+  session.on('secure', common.mustCall(() => {
+    const stream = session.openStream({ halfOpen: true });
+    stream.end('Hi!');
+  }));
+}, 2));
+
+function connect(callback) {
+  const req = client.connect({
+    address: 'localhost',
+    port: server.endpoints[0].address.port,
+  });
+  req.on('stream', common.mustCall((stream) => {
+    stream.resume();
+    stream.on('end', common.mustCall(() => req.close()));
+  }));
+  req.on('close', common.mustCall(callback));
+}
+
+server.on('ready', common.mustCall(() => {
+  client = createQuicSocket({ client: options });
+
+  connect(common.mustCall(() => {
+    assert.strictEqual(server.retryCount, 1n);
+    assert.strictEqual(server.newTokenCount, 0n);
+
+    connect(common.mustCall(() => {
+      assert.strictEqual(server.retryCount, 1n);
+      assert.strictEqual(server.newTokenCount, 1n);
+      client.close();
+      server.close();
+    }));
+  }));
+}));
@@ -0,0 +1,72 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that path MTU discovery probes for a larger packet size once
+// the handshake is confirmed, reports the size in use, and that probing
+// does not cause a congestion event.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { once } = require('events');
+
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'zzz' };
+const data = Buffer.alloc(100000, 'a');
+
+(async () => {
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+
+  server.listen();
+
+  server.on('session', common.mustCall((session) => {
+    session.on('stream', common.mustCall((stream) => {
+      stream.resume();
+      stream.on('end', () => stream.end());
+    }));
+  }));
+
+  await once(server, 'ready');
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+  });
+
+  await once(req, 'secure');
+  assert.strictEqual(req.pathMtu, 1252n);
+  const ssthresh = req.slowStartThreshold;
+  const cwnd = req.congestionWindow;
+
+  const stream = req.openStream();
+  stream.end(data);
+  stream.resume();
+  await once(stream, 'end');
+
+  assert(req.pathMtu >= 1252n);
+  // Sockets are created so that datagrams are never fragmented,
+  // which discovery depends on, on Linux. The loopback interface
+  // carries the largest length that is searched for.
+  if (common.isLinux) {
+    assert(req.pathMtuProbeCount > 0n);
+    assert(req.pathMtu > 1252n);
+  }
+
+  // Probes are not congestion controlled data, so neither sending
+  // nor losing them may reduce the congestion window.
+  assert.strictEqual(req.slowStartThreshold, ssthresh);
+  assert(req.congestionWindow >= cwnd);
+
+  server.close();
+  client.close();
+
+  await Promise.allSettled([
+    once(server, 'close'),
+    once(client, 'close')
+  ]);
+})().then(common.mustCall());
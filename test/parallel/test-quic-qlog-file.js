@@ -0,0 +1,98 @@
+// Flags: --expose-internals --expose-gc --no-warnings
+'use strict';
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+// Tests that qlog output is written to files in the qlogDir
+// directory, and that sessions selected by qlogSampleRate are
+// traced without the qlog option.
+
+const { makeUDPPair } = require('../common/udppair');
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const { createQuicSocket } = require('net');
+const { kUDPHandleForTesting } = require('internal/quic/core');
+
+const { key, cert, ca } = require('../common/quic');
+
+const tmpdir = require('../common/tmpdir');
+tmpdir.refresh();
+
+const { serverSide, clientSide } = makeUDPPair();
+
+const server = createQuicSocket({
+  endpoint: { [kUDPHandleForTesting]: serverSide._handle },
+  qlogDir: tmpdir.path,
+  qlogSampleRate: 1
+});
+
+serverSide.afterBind();
+server.listen({ key, cert, ca, alpn: 'meow' });
+
+server.on('session', common.mustCall((session) => {
+  session.on('qlog', common.mustNotCall());
+  session.on('secure', common.mustCall(() => {
+    const stream = session.openStream({ halfOpen: true });
+    stream.end('Hi!');
+  }));
+}));
+
+server.on('ready', common.mustCall(() => {
+  const client = createQuicSocket({
+    endpoint: { [kUDPHandleForTesting]: clientSide._handle },
+    client: { key, cert, ca, alpn: 'meow' },
+    qlogDir: tmpdir.path
+  });
+  clientSide.afterBind();
+
+  const req = client.connect({
+    address: 'localhost',
+    port: server.endpoints[0].address.port,
+    qlog: true
+  });
+
+  req.on('qlog', common.mustNotCall());
+
+  req.on('stream', common.mustCall((stream) => {
+    stream.resume();
+    stream.on('end', common.mustCall(() => {
+      req.close();
+    }));
+  }));
+
+  req.on('close', common.mustCall(() => {
+    client.close();
+    server.close();
+    waitForTraces();
+  }));
+}));
+
+// The last of a trace is written when the native session is
+// destroyed, and the file itself is written on a separate thread,
+// so poll until both traces are complete.
+function waitForTraces() {
+  global.gc();
+  const traces = fs.readdirSync(tmpdir.path)
+    .filter((name) => path.extname(name) === '.qlog')
+    .map((name) => {
+      try {
+        return JSON.parse(fs.readFileSync(path.join(tmpdir.path, name)));
+      } catch {
+        return undefined;
+      }
+    });
+  if (traces.length < 2 || traces.includes(undefined)) {
+    setTimeout(waitForTraces, 10);
+    return;
+  }
+  assert.strictEqual(traces.length, 2);
+  for (const { qlog_version, traces: [trace] } of traces) {
+    assert.strictEqual(typeof qlog_version, 'string');
+    assert.strictEqual(typeof trace.events, 'object');
+  }
+  assert.deepStrictEqual(
+    fs.readdirSync(tmpdir.path).map((name) => name.split('-')[0]).sort(),
+    ['client', 'server']);
+}
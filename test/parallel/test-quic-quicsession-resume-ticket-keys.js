@@ -0,0 +1,93 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that a session ticket issued by one QuicSocket resumes a
+// session on another QuicSocket sharing its ticket key secret, and
+// that explicitly set ticket keys can be shared in the same way.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { once } = require('events');
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'zzz' };
+
+async function getTicket(client, server) {
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+  });
+  const [ticket, params] = await once(req, 'sessionTicket');
+  req.destroy();
+  return { sessionTicket: ticket, remoteTransportParams: params };
+}
+
+async function resume(client, server, ticket, resumed) {
+  server.once('session', common.mustCall((session) => {
+    session.on('secure', common.mustCall(() => {
+      assert.strictEqual(session.usingEarlyData, resumed);
+    }));
+  }));
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+    ...ticket,
+  });
+  await once(req, 'secure');
+  req.destroy();
+}
+
+async function test(first, second, resumed) {
+  const client = createQuicSocket({ client: options });
+  first.listen(options);
+  second.listen(options);
+  await Promise.all([once(first, 'ready'), once(second, 'ready')]);
+
+  const ticket = await getTicket(client, first);
+  await resume(client, second, ticket, resumed);
+
+  client.close();
+  first.close();
+  second.close();
+}
+
+(async () => {
+  // Sockets sharing a ticket key secret accept each other's tickets.
+  const ticketKeySecret = Buffer.alloc(32, 1);
+  await test(
+    createQuicSocket({ ticketKeySecret }),
+    createQuicSocket({ ticketKeySecret }),
+    true);
+
+  // Sockets with different secrets fall back to a full handshake.
+  await test(createQuicSocket(), createQuicSocket(), false);
+
+  // Explicitly set ticket keys are shared the same way.
+  {
+    const first = createQuicSocket();
+    const second = createQuicSocket();
+    const keys = Buffer.alloc(48 * 2, 2);
+    first.setTicketKeys(keys);
+    second.setTicketKeys(keys);
+    await test(first, second, true);
+  }
+})().then(common.mustCall());
+
+{
+  const socket = createQuicSocket();
+  [1, 'test', {}, [], null].forEach((keys) => {
+    assert.throws(() => socket.setTicketKeys(keys), {
+      code: 'ERR_INVALID_ARG_TYPE'
+    });
+  });
+  [0, 47, 49, 48 * 17].forEach((length) => {
+    assert.throws(() => socket.setTicketKeys(Buffer.alloc(length)), {
+      code: 'ERR_INVALID_ARG_VALUE'
+    });
+  });
+  socket.close();
+}
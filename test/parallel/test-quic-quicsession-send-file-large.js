@@ -0,0 +1,86 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that files larger than the amount read ahead of sending are
+// sent in full by sendFile, and that ranges of them are sent by sendFD.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const { key, cert, ca } = require('../common/quic');
+const { once } = require('events');
+
+const { createQuicSocket } = require('net');
+
+const tmpdir = require('../common/tmpdir');
+tmpdir.refresh();
+
+const options = { key, cert, ca, alpn: 'zzz' };
+const filename = path.join(tmpdir.path, 'large');
+const content = Buffer.alloc(1024 * 1024 + 123);
+for (let n = 0; n < content.length; n++)
+  content[n] = n % 251;
+fs.writeFileSync(filename, content);
+
+const variants = [
+  { offset: -1, length: -1 },
+  { offset: 70000, length: -1 },
+  { offset: 12345, length: 300000 },
+];
+
+(async () => {
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+
+  server.listen();
+
+  server.on('session', common.mustCall((session) => {
+    session.on('stream', common.mustCall((stream) => {
+      stream.once('data', common.mustCall((data) => {
+        const { offset, length } = variants[data[0]];
+        if (offset === -1) {
+          stream.sendFile(filename);
+        } else {
+          const fd = fs.openSync(filename, 'r');
+          stream.sendFD(fd, { offset, length });
+          stream.on('close', () => fs.closeSync(fd));
+        }
+      }));
+    }, variants.length));
+  }));
+
+  await once(server, 'ready');
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+  });
+
+  await once(req, 'secure');
+
+  for (let n = 0; n < variants.length; n++) {
+    const { offset, length } = variants[n];
+    let expected = content;
+    if (offset !== -1) expected = expected.slice(offset);
+    if (length !== -1) expected = expected.slice(0, length);
+
+    const stream = req.openStream();
+    stream.end(Buffer.from([n]));
+    const data = [];
+    stream.on('data', (chunk) => data.push(chunk));
+    await once(stream, 'end');
+    assert.deepStrictEqual(Buffer.concat(data), expected);
+  }
+
+  server.close();
+  client.close();
+
+  await Promise.allSettled([
+    once(server, 'close'),
+    once(client, 'close')
+  ]);
+})().then(common.mustCall());
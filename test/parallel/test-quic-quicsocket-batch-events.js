@@ -0,0 +1,72 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that, with the batchEvents option, the stream events of many
+// concurrently opened streams are delivered, and delivered before the
+// data of the streams, and that the events are passed to JavaScript
+// in batches.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { once } = require('events');
+
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'zzz' };
+const kStreams = 50;
+
+(async () => {
+  const server = createQuicSocket({ batchEvents: true, server: options });
+  const client = createQuicSocket({ batchEvents: true, client: options });
+
+  server.listen();
+
+  server.on('session', common.mustCall((session) => {
+    session.on('stream', common.mustCall((stream) => {
+      const data = [];
+      stream.on('data', (chunk) => data.push(chunk));
+      stream.on('end', common.mustCall(() => {
+        stream.end(Buffer.concat(data));
+      }));
+    }, kStreams));
+  }));
+
+  await once(server, 'ready');
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+  });
+
+  await once(req, 'secure');
+
+  await Promise.all(Array.from({ length: kStreams }, async (_, n) => {
+    const stream = req.openStream();
+    const expected = Buffer.alloc(100 + n, n);
+    stream.end(expected);
+    const data = [];
+    stream.on('data', (chunk) => data.push(chunk));
+    await once(stream, 'close');
+    assert.deepStrictEqual(Buffer.concat(data), expected);
+  }));
+
+  // Every event has been passed to JavaScript through a batch, and at
+  // least some of the batches held more than one event.
+  const events = server.batchedEventCount + client.batchedEventCount;
+  const batches = server.eventBatchCount + client.eventBatchCount;
+  assert(server.batchedEventCount >= BigInt(kStreams));
+  assert(client.batchedEventCount > 0n);
+  assert(events > batches);
+
+  server.close();
+  client.close();
+
+  await Promise.allSettled([
+    once(server, 'close'),
+    once(client, 'close')
+  ]);
+})().then(common.mustCall());
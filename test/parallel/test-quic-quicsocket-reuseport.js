@@ -0,0 +1,36 @@
+// Flags: --no-warnings
+'use strict';
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+if (common.isWindows)
+  common.skip('SO_REUSEPORT is not supported on Windows');
+
+// Tests that QuicSockets whose endpoints set the reusePort option can
+// bind to the same address and port.
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'meow' };
+
+const first = createQuicSocket({
+  endpoint: { address: '127.0.0.1', reusePort: true },
+  server: options,
+});
+
+first.listen();
+first.on('ready', common.mustCall(() => {
+  const port = first.endpoints[0].address.port;
+  const second = createQuicSocket({
+    endpoint: { address: '127.0.0.1', port, reusePort: true },
+    server: options,
+  });
+  second.listen();
+  second.on('ready', common.mustCall(() => {
+    assert.strictEqual(second.endpoints[0].address.port, port);
+    second.close();
+    first.close();
+  }));
+}));
@@ -41,6 +41,12 @@ assert.strictEqual(socket.packetsReceived, 0n);
 assert.strictEqual(socket.packetsSent, 0n);
 assert.strictEqual(socket.serverSessions, 0n);
 assert.strictEqual(socket.clientSessions, 0n);
+assert.strictEqual(socket.sendBatchCount, 0n);
+assert.strictEqual(socket.packetPoolHits, 0n);
+assert.strictEqual(socket.packetPoolMisses, 0n);
+assert.strictEqual(socket.qlogBytesDropped, 0n);
+assert.strictEqual(socket.eventBatchCount, 0n);
+assert.strictEqual(socket.batchedEventCount, 0n);
 
 const endpoint = socket.endpoints[0];
 assert(endpoint);
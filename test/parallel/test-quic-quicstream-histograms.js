@@ -0,0 +1,73 @@
+// Flags: --expose-internals --no-warnings
+'use strict';
+
+// Tests the histograms option of QuicSocket. The server shares one
+// set of histograms among all of its QuicStreams, while the client
+// allocates histograms for each QuicStream as it is created.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const Countdown = require('../common/countdown');
+const assert = require('assert');
+const { debug, key, cert } = require('../common/quic');
+const { kHandle } = require('internal/histogram');
+
+const { createQuicSocket } = require('net');
+const options = { key, cert, alpn: 'zzz' };
+
+let client;
+const server = createQuicSocket({ server: options, histograms: 'shared' });
+
+const countdown = new Countdown(2, () => {
+  debug('Countdown expired. Closing sockets');
+  server.close();
+  client.close();
+});
+
+server.listen();
+server.on('session', common.mustCall((session) => {
+  session.on('secure', common.mustCall(() => {
+    const streams = [
+      session.openStream({ halfOpen: true }),
+      session.openStream({ halfOpen: true }),
+    ];
+    for (const stream of streams)
+      stream.end('test');
+
+    const [a, b] = streams;
+    assert.notStrictEqual(a.dataAckHistogram, b.dataAckHistogram);
+    assert.strictEqual(a.dataAckHistogram[kHandle],
+                       b.dataAckHistogram[kHandle]);
+    assert.strictEqual(a.dataRateHistogram[kHandle],
+                       b.dataRateHistogram[kHandle]);
+    assert.strictEqual(a.dataSizeHistogram[kHandle],
+                       b.dataSizeHistogram[kHandle]);
+    assert.notStrictEqual(a.dataAckHistogram[kHandle],
+                          a.dataRateHistogram[kHandle]);
+    assert.notStrictEqual(a.dataAckHistogram[kHandle],
+                          session.handshakeAckHistogram[kHandle]);
+  }));
+}));
+
+server.on('ready', common.mustCall(() => {
+  client = createQuicSocket({ client: options, histograms: 'eager' });
+
+  const req = client.connect({
+    address: 'localhost',
+    port: server.endpoints[0].address.port,
+  });
+
+  req.on('stream', common.mustCall((stream) => {
+    stream.resume();
+    stream.on('end', common.mustCall(() => {
+      // The size histogram has been recording since the stream was
+      // created, before it was first accessed.
+      assert.strictEqual(stream.dataSizeHistogram.max, 4);
+      countdown.dec();
+    }));
+  }, 2));
+}));
+
+server.on('close', common.mustCall());
@@ -0,0 +1,100 @@
+// Flags: --no-warnings
+'use strict';
+
+// Test that QuicStream priorities can be set and read, and that the
+// data for a more urgent stream is sent before that of a less urgent
+// stream that started sending first.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const {
+  debug,
+  key,
+  cert,
+  ca
+} = require('../common/quic');
+
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'zzz' };
+
+const server = createQuicSocket({ server: options });
+
+const largeData = Buffer.alloc(1024 * 1024, 'a');
+const smallData = Buffer.from('urgent');
+
+server.listen();
+
+server.on('session', common.mustCall((session) => {
+  debug('QuicServerSession Created');
+
+  const ended = [];
+  session.on('stream', common.mustCall((stream) => {
+    let length = 0;
+    stream.on('data', (chunk) => length += chunk.length);
+    stream.on('end', common.mustCall(() => {
+      debug('Stream %d ended with %d bytes', stream.id, length);
+      ended.push(length);
+      if (ended.length === 2) {
+        assert.deepStrictEqual(ended, [smallData.length, largeData.length]);
+        session.close();
+      }
+    }));
+    stream.end();
+  }, 2));
+}));
+
+server.on('ready', common.mustCall(() => {
+  debug('Server is listening on port %d', server.endpoints[0].address.port);
+
+  const client = createQuicSocket({ client: options });
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port
+  });
+
+  req.on('secure', common.mustCall(() => {
+    debug('QuicClientSession TLS Handshake Complete');
+
+    const large = req.openStream();
+    assert.deepStrictEqual(large.priority, { urgency: 3, incremental: false });
+    large.setPriority({ urgency: 7 });
+    assert.deepStrictEqual(large.priority, { urgency: 7, incremental: false });
+    large.end(largeData);
+
+    const small = req.openStream();
+    small.setPriority({ urgency: 0, incremental: true });
+    assert.deepStrictEqual(small.priority, { urgency: 0, incremental: true });
+    small.end(smallData);
+
+    [-1, 8, 1.5].forEach((urgency) => {
+      assert.throws(() => small.setPriority({ urgency }), {
+        code: 'ERR_OUT_OF_RANGE'
+      });
+    });
+    ['a', 1n, null, {}].forEach((urgency) => {
+      assert.throws(() => small.setPriority({ urgency }), {
+        code: 'ERR_INVALID_ARG_TYPE'
+      });
+    });
+    [1, 'a', null].forEach((incremental) => {
+      assert.throws(() => small.setPriority({ incremental }), {
+        code: 'ERR_INVALID_ARG_TYPE'
+      });
+    });
+
+    large.resume();
+    small.resume();
+  }));
+
+  req.on('close', common.mustCall(() => {
+    client.close();
+    server.close();
+  }));
+}));
+
+server.on('listening', common.mustCall());
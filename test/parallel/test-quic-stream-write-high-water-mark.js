@@ -0,0 +1,95 @@
+// Flags: --no-warnings
+'use strict';
+
+// Tests that, with the writeHighWaterMark option, writes to a QuicStream
+// complete before their data is acknowledged, that no more than the mark
+// is buffered for a write that has not completed, and that bufferSize
+// counts the data of every write exactly once, with and without the option.
+
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+const assert = require('assert');
+const { key, cert, ca } = require('../common/quic');
+const { once } = require('events');
+const { promisify } = require('util');
+
+const { createQuicSocket } = require('net');
+
+const options = { key, cert, ca, alpn: 'zzz' };
+const kChunks = 8;
+const chunk = Buffer.alloc(16384, 'a');
+
+(async () => {
+  const server = createQuicSocket({ server: options });
+  const client = createQuicSocket({ client: options });
+
+  server.listen();
+
+  server.on('session', common.mustCall((session) => {
+    session.on('stream', common.mustCall((stream) => {
+      let received = 0;
+      stream.on('data', (data) => received += data.length);
+      stream.on('end', common.mustCall(() => {
+        assert.strictEqual(received, stream.id === 0 ?
+          kChunks * chunk.length : chunk.length);
+        stream.end();
+      }));
+    }, 3));
+  }));
+
+  await once(server, 'ready');
+
+  const req = client.connect({
+    address: common.localhostIPv4,
+    port: server.endpoints[0].address.port,
+  });
+
+  await once(req, 'secure');
+
+  const stream = req.openStream({ writeHighWaterMark: 1024 * 1024 });
+  assert(!stream.pending);
+
+  const write = promisify(stream.write.bind(stream));
+  for (let n = 0; n < kChunks; n++) {
+    await write(chunk);
+    // The write completed without waiting for the peer to
+    // acknowledge the data.
+    assert(stream.bufferSize > 0);
+  }
+  stream.end();
+  stream.resume();
+
+  await once(stream, 'close');
+
+  // A write larger than the mark does not complete synchronously, and
+  // its data is counted once while it is in flight.
+  const large = req.openStream({ writeHighWaterMark: 1024 });
+  let completed = false;
+  large.write(chunk, common.mustCall(() => completed = true));
+  assert(!completed);
+  assert.strictEqual(large.bufferSize, chunk.length);
+  large.end();
+  large.resume();
+  await once(large, 'close');
+  assert(completed);
+
+  // Without the option, the data of a write is counted once until
+  // the write completes with the acknowledgement of the data.
+  const zeroCopy = req.openStream();
+  zeroCopy.write(chunk, common.mustCall());
+  assert.strictEqual(zeroCopy.bufferSize, chunk.length);
+  zeroCopy.end();
+  zeroCopy.resume();
+  await once(zeroCopy, 'close');
+  assert.strictEqual(zeroCopy.bufferSize, 0);
+
+  server.close();
+  client.close();
+
+  await Promise.allSettled([
+    once(server, 'close'),
+    once(client, 'close')
+  ]);
+})().then(common.mustCall());
@@ -0,0 +1,82 @@
+// Flags: --no-warnings
+'use strict';
+const common = require('../common');
+if (!common.hasQuic)
+  common.skip('missing quic');
+
+// Tests that a QuicSocket that is one of a group of workers forwards a
+// short header packet for a connection ID issued by another worker to
+// that worker's forwarding endpoint, prefixed with the addresses the
+// packet was received from and on.
+
+const assert = require('assert');
+const dgram = require('dgram');
+const { key, cert, ca } = require('../common/quic');
+const { createQuicSocket } = require('net');
+
+const kCIDLength = 20;
+
+// Stands in for the forwarding endpoint of worker 0.
+const peer = dgram.createSocket('udp4');
+const client = dgram.createSocket('udp4');
+
+// Reserve a port for the forwarding endpoint of worker 1.
+const reserved = dgram.createSocket('udp4');
+
+peer.bind(0, '127.0.0.1', common.mustCall(() => {
+  reserved.bind(0, '127.0.0.1', common.mustCall(() => {
+    const forwardingPort = reserved.address().port;
+    reserved.close(common.mustCall(() => start(forwardingPort)));
+  }));
+}));
+
+function start(forwardingPort) {
+  const server = createQuicSocket({
+    endpoint: { address: '127.0.0.1' },
+    workerId: 1,
+    workerForwarding: [
+      { address: '127.0.0.1', port: peer.address().port },
+      { address: '127.0.0.1', port: forwardingPort },
+    ],
+    server: { key, cert, ca, alpn: 'meow' },
+  });
+  assert.strictEqual(server.endpoints.length, 2);
+
+  server.listen();
+  server.on('session', common.mustNotCall());
+
+  // A short header packet whose destination connection ID belongs
+  // to worker 0.
+  const packet = Buffer.alloc(1 + kCIDLength + 32, 0xab);
+  packet[0] = 0x40;
+  packet[1] = 0;
+
+  peer.on('message', common.mustCall((msg, rinfo) => {
+    assert.strictEqual(rinfo.address, '127.0.0.1');
+    assert.strictEqual(rinfo.port, forwardingPort);
+
+    const serverPort = server.endpoints[0].address.port;
+    assert.strictEqual(msg[0], 4);
+    assert.deepStrictEqual([...msg.slice(1, 5)], [127, 0, 0, 1]);
+    assert.strictEqual(msg.readUInt16BE(5), client.address().port);
+    assert.deepStrictEqual([...msg.slice(7, 11)], [127, 0, 0, 1]);
+    assert.strictEqual(msg.readUInt16BE(11), serverPort);
+    assert.deepStrictEqual(msg.slice(13), packet);
+
+    assert.strictEqual(server.packetsForwarded, 1n);
+    server.close();
+    peer.close();
+    client.close();
+  }));
+
+  server.on('ready', common.mustCall(() => {
+    // The forwarding endpoint is bound separately from the endpoint
+    // that receives the packet.
+    const send = () => {
+      if (!server.endpoints[1].bound)
+        return setImmediate(send);
+      client.send(packet, server.endpoints[0].address.port, '127.0.0.1');
+    };
+    send();
+  }));
+}